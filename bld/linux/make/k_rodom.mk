@@ -5,6 +5,7 @@ OBJ=$(KCC_OBJ)
 BIN=$(KCC_BIN)
 OBJFILES= \
 	$(OBJ)/DOM.o \
+	$(OBJ)/DOMArena.o \
 	$(OBJ)/RODOM.o
 TARGET=$(BIN)/libk_rodom.so
 
@@ -18,6 +19,9 @@ $(OBJ)/RODOM.o: $(SRC)/RODOM.cpp
 $(OBJ)/DOM.o: $(SRC)/DOM.cpp
 	g++ -c $(COMPILE_OPTIONS) $< -o $@
 
+$(OBJ)/DOMArena.o: $(SRC)/DOMArena.cpp
+	g++ -c $(COMPILE_OPTIONS) $< -o $@
+
 $(TARGET).1: $(OBJFILES)
 	g++ $(LINK_OPTIONS) -shared -Wl \
 	-o $(TARGET).1 \
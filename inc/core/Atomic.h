@@ -0,0 +1,125 @@
+/*
+ * Kuumba C++ Core
+ *
+ * $Id$
+ */
+#ifndef Atomic_h
+#define Atomic_h
+
+#if defined(KCC_WINDOWS)
+#   include <intrin.h>
+#   pragma intrinsic(_InterlockedIncrement, _InterlockedDecrement, _ReadWriteBarrier)
+#endif
+
+namespace kcc
+{
+    /**
+     * Reference count (NOT MT-safe)
+     */
+    class RefCount
+    {
+    public:
+        explicit RefCount(long c = 1L) : m_c(c) {}
+
+        /**
+         * Modifiers
+         */
+        inline void increment() { m_c++; }
+        inline long decrement() { return --m_c; }
+
+        /**
+         * Accessors
+         */
+        inline long get() const { return m_c; }
+
+    private:
+        RefCount(const RefCount&);
+        RefCount& operator = (const RefCount&);
+
+        // Attributes
+        long m_c;
+    };
+
+    /**
+     * Atomic reference count (MT-safe)
+     *   - increment is relaxed: a reference is only ever taken from one already held
+     *   - decrement is acquire-release: the owner dropping the last reference sees every
+     *     write made through the other references before deleting
+     */
+    class AtomicCount
+    {
+    public:
+        explicit AtomicCount(long c = 1L) : m_c(c) {}
+
+        /**
+         * Modifiers
+         */
+#if defined(KCC_WINDOWS)
+        inline void increment() { _InterlockedIncrement(&m_c); }
+        inline long decrement() { return _InterlockedDecrement(&m_c); }
+#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+        inline void increment() { __atomic_fetch_add(&m_c, 1L, __ATOMIC_RELAXED); }
+        inline long decrement() { return __atomic_sub_fetch(&m_c, 1L, __ATOMIC_ACQ_REL); }
+#else
+        inline void increment() { __sync_fetch_and_add(&m_c, 1L); } // full barrier prior to gcc 4.7
+        inline long decrement() { return __sync_sub_and_fetch(&m_c, 1L); }
+#endif
+
+        /**
+         * Accessors (snapshot only: may change as soon as read)
+         */
+        inline long get() const { return m_c; }
+
+    private:
+        AtomicCount(const AtomicCount&);
+        AtomicCount& operator = (const AtomicCount&);
+
+        // Attributes
+        volatile long m_c;
+    };
+
+    /**
+     * Atomic pointer publication (MT-safe): a pointer stored with release is read with 
+     * acquire, so the reader sees the pointee fully constructed
+     */
+    struct AtomicPtr
+    {
+#if defined(KCC_WINDOWS)
+        // volatile access has acquire/release semantics (/volatile:ms)
+        static inline void* load (void* const volatile* p)    { void* v = *p; _ReadWriteBarrier(); return v; }
+        static inline void  store(void* volatile* p, void* v) { _ReadWriteBarrier(); *p = v; }
+#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+        static inline void* load (void* const volatile* p)    { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+        static inline void  store(void* volatile* p, void* v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+#else
+        static inline void* load (void* const volatile* p)    { void* v = *p; __sync_synchronize(); return v; }
+        static inline void  store(void* volatile* p, void* v) { __sync_synchronize(); *p = v; }
+#endif
+
+    private:
+        AtomicPtr();
+    };
+
+    /**
+     * Atomic value publication (MT-safe) of a word sized value (int, bool or pointer) with 
+     * a single writer: stored with release and read with acquire (see AtomicPtr)
+     */
+    template<class T> struct AtomicValue
+    {
+#if defined(KCC_WINDOWS)
+        static inline T    load (const volatile T* p) { T v = *p; _ReadWriteBarrier(); return v; }
+        static inline void store(volatile T* p, T v)  { _ReadWriteBarrier(); *p = v; }
+#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+        static inline T    load (const volatile T* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+        static inline void store(volatile T* p, T v)  { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+#else
+        static inline T    load (const volatile T* p) { T v = *p; __sync_synchronize(); return v; }
+        static inline void store(volatile T* p, T v)  { __sync_synchronize(); *p = v; }
+#endif
+
+    private:
+        AtomicValue();
+    };
+}
+
+#endif // Atomic_h
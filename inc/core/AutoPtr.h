@@ -49,8 +49,11 @@ namespace kcc
 
     /**
      * std::auto_ptr-like class with ref-counting and implicit conversion to ptr type
+     *   - SharedPtr<_C>              NOT MT-safe: copies shared between threads must be locked
+     *   - SharedPtr<_C, AtomicCount> MT-safe ref-count: copies may be taken and released by 
+     *                                any thread without locking (the pointee is NOT guarded)
      */
-    template<class _C> class SharedPtr
+    template<class _C, class _RC = RefCount> class SharedPtr
     {
     public:
         /**
@@ -59,10 +62,10 @@ namespace kcc
          * @param p pointer to ref-count & auto-destruct 
          * @param rhs pointer to attach
          */
-        explicit SharedPtr(_C *p = NULL)    : m_self(new Self(p)) {}
-        SharedPtr(const SharedPtr<_C>& rhs) : m_self(NULL)   { attach(rhs.m_self); }
-        SharedPtr<_C>& operator = (const SharedPtr<_C>& rhs) { if (this != &rhs) { attach(rhs.m_self); } return *this; }
-        SharedPtr<_C>& operator = (_C* rhs) { reset(rhs); return *this; }
+        explicit SharedPtr(_C *p = NULL)        : m_self(new Self(p)) {}
+        SharedPtr(const SharedPtr<_C, _RC>& rhs) : m_self(NULL)   { attach(rhs.m_self); }
+        SharedPtr<_C, _RC>& operator = (const SharedPtr<_C, _RC>& rhs) { if (this != &rhs) { attach(rhs.m_self); } return *this; }
+        SharedPtr<_C, _RC>& operator = (_C* rhs) { reset(rhs); return *this; }
         ~SharedPtr() { clean(); }
 
         /**
@@ -81,29 +84,28 @@ namespace kcc
          */
         inline _C*  release()             { _C* t = m_self->m_p; clean(false); return t; }
         inline void reset  (_C* p = NULL) { clean(); m_self = new Self(p); }
-        inline int  rc     () const       { return m_self->m_rc; }
+        inline int  rc     () const       { return (int)m_self->m_rc.get(); }
 
     private:
         // Attributes
         struct Self
         {
-            Self(_C* p) : m_rc(1), m_p(p) {}
+            Self(_C* p) : m_rc(1L), m_p(p) {}
             ~Self() { delete m_p; }
-            int m_rc;
+            _RC m_rc;
             _C* m_p;
         } *m_self;
 
         // Implemenation
         inline void attach(Self* t)
         {
+            t->m_rc.increment(); // before clean(): t may be kept alive only by m_self
             if (m_self != NULL) clean();
             m_self = t;
-            m_self->m_rc++;
         }
         inline void clean(bool del = true) 
         { 
-            m_self->m_rc--; 
-            if (m_self->m_rc==0 && del) 
+            if (m_self->m_rc.decrement()==0 && del) 
             {
                 delete m_self; 
                 m_self = NULL;
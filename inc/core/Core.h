@@ -62,6 +62,7 @@
 #include <stdexcept>
 
 /* Core: abstract data types */
+#include <inc/core/Atomic.h>
 #include <inc/core/AutoPtr.h>
 #include <inc/core/StringTypes.h>
 #include <inc/core/ISODate.h>
@@ -105,15 +106,17 @@ namespace kcc
      *   init() - call once at the top of any executable (not components)
      *
      * CONFIGURATION PROPERTIES
-     *   kcc.systemDir - abosolute path to kcc components & config files
-     *   kcc.locale    - name of locale to use
-     *   kcc.rodom     - name of default RODOM component
-     *   kcc.regex     - name of default REGEX component
+     *   kcc.systemDir       - abosolute path to kcc components & config files
+     *   kcc.locale          - name of locale to use
+     *   kcc.rodom           - name of default RODOM component
+     *   kcc.regex           - name of default REGEX component
+     *   kcc.executorThreads - number of shared executor workers (0 for number of processors)
      *
      * GENERAL ACCESSORS/MODIFIERS:
      *   properties() - system global properties
      *   rodom()      - rodom provider (ownership NOT consumed)
      *   regex()      - regex provider (ownership NOT consumed)
+     *   executor()   - shared thread pool (shut down, running queued tasks, when Core exits)
      *
      * MODULE STATE ACCESSORS/MODIFIERS:
      *   Keep track of module state variables (file statics).
@@ -175,6 +178,12 @@ namespace kcc
          */
         static IRegex* regex() throw (Exception);
 
+        /**
+         * Accessor to shared executor (created on first use)
+         * @return executor instance (ownership NOT consumed)
+         */
+        static Executor& executor();
+
         //
         // Module state management
         //
@@ -185,9 +194,17 @@ namespace kcc
          */
         struct ModuleState
         {
-            /** Singleton (GOF) - Implementation, use KCC_STATE() instead */
+            /** 
+             * Singleton (GOF) - Implementation, use KCC_STATE() instead
+             *   - once published, access is a single acquire load (no locking)
+             *   - published states are withdrawn when Core shuts down
+             */
             template<class _C> static _C& instance(const Char* name)
             {
+                static void* volatile published = NULL;
+                void* p = kcc::AtomicPtr::load(&published);
+                if (p != NULL) return *static_cast<_C*>(static_cast<ModuleState*>(p));
+
                 kcc::Mutex::Lock lock(kcc::Core::sentinel());
                 _C* state = (_C*) kcc::Core::state(name);
                 if (state == NULL)
@@ -195,6 +212,7 @@ namespace kcc
                     state = new _C;
                     kcc::Core::state(name, state);
                 }
+                kcc::Core::state(&published, state);
                 return *state;
             }
 
@@ -211,6 +229,7 @@ namespace kcc
         static Mutex&       sentinel();
         static ModuleState* state(const Char* n);
         static void         state(const Char* n, ModuleState* s);
+        static void         state(void* volatile* published, ModuleState* s);
     };
 }
 
@@ -240,6 +259,7 @@ namespace kcc
 #define KCC_CORE_LOCALE    "kcc.locale"
 #define KCC_CORE_RODOM     "kcc.rodom"
 #define KCC_CORE_REGEX     "kcc.regex"
+#define KCC_CORE_EXECUTOR  "kcc.executorThreads"
 
 /**
  * Application configurations
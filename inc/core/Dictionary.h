@@ -8,37 +8,219 @@
 
 namespace kcc
 {
-    /** Finder Utility Types */
-    typedef std::pair<StringMultimap::iterator, StringMultimap::iterator>             DictionaryFinder;
-    typedef std::pair<StringMultimap::const_iterator, StringMultimap::const_iterator> DictionaryFinderConst;
+    /** Key/value pair types */
+    typedef std::pair<String, String> StringPair;
+    typedef std::list<StringPair>     StringPairs;
 
-    /** 
-     * Dictionary (multi-map) ADT
+    /**
+     * Flat open-addressing (linear probing) index of string keys. Maps key hashes to the
+     * run of pairs of a key (first, last, count) in a list of pairs (the pairs own the keys).
+     * Entries hold iterators into the indexed pairs: rebuild() after the pairs are copied.
      *
      * @author Ted V. Kremer
      */
-    class KCC_CORE_EXPORT Dictionary : public StringMultimap
+    class KCC_CORE_EXPORT StringIndex
     {
     public:
+        /** Key hashing & comparison */
+        enum Keys
+        {
+            K_EXACT,  // case-sensitive (parameters, properties)
+            K_NOCASE  // case-insensitive (HTTP headers)
+        };
+        typedef unsigned long Hash;
+
+        /**
+         * Interned key: key with its hashes computed once (use for constant keys)
+         */
+        class Key : public String
+        {
+        public:
+            explicit Key(const String& key) :
+                String(key), m_exact(StringIndex::hash(key, K_EXACT)), m_nocase(StringIndex::hash(key, K_NOCASE)) {}
+            inline Hash hash(Keys keys) const { return keys == K_NOCASE ? m_nocase : m_exact; }
+
+        private:
+            Hash m_exact;
+            Hash m_nocase;
+        };
+
+        /**
+         * Indexed key: consecutive pairs [first, last] of a key (count 0 when slot is empty)
+         */
+        struct Entry
+        {
+            Hash                  hash;
+            StringPairs::iterator first;
+            StringPairs::iterator last;
+            long                  count;
+        };
+
+        /**
+         * Create empty index
+         * @param keys key hashing & comparison
+         */
+        explicit StringIndex(Keys keys = K_EXACT) : m_keys(keys), m_used(0L) {}
+
+        /**
+         * Accessors
+         */
+        inline Keys keys() const                  { return m_keys; }
+        inline Hash hash(const String& key) const { return hash(key, m_keys); }
+        inline Hash hash(const Key& key) const    { return key.hash(m_keys); }
+        static Hash hash(const String& key, Keys keys);
+        bool        equals(const String& lhs, const String& rhs) const;
+
+        /**
+         * Find entry of key
+         * @param key key to find
+         * @param h hash of key
+         * @return entry or NULL if not found (valid until next insert or erase)
+         */
+        Entry*       find(const String& key, Hash h);
+        const Entry* find(const String& key, Hash h) const;
+
+        /**
+         * Index pair as the only pair of its key (key must not already be indexed)
+         * @param h hash of key
+         * @param pos pair
+         * @return entry (valid until next insert or erase)
+         */
+        Entry& insert(Hash h, StringPairs::iterator pos);
+
+        /**
+         * Remove entry of key from index (pairs are NOT erased)
+         * @param entry entry found or inserted
+         */
+        void erase(Entry& entry);
+
+        /**
+         * Re-index pairs (after pairs are copied)
+         * @param pairs pairs to index (pairs of a key must be consecutive)
+         * @param keys key hashing & comparison
+         */
+        void rebuild(StringPairs& pairs)            { rebuild(pairs, m_keys); }
+        void rebuild(StringPairs& pairs, Keys keys);
+
+        /**
+         * Clear index (capacity is kept)
+         */
+        void clear();
+
+        /**
+         * Swap index with index of swapped pairs (entries remain valid)
+         * @param rhs index to swap with
+         */
+        inline void swap(StringIndex& rhs) { std::swap(m_keys, rhs.m_keys); std::swap(m_used, rhs.m_used); m_slots.swap(rhs.m_slots); }
+
+    private:
+        StringIndex(const StringIndex&);
+        StringIndex& operator = (const StringIndex&);
+
+        // Implementation
+        typedef std::vector<Entry> Slots;
+        Entry& place(const Entry& entry);
+        void   grow();
+
+        // Attributes
+        Keys  m_keys;
+        long  m_used;
+        Slots m_slots;
+    };
+
+    /**
+     * Dictionary (multi-map) ADT. Pairs are stored in order of insertion, with the pairs
+     * of a key kept together, and located through a StringIndex. Insert and erase are
+     * constant time and never move other pairs (iterators and references stay valid).
+     *
+     * @author Ted V. Kremer
+     */
+    class KCC_CORE_EXPORT Dictionary
+    {
+    public:
+        /** Collection types */
+        typedef StringPair                  value_type;
+        typedef StringPairs::iterator       iterator;
+        typedef StringPairs::const_iterator const_iterator;
+        typedef StringPairs::size_type      size_type;
+        typedef StringIndex::Key            Key;
+
         /**
          * Construct dictionary, empty or from existing dictionary
+         * @param keys key comparison (StringIndex::K_NOCASE for HTTP headers)
+         */
+        explicit Dictionary(StringIndex::Keys keys = StringIndex::K_EXACT) : m_index(keys) {}
+        Dictionary(const Dictionary& dict) : m_pairs(dict.m_pairs), m_index(dict.keys()) { m_index.rebuild(m_pairs); }
+        Dictionary(const_iterator begin, const_iterator end, StringIndex::Keys keys = StringIndex::K_EXACT) : m_index(keys) { insert(begin, end); }
+        Dictionary& operator = (const Dictionary& rhs) { if (this != &rhs) { m_pairs = rhs.m_pairs; m_index.rebuild(m_pairs, rhs.keys()); } return *this; }
+
+        /**
+         * Collection accessors
+         */
+        inline iterator          begin()       { return m_pairs.begin(); }
+        inline iterator          end  ()       { return m_pairs.end();   }
+        inline const_iterator    begin() const { return m_pairs.begin(); }
+        inline const_iterator    end  () const { return m_pairs.end();   }
+        inline size_type         size () const { return m_pairs.size();  }
+        inline StringIndex::Keys keys () const { return m_index.keys();  }
+
+        /**
+         * Find first value of key
+         * @param key to find
+         * @return iterator to pair or end() if not found
+         */
+        inline iterator       find(const String& key)       { return at(key, m_index.hash(key)); }
+        inline const_iterator find(const String& key) const { return at(key, m_index.hash(key)); }
+        inline iterator       find(const Key& key)          { return at(key, m_index.hash(key)); }
+        inline const_iterator find(const Key& key) const    { return at(key, m_index.hash(key)); }
+
+        /**
+         * Count values of key
+         * @param key to count
+         * @return number of values
+         */
+        size_type count(const String& key) const;
+
+        /**
+         * Insert value (after existing values of key)
+         * @param value key/value to insert
+         * @param begin, end pairs to insert
+         * @return iterator to inserted pair
+         */
+        iterator insert(const value_type& value);
+        void     insert(const_iterator begin, const_iterator end) { for (const_iterator i = begin; i != end; i++) insert(*i); }
+
+        /**
+         * Erase values
+         * @param i pair to erase
+         * @param key key of values to erase
+         * @return number of values erased
+         */
+        void      erase(iterator i);
+        size_type erase(const String& key);
+
+        /**
+         * Clear all values
+         */
+        inline void clear() { m_pairs.clear(); m_index.clear(); }
+
+        /**
+         * Swap contents with dictionary (iterators remain valid, referring to the other dictionary)
+         * @param rhs dictionary to swap with
          */
-        Dictionary() {}
-        Dictionary(const Dictionary& dict) : StringMultimap(dict.begin(), dict.end()) {}
-        Dictionary(Dictionary::const_iterator begin, Dictionary::const_iterator end) : StringMultimap(begin, end) {}
-        Dictionary& operator = (const Dictionary& rhs) { if (this != &rhs) { StringMultimap::operator = (rhs); } return *this; }
+        inline void swap(Dictionary& rhs) { m_pairs.swap(rhs.m_pairs); m_index.swap(rhs.m_index); }
 
         /**
          * Convenience insert operator
          * @param key key to add
          * @return reference to key value
          */
-        inline String& operator () (const String& key) 
-        { 
-            return insert(std::make_pair(key, Strings::empty()))->second; 
+        inline String& operator () (const String& key)
+        {
+            return insert(std::make_pair(key, Strings::empty()))->second;
         }
 
-        /** 
+        /**
          * Convenience finder operator
          * @param key to find
          * @return value or empty if not exists
@@ -48,6 +230,11 @@ namespace kcc
             Dictionary::const_iterator i = find(key);
             return i == end() ? Strings::empty() : i->second;
         }
+        inline const String& operator [] (const Key& key) const
+        {
+            Dictionary::const_iterator i = find(key);
+            return i == end() ? Strings::empty() : i->second;
+        }
 
         /**
          * Query existence of key
@@ -55,20 +242,83 @@ namespace kcc
          * @return true if exists
          */
         inline bool exists(const String& key) const { return find(key) != end(); }
+        inline bool exists(const Key& key) const    { return find(key) != end(); }
 
-        /** 
+        /**
          * Convenience finder to find set of values
          * @param key to find
          * @return property finder with bounds (first=lower, second=upper)
          */
-        inline DictionaryFinder      finder(const String& key)       { return equal_range(key); }
-        inline DictionaryFinderConst finder(const String& key) const { return equal_range(key); }
+        std::pair<iterator, iterator>             finder(const String& key);
+        std::pair<const_iterator, const_iterator> finder(const String& key) const;
 
         /**
          * Empty dictionary (GOF: Singleton, Null-Object)
          * @return empty dictionary
          */
         static const Dictionary& empty();
+
+    private:
+        // Implementation
+        inline iterator at(const String& key, StringIndex::Hash h)
+        {
+            StringIndex::Entry* e = m_index.find(key, h);
+            return e == NULL ? m_pairs.end() : e->first;
+        }
+        inline const_iterator at(const String& key, StringIndex::Hash h) const
+        {
+            const StringIndex::Entry* e = m_index.find(key, h);
+            return e == NULL ? m_pairs.end() : const_iterator(e->first);
+        }
+
+        // Attributes
+        StringPairs m_pairs;
+        StringIndex m_index;
+    };
+
+    /** Finder Utility Types */
+    typedef std::pair<Dictionary::iterator, Dictionary::iterator>             DictionaryFinder;
+    typedef std::pair<Dictionary::const_iterator, Dictionary::const_iterator> DictionaryFinderConst;
+
+    /**
+     * Hash set of strings (e.g. tokenizer stoplist): the keys of a dictionary.
+     *
+     * @author Ted V. Kremer
+     */
+    class StringHashSet
+    {
+    public:
+        /**
+         * Construct set, empty or from existing strings
+         * @param strings strings to insert
+         */
+        StringHashSet() {}
+        explicit StringHashSet(const StringSet& strings) { insert(strings.begin(), strings.end()); }
+
+        /**
+         * Insert string(s) (ignored if already in set)
+         * @param s string to insert
+         * @param begin, end strings to insert
+         */
+        inline void insert(const String& s) { if (!m_set.exists(s)) m_set(s); }
+        template<class _I> void insert(_I begin, _I end) { for (; begin != end; begin++) insert(*begin); }
+
+        /**
+         * Query set
+         * @param s string to find
+         * @return true if in set
+         */
+        inline bool contains(const String& s) const { return m_set.exists(s); }
+
+        /**
+         * Accessors/modifiers
+         */
+        inline Dictionary::size_type size () const { return m_set.size(); }
+        inline void                  clear()       { m_set.clear(); }
+
+    private:
+        // Attributes
+        Dictionary m_set;
     };
 }
 
@@ -17,11 +17,12 @@ namespace kcc
     {
         String     method;
         String     path;
+        String     version;
         String     ip;
         int        port;
-        Dictionary attributes;
+        Dictionary attributes; // headers (case-insensitive)
         Dictionary parameters;
-        HTTPRequest() : port(URL::PORT_NONE) {}
+        HTTPRequest() : port(URL::PORT_NONE), attributes(StringIndex::K_NOCASE) {}
     };
 
     /**
@@ -40,7 +41,15 @@ namespace kcc
             C_NOT_MODIFIED = 304, 
             C_FORBIDDEN    = 403, 
             C_NOT_FOUND    = 404, 
-            C_ERROR        = 500
+            C_ERROR        = 500,
+            C_UNAVAILABLE  = 503
+        };
+
+        /** HTTP content framing (response length when content length is not known in advance) */
+        enum Framing
+        {
+            F_CHUNKED = -1, // chunked transfer encoding (HTTP/1.1)
+            F_CLOSE   = -2  // content delimited by connection close (HTTP/1.0)
         };
         
         /* HTTP Methods */
@@ -55,11 +64,13 @@ namespace kcc
          * @param url disparch url
          * @param method HTTP method
          * @param headers additional HTTP connection header
+         * @param keepAlive request connection persists following response
          * @throws Socket::Failed exception if error
          */
         static void dispatch(
             Socket& client, const URL& url, const String& method, 
-            const Dictionary& headers = Dictionary::empty()) throw (Socket::Failed);
+            const Dictionary& headers = Dictionary::empty(),
+            bool keepAlive = false) throw (Socket::Failed);
 
         /** 
          * Retrieve HTTP request header
@@ -69,6 +80,69 @@ namespace kcc
          */
         static void request(Socket& client, HTTPRequest& request) throw (Socket::Failed);
 
+        /** 
+         * Parse HTTP request header already read from a client (e.g. by a non-blocking reader)
+         * @param header raw request header (terminated by EOL+EOL)
+         * @param content request content read following the header (form params are parsed from it)
+         * @param request output param where request header is places
+         * @throws Socket::Failed exception if error
+         */
+        static void request(const String& header, const String& content, HTTPRequest& request) throw (Socket::Failed);
+
+        /** 
+         * Parse HTTP request header already read from a client, deferring parameters until
+         * the content is read (request(header, content, request) in two steps)
+         * @param header raw request header (terminated by EOL+EOL)
+         * @param request output param where method, path, version & attributes are placed
+         * @return query of request uri (pass to requestParameters)
+         * @throws Socket::Failed exception if error
+         */
+        static String requestHeader(const String& header, HTTPRequest& request) throw (Socket::Failed);
+
+        /** 
+         * Parse request parameters of a request header parsed by requestHeader
+         * @param query query returned by requestHeader
+         * @param content request content read following the header (form params are parsed from it)
+         * @param request output param where parameters are placed
+         */
+        static void requestParameters(const String& query, const String& content, HTTPRequest& request);
+
+        /**
+         * Query if connection persists following a request or response (HTTP/1.1 keep-alive)
+         * @param request request (or response) header
+         * @return true if connection persists
+         */
+        static bool keepAlive(const HTTPRequest& request);
+
+        /**
+         * Query content length of a request (or response)
+         * @param attributes request attributes
+         * @return content length, F_CHUNKED if chunked, or F_CLOSE if delimited by connection close
+         */
+        static long contentLength(const Dictionary& attributes);
+
+        /** Chunked content decode state (decoding resumes as more data is buffered) */
+        struct Chunked
+        {
+            String::size_type pos;      // offset in data of next chunk (or trailer) to decode
+            bool              trailers; // last chunk decoded, trailers pending
+            Chunked() : pos(0), trailers(false) {}
+        };
+
+        /**
+         * Decode chunked content from buffered data, resuming from the chunk where a previous
+         * call returned pending (complete chunks are decoded once however the data arrives)
+         * @param data buffered data
+         * @param offset offset of content in data
+         * @param state decode state of content (default constructed before first call)
+         * @param decoded output param where decoded chunks are appended
+         * @return size of encoded content in data or String::npos if not completely buffered
+         * @throws Socket::Failed exception if malformed
+         */
+        static String::size_type dechunk(
+            const String& data, String::size_type offset, 
+            Chunked& state, String& decoded) throw (Socket::Failed);
+
         /** 
          * Read request headers. Read a line delimted by EOL until EOL+EOL reached.
          * @param client connected & unread socket to fetch request from
@@ -85,8 +159,16 @@ namespace kcc
         static void write(Socket& client, const String& data) throw (Socket::Failed);
         static void write(Socket& client, std::istream& data) throw (Socket::Failed);
 
+        /**
+         * Send chunk of data using chunked transfer encoding
+         * @param buf chunk to send (sz of 0 sends the terminating chunk)
+         * @param sz size of chunk
+         * @throws Socket::Failed exception if error
+         */
+        static void chunk(Socket& client, const char* buf, int sz) throw (Socket::Failed);
+
         /** 
-         * Retrieve HTTP content (content type MUST be of text type, caller MUST validate PRIOR to calling)
+         * Retrieve HTTP content (framed by Content-Length, chunked, or connection close)
          * @param client connected & unread socket to fetch request from
          * @param attributes request attributes
          * @param data output param to place text content
@@ -98,11 +180,12 @@ namespace kcc
          * Write HTTP response header
          * @param client connected socket to write to
          * @param headers response headers
-         * @param len response total length
+         * @param len response total length (or Framing)
          * @param response code
+         * @param keepAlive connection persists following response
          * @throws Socket::Failed exception if error
          */
-        static void response(Socket& client, const Dictionary& headers, int len, int response = 200) throw (Socket::Failed);
+        static void response(Socket& client, const Dictionary& headers, int len, int response = 200, bool keepAlive = false) throw (Socket::Failed);
 
         /** 
          * Helper wrappers for GET/PUT/POST/DELETE of xml data
@@ -162,7 +245,13 @@ namespace kcc
     };
 
     /** 
-     * HTTP dispatch helper 
+     * HTTP dispatch helper. The connection persists (HTTP/1.1 keep-alive) across 
+     * dispatches to the same host while the server allows, responses are read in 
+     * order, and up to maxRequests are dispatched on a connection idle no longer than idleSec.
+     * Persisted connections are shared process-wide: a dispatch takes an idle connection
+     * to the host from the connection pool and returns it when released or destructed
+     * with no response outstanding (kcc.httpPoolMax idle connections per host:port, 
+     * evicted after kcc.httpPoolIdle secs).
      *
      * @author Ted V. Kremer
      */
@@ -171,8 +260,13 @@ namespace kcc
     public:
         /**
          * Construct dispatch
+         * @param maxRequests maximum requests dispatched per connection (1 disables keep-alive)
+         * @param idleSec maximum secs a connection may be idle and reused
          */
-        HTTPDispatch() {}
+        HTTPDispatch(long maxRequests = 100L, long idleSec = 15L);
+
+        /** Release connection to pool (or close if not reusable) */
+        ~HTTPDispatch();
         
         /**
          * Send dispatch to HTTP
@@ -181,12 +275,9 @@ namespace kcc
          * @param headers additional HTTP connection header
          * @throws Socket::Failed exception if error
          */
-        inline void send(
+        void send(
             const URL& url, const String& method, 
-            const Dictionary& headers = Dictionary::empty()) throw (Socket::Failed)
-        {
-            HTTP::dispatch(m_client, url, method, headers);
-        }
+            const Dictionary& headers = Dictionary::empty()) throw (Socket::Failed);
             
         /**
          * Send data to HTTP dispatch
@@ -197,16 +288,12 @@ namespace kcc
         inline void write(std::istream& data) throw (Socket::Failed) { HTTP::write(m_client, data); }
 
         /**
-         * Get response from HTTP dispatch
+         * Get response from HTTP dispatch (in order of dispatches sent)
          * @param request response attributes
          * @return HTTP response code
          * @throws Socket::Failed exception if error
          */            
-        inline int response(HTTPRequest& request) throw (Socket::Failed)
-        {
-            HTTP::request(m_client, request);
-            return Strings::parseInteger(request.path);
-        }
+        int response(HTTPRequest& request) throw (Socket::Failed);
         
         /**
          * Retrieve HTTP content from client
@@ -214,18 +301,46 @@ namespace kcc
          * @param data output param to place text content
          * @throws Socket::Failed exception if error
          */
-        inline void content(const Dictionary& attributes, String& receivedData) throw (Socket::Failed)
-        {
-            HTTP::content(m_client, attributes, receivedData); 
-        }
+        void content(const Dictionary& attributes, String& receivedData) throw (Socket::Failed);
+
+        /**
+         * Close connection
+         */
+        void close();
+
+        /**
+         * Release persisted connection to the connection pool (closed if not reusable)
+         */
+        void release();
+
+        /**
+         * Query if connection was taken from the connection pool and has not yet 
+         * received a response (peer may have closed it while pooled)
+         * @return true if an idempotent request may be retried on a new connection
+         */
+        inline bool pooled() const { return m_pooled; }
 
     private:
         HTTPDispatch(const HTTPDispatch&);
         HTTPDispatch& operator = (const HTTPDispatch&);
 
         // Attributes
-        Socket m_client;
+        Socket      m_client;
+        long        m_maxRequests;
+        long        m_idleSec;
+        long        m_requests;
+        long        m_outstanding;
+        bool        m_keepAlive;
+        bool        m_unread;
+        bool        m_pooled;
+        std::time_t m_accessed;
     };
 }
 
+/**
+ * HTTP client configurations
+ */
+#define KCC_HTTP_POOLMAX  "kcc.httpPoolMax"
+#define KCC_HTTP_POOLIDLE "kcc.httpPoolIdle"
+
 #endif // HTTP_h
@@ -22,6 +22,13 @@ namespace kcc
         /** Parse failed exception */
         KCC_COMPONENT_EXCEPTION(ParseFailed);
 
+        /** Node allocation */
+        enum Allocation
+        {
+            A_HEAP,  // nodes, names and values allocated individually (default)
+            A_ARENA  // nodes allocated from a per-document arena, names and values read from the input on demand
+        };
+
         /**
          * Construct DOM from XML input
          * @param xml input to parse
@@ -29,6 +36,15 @@ namespace kcc
          */
         virtual IDOMNode* parseXML(const String& xml) throw (IRODOM::ParseFailed) = 0;
 
+        /**
+         * Construct DOM from XML input using node allocation. Arena documents keep a single
+         * copy of the input and are released as a whole when the root node is deleted.
+         * @param xml input to parse
+         * @param allocation node allocation
+         * @return document root node or null if invalid or parse error (ownership IS consumed)
+         */
+        virtual IDOMNode* parseXML(const String& xml, Allocation allocation) throw (IRODOM::ParseFailed) = 0;
+
         /**
          * Construct DOM from HTML input
          * @param html input to parse
@@ -10,10 +10,30 @@ namespace kcc
 {
     interface IRegexExpression;
 
+    /**
+     * Compiled expression cache statistics
+     */
+    struct RegexCacheStatistics
+    {
+        long entries;    // cached expressions
+        long max;        // maximum cached expressions
+        long frontHits;  // expressions served from thread front caches (published periodically)
+        long hits;       // expressions served from the shared cache
+        long misses;     // expressions compiled
+        long evictions;  // least recently used expressions evicted
+        long pinned;     // expressions held by expression() until flushed
+        RegexCacheStatistics() : entries(0L), max(0L), frontHits(0L), hits(0L), misses(0L), evictions(0L), pinned(0L) {}
+    };
+
     /**
      * Regular expressions. Provider compiles and caches all expressions. 
      * For fine grained control of regex lifetime use an IRegexExpression.
      *
+     * CACHE
+     *   Compiled expressions are shared (immutable) by expression & options in a least
+     *   recently used cache of kcc.regexCacheMax expressions, fronted by a small per-thread
+     *   cache that serves hot expressions without locking.
+     *
      * @author Ted V. Kremer
      */
     interface IRegex : IComponent
@@ -47,9 +67,16 @@ namespace kcc
          */
         virtual void flush   (IRegexExpression* rx) = 0; // rx invalid on return
         virtual void flushAll() = 0;
+
+        /**
+         * Compiled expression cache statistics
+         * @param stats out-param of cache counters
+         */
+        virtual void cacheStatistics(RegexCacheStatistics& stats) = 0;
         
         /**
          * Accessor to compiled regex expression. Will compile and cache expression if not cached.
+         * The expression is held (not evicted) until flushed.
          * @param regex regular expression 
          * @param ops regular expression options
          * @retrun regex expression (ownership NOT consumed)
@@ -167,4 +194,9 @@ namespace kcc
     };
 }
 
+/**
+ * Regex configurations
+ */
+#define KCC_REGEX_CACHEMAX "kcc.regexCacheMax"
+
 #endif // IRegex_h
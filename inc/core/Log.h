@@ -23,6 +23,14 @@ namespace kcc
      * Defines:
      *    KCC_LOG_BRIEF - compiling away log verbosity > info3
      *
+     * Asynchronous logging (kcc.logAsync=1) formats entries on the calling
+     * thread into a bounded buffer (kcc.logBuffer entries) that a writer thread
+     * batches to the log file. When the buffer is full kcc.logFull selects:
+     *    block - caller waits for buffer space (default)
+     *    drop  - entry is discarded
+     *    count - entry is discarded and drops are logged by the writer
+     * The writer thread's own entries are written synchronously (never buffered).
+     *
      * USAGE:
      *   ... Foo.cpp ...
      *   #define KCC_FILE "Foo"
@@ -79,7 +87,8 @@ namespace kcc
         static String         name();
         static String         ext();
         static String         file();
-        static long           entries();
+        static long           entries(); // records written (asynchronous records once the writer writes them)
+        static long           dropped(); // records dropped by asynchronous writer
         static long           maxSize();
         static int            maxFiles();
         static void           history(StringSet& logs, bool clear = true);
@@ -185,5 +194,8 @@ namespace kcc
 #define KCC_LOG_EXT       "kcc.logExt"  
 #define KCC_LOG_STDOUT    "kcc.logStdOut"  
 #define KCC_LOG_DECORATOR "kcc.logDecorator"  
+#define KCC_LOG_ASYNC     "kcc.logAsync"  
+#define KCC_LOG_BUFFER    "kcc.logBuffer"  
+#define KCC_LOG_FULL      "kcc.logFull"  
 
 #endif // Log_h
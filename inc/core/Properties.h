@@ -9,7 +9,7 @@
 namespace kcc
 {
     /**
-    * Class to manage key/value properties ADT
+    * Class to manage key/value properties ADT (in insertion order, hashed: see StringIndex)
     *
     * XML:
     *   <Properties>
@@ -159,8 +159,12 @@ namespace kcc
         static const Properties& empty();
 
     protected:
+        // Implementation
+        const String* find(const String& key) const;
+
         // Attributes
-        StringMap m_properties;
+        StringPairs m_properties;
+        StringIndex m_index;
     };
 }
 
@@ -170,6 +174,55 @@ namespace kcc
 #define KCC_PROPERTY_TRUE  ((long)true)
 #define KCC_PROPERTY_FALSE ((long)false)
 
+namespace kcc
+{
+    // kcc_property: resolve typed property value (value is default on entry)
+    inline void kcc_property(const Properties& p, const String& k, String& v) { v = p.get(k, v); }
+    inline void kcc_property(const Properties& p, const String& k, long& v)   { v = p.get(k, v); }
+    inline void kcc_property(const Properties& p, const String& k, double& v) { v = p.get(k, v); }
+    inline void kcc_property(const Properties& p, const String& k, bool& v)   { v = p.get(k, v ? KCC_PROPERTY_TRUE : KCC_PROPERTY_FALSE) == KCC_PROPERTY_TRUE; }
+
+    /**
+     * Typed property handle. The value is resolved once when the handle is constructed,
+     * so later changes to the properties are not seen.
+     *
+     * USAGE:
+     *   static const String k_keyMax("foo.max");
+     *   PropertyLong max(Core::properties(), k_keyMax, 10L);
+     *   ... max() ...
+     *
+     * @author Ted V. Kremer
+     */
+    template<class _T> class PropertyValue
+    {
+    public:
+        /**
+         * Resolve property
+         * @param properties properties to resolve from
+         * @param key key of value
+         * @param value default value
+         */
+        PropertyValue(const Properties& properties, const String& key, const _T& value) : m_value(value)
+        {
+            kcc_property(properties, key, m_value);
+        }
+
+        /**
+         * Accessors
+         */
+        inline const _T& operator () () const { return m_value; }
+        inline operator const _T&     () const { return m_value; }
+
+    private:
+        // Attributes
+        _T m_value;
+    };
+    typedef PropertyValue<String> PropertyString;
+    typedef PropertyValue<long>   PropertyLong;
+    typedef PropertyValue<double> PropertyDouble;
+    typedef PropertyValue<bool>   PropertyBool;
+}
+
 /**
  * Property XML
  */
@@ -50,19 +50,67 @@ namespace kcc
         void connect()                             throw (Socket::Failed);
         void close();
 
-        /** Reader methods */
+        /** Reader methods (served from read buffer before socket) */
         void read(long& l)                        throw (Socket::Failed);
         void read(char* buf, int sz, int& actual) throw (Socket::Failed);
 
+        /**
+         * Read until size bytes read or connection closed
+         * @param buf buffer to read into (at least sz bytes)
+         * @param sz bytes to read
+         * @param actual bytes read (less than sz if closed by peer)
+         * @throws Socket::Failed if read fails
+         */
+        void readFully(char* buf, int sz, int& actual) throw (Socket::Failed);
+
+        /**
+         * Read through delimiter using block reads, buffering data read past delimiter
+         * @param delimiter delimiter to read through
+         * @param data output param of data read including delimiter
+         * @param max maximum bytes to read
+         * @return true if delimiter read, false if connection closed
+         * @throws Socket::Failed if read fails or max exceeded
+         */
+        bool readThrough(const String& delimiter, String& data, int max) throw (Socket::Failed);
+
+        /**
+         * Query bytes buffered but not yet read
+         * @return buffered bytes
+         */
+        inline int buffered() const { return (int)(m_buffer.size() - m_offset); }
+
+        /**
+         * Wait for data to read
+         * @param sec seconds to wait
+         * @return true if data available, false if timed out or closed by peer
+         */
+        bool wait(long sec);
+
+        /**
+         * Query if connection is open and quiet (no data pending and not closed by peer)
+         * @return true if connection may be reused for a new request
+         */
+        bool idle();
+
         /** Writer methods */
         void write(long l)                  throw (Socket::Failed);
         void write(const String& s)         throw (Socket::Failed);
         void write(const char* buf, int sz) throw (Socket::Failed);
 
+        /**
+         * Write file content without staging it in a user-space buffer (sendfile on linux)
+         * @param file path of file to write
+         * @param offset offset into file to write from
+         * @param size bytes to write
+         * @throws Socket::Failed if file can't be opened or write fails
+         */
+        void writeFile(const String& file, long offset, long size) throw (Socket::Failed);
+
         /** Accessors */
         inline const String& ip()   { return m_ip;   }
         inline const String& host() { return m_host; }
         inline int           port() { return m_port; }
+        inline bool          connected() const { return m_handle >= 0; }
         
         /** Option Flags */
         enum OptionFlags
@@ -70,7 +118,8 @@ namespace kcc
             O_KEEPALIVE,
             O_LINGER,
             O_SNDBUF,
-            O_RCVBUF
+            O_RCVBUF,
+            O_NODELAY  // disable send coalescing (TCP_NODELAY)
         };
         int  getOption(OptionFlags o)            throw (Socket::Failed);
         void setOption(OptionFlags o, int value) throw (Socket::Failed);
@@ -91,12 +140,20 @@ namespace kcc
          */
         static String getHostName() throw (Socket::Failed);
 
+        /**
+         * Exchange connection state (handle, address, and read buffer) with another socket
+         * @param s socket to exchange with
+         */
+        void swap(Socket& s);
+
     protected:
         // Attributes
         String m_ip;
         String m_host;
         int    m_port;
         Handle m_handle;
+        String m_buffer;
+        String::size_type m_offset;
 
         /** onConnect: Template method (GOF) - client connection to server */
         virtual void onConnect(Address addr) throw (Socket::Failed);
@@ -147,4 +204,9 @@ namespace kcc
     };
 }
 
+/**
+ * Socket configurations
+ */
+#define KCC_SOCKET_DNSTTL "kcc.socketDNSTTL"
+
 #endif // Socket_h
@@ -29,11 +29,13 @@ namespace kcc
     typedef std::vector<StringPart>       StringParts;
 
     /**
-     * Immutable ref-counted wrapper to string (NOT MT-safe)
+     * Immutable ref-counted wrapper to string
+     *   - StringRC       NOT MT-safe
+     *   - StringRCAtomic MT-safe ref-count (see AtomicCount)
      *
      * @author Ted V. Kremer
      */
-    class StringRC
+    template<class _RC> class BasicStringRC
     {
     public:
         /**
@@ -42,11 +44,11 @@ namespace kcc
          * @param s string to ref-count
          * @param rhs RC string to attach to
          */
-        StringRC(const Char* s)       : m_data(new Data(s)) {}
-        StringRC(const String& s)     : m_data(new Data(s)) {}
-        StringRC(const StringRC& rhs) : m_data(NULL)        { assign(rhs); }
-        ~StringRC() { clean(); }
-        StringRC& operator = (const StringRC& rhs) { if (this != &rhs) { assign(rhs); } return *this; }
+        BasicStringRC(const Char* s)            : m_data(new Data(s)) {}
+        BasicStringRC(const String& s)          : m_data(new Data(s)) {}
+        BasicStringRC(const BasicStringRC& rhs) : m_data(NULL)        { assign(rhs); }
+        ~BasicStringRC() { clean(); }
+        BasicStringRC& operator = (const BasicStringRC& rhs) { if (this != &rhs) { assign(rhs); } return *this; }
 
         /**
          * Accessors
@@ -58,24 +60,24 @@ namespace kcc
         /**
          * Utility
          */
-        inline bool empty  ()                    const { return m_data->str.empty(); }
-        inline int  compare(const StringRC& rhs) const { return m_data->str.compare(rhs.m_data->str); }
-        inline int  rc     ()                    const { return m_data->rc; }
+        inline bool empty  ()                         const { return m_data->str.empty(); }
+        inline int  compare(const BasicStringRC& rhs) const { return m_data->str.compare(rhs.m_data->str); }
+        inline int  rc     ()                         const { return (int)m_data->rc.get(); }
 
     private:
         // Implemenation
-        inline void assign(const StringRC& rhs)
+        inline void assign(const BasicStringRC& rhs)
         {
+            rhs.m_data->rc.increment();
             clean();
             m_data = rhs.m_data;
-            m_data->rc++;
         }
         inline void clean()
         {
             if (m_data != NULL)
             {
-                m_data->rc--;
-                if (m_data->rc==0) { delete m_data; m_data = NULL; }
+                if (m_data->rc.decrement()==0) delete m_data;
+                m_data = NULL;
             }
         }
 
@@ -83,15 +85,23 @@ namespace kcc
         struct Data
         {
             String str;
-            int    rc;
-            Data(const String& s) : str(s), rc(1) {}
+            _RC    rc;
+            Data(const String& s) : str(s), rc(1L) {}
         } *m_data;
     };
-    inline const bool     operator <  (const StringRC& lhs, const StringRC& rhs) { return lhs.compare(rhs)<0; }
-    inline const bool     operator == (const StringRC& lhs, const StringRC& rhs) { return (const String&)lhs == (const String&)rhs; }
-    inline const bool     operator != (const StringRC& lhs, const StringRC& rhs) { return (const String&)lhs != (const String&)rhs; }
-    inline const StringRC operator +  (const StringRC& lhs, const StringRC& rhs) { return StringRC((const String&)lhs + (const String&)rhs); }
-    inline std::ostream&  operator << (std::ostream& out, const StringRC& s)     { out << (const kcc::String&) s; return out; }
+    typedef BasicStringRC<RefCount>    StringRC;
+    typedef BasicStringRC<AtomicCount> StringRCAtomic;
+
+    // RC string operators (non-template so String & Char* operands convert)
+#   define KCC_STRINGRC_OPERATORS(_S) \
+    inline const bool    operator <  (const _S& lhs, const _S& rhs) { return lhs.compare(rhs)<0; } \
+    inline const bool    operator == (const _S& lhs, const _S& rhs) { return (const String&)lhs == (const String&)rhs; } \
+    inline const bool    operator != (const _S& lhs, const _S& rhs) { return (const String&)lhs != (const String&)rhs; } \
+    inline const _S      operator +  (const _S& lhs, const _S& rhs) { return _S((const String&)lhs + (const String&)rhs); } \
+    inline std::ostream& operator << (std::ostream& out, const _S& s)   { out << (const kcc::String&) s; return out; }
+    KCC_STRINGRC_OPERATORS(StringRC)
+    KCC_STRINGRC_OPERATORS(StringRCAtomic)
+#   undef KCC_STRINGRC_OPERATORS
 
     /** RC String types */
     typedef std::set<StringRC>              StringSetRC;
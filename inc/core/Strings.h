@@ -8,6 +8,8 @@
 
 namespace kcc
 {
+    class StringHashSet;
+
     /**
      * String Utilities
      *
@@ -185,8 +187,10 @@ namespace kcc
         static bool match(const String& value, const String& expr, SelectDefault sd = Strings::SD_ENUM) throw (Exception);
 
         /**
-         * Tokenize and filter text.
-         * @see Regex
+         * Tokenize and filter text. Tokens are runs of non-white space (regex \s+ split);
+         * blanks are tokens without a word character (\w), decimals a single digit (^\d$),
+         * fractions begin and end with a digit (^\d.*\d$). Classification is table-driven
+         * (no regex) using the C library character classes of the system locale, as regex does.
          * @param text text to tokenize
          * @param tokens out-param of filtered tokens
          * @param stoplist terms to filter our
@@ -212,6 +216,12 @@ namespace kcc
             const StringSet& stoplist, 
             TokenOptions ops = Strings::TF_ALL,
             bool clear = true) throw (Exception);
+        static void tokenize(
+            const String& text, 
+            StringVector& tokens, 
+            const StringHashSet& stoplist, 
+            TokenOptions ops = Strings::TF_ALL,
+            bool clear = true) throw (Exception);
             
         /**
          * Escape regex expression
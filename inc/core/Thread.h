@@ -170,6 +170,121 @@ namespace kcc
         void* m_mutex;
     };
 
+    /**
+     * Reader-writer mutex for read-dominated shared state: any number of shared (reader)
+     * locks or one exclusive (writer) lock. Waiting writers are preferred over new readers
+     * where supported. NOT recursive: never relock (shared or exclusive) while holding.
+     *
+     * @author Ted V. Kremer
+     */
+    class KCC_CORE_EXPORT RWMutex
+    {
+    public:
+        /** Utility classes to automatically lock/unlock on stack boundary */
+        struct SharedLock
+        {
+            RWMutex& m;
+            SharedLock(RWMutex& _m) : m(_m) { m.lockShared();   }
+            ~SharedLock()                   { m.unlockShared(); }
+        };
+        struct ExclusiveLock
+        {
+            RWMutex& m;
+            ExclusiveLock(RWMutex& _m) : m(_m) { m.lock();   }
+            ~ExclusiveLock()                   { m.unlock(); }
+        };
+
+        /** Map init/destroy of rwlock to ctor/dtor */
+        RWMutex();
+        ~RWMutex();
+
+        /** Lock/unlock shared */
+        void lockShared();
+        void unlockShared();
+
+        /** Lock/unlock exclusive */
+        void lock();
+        void unlock();
+
+    private:
+        RWMutex(const RWMutex&);
+        RWMutex& operator = (const RWMutex&);
+
+        // Attributes
+        void* m_rwlock;
+    };
+
+    /**
+     * Adaptive mutex for very short critical sections: spins briefly (multi-processor only)
+     * then sleeps in the kernel (Linux futex, Windows critical section spin count).
+     * NOT recursive.
+     *
+     * @author Ted V. Kremer
+     */
+    class KCC_CORE_EXPORT SpinMutex
+    {
+    public:
+        /** Utility class to automatically lock/unlock on stack boundary */
+        struct Lock
+        {
+            SpinMutex& m;
+            Lock(SpinMutex& _m) : m(_m) { m.lock();   }
+            ~Lock()                     { m.unlock(); }
+        };
+
+        /** Map init/destroy of mutex to ctor/dtor */
+        SpinMutex();
+        ~SpinMutex();
+
+        /** Lock/unlock mutex */
+        void lock();
+        void unlock();
+
+        /**
+         * Attempt lock
+         * @return true if locked
+         */
+        bool tryLock();
+
+    private:
+        SpinMutex(const SpinMutex&);
+        SpinMutex& operator = (const SpinMutex&);
+
+        // Attributes
+        volatile int m_state;  // futex: 0 unlocked, 1 locked, 2 locked & contended
+        int          m_spins;
+        void*        m_mutex;  // critical section (Windows)
+    };
+
+    /**
+     * Thread-local value slot: one pointer per thread. A thread's value is passed to the
+     * cleanup function when the thread exits; values of threads still running when the
+     * slot is destroyed are NOT cleaned up (release the calling thread's value first).
+     *
+     * @author Ted V. Kremer
+     */
+    class KCC_CORE_EXPORT ThreadLocal
+    {
+    public:
+        /** Thread exit cleanup of a non-null value */
+        typedef void (*Cleanup)(void* value);
+
+        /** Map create/delete of thread key to ctor/dtor */
+        explicit ThreadLocal(Cleanup cleanup = NULL);
+        ~ThreadLocal();
+
+        /** Accessor/modifier to value of calling thread (initially NULL) */
+        void* get() const;
+        void  set(void* value);
+
+    private:
+        ThreadLocal(const ThreadLocal&);
+        ThreadLocal& operator = (const ThreadLocal&);
+
+        // Attributes
+        void* m_key;
+    };
+
     /**
      * Thread synchronization condition abstract class. This class provides
      * signaled event completion (POSIX conditions).
@@ -197,6 +312,13 @@ namespace kcc
         /** Wait for all conditions to complete */
         void wait();
 
+        /**
+         * Wait for all conditions to complete, at most ms
+         * @param ms milliseconds to wait for
+         * @return true if completed, false if timed out
+         */
+        bool wait(long ms);
+
     protected:
         // Template methods (GOF) to manage condition
         virtual void onBegin() = 0;
@@ -239,6 +361,115 @@ namespace kcc
         // Attributes
         int m_count;
     };
+
+    /**
+     * Fixed-size thread pool executor. Each worker has its own task deque: a worker runs its
+     * own tasks newest first and, when out of work, steals the oldest task of another worker.
+     * Tasks submitted from outside the pool are spread round-robin across the workers.
+     *
+     * Tasks are Future derivatives owned by the caller: submit() queues a task and wait()
+     * is its completion handle. A thread waiting on a future runs queued tasks until the
+     * future completes, so tasks may submit and wait on nested tasks without deadlock;
+     * a thread outside the pool may instead block, so it is not held up by unrelated tasks.
+     *
+     * shutdown() is graceful: queued tasks are run, then the workers exit. The shared
+     * executor (Core::executor()) is shut down when Core exits.
+     *
+     * @author Ted V. Kremer
+     */
+    class KCC_CORE_EXPORT Executor
+    {
+    public:
+        /**
+         * Task and completion handle. Override invoke() with the task; it must not be
+         * deleted or resubmitted until wait() returns.
+         */
+        class KCC_CORE_EXPORT Future : public IThread
+        {
+        public:
+            Future() : m_executor(NULL) {}
+            virtual ~Future() {}
+
+            /**
+             * Wait for task completion
+             * @param help run queued tasks meanwhile (false to only block; workers blocking on
+             *             tasks of their own executor may deadlock it)
+             * @return true if task completed, false if it threw (see error())
+             */
+            bool wait(bool help = true);
+
+            /**
+             * Query task completion
+             * @return true if completed (or never submitted)
+             */
+            inline bool completed() { return m_done.count() == 0; }
+
+            /**
+             * Accessor to error of task
+             * @return uncaught exception message of task, empty if none
+             */
+            inline const String& error() const { return m_error; }
+
+        private:
+            Future(const Future&);
+            Future& operator = (const Future&);
+
+            // Implementation
+            friend class Executor;
+            void run();
+
+            // Attributes
+            Executor* m_executor;
+            Monitor   m_done;
+            String    m_error;
+        };
+
+        /**
+         * Start workers
+         * @param threads number of workers (0 for number of processors)
+         * @param name worker thread name (NOT copied)
+         */
+        explicit Executor(int threads = 0, const Char* name = "Executor");
+
+        /** Shut down (see shutdown()) */
+        ~Executor();
+
+        /**
+         * Queue task to run on a worker (run on calling thread once shut down)
+         * @param task task to run (ownership NOT consumed)
+         */
+        void submit(Future* task);
+
+        /**
+         * Run queued tasks, then stop and wait for workers to exit
+         */
+        void shutdown();
+
+        /**
+         * Accessors
+         */
+        int  threads() const;
+        long executed() const; // tasks run
+        long stolen  () const; // tasks run by a thread other than the worker they were queued to
+
+        /**
+         * Query number of processors
+         * @return online processors (at least 1)
+         */
+        static int processors();
+
+    private:
+        Executor(const Executor&);
+        Executor& operator = (const Executor&);
+
+        // Implementation
+        friend class Future;
+        struct Pool;
+        bool help();
+
+        // Attributes
+        Pool* m_pool;
+    };
 }
 
 #endif // Thread_h
@@ -49,7 +49,7 @@ namespace kcc
     interface IHTTPResponseWriter : IComponent
     {
         /**
-         * Write complete response (headers & content)
+         * Write complete response (headers & content), streamed through a bounded buffer (see stream())
          * @param in response to write
          * @param headers response headers
          * @param response code
@@ -67,7 +67,7 @@ namespace kcc
         /**
          * Write response headers
          * @param headers response headers
-         * @param len response total length
+         * @param len response total length (or HTTP::F_CHUNKED to chunk writes, HTTP::F_CLOSE to close on completion)
          * @param response code
          * @throws Socket::Failed exception if error
          */
@@ -81,6 +81,25 @@ namespace kcc
          */
         virtual void write(const char* buf, int sz) throw (Socket::Failed) = 0;
 
+        /**
+         * Write file content (headers MUST have been written with len == size, or HTTP::F_CHUNKED)
+         * @param path file to write
+         * @param size bytes of file to write
+         * @throws Socket::Failed exception if error
+         */
+        virtual void file(const String& path, long size) throw (Socket::Failed) = 0;
+        /**
+         * Begin streamed response. Content written to the stream is sent through a bounded buffer:
+         * with Content-Length if complete within the buffer, otherwise chunked (or delimited by connection 
+         * close for HTTP/1.0). The response is completed when the response handler returns. Another response 
+         * before the buffer is first sent discards the streamed content.
+         * @param headers response headers
+         * @param response code
+         * @return stream to write response content to (valid until response handler returns)
+         * @throws Socket::Failed exception if error
+         */
+        virtual std::ostream& stream(const Dictionary& headers, int response = HTTP::C_OK) throw (Socket::Failed) = 0;
+
         /**
          * Write xml (client-caching disabled)
          * @param in xml to write
@@ -31,6 +31,22 @@ namespace kcc
         virtual void onHandle(const HTTPRequest& request, IPageReader* in, IPageWriter* out, IPageResponse* response) = 0;
     };
 
+    /**
+     * Page multi-part form content sink
+     *
+     * @author Ted V. Kremer
+     */
+    interface IPageFormSink : IComponent
+    {
+        /**
+         * Receive next block of part content
+         * @param buf content (valid only during call)
+         * @param sz size of content
+         * @throws Socket::Failed exception to abandon form
+         */
+        virtual void onContent(const char* buf, int sz) throw (Socket::Failed) = 0;
+    };
+
     /**
      * Page multi-part form reader
      *
@@ -59,9 +75,27 @@ namespace kcc
          * @param buf buffer to read into
          * @param sz size of buffer
          * @param actual actual bytes read
+         * @return true if part has more content to read
+         * @throws Socket::Failed exception if error
          */
         virtual bool read(char* buf, int sz, int& actual) throw (Socket::Failed) = 0;
 
+        /**
+         * Stream remaining part content to sink (blocks are passed from the read buffer, without copying)
+         * @param sink sink to receive content (ownership NOT consumed)
+         * @return bytes of content passed to sink
+         * @throws Socket::Failed exception if error
+         */
+        virtual long read(IPageFormSink* sink) throw (Socket::Failed) = 0;
+
+        /**
+         * Spill remaining part content to file
+         * @param path file to write (created or truncated)
+         * @return true if written, false if file can't be written (part content is still consumed)
+         * @throws Socket::Failed exception if error
+         */
+        virtual bool save(const String& path) throw (Socket::Failed) = 0;
+
         /**
          * Read text data from form (form must have text content, consumer MUST validate Part content type PRIOR to calling)
          * @param data string to read into
@@ -70,7 +104,7 @@ namespace kcc
         virtual void read(String& data) throw (Socket::Failed) = 0;
         
         /**
-         * Read to end of part
+         * Read to end of form, discarding remaining parts
          * @throws Socket::Failed exception if error
          */
         virtual void end() throw (Socket::Failed) = 0;
@@ -128,7 +162,8 @@ namespace kcc
             const Dictionary& headers) throw (IXMLTransform::TransformException, Socket::Failed) = 0;
 
         /**
-         * Stream resource to writer
+         * Stream resource to writer. Small resources are served from an in-memory cache
+         * (with ETag and gzip variants), larger resources are written from the file (sendfile)
          * @param path path to resource
          * @param attributes request attributes
          * @throws Socket::Failed exception if error
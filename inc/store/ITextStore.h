@@ -23,7 +23,8 @@ namespace kcc
             C_METADATA      = 1, // store/return metadata
             C_TEXT          = 2, // store/return document text (allows using the term-index and boolean query facilities only)
             C_TERMS         = 4, // store/return tokenized term frequency vector
-            C_QUERY_MATCHES = 8  // return document query selections
+            C_QUERY_MATCHES = 8, // return document query selections
+            C_TERM_OFFSETS  = 16 // store term positions & offsets (query selections without re-tokenizing text)
         };
         typedef unsigned int Contents;
         enum MetadataFlags
@@ -45,18 +46,36 @@ namespace kcc
         String    text;
         Terms     terms;
         Matches   matches;
+        double    score;   // query relevance (higher is better)
 
         // Modifiers
+        TextDocument() : score(0.0) {}
         void clear() 
         { 
             metadata.clear(); 
             text.clear(); 
             terms.clear();
             matches.clear();
+            score = 0.0;
         }
     };
     typedef std::vector<TextDocument> TextDocuments;
 
+    /**
+     * Text query result cache statistics
+     */
+    struct TextCacheStatistics
+    {
+        long      entries;       // cached queries
+        long      max;           // maximum cached queries
+        long      hits;          // queries served from cache
+        long      misses;        // queries searched
+        long      evictions;     // least recently used queries evicted
+        long      invalidations; // caches cleared by index changes
+        long long generation;    // index generation (version, changes on every commit) of cached queries
+        TextCacheStatistics() : entries(0L), max(0L), hits(0L), misses(0L), evictions(0L), invalidations(0L), generation(0LL) {}
+    };
+
     /**
      * Text results
      *
@@ -84,6 +103,13 @@ namespace kcc
         virtual long total() = 0;
         virtual long row  () = 0;
 
+        /**
+         * Score scale: document scores are raw relevance divided by scale (the top raw score
+         * if above 1, otherwise 1), so scores of different results compare once multiplied by it
+         * @return score scale of results
+         */
+        virtual double scale() = 0;
+
         /**
          * Fetch results
          * @param txtdoc out-param of document results
@@ -95,6 +121,10 @@ namespace kcc
     /**
      * Text query
      *
+     * The text query client (k_textqueryclient) queries the httptextquery shards listed in
+     * TextQueryClient.connections concurrently, on its own pool of TextQueryClient.ioThreads
+     * threads (default one per connection; raise it for concurrent queries on one client).
+     *
      * @author Ted V. Kremer
      */
     interface ITextQuery : IComponent
@@ -140,11 +170,20 @@ namespace kcc
          */
         virtual ITextResults* query(const String& expression, TextDocument::Contents contents = TextDocument::C_METADATA) throw (TextException) = 0;
 
+        /**
+         * Query result cache statistics. Top documents of queries are cached by normalized 
+         * expression (TextStore.queryCacheMax queries of TextStore.queryCacheHits documents) 
+         * and invalidated when the index searcher is reopened on a changed index
+         * @param stats out-param of cache counters
+         */
+        virtual void queryCacheStatistics(TextCacheStatistics& stats) = 0;
+
         /**
          * Index text into store
          * @param document txtdoc to index (document.text required, document.metadata optional, termCount ignored)
          * @param contents document contents (C_METADATA to index metadata, 
-         *                 C_TEXT to store complete text in index, C_TERMS to store tokenized term frequency vectors)
+         *                 C_TEXT to store complete text in index, C_TERMS to store tokenized term frequency vectors,
+         *                 C_TERM_OFFSETS to store term offsets for query selections)
          * @throws TextException if text error
          */
         virtual void indexText(
@@ -152,6 +191,22 @@ namespace kcc
             const TextDocument::MetadataFields& fields,
             TextDocument::Contents              contents) throw (TextException) = 0;
         virtual void indexText     (TextDocument& txtdoc, TextDocument::Contents contents = TextDocument::C_TEXT|TextDocument::C_METADATA) throw (TextException) = 0;
+
+        /**
+         * Bulk index batch of text into store. Documents are analyzed concurrently into
+         * in-memory segments (TextStore.bulkThreads) which are merged into the index every
+         * TextStore.bulkDocsPerMerge documents and on indexOptimize()/indexClose(); no per-document
+         * auto-optimization is performed. Documents are added to the index in call and batch order.
+         * A batch that fails is discarded whole; batches already pending are unaffected
+         * @param txtdocs batch of documents to index (see indexText)
+         * @param fields metadata field indexing
+         * @param contents document contents (see indexText)
+         * @throws TextException if text error
+         */
+        virtual void indexBulk(
+            const TextDocuments&                txtdocs,
+            const TextDocument::MetadataFields& fields,
+            TextDocument::Contents              contents) throw (TextException) = 0;
         virtual long indexDocuments() throw (TextException) = 0;
         virtual void indexOpen     () throw (TextException) = 0;
         virtual bool indexIsOpen   () throw (TextException) = 0;
@@ -0,0 +1,299 @@
+/*
+ * Kuumba C++ Core
+ *
+ * $Id$
+ */
+#ifndef TextQueryBinary_h
+#define TextQueryBinary_h
+
+#include <inc/store/ITextStore.h>
+
+namespace kcc
+{
+    /**
+     * Compact binary encoding of text query results (alternative to TextQueryXml,
+     * negotiated by the format=bin query parameter).
+     *
+     * ENCODING
+     *   magic     - "KTQ" + version byte
+     *   records   - tag byte followed by record fields, in the order of the XML elements
+     *               D: document (row, score, text, metadata, terms, matches)
+     *               S: status   (id, expression, contents, row, size, total, time, scale)
+     *   integers  - zig-zag varints (7 bits per byte, low bits first)
+     *   strings   - varint length followed by bytes
+     *   fractions - IEEE double, little-endian
+     *   maps      - varint count followed by key/value pairs
+     *
+     * Errors and messages are always returned as XML; use isBinary() to select a decoder.
+     *
+     * @author Ted V. Kremer
+     */
+    struct TextQueryBinary
+    {
+        /** Record tags */
+        enum Tag
+        {
+            T_END      = 0,
+            T_DOCUMENT = 'D',
+            T_STATUS   = 'S'
+        };
+
+        /** Query status record */
+        struct Status
+        {
+            String id;
+            String expression;
+            long   contents;
+            long   row;
+            long   size;
+            long   total;
+            double time;
+            double scale; // score scale (see ITextResults::scale)
+            Status() : contents(0L), row(-1L), size(0L), total(0L), time(0.0), scale(1.0) {}
+        };
+
+        /**
+         * Query if data is binary encoded
+         * @param data response data
+         * @return true if data begins with binary magic
+         */
+        static bool isBinary(const String& data)
+        {
+            return data.size() >= 4 && data.compare(0, 4, magic(), 4) == 0;
+        }
+
+        /** Accessor to binary content type */
+        static const String& contentType()
+        {
+            static const String k_contentType("application/x-kcc-textquery");
+            return k_contentType;
+        }
+
+        /**
+         * Binary results writer
+         */
+        class Writer
+        {
+        public:
+            /**
+             * Begin results
+             * @param out buffer to append encoding to (reserve for expected size)
+             */
+            Writer(String& out) : m_out(out) { m_out.append(magic(), 4); }
+
+            /** Write document record */
+            void document(long row, const TextDocument& doc)
+            {
+                m_out += (char)T_DOCUMENT;
+                integer(row);
+                fraction(doc.score);
+                string(doc.text);
+                integer((long)doc.metadata.size());
+                for (StringMap::const_iterator i = doc.metadata.begin(); i != doc.metadata.end(); i++)
+                {
+                    string(i->first);
+                    string(i->second);
+                }
+                integer((long)doc.terms.size());
+                for (TextDocument::Terms::const_iterator i = doc.terms.begin(); i != doc.terms.end(); i++)
+                {
+                    string(i->first);
+                    integer(i->second);
+                }
+                integer((long)doc.matches.size());
+                for (TextDocument::Matches::const_iterator i = doc.matches.begin(); i != doc.matches.end(); i++)
+                {
+                    integer(i->startOffset);
+                    integer(i->endOffset);
+                }
+            }
+
+            /** Write status record */
+            void status(const Status& s)
+            {
+                m_out += (char)T_STATUS;
+                string (s.id);
+                string (s.expression);
+                integer(s.contents);
+                integer(s.row);
+                integer(s.size);
+                integer(s.total);
+                fraction(s.time);
+                fraction(s.scale);
+            }
+
+        private:
+            Writer(const Writer&);
+            Writer& operator = (const Writer&);
+
+            // integer: zig-zag varint
+            void integer(long v)
+            {
+                unsigned long u = ((unsigned long)v << 1) ^ (unsigned long)(v >> (sizeof(long)*8 - 1));
+                while (u >= 0x80UL)
+                {
+                    m_out += (char)((u & 0x7fUL) | 0x80UL);
+                    u >>= 7;
+                }
+                m_out += (char)u;
+            }
+
+            // string: length prefixed
+            void string(const String& s)
+            {
+                integer((long)s.size());
+                m_out.append(s);
+            }
+
+            // fraction: little-endian IEEE double
+            void fraction(double d)
+            {
+                unsigned char b[sizeof(double)];
+                std::memcpy(b, &d, sizeof(double));
+                if (!littleEndian()) std::reverse(b, b + sizeof(double));
+                m_out.append((const char*)b, sizeof(double));
+            }
+
+            // Attributes
+            String& m_out;
+        };
+
+        /**
+         * Binary results reader
+         */
+        class Reader
+        {
+        public:
+            /**
+             * Begin reading results
+             * @param data binary encoded results (NOT copied, must outlive reader)
+             * @throws TextException if not binary encoded
+             */
+            Reader(const String& data) throw (TextException) :
+                m_pos(data.data() + 4), m_end(data.data() + data.size())
+            {
+                if (!isBinary(data)) throw TextException("text query results not binary encoded");
+            }
+
+            /**
+             * Read next record tag
+             * @return next tag or T_END
+             */
+            Tag next() throw (TextException)
+            {
+                if (m_pos == m_end) return T_END;
+                Tag t = (Tag)*m_pos++;
+                if (t != T_DOCUMENT && t != T_STATUS) throw TextException("text query results corrupted: unknown tag");
+                return t;
+            }
+
+            /** Read document record (following T_DOCUMENT) */
+            void document(long& row, TextDocument& doc) throw (TextException)
+            {
+                doc.clear();
+                row       = integer();
+                doc.score = fraction();
+                string(doc.text);
+                String k, v;
+                for (long n = count(); n > 0L; n--)
+                {
+                    string(k);
+                    string(v);
+                    doc.metadata[k] = v;
+                }
+                for (long n = count(); n > 0L; n--)
+                {
+                    string(k);
+                    doc.terms[k] = integer();
+                }
+                long n = count();
+                doc.matches.reserve(n);
+                for (; n > 0L; n--)
+                {
+                    long so = integer();
+                    long eo = integer();
+                    doc.matches.push_back(TextDocument::Match(so, eo));
+                }
+            }
+
+            /** Read status record (following T_STATUS) */
+            void status(Status& s) throw (TextException)
+            {
+                string(s.id);
+                string(s.expression);
+                s.contents = integer();
+                s.row      = integer();
+                s.size     = integer();
+                s.total    = integer();
+                s.time     = fraction();
+                s.scale    = fraction();
+            }
+
+        private:
+            Reader(const Reader&);
+            Reader& operator = (const Reader&);
+
+            // integer: zig-zag varint
+            long integer() throw (TextException)
+            {
+                unsigned long u = 0UL;
+                for (int shift = 0; ; shift += 7)
+                {
+                    if (m_pos == m_end || shift >= (int)sizeof(long)*8) throw TextException("text query results corrupted: integer");
+                    unsigned char b = (unsigned char)*m_pos++;
+                    u |= (unsigned long)(b & 0x7f) << shift;
+                    if ((b & 0x80) == 0) break;
+                }
+                return (long)(u >> 1) ^ -(long)(u & 1UL);
+            }
+
+            // count: collection size (bounded by remaining data)
+            long count() throw (TextException)
+            {
+                long n = integer();
+                if (n < 0L || n > (long)(m_end - m_pos)) throw TextException("text query results corrupted: count");
+                return n;
+            }
+
+            // string: length prefixed
+            void string(String& s) throw (TextException)
+            {
+                long n = count();
+                s.assign(m_pos, n);
+                m_pos += n;
+            }
+
+            // fraction: little-endian IEEE double
+            double fraction() throw (TextException)
+            {
+                if (m_end - m_pos < (long)sizeof(double)) throw TextException("text query results corrupted: fraction");
+                unsigned char b[sizeof(double)];
+                std::memcpy(b, m_pos, sizeof(double));
+                if (!littleEndian()) std::reverse(b, b + sizeof(double));
+                m_pos += sizeof(double);
+                double d;
+                std::memcpy(&d, b, sizeof(double));
+                return d;
+            }
+
+            // Attributes
+            const Char* m_pos;
+            const Char* m_end;
+        };
+
+        /** Accessor to encoding signature and version (4 bytes) */
+        static const Char* magic() { return "KTQ\x02"; }
+
+        /** Query host byte order */
+        static bool littleEndian()
+        {
+            const unsigned short one = 1;
+            return *(const unsigned char*)&one == 1;
+        }
+
+    private:
+        TextQueryBinary();
+    };
+}
+
+#endif // TextQueryBinary_h
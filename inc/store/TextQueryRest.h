@@ -43,6 +43,16 @@ namespace kcc
             static const String k_queryRow("row");
             return k_queryRow;
         }
+        static const String& queryFormat()
+        {
+            static const String k_queryFormat("format");
+            return k_queryFormat;
+        }
+        static const String& queryFormatBinary()
+        {
+            static const String k_queryFormatBinary("bin");
+            return k_queryFormatBinary;
+        }
         static const String& status()
         {
             static const String k_status("/status");
@@ -48,6 +48,106 @@ namespace kcc
             static const String k_rootExpire("expire");
             return k_rootExpire;
         }
+        static const String& rootActive()
+        {
+            static const String k_rootActive("active");
+            return k_rootActive;
+        }
+        static const String& rootExpired()
+        {
+            static const String k_rootExpired("expired");
+            return k_rootExpired;
+        }
+        static const String& rootExpirations()
+        {
+            static const String k_rootExpirations("expirations");
+            return k_rootExpirations;
+        }
+        static const String& rootEvictions()
+        {
+            static const String k_rootEvictions("evictions");
+            return k_rootEvictions;
+        }
+        static const String& rootRevives()
+        {
+            static const String k_rootRevives("revives");
+            return k_rootRevives;
+        }
+        static const String& rootMemInUse()
+        {
+            static const String k_rootMemInUse("memInUseKB");
+            return k_rootMemInUse;
+        }
+        static const String& rootCacheEntries()
+        {
+            static const String k_rootCacheEntries("cacheEntries");
+            return k_rootCacheEntries;
+        }
+        static const String& rootCacheMax()
+        {
+            static const String k_rootCacheMax("cacheMax");
+            return k_rootCacheMax;
+        }
+        static const String& rootCacheHits()
+        {
+            static const String k_rootCacheHits("cacheHits");
+            return k_rootCacheHits;
+        }
+        static const String& rootCacheMisses()
+        {
+            static const String k_rootCacheMisses("cacheMisses");
+            return k_rootCacheMisses;
+        }
+        static const String& rootCacheEvictions()
+        {
+            static const String k_rootCacheEvictions("cacheEvictions");
+            return k_rootCacheEvictions;
+        }
+        static const String& rootCacheInvalidations()
+        {
+            static const String k_rootCacheInvalidations("cacheInvalidations");
+            return k_rootCacheInvalidations;
+        }
+        static const String& rootGeneration()
+        {
+            static const String k_rootGeneration("generation");
+            return k_rootGeneration;
+        }
+        static const String& rootRegexCacheEntries()
+        {
+            static const String k_rootRegexCacheEntries("regexCacheEntries");
+            return k_rootRegexCacheEntries;
+        }
+        static const String& rootRegexCacheMax()
+        {
+            static const String k_rootRegexCacheMax("regexCacheMax");
+            return k_rootRegexCacheMax;
+        }
+        static const String& rootRegexCacheFrontHits()
+        {
+            static const String k_rootRegexCacheFrontHits("regexCacheFrontHits");
+            return k_rootRegexCacheFrontHits;
+        }
+        static const String& rootRegexCacheHits()
+        {
+            static const String k_rootRegexCacheHits("regexCacheHits");
+            return k_rootRegexCacheHits;
+        }
+        static const String& rootRegexCacheMisses()
+        {
+            static const String k_rootRegexCacheMisses("regexCacheMisses");
+            return k_rootRegexCacheMisses;
+        }
+        static const String& rootRegexCacheEvictions()
+        {
+            static const String k_rootRegexCacheEvictions("regexCacheEvictions");
+            return k_rootRegexCacheEvictions;
+        }
+        static const String& rootRegexCacheHitRatio()
+        {
+            static const String k_rootRegexCacheHitRatio("regexCacheHitRatio");
+            return k_rootRegexCacheHitRatio;
+        }
         static const String& rootMessage()
         {
             static const String k_rootMessage("message");
@@ -68,6 +168,11 @@ namespace kcc
             static const String k_documentRow("row");
             return k_documentRow;
         }
+        static const String& documentScore()
+        {
+            static const String k_documentScore("score");
+            return k_documentScore;
+        }
         static const String& text()
         {
             static const String k_text("Text");
@@ -153,6 +258,11 @@ namespace kcc
             static const String k_statusTotal("total");
             return k_statusTotal;
         }
+        static const String& statusScale()
+        {
+            static const String k_statusScale("scale");
+            return k_statusScale;
+        }
         static const String& statusAccessed()
         {
             static const String k_statusAccessed("accessed");
@@ -0,0 +1,120 @@
+/*
+ * Kuumba C++ Core
+ *
+ * $Id$
+ */
+#ifndef TextQueryXmlCodec_h
+#define TextQueryXmlCodec_h
+
+#include <inc/store/ITextStore.h>
+#include <inc/store/TextQueryXml.h>
+
+namespace kcc
+{
+    /**
+     * XML encoding of text query result documents (TextQueryXml elements), written by
+     * httptextquery and read by the text query client. See TextQueryBinary for the
+     * binary encoding.
+     *
+     * @author Ted V. Kremer
+     */
+    struct TextQueryXmlCodec
+    {
+        /**
+         * Write document element
+         * @param w writer positioned within the results root
+         * @param row row of document in results
+         * @param doc document to write (empty text is omitted)
+         */
+        static void document(DOMWriter& w, long row, const TextDocument& doc)
+        {
+            w.start(TextQueryXml::document());
+            w.attr(TextQueryXml::documentRow(),   Strings::printf("%d", row));
+            w.attr(TextQueryXml::documentScore(), Strings::printf("%.6g", doc.score));
+            if (!doc.text.empty())
+            {
+                w.start(TextQueryXml::text());
+                w.text(doc.text);
+                w.end(TextQueryXml::text());
+            }
+            for (StringMap::const_iterator i = doc.metadata.begin(); i != doc.metadata.end(); i++)
+            {
+                w.start(TextQueryXml::metadata());
+                w.attr(TextQueryXml::metadataKey(),   i->first);
+                w.attr(TextQueryXml::metadataValue(), i->second);
+                w.end(TextQueryXml::metadata());
+            }
+            for (TextDocument::Terms::const_iterator i = doc.terms.begin(); i != doc.terms.end(); i++)
+            {
+                w.start(TextQueryXml::term());
+                w.attr(TextQueryXml::termTerm(),      i->first);
+                w.attr(TextQueryXml::termFrequency(), Strings::printf("%d", i->second));
+                w.end(TextQueryXml::term());
+            }
+            for (TextDocument::Matches::const_iterator i = doc.matches.begin(); i != doc.matches.end(); i++)
+            {
+                w.start(TextQueryXml::match());
+                w.attr(TextQueryXml::matchStartOffset(), Strings::printf("%d", i->startOffset));
+                w.attr(TextQueryXml::matchEndOffset(),   Strings::printf("%d", i->endOffset));
+                w.end(TextQueryXml::match());
+            }
+            w.end(TextQueryXml::document());
+        }
+
+        /**
+         * Read document element
+         * @param r reader of results
+         * @param d document element
+         * @param doc output param where document is placed (cleared first)
+         */
+        static void document(DOMReader& r, const IDOMNode* d, TextDocument& doc) throw (Exception)
+        {
+            String k, v;
+            doc.clear();
+
+            // score
+            if (r.attrOp(d, TextQueryXml::documentScore(), v)) doc.score = Strings::parseFraction(v);
+
+            // text
+            const IDOMNode* txt = r.nodeOp(d, TextQueryXml::text());
+            if (txt != NULL) doc.text = r.text(txt);
+
+            // metadata
+            AutoPtr<IDOMNodeList> md(r.nodes(d, TextQueryXml::metadata()));
+            long mdsz = md->getLength();
+            for (long j = 0L; j < mdsz; j++)
+            {
+                const IDOMNode* m = md->getItem(j);
+                k = r.attr(m, TextQueryXml::metadataKey());
+                v.clear();
+                r.attrOp(m, TextQueryXml::metadataValue(), v);
+                doc.metadata[k] = v;
+            }
+
+            // terms
+            AutoPtr<IDOMNodeList> tfv(r.nodes(d, TextQueryXml::term()));
+            long tfvsz = tfv->getLength();
+            for (long j = 0L; j < tfvsz; j++)
+            {
+                const IDOMNode* t = tfv->getItem(j);
+                k = r.attr(t, TextQueryXml::termTerm());
+                v.clear();
+                r.attrOp(t, TextQueryXml::termFrequency(), v);
+                doc.terms[k] = Strings::parseInteger(v);
+            }
+
+            // matches
+            AutoPtr<IDOMNodeList> match(r.nodes(d, TextQueryXml::match()));
+            long matchsz = match->getLength();
+            for (long j = 0L; j < matchsz; j++)
+            {
+                const IDOMNode* m = match->getItem(j);
+                long so = Strings::parseInteger(r.attr(m, TextQueryXml::matchStartOffset()));
+                long eo = Strings::parseInteger(r.attr(m, TextQueryXml::matchEndOffset()));
+                doc.matches.push_back(TextDocument::Match(so, eo));
+            }
+        }
+    };
+}
+
+#endif // TextQueryXmlCodec_h
@@ -103,6 +103,16 @@ namespace kcc
          * @return zip writer instance
          */
         virtual IZipWriter* constructWriter() = 0;
+
+        /**
+         * Compress buffer in memory (same stream format as the writer)
+         * @param buf buffer to compress
+         * @param sz size of buffer
+         * @param out output param of compressed stream
+         * @param blocksz (1=fast, 9=best)
+         * @return true if compressed
+         */
+        virtual bool compress(const char* buf, int sz, String& out, int blocksz = 9) = 0;
     };
 }
 
@@ -29,7 +29,8 @@ namespace kcc
         ComponentLocators  m_locators;
         ComponentModules   m_modules;
         ComponentFactories m_factories;
-        Mutex              m_sentinel;
+        Mutex              m_sentinel;    // modules & locators (recursive: locators are components)
+        RWMutex            m_factoryLock; // factories (read-dominated; never held while calling out)
         ~ComponentsModuleState()
         {
             Mutex::Lock lock(m_sentinel);
@@ -75,11 +76,19 @@ namespace kcc
         {
             Mutex::Lock lock(m_sentinel);
             Log::Scope scope(KCC_FILE, "ComponentsModuleState::onUnbind");
-            ComponentFactories::iterator i = m_factories.find(module->definition().id);
-            if (i != m_factories.end()) 
+            IComponentFactory* f = NULL;
+            {
+                RWMutex::ExclusiveLock flock(m_factoryLock);
+                ComponentFactories::iterator i = m_factories.find(module->definition().id);
+                if (i != m_factories.end()) 
+                {
+                    f = i->second;
+                    m_factories.erase(i);
+                }
+            }
+            if (f != NULL)
             {
-                delete i->second;
-                m_factories.erase(i);
+                delete f;
             }
             else
             {
@@ -143,19 +152,25 @@ namespace kcc
         }
 
         // factory: accessor to factor (lazy creation & cached)
+        //  - cached factories are found under a shared lock; creation is serialized by the sentinel
         IComponentFactory* factory(const String& id)
             throw (ComponentModule::ComponentNotFound, ComponentModule::FactoryNotFound)
         {
+            {
+                RWMutex::SharedLock flock(m_factoryLock);
+                ComponentFactories::iterator i = m_factories.find(id);
+                if (i != m_factories.end()) return i->second;
+            }
             Mutex::Lock lock(m_sentinel);
             Log::Scope scope(KCC_FILE, "ComponentsModuleState::factory");
-            IComponentFactory* f = NULL;
-            ComponentFactories::iterator i = m_factories.find(id);
-            if (i != m_factories.end()) f = i->second;
-            else
             {
-                f = module(id).constructFactory();
-                m_factories[id] = f;
+                RWMutex::SharedLock flock(m_factoryLock);
+                ComponentFactories::iterator i = m_factories.find(id);
+                if (i != m_factories.end()) return i->second;
             }
+            IComponentFactory* f = module(id).constructFactory();
+            RWMutex::ExclusiveLock flock(m_factoryLock);
+            m_factories[id] = f;
             return f;
         }
 
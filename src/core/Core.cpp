@@ -21,11 +21,13 @@ namespace kcc
     static const String k_keyLocale   (KCC_CORE_LOCALE);
     static const String k_keyRODOM    (KCC_CORE_RODOM);
     static const String k_keyRegex    (KCC_CORE_REGEX);
+    static const String k_keyExecutor (KCC_CORE_EXECUTOR);
     static const String k_keyAppSCM   (KCC_APPLICATION_SCM);
     static const String k_keyAppDebug (KCC_APPLICATION_DEBUG);
     static const String k_defLocale   ("C");
     static const String k_defRODOM    ("k_rodom");
     static const String k_defRegex    ("k_regex");
+    static const long   k_defExecutor = 0L;
 
     //
     // SystemState implementation
@@ -36,7 +38,7 @@ namespace kcc
     {
         // ctor/dtor
         SystemState(const Properties& config, const Char* scm) : 
-            m_properties(config) 
+            m_closing(false), m_properties(config) 
         {
             // scm
             m_properties.set(k_keyAppSCM, scm);
@@ -51,7 +53,14 @@ namespace kcc
         }
         ~SystemState()
         {
+            // withdraw published states first so teardown (and any state used by a
+            // module state dtor) is located by name as before
             Mutex::Lock lock(m_sentinel);
+            m_closing = true;
+            for (PublishedModuleStates::iterator i = m_published.begin(); i != m_published.end(); i++)
+                AtomicPtr::store(*i, NULL);
+            m_published.clear();
+            m_executor.reset();
             m_rodom.reset();
             m_regex.reset();
             while (!m_moduleStates.empty())
@@ -80,6 +89,15 @@ namespace kcc
             m_namedModuleStates[n] = s;
         }
 
+        // module: publish module state to KCC_STATE fast path
+        void module(void* volatile* published, Core::ModuleState* s)
+        {
+            Mutex::Lock lock(m_sentinel);
+            if (m_closing) return;
+            m_published.insert(published);
+            AtomicPtr::store(published, s);
+        }
+
         // properties: accessor to properties
         Properties& properties() { return m_properties; }
 
@@ -107,16 +125,44 @@ namespace kcc
             return m_regex; 
         }
 
+        // executor: lazy creation of system executor
+        Executor& executor()
+        {
+            Mutex::Lock lock(m_sentinel);
+            if (m_executor == NULL)
+            {
+                long threads = Core::properties().get(k_keyExecutor, k_defExecutor);
+                m_executor = new Executor((int)threads, "CoreExecutor");
+            }
+            return *m_executor;
+        }
+
+        // shutdown: complete executor tasks while module states are still available
+        //  - not under the sentinel: tasks may use module states or submit tasks
+        void shutdown()
+        {
+            Executor* executor = NULL;
+            {
+                Mutex::Lock lock(m_sentinel);
+                executor = m_executor;
+            }
+            if (executor != NULL) executor->shutdown();
+        }
+
     private:
         // Attributes
         typedef std::map<String, Core::ModuleState*> NamedModuleState;
         typedef std::stack<Core::ModuleState*>       ModuleStates;
-        Mutex            m_sentinel;
-        NamedModuleState m_namedModuleStates;
-        ModuleStates     m_moduleStates;
+        typedef std::set<void* volatile*>            PublishedModuleStates;
+        Mutex                 m_sentinel;
+        bool                  m_closing;
+        NamedModuleState      m_namedModuleStates;
+        ModuleStates          m_moduleStates;
+        PublishedModuleStates m_published;
         Properties       m_properties;
         AutoPtr<IRODOM>  m_rodom;
         AutoPtr<IRegex>  m_regex;
+        AutoPtr<Executor> m_executor;
     };
 
     //
@@ -190,6 +236,7 @@ namespace kcc
             #endif
 
             // clean-up system root
+            m_state->shutdown();
             delete m_state;
             m_state = NULL;
 
@@ -243,7 +290,9 @@ namespace kcc
     const Properties& Core::properties()            { return k_system.state().properties(); }
     IRODOM* Core::rodom() throw (Exception)         { return k_system.state().rodom(); }
     IRegex* Core::regex() throw (Exception)         { return k_system.state().regex(); }
+    Executor& Core::executor()                      { return k_system.state().executor(); }
     Mutex& Core::sentinel()                         { return k_system.state().sentinel(); }
     Core::ModuleState* Core::state(const Char* n)   { return k_system.state().module(n); }
     void Core::state(const Char* n, ModuleState* s) { k_system.state().module(n, s); }
+    void Core::state(void* volatile* p, ModuleState* s) { k_system.state().module(p, s); }
 }
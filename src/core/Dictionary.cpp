@@ -9,6 +9,206 @@
 
 namespace kcc
 {
+    // Constants
+    static const long              k_minSlots   = 32L; // initial index size (power of 2)
+    static const StringIndex::Hash k_fnvBasis   = 2166136261UL;
+    static const StringIndex::Hash k_fnvPrime   = 16777619UL;
+
+    // k_fold: ascii case fold (HTTP header names are ascii)
+    static inline unsigned char k_fold(unsigned char c) { return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c; }
+
+    //
+    // StringIndex implementation
+    //
+
+    // hash: FNV-1a hash of key (32-bit)
+    StringIndex::Hash StringIndex::hash(const String& key, Keys keys)
+    {
+        Hash h = k_fnvBasis;
+        const unsigned char* c   = (const unsigned char*)key.data();
+        const unsigned char* end = c + key.size();
+        if (keys == K_NOCASE) for (; c != end; c++) h = ((h ^ k_fold(*c)) * k_fnvPrime) & 0xffffffffUL;
+        else                  for (; c != end; c++) h = ((h ^ *c)         * k_fnvPrime) & 0xffffffffUL;
+        return h;
+    }
+
+    // equals: compare keys
+    bool StringIndex::equals(const String& lhs, const String& rhs) const
+    {
+        if (lhs.size() != rhs.size()) return false;
+        if (m_keys == K_EXACT) return lhs == rhs;
+        const unsigned char* l = (const unsigned char*)lhs.data();
+        const unsigned char* r = (const unsigned char*)rhs.data();
+        for (String::size_type i = 0; i < lhs.size(); i++)
+        {
+            if (k_fold(l[i]) != k_fold(r[i])) return false;
+        }
+        return true;
+    }
+
+    // find: probe for entry of key
+    StringIndex::Entry* StringIndex::find(const String& key, Hash h)
+    {
+        return const_cast<Entry*>(static_cast<const StringIndex*>(this)->find(key, h));
+    }
+    const StringIndex::Entry* StringIndex::find(const String& key, Hash h) const
+    {
+        if (m_used == 0L) return NULL;
+        long mask = (long)m_slots.size() - 1L;
+        for (long i = (long)(h & mask); ; i = (i + 1L) & mask)
+        {
+            const Entry& e = m_slots[i];
+            if (e.count == 0L) return NULL;
+            if (e.hash == h && equals(e.first->first, key)) return &e;
+        }
+    }
+
+    // insert: index pair as only pair of key (at most half full)
+    StringIndex::Entry& StringIndex::insert(Hash h, StringPairs::iterator pos)
+    {
+        if ((m_used + 1L) * 2L > (long)m_slots.size()) grow();
+        Entry e = { h, pos, pos, 1L };
+        return place(e);
+    }
+
+    // place: probe for free slot of entry
+    StringIndex::Entry& StringIndex::place(const Entry& entry)
+    {
+        long mask = (long)m_slots.size() - 1L;
+        long i    = (long)(entry.hash & mask);
+        while (m_slots[i].count != 0L) i = (i + 1L) & mask;
+        m_slots[i] = entry;
+        m_used++;
+        return m_slots[i];
+    }
+
+    // erase: empty slot of entry, shifting back later entries of its probe run
+    void StringIndex::erase(Entry& entry)
+    {
+        long mask = (long)m_slots.size() - 1L;
+        long i    = (long)(&entry - &m_slots[0]);
+        for (long j = (i + 1L) & mask; m_slots[j].count != 0L; j = (j + 1L) & mask)
+        {
+            // leave entry at j if its home slot is cyclically within (i, j]
+            long home = (long)(m_slots[j].hash & mask);
+            if (i <= j ? (i < home && home <= j) : (i < home || home <= j)) continue;
+            m_slots[i] = m_slots[j];
+            i = j;
+        }
+        m_slots[i].count = 0L;
+        m_used--;
+    }
+
+    // grow: double slots, re-probing indexed entries
+    void StringIndex::grow()
+    {
+        Slots slots;
+        slots.swap(m_slots);
+        Entry empty = { 0UL, StringPairs::iterator(), StringPairs::iterator(), 0L };
+        m_slots.assign(slots.empty() ? k_minSlots : slots.size() * 2, empty);
+        m_used = 0L;
+        for (Slots::iterator s = slots.begin(); s != slots.end(); s++)
+        {
+            if (s->count != 0L) place(*s);
+        }
+    }
+
+    // rebuild: re-index runs of pairs of each key
+    void StringIndex::rebuild(StringPairs& pairs, Keys keys)
+    {
+        clear();
+        m_keys = keys;
+        Entry* e = NULL;
+        for (StringPairs::iterator i = pairs.begin(); i != pairs.end(); i++)
+        {
+            if (e != NULL && equals(e->first->first, i->first))
+            {
+                e->last = i;
+                e->count++;
+                continue;
+            }
+            e = &insert(hash(i->first), i);
+        }
+    }
+
+    // clear: clear slots
+    void StringIndex::clear()
+    {
+        if (m_used == 0L) return;
+        Entry empty = { 0UL, StringPairs::iterator(), StringPairs::iterator(), 0L };
+        std::fill(m_slots.begin(), m_slots.end(), empty);
+        m_used = 0L;
+    }
+
+    //
+    // Dictionary implementation
+    //
+
+    // insert: insert pair after existing pairs of key
+    Dictionary::iterator Dictionary::insert(const value_type& value)
+    {
+        StringIndex::Hash   h = m_index.hash(value.first);
+        StringIndex::Entry* e = m_index.find(value.first, h);
+        if (e == NULL)
+        {
+            m_pairs.push_back(value);
+            return m_index.insert(h, --m_pairs.end()).first;
+        }
+        StringPairs::iterator last = e->last;
+        e->last = m_pairs.insert(++last, value);
+        e->count++;
+        return e->last;
+    }
+
+    // erase: erase pair
+    void Dictionary::erase(iterator i)
+    {
+        StringIndex::Entry* e = m_index.find(i->first, m_index.hash(i->first));
+        if (e->count == 1L)       m_index.erase(*e);
+        else
+        {
+            if      (i == e->first) e->first++;
+            else if (i == e->last)  e->last--;
+            e->count--;
+        }
+        m_pairs.erase(i);
+    }
+
+    // erase: erase pairs of key
+    Dictionary::size_type Dictionary::erase(const String& key)
+    {
+        StringIndex::Entry* e = m_index.find(key, m_index.hash(key));
+        if (e == NULL) return 0;
+        StringPairs::iterator first = e->first, end = e->last;
+        size_type             count = (size_type)e->count;
+        m_index.erase(*e);
+        m_pairs.erase(first, ++end);
+        return count;
+    }
+
+    // count: count pairs of key
+    Dictionary::size_type Dictionary::count(const String& key) const
+    {
+        const StringIndex::Entry* e = m_index.find(key, m_index.hash(key));
+        return e == NULL ? 0 : (size_type)e->count;
+    }
+
+    // finder: bounds of pairs of key
+    DictionaryFinder Dictionary::finder(const String& key)
+    {
+        StringIndex::Entry* e = m_index.find(key, m_index.hash(key));
+        if (e == NULL) return DictionaryFinder(m_pairs.end(), m_pairs.end());
+        StringPairs::iterator end = e->last;
+        return DictionaryFinder(e->first, ++end);
+    }
+    DictionaryFinderConst Dictionary::finder(const String& key) const
+    {
+        const StringIndex::Entry* e = m_index.find(key, m_index.hash(key));
+        if (e == NULL) return DictionaryFinderConst(m_pairs.end(), m_pairs.end());
+        StringPairs::const_iterator end = e->last;
+        return DictionaryFinderConst(e->first, ++end);
+    }
+
     // empty: empty properties object
     const Dictionary& Dictionary::empty()
     {
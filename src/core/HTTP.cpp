@@ -13,21 +13,23 @@ namespace kcc
     static const String::size_type k_szPacket           = 1024*4;       //   4kb max
     static const String::size_type k_szMaxHeader        = 1024*256;     // 256kb max
     static const String::size_type k_szMaxContent       = 1024*1024*64; //  64mb max
-    static const int               k_packetRetries      = 8;
     static const String            k_schemeHTTP         = "http";
     static const String            k_schemeFile         = "file";
     static const String            k_sepHeader          (" ");
     static const String            k_sepQuery           ("?");
     static const String            k_sepAttr            (": ");
+    static const char              k_sepName            = ':';
+    static const char*             k_ows                = " \t"; // optional white space
     static const int               k_httpPort           = 80;
     static const String            k_httpEOL            ("\r\n");
+    static const String            k_httpEOH            ("\r\n\r\n");
     static const String            k_httpGet            ("GET");
     static const String            k_httpPut            ("PUT");
     static const String            k_httpPost           ("POST");
     static const String            k_httpDelete         ("DELETE");
     static const String            k_httpAccept         ("Accept");
-    static const String            k_httpContentType    ("Content-Type");
-    static const String            k_httpContentLength  ("Content-Length");
+    static const Dictionary::Key   k_httpContentType    ("Content-Type");
+    static const Dictionary::Key   k_httpContentLength  ("Content-Length");
     static const String            k_httpContentTypeXml ("text/xml");
     static const String            k_httpContentTypeForm("application/x-www-form-urlencoded");
     static const String            k_httpLastModified   ("Last-Modified");
@@ -36,19 +38,129 @@ namespace kcc
     static const String            k_httpPragma         ("Pragma");
     static const String            k_httpNoCache        ("no-cache");
     static const String            k_httpCookieSet      ("Set-Cookie");
-    static const String            k_httpCookieGet      ("Cookie");
+    static const Dictionary::Key   k_httpCookieGet      ("Cookie");
     static const String            k_httpParamSep       (";");
     static const String            k_httpParamVal       ("=");
     static const String            k_httpCookieAV       ("; Expires=%s; Path=%s");
+    static const Dictionary::Key   k_httpConnection     ("Connection");
+    static const String            k_httpKeepAlive      ("keep-alive");
+    static const String            k_httpClose          ("close");
+    static const Dictionary::Key   k_httpTransferEncoding("Transfer-Encoding");
+    static const String            k_httpChunked        ("chunked");
+    static const String            k_httpVersion        ("HTTP/");
+    static const String            k_httpVersion11      ("HTTP/1.1");
     static const String            k_httpResponse(
-        "HTTP/1.0 %d OK\r\n"
+        "HTTP/1.1 %d OK\r\n"
         "Date: %s\r\n"
         "Server: KCC/1.0.0\r\n"
-        "Content-Length: %d\r\n");  // EOL added after headers appended
+        "Connection: %s\r\n");      // framing & EOL added after headers appended
+    static const String            k_httpLength         ("Content-Length: %d\r\n");
+    static const String            k_httpChunkedLength  ("Transfer-Encoding: chunked\r\n");
     static const String k_httpDispatch(
-        " HTTP/1.0\r\n"
+        " HTTP/1.1\r\n"
         "Date: %s\r\n"
-        "Host: %s:%d\r\n");         // EOL added after headers appended
+        "Host: %s:%d\r\n"
+        "Connection: %s\r\n");      // EOL added after headers appended
+
+    static const String            k_keyPoolMax         (KCC_HTTP_POOLMAX);
+    static const String            k_keyPoolIdle        (KCC_HTTP_POOLIDLE);
+    static const long              k_defPoolMax         = 8L;  // idle connections per host:port
+    static const long              k_defPoolIdle        = 10L; // secs (less than server keep-alive idle)
+
+    // Module state: pool of persisted client connections by host:port
+    struct HTTPModuleState : Core::ModuleState
+    {
+        struct Connection
+        {
+            Socket*     client;
+            long        requests;
+            std::time_t accessed;
+        };
+        typedef std::deque<Connection>        Connections;
+        typedef std::map<String, Connections> Hosts;
+        HTTPModuleState() : 
+            m_max(Core::properties().get(k_keyPoolMax, k_defPoolMax)), 
+            m_idle(Core::properties().get(k_keyPoolIdle, k_defPoolIdle)),
+            m_swept(0)
+        {}
+        ~HTTPModuleState()
+        {
+            for (Hosts::iterator h = m_hosts.begin(); h != m_hosts.end(); h++)
+                for (Connections::iterator c = h->second.begin(); c != h->second.end(); c++) delete c->client;
+        }
+
+        // acquire: move most recently used live connection to host into client
+        bool acquire(const String& host, int port, Socket& client, long& requests)
+        {
+            Socket* pooled = NULL;
+            {
+                Mutex::Lock lock(m_sentinel);
+                Hosts::iterator h = m_hosts.find(Strings::printf("%s:%d", host.c_str(), port));
+                if (h == m_hosts.end()) return false;
+                std::time_t now = std::time(NULL);
+                Connections& connections = h->second;
+                while (pooled == NULL && !connections.empty())
+                {
+                    Connection c = connections.back();
+                    connections.pop_back();
+                    if ((long)(now - c.accessed) <= m_idle && c.client->idle())
+                    {
+                        pooled   = c.client;
+                        requests = c.requests;
+                    }
+                    else delete c.client; // expired or closed by peer
+                }
+            }
+            if (pooled == NULL) return false;
+            client.swap(*pooled);
+            delete pooled;
+            return true;
+        }
+
+        // release: move connection from client into pool, evicting expired and oldest over limit
+        void release(Socket& client, long requests)
+        {
+            if (m_max <= 0L)
+            {
+                client.close();
+                return;
+            }
+            Connection c = { new Socket(), requests, std::time(NULL) };
+            c.client->swap(client);
+            Mutex::Lock lock(m_sentinel);
+            if (c.accessed != m_swept) sweep(c.accessed);
+            Connections& connections = m_hosts[Strings::printf("%s:%d", c.client->host().c_str(), c.client->port())];
+            if ((long)connections.size() >= m_max)
+            {
+                delete connections.front().client;
+                connections.pop_front();
+            }
+            connections.push_back(c);
+        }
+
+    private:
+        // sweep: close connections idle past limit (at most once a sec)
+        void sweep(std::time_t now)
+        {
+            m_swept = now;
+            for (Hosts::iterator h = m_hosts.begin(); h != m_hosts.end(); h++)
+            {
+                Connections& connections = h->second;
+                while (!connections.empty() && (long)(now - connections.front().accessed) > m_idle)
+                {
+                    delete connections.front().client;
+                    connections.pop_front();
+                }
+            }
+        }
+
+        // Attributes
+        long        m_max;
+        long        m_idle;
+        std::time_t m_swept;
+        Mutex       m_sentinel;
+        Hosts       m_hosts;
+    };
 
     //
     // HTTP implementation
@@ -65,7 +177,8 @@ namespace kcc
         Socket& client,
         const URL& url, 
         const String& method, 
-        const Dictionary& headers) throw (Socket::Failed)
+        const Dictionary& headers,
+        bool keepAlive) throw (Socket::Failed)
     {
         Log::Scope scope(KCC_FILE, "dispatch");
 
@@ -74,52 +187,70 @@ namespace kcc
         String uri = url.path;
         if (!url.query.empty()) uri += k_sepQuery + url.query;
         String header;
-        header.reserve(k_szMaxHeader);
+        header.reserve(k_szPacket);
         header += method + " " + uri;
-        header += Strings::printf(k_httpDispatch.c_str(), ISODate::utc().gmtdatetime().c_str(), url.host.c_str(), port);
+        header += Strings::printf(
+            k_httpDispatch.c_str(), ISODate::utc().gmtdatetime().c_str(), url.host.c_str(), port, 
+            (keepAlive ? k_httpKeepAlive : k_httpClose).c_str());
         for (Dictionary::const_iterator i = headers.begin(); i != headers.end(); i++) 
             header += i->first + k_sepAttr + i->second + k_httpEOL;
         header += k_httpEOL;
 
-        // send dispatch
-        client.connect(url.host, port);
+        // send dispatch (connecting unless connection persisted, persisted connections
+        // disable coalescing so responses aren't held for delayed acks of prior writes)
+        if (!client.connected()) 
+        {
+            client.connect(url.host, port);
+            if (keepAlive) client.setOption(Socket::O_NODELAY, 1);
+        }
         client.write(header);
     }
     
-    // request: fetch http request header from client socket
-    void HTTP::request(Socket& client, HTTPRequest& request) throw (Socket::Failed)
+    // k_requestParse: parse request header prologue and attributes, returning query
+    static String k_requestParse(const StringVector& headers, HTTPRequest& request) throw (Socket::Failed)
     {
-        Log::Scope scope(KCC_FILE, "request");
-
-        // client
-        request.ip   = client.ip();
-        request.port = client.port();
-        Dictionary& attrs  = request.attributes;
-        Dictionary& params = request.parameters;
-
-        // request raw header
-        int size = 0;
-        StringVector headers;
-        HTTP::requestHeaders(client, headers, size);
-
         // header prologue: method, query, uri
         StringVector prologue;
         Strings::tokenize(headers.at(0), k_sepHeader, prologue);
         if (prologue.size() < 2) throw Socket::Failed("can't parse http method header");
         request.method = prologue.at(0);
+        if (request.method.compare(0, k_httpVersion.size(), k_httpVersion) == 0) request.version = request.method; // response
+        else if (prologue.size() > 2)                                             request.version = prologue.at(2);
         String uri = prologue.at(1);
         String::size_type querySep = uri.find(k_sepQuery);
         String            query;
         if (querySep != String::npos) query = uri.substr(querySep + 1);
         request.path = uri.substr(0, querySep);
 
-        // request attrs
+        // request attrs (value follows optional white space)
+        Dictionary& attrs = request.attributes;
         for (StringVector::size_type i = 1; i < headers.size(); i++)
         {
             const String& line = headers.at(i);
-            String::size_type sep = line.find(k_sepAttr);
-            if (sep != String::npos) attrs(line.substr(0, sep)) = line.substr(sep+2); // do not decode attr's
+            String::size_type sep = line.find(k_sepName);
+            if (sep == String::npos) continue;
+            String::size_type value = line.find_first_not_of(k_ows, sep + 1);
+            attrs(line.substr(0, sep)) = value == String::npos ? String() : line.substr(value); // do not decode attr's
         }
+        return query;
+    }
+
+    // request: fetch http request header from client socket
+    void HTTP::request(Socket& client, HTTPRequest& request) throw (Socket::Failed)
+    {
+        Log::Scope scope(KCC_FILE, "request");
+
+        // client
+        request.ip   = client.ip();
+        request.port = client.port();
+        Dictionary& attrs  = request.attributes;
+        Dictionary& params = request.parameters;
+
+        // request raw header
+        int size = 0;
+        StringVector headers;
+        HTTP::requestHeaders(client, headers, size);
+        String query(k_requestParse(headers, request));
 
         // form params
         if (request.method == k_httpPost && attrs[k_httpContentType] == k_httpContentTypeForm)
@@ -133,45 +264,110 @@ namespace kcc
         URL::parameters(query, params, false);
     }
 
-    // requestHeaders: retrieve raw http request headers
+    // request: parse http request header already read from client
+    void HTTP::request(const String& header, const String& content, HTTPRequest& request) throw (Socket::Failed)
+    {
+        Log::Scope scope(KCC_FILE, "request");
+        HTTP::requestParameters(HTTP::requestHeader(header, request), content, request);
+    }
+
+    // requestHeader: parse http request header already read from client (but not its parameters)
+    String HTTP::requestHeader(const String& header, HTTPRequest& request) throw (Socket::Failed)
+    {
+        StringVector headers;
+        Strings::tokenize(header, k_httpEOL, headers);
+        if (headers.size() == 0) throw Socket::Failed("http header empty");
+        return k_requestParse(headers, request);
+    }
+
+    // requestParameters: parse form & query params of parsed request header
+    void HTTP::requestParameters(const String& query, const String& content, HTTPRequest& request)
+    {
+        // form params
+        Dictionary& params = request.parameters;
+        if (request.method == k_httpPost && request.attributes[k_httpContentType] == k_httpContentTypeForm)
+            URL::parameters(content, params, false);
+
+        // query params
+        URL::parameters(query, params, false);
+    }
+
+    // keepAlive: query if connection persists (HTTP/1.1 unless closed, HTTP/1.0 only if kept alive)
+    bool HTTP::keepAlive(const HTTPRequest& request)
+    {
+        String connection(Strings::toLower(request.attributes[k_httpConnection]));
+        if (connection == k_httpClose)     return false;
+        if (connection == k_httpKeepAlive) return true;
+        return request.version == k_httpVersion11;
+    }
+
+    // contentLength: query content framing
+    long HTTP::contentLength(const Dictionary& attrs)
+    {
+        if (Strings::toLower(attrs[k_httpTransferEncoding]).find(k_httpChunked) != String::npos) return F_CHUNKED;
+        const String& length = attrs[k_httpContentLength];
+        return length.empty() ? F_CLOSE : Strings::parseInteger(length);
+    }
+
+    // dechunk: decode chunked content from buffer, resuming from state
+    String::size_type HTTP::dechunk(const String& data, String::size_type offset, Chunked& state, String& decoded) throw (Socket::Failed)
+    {
+        if (state.pos < offset) state.pos = offset;
+        while (!state.trailers)
+        {
+            // chunk size line (extensions ignored)
+            String::size_type eol = data.find(k_httpEOL, state.pos);
+            if (eol == String::npos) return String::npos;
+            char* end = NULL;
+            long  sz  = std::strtol(data.c_str() + state.pos, &end, 16);
+            if (end == data.c_str() + state.pos || sz < 0L) throw Socket::Failed("malformed http chunk");
+            if (decoded.size() + sz > k_szMaxContent) throw Socket::Failed(Strings::printf("maximum content size exceeded: max=[%d]", k_szMaxContent));
+            String::size_type pos = eol + k_httpEOL.size();
+            if (sz == 0L)
+            {
+                state.pos      = pos;
+                state.trailers = true;
+                break;
+            }
+
+            // chunk data & EOL
+            if (data.size() < pos + sz + k_httpEOL.size()) return String::npos;
+            decoded.append(data, pos, sz);
+            state.pos = pos + sz + k_httpEOL.size();
+        }
+
+        // trailers until empty line
+        while (true)
+        {
+            String::size_type eol = data.find(k_httpEOL, state.pos);
+            if (eol == String::npos) return String::npos;
+            bool empty = eol == state.pos;
+            state.pos = eol + k_httpEOL.size();
+            if (empty) break;
+        }
+        return state.pos - offset;
+    }
+
+    // requestHeaders: retrieve raw http request headers (content read past header remains buffered)
     void HTTP::requestHeaders(Socket& client, StringVector& headers, int& total) throw (Socket::Failed)
     {
-        Log::Scope scope(KCC_FILE, "requestHeaders");
         headers.clear();
         String requestRaw;
-        requestRaw.reserve(k_szPacket);
         total = 0;
-        bool eof      = false;
-        char buf[2]   = { 0, 0 };
-        int  szEOF    = (int)k_httpEOL.size()*2;
-        int  attempts = 0;
-        int  actual   = 0;
-        int  max      = (int)k_szMaxHeader;
-        client.read(buf, 1, actual);
-        total += actual;
-        while (total < max)
+        try
         {
-            requestRaw += buf;
-            if (
-                total >= szEOF &&
-                requestRaw[total-1] == k_httpEOL[1] &&
-                requestRaw[total-2] == k_httpEOL[0] &&
-                requestRaw[total-3] == k_httpEOL[1] &&
-                requestRaw[total-4] == k_httpEOL[0])
+            if (!client.readThrough(k_httpEOH, requestRaw, (int)k_szMaxHeader))
             {
-                eof = true;
-                break; // packet EOF == EOL+EOL
+                if (client.buffered() == 0) throw Socket::Failed("http request header not received");
+                else                        throw Socket::Failed("http header not read; socket connection broken");
             }
-            client.read(buf, 1, actual);
-            total += actual;
-            if (actual == 0) attempts++;
-            if (attempts > k_packetRetries) throw Socket::Failed("http request header not received");
         }
-        if (!eof) 
+        catch (Socket::Failed& e)
         {
-            if (total < max) throw Socket::Failed("http header not read; socket connection broken");
-            else             throw Socket::Failed("http header too large");
+            if (client.buffered() > (int)k_szMaxHeader) throw Socket::Failed("http header too large");
+            throw;
         }
+        total = (int)requestRaw.size();
         Strings::tokenize(requestRaw, k_httpEOL, headers);
         if (headers.size() == 0) throw Socket::Failed("http header empty");
     }
@@ -201,52 +397,117 @@ namespace kcc
         }
     }
 
-    // content: fetch HTTP text content from client
+    // chunk: write chunk using chunked transfer encoding
+    void HTTP::chunk(Socket& client, const char* buf, int sz) throw (Socket::Failed)
+    {
+        if (sz <= 0)
+        {
+            client.write("0\r\n\r\n", 5);
+            return;
+        }
+        client.write(Strings::printf("%x\r\n", sz));
+        client.write(buf, sz);
+        client.write(k_httpEOL);
+    }
+
+    // k_contentLine: read EOL terminated line of chunked content framing
+    static String k_contentLine(Socket& client) throw (Socket::Failed)
+    {
+        String line;
+        if (!client.readThrough(k_httpEOL, line, (int)k_szPacket)) throw Socket::Failed("http chunk not received; socket connection broken");
+        line.resize(line.size() - k_httpEOL.size());
+        return line;
+    }
+
+    // k_contentRead: read sz bytes of content directly into data (binary safe)
+    static void k_contentRead(Socket& client, String& data, String::size_type sz) throw (Socket::Failed)
+    {
+        String::size_type offset = data.size();
+        int actual = 0;
+        data.resize(offset + sz);
+        if (sz > 0) client.readFully(&data[offset], (int)sz, actual);
+        data.resize(offset + actual);
+    }
+
+    // content: fetch HTTP content from client
     void HTTP::content(Socket& client, const Dictionary& attrs, String& data) throw (Socket::Failed)
     {
         Log::Scope scope(KCC_FILE, "content");
         data.clear();
-        String::size_type sz = 0;
-        const String& length = attrs[k_httpContentLength];
-        if (length.empty())
+        long length = HTTP::contentLength(attrs);
+        if (length == F_CHUNKED)
         {
-            sz = k_szMaxContent;
-            data.reserve(k_szPacket);
+            // chunks until zero length chunk, then trailers until empty line
+            while (true)
+            {
+                String::size_type sz = (String::size_type)std::strtol(k_contentLine(client).c_str(), NULL, 16);
+                if (sz == 0) break;
+                if (data.size() + sz > k_szMaxContent) throw Socket::Failed(Strings::printf("maximum content size exceeded: max=[%d] sz=[%d]", k_szMaxContent, data.size() + sz));
+                k_contentRead(client, data, sz);
+                k_contentLine(client);
+            }
+            while (!k_contentLine(client).empty());
+        }
+        else if (length == F_CLOSE)
+        {
+            // read until connection closed
+            String::size_type sz = 0;
+            do
+            {
+                sz = data.size();
+                k_contentRead(client, data, k_szPacket);
+            } while (data.size() == sz + k_szPacket && data.size() < k_szMaxContent);
         }
         else
         {
-            sz = Strings::parseInteger(length);
+            // read content length
+            String::size_type sz = (String::size_type)length;
             if (sz > k_szMaxContent) throw Socket::Failed(Strings::printf("maximum content size exceeded: max=[%d] sz=[%d]", k_szMaxContent, sz));
-            data.reserve(sz);
+            k_contentRead(client, data, sz);
         }
-        char buf[k_szPacket+1]; // +1 for null
-        int actual = 0;
-        String::size_type total = 0;
-        do
-        {
-            client.read(buf, k_szPacket, actual);
-            if (actual > 0)
-            {
-                total += actual;
-                buf[actual] = 0;
-                data += buf;
-            }
-        } while (actual > 0 && total < sz);
     }
 
     // response: send HTTP response header
-    void HTTP::response(Socket& client, const Dictionary& headers, int len, int response) throw (Socket::Failed)
+    void HTTP::response(Socket& client, const Dictionary& headers, int len, int response, bool keepAlive) throw (Socket::Failed)
     {
         Log::Scope scope(KCC_FILE, "response");
         String header;
-        header.reserve(k_szMaxHeader);
-        header += Strings::printf(k_httpResponse.c_str(), response, ISODate::utc().gmtdatetime().c_str(), len);
+        header.reserve(k_szPacket);
+        header += Strings::printf(
+            k_httpResponse.c_str(), response, ISODate::utc().gmtdatetime().c_str(), 
+            (keepAlive ? k_httpKeepAlive : k_httpClose).c_str());
+        if      (len >= 0)         header += Strings::printf(k_httpLength.c_str(), len);
+        else if (len == F_CHUNKED) header += k_httpChunkedLength;
         for (Dictionary::const_iterator i = headers.begin(); i != headers.end(); i++) 
             header += i->first + k_sepAttr + i->second + k_httpEOL;
         header += k_httpEOL;
         client.write(header);
     }
 
+    // k_exchange: send dispatch and read response header, retrying once on a new connection
+    // when a pooled connection was closed by the peer while idle (idempotent methods only:
+    // a POST/PUT the peer received before failing must not be applied twice)
+    static int k_exchange(
+        HTTPDispatch& dispatch, const URL& url, const String& method, 
+        const Dictionary& headers, const String* data, HTTPRequest& request) throw (Socket::Failed)
+    {
+        try
+        {
+            dispatch.send(url, method, headers);
+            if (data != NULL) dispatch.write(*data);
+            return dispatch.response(request);
+        }
+        catch (Socket::Failed&)
+        {
+            if (!dispatch.pooled() || (method != HTTP::GET() && method != HTTP::DELETE())) throw;
+            Log::info3("pooled connection closed by peer, retrying: host=[%s]", url.host.c_str());
+            dispatch.close();
+        }
+        dispatch.send(url, method, headers);
+        if (data != NULL) dispatch.write(*data);
+        return dispatch.response(request);
+    }
+
     // getxml: get XML contents using HTTP/GET
     int HTTP::getxml(const URL& url, String& receivedXml) throw (Socket::Failed)
     {
@@ -261,9 +522,8 @@ namespace kcc
             Dictionary headers;
             headers(k_httpAccept) = k_httpContentTypeXml;
             HTTPDispatch dispatch;
-            dispatch.send(url, HTTP::GET(), headers);
             HTTPRequest request;
-            code = dispatch.response(request);
+            code = k_exchange(dispatch, url, HTTP::GET(), headers, NULL, request);
             if (code == HTTP::C_OK) dispatch.content(request.attributes, receivedXml);
         }
         return code;
@@ -276,10 +536,8 @@ namespace kcc
         Dictionary headers;
         headers(k_httpContentLength) = Strings::printf("%d", sendXml.size());
         HTTPDispatch dispatch;
-        dispatch.send(url, HTTP::PUT(), headers);
-        dispatch.write(sendXml);
         HTTPRequest request;
-        return dispatch.response(request);
+        return k_exchange(dispatch, url, HTTP::PUT(), headers, &sendXml, request);
     }
 
     // postxml: dispatch XML contents using HTTP/POST
@@ -290,10 +548,8 @@ namespace kcc
         headers(k_httpAccept)        = k_httpContentTypeXml;
         headers(k_httpContentLength) = Strings::printf("%d", sendXml.size());
         HTTPDispatch dispatch;
-        dispatch.send(url, HTTP::POST(), headers);
-        dispatch.write(sendXml);
         HTTPRequest request;
-        int code = dispatch.response(request);
+        int code = k_exchange(dispatch, url, HTTP::POST(), headers, &sendXml, request);
         if (code == HTTP::C_OK) dispatch.content(request.attributes, receivedXml);
         return code;
     }
@@ -303,9 +559,8 @@ namespace kcc
     {
         Log::Scope scope(KCC_FILE, "deletexml");
         HTTPDispatch dispatch;
-        dispatch.send(url, HTTP::DELETE());
         HTTPRequest request;
-        return dispatch.response(request);
+        return k_exchange(dispatch, url, HTTP::DELETE(), Dictionary::empty(), NULL, request);
     }
 
     // setHeaders: set http headers
@@ -371,4 +626,100 @@ namespace kcc
         }
         return true;
     }
+
+    //
+    // HTTPDispatch implementation
+    //
+
+    // HTTPDispatch: construct dispatch
+    HTTPDispatch::HTTPDispatch(long maxRequests, long idleSec) 
+        : 
+        m_maxRequests(maxRequests), 
+        m_idleSec(idleSec), 
+        m_requests(0L), 
+        m_outstanding(0L), 
+        m_keepAlive(false), 
+        m_unread(false),
+        m_pooled(false),
+        m_accessed(0)
+    {}
+
+    // ~HTTPDispatch: return connection to pool
+    HTTPDispatch::~HTTPDispatch()
+    {
+        try
+        {
+            release();
+        }
+        catch (...)
+        {}
+    }
+
+    // send: send dispatch, reusing persisted connection to same host (or pooled connection)
+    void HTTPDispatch::send(const URL& url, const String& method, const Dictionary& headers) throw (Socket::Failed)
+    {
+        Log::Scope scope(KCC_FILE, "HTTPDispatch::send");
+        int port = (url.port == URL::PORT_NONE) ? k_httpPort : url.port;
+        bool reuse = 
+            m_client.connected()           && 
+            m_keepAlive                    && 
+            !m_unread                      &&
+            m_client.host() == url.host    && 
+            m_client.port() == port        &&
+            m_requests < m_maxRequests     &&
+            (long)(std::time(NULL) - m_accessed) <= m_idleSec;
+        if (!reuse) release();
+        m_pooled = false;
+        if (!m_client.connected() && m_maxRequests > 1L)
+            m_pooled = KCC_STATE(HTTPModuleState).acquire(url.host, port, m_client, m_requests);
+        bool keepAlive = m_requests + 1L < m_maxRequests; // last request on connection requests close
+        HTTP::dispatch(m_client, url, method, headers, keepAlive);
+        m_requests++;
+        m_outstanding++;
+        m_keepAlive = keepAlive;
+        std::time(&m_accessed);
+    }
+
+    // response: read next response header
+    int HTTPDispatch::response(HTTPRequest& request) throw (Socket::Failed)
+    {
+        Log::Scope scope(KCC_FILE, "HTTPDispatch::response");
+        HTTP::request(m_client, request);
+        m_pooled = false;
+        m_outstanding--;
+        long length = HTTP::contentLength(request.attributes);
+        if (!HTTP::keepAlive(request) || length == HTTP::F_CLOSE) m_keepAlive = false;
+        m_unread = length != 0L;
+        std::time(&m_accessed);
+        return Strings::parseInteger(request.path);
+    }
+
+    // content: read response content, closing connection if not persisted
+    void HTTPDispatch::content(const Dictionary& attributes, String& receivedData) throw (Socket::Failed)
+    {
+        Log::Scope scope(KCC_FILE, "HTTPDispatch::content");
+        HTTP::content(m_client, attributes, receivedData); 
+        m_unread = false;
+        std::time(&m_accessed);
+        if (!m_keepAlive && m_outstanding <= 0L) close();
+    }
+
+    // close: close connection
+    void HTTPDispatch::close()
+    {
+        m_client.close();
+        m_requests    = 0L;
+        m_outstanding = 0L;
+        m_keepAlive   = false;
+        m_unread      = false;
+        m_pooled      = false;
+    }
+
+    // release: pool connection if persisted with nothing outstanding, otherwise close
+    void HTTPDispatch::release()
+    {
+        if (m_client.connected() && m_keepAlive && !m_unread && m_outstanding <= 0L && m_requests < m_maxRequests)
+            KCC_STATE(HTTPModuleState).release(m_client, m_requests);
+        close();
+    }
 }
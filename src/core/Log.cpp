@@ -5,6 +5,14 @@
  */
 #include <inc/core/Core.h>
 
+#if defined(KCC_WINDOWS)
+#   include "winpthr/pthread.h"
+#   define KCC_LOG_TLS __declspec(thread)
+#elif defined (KCC_LINUX)
+#   include "pthread.h"
+#   define KCC_LOG_TLS __thread
+#endif
+
 #define KCC_FILE "Log"
 
 namespace kcc
@@ -25,6 +33,9 @@ namespace kcc
     static const String k_keyExt      (KCC_LOG_EXT);
     static const String k_keyStdOut   (KCC_LOG_STDOUT);
     static const String k_keyDecorator(KCC_LOG_DECORATOR);
+    static const String k_keyAsync    (KCC_LOG_ASYNC);
+    static const String k_keyBuffer   (KCC_LOG_BUFFER);
+    static const String k_keyFull     (KCC_LOG_FULL);
     static const String k_keyAppSCM   (KCC_APPLICATION_SCM);
     static const String k_keyAppDebug (KCC_APPLICATION_DEBUG);
     static const long   k_defMaxSize   = 1024L * 1024L * 2L; // 2 meg boundaries
@@ -32,6 +43,10 @@ namespace kcc
     static const String k_defPath     ("logs");
     static const String k_defName     ("log");
     static const String k_defExt      ("xml");
+    static const long   k_defBuffer    = 1024L * 8L; // 8K entries
+    static const String k_fullBlock   ("block");
+    static const String k_fullDrop    ("drop");
+    static const String k_fullCount   ("count");
     
     // Constants
     static const Char* k_error   = KCC_LOG_ERROR;
@@ -45,28 +60,195 @@ namespace kcc
     static const std::size_t    k_szLogDetail     = 1024*4; // 4K log message
 
     //
-    // LogModuleState Implementation
+    // Thread scope stack
     //
 
-    /** Track state static class */
-    struct LogModuleState : Core::ModuleState
+    /** 
+     * Per-thread scope stack. Owned and modified only by its thread (lock-free),
+     * read by other threads when marking or dumping scope. An entry is stored before
+     * the depth that covers it is published (release), and readers load the depth
+     * (acquire) before its entries. Entries hold literal context/name pointers so a 
+     * concurrent reader never follows a popped scope.
+     */
+    struct LogScopeStack
     {
-        // Helper structure for scope stack
-        struct ScopeStack : std::vector<Log::Scope*>
+        // Helper structure for scope entry
+        struct Entry { const Char* volatile context; const Char* volatile name; };
+        enum { MAX_DEPTH = 256 };
+
+        // Attributes
+        unsigned long m_threadId;
+        volatile int  m_depth;
+        volatile bool m_released;
+        Entry         m_entries[MAX_DEPTH];
+        LogScopeStack() : m_threadId(Thread::current()), m_depth(0), m_released(false) {}
+
+        // push/pop: scopes deeper than max are counted but not tracked (owning thread)
+        inline void push(Log::Scope* s)
+        {
+            int depth = m_depth;
+            if (depth < MAX_DEPTH)
+            {
+                Entry& e = m_entries[depth];
+                AtomicValue<const Char*>::store(&e.context, s->context());
+                AtomicValue<const Char*>::store(&e.name,    s->name());
+            }
+            AtomicValue<int>::store(&m_depth, depth + 1);
+        }
+        inline void pop() { int depth = m_depth; if (depth > 0) AtomicValue<int>::store(&m_depth, depth - 1); }
+
+        // release: thread exited (stack is reaped by registry)
+        inline void release()        { AtomicValue<bool>::store(&m_released, true); }
+        inline bool released() const { return AtomicValue<bool>::load(&m_released); }
+
+        // mark: copy tracked entries (other threads)
+        template<class Markers> void mark(Markers& markers) const
         {
-            ScopeStack()             { reserve(32);  }
-            void push(Log::Scope* s) { push_back(s); }
-            Log::Scope* top()        { return empty() ? NULL : back(); }
-            Log::Scope* pop()        
-            { 
-                if (empty()) return NULL;
-                Log::Scope* t = back(); 
-                pop_back();
-                return t; 
+            int depth = std::min(AtomicValue<int>::load(&m_depth), (int)MAX_DEPTH);
+            for (int j = 0; j < depth; j++)
+            {
+                markers.push_back(typename Markers::value_type());
+                typename Markers::value_type& m = markers.back();
+                m.threadId = m_threadId;
+                m.context  = AtomicValue<const Char*>::load(&m_entries[j].context);
+                m.name     = AtomicValue<const Char*>::load(&m_entries[j].name);
             }
+        }
+
+        // top: current scope entry
+        inline const Entry* top() const 
+        { 
+            return m_depth == 0 ? NULL : &m_entries[std::min((int)m_depth, (int)MAX_DEPTH) - 1]; 
+        }
+    };
+
+    //
+    // Asynchronous log buffer
+    //
+
+    /** 
+     * Bounded multi-producer, single consumer ring of formatted log entries.
+     * Entries are swapped in and out of slots so buffers are recycled.
+     */
+    struct LogRing : SynchCondition
+    {
+        /** Full buffer policies */
+        enum Policy { P_BLOCK, P_DROP, P_COUNT };
+
+        /** Space available: blocked producers wait until the writer swaps out a batch */
+        struct Space : SynchCondition
+        {
+            bool m_full;
+            Space() : m_full(false) {}
+
+        protected:
+            void onBegin() { m_full = true;  }
+            void onEnd()   { m_full = false; }
+            bool onTest()  { return m_full;  }
         };
-        typedef std::map<long, ScopeStack> ThreadScopeStack;
-        typedef std::list<ScopeStack*>     ThreadScopeStackOrdered;
+
+        // Attributes
+        StringVector m_entries;
+        std::size_t  m_head;
+        std::size_t  m_count;
+        Policy       m_policy;
+        long         m_dropped;
+        bool         m_closed;
+        Space        m_space;
+        LogRing(std::size_t sz, Policy policy) : 
+            m_entries(sz), m_head(0), m_count(0), m_policy(policy), m_dropped(0L), m_closed(false)
+        {}
+
+        // push: swap entry into ring, false if dropped
+        bool push(String& entry)
+        {
+            while (true)
+            {
+                {
+                    Mutex::Lock lock(m_busy);
+                    if (m_closed) return false;
+                    if (m_count < m_entries.size())
+                    {
+                        m_entries[(m_head + m_count) % m_entries.size()].swap(entry);
+                        if (++m_count > 1) return true;
+                        break; // ring was empty, wake writer
+                    }
+                    if (m_policy != P_BLOCK)
+                    {
+                        m_dropped++;
+                        return false;
+                    }
+                    m_space.init(); // marked full under ring lock so the writer's pop can't be missed
+                }
+                notify();
+                m_space.wait();
+            }
+            notify();
+            return true;
+        }
+
+        // pop: wait for entries and swap all into batch, false if closed and drained
+        bool pop(StringVector& batch)
+        {
+            wait();
+            bool drained = false;
+            {
+                Mutex::Lock lock(m_busy);
+                if (batch.size() < m_count) batch.resize(m_count);
+                for (std::size_t i = 0; i < m_count; i++) batch[i].swap(m_entries[(m_head + i) % m_entries.size()]);
+                batch.resize(m_count);
+                m_head  = (m_head + m_count) % m_entries.size();
+                m_count = 0;
+                drained = m_closed && batch.empty();
+            }
+            m_space.notifyAll();
+            return !drained;
+        }
+
+        // close: stop accepting entries, wake writer to drain and blocked producers to drop
+        void close()
+        {
+            {
+                Mutex::Lock lock(m_busy);
+                m_closed = true;
+            }
+            notifyAll();
+            m_space.notifyAll();
+        }
+
+        // dropped: accessor to dropped entries
+        long dropped()
+        {
+            Mutex::Lock lock(m_busy);
+            return m_dropped;
+        }
+
+    protected:
+        // Implementation
+        void onBegin() {}
+        void onEnd()   {}
+        bool onTest()  { return m_count == 0 && !m_closed; }
+    };
+
+    // k_scopeStack: thread local scope stack (NULL until thread's first scope)
+    static KCC_LOG_TLS LogScopeStack* k_scopeStack = NULL;
+
+    // k_scopeRelease: thread exit, release scope stack (deleted by registry)
+    static void k_scopeRelease(void* arg)
+    {
+        static_cast<LogScopeStack*>(arg)->release();
+        k_scopeStack = NULL;
+    }
+
+    //
+    // LogModuleState Implementation
+    //
+
+    /** Track state static class (and asynchronous writer thread) */
+    struct LogModuleState : Core::ModuleState, IThread
+    {
+        // Registry of thread scope stacks (in order of registration)
+        typedef std::list<LogScopeStack*> ScopeStacks;
 
         // Helper structure to track marked scope
         struct ScopeMarker { long threadId; String context; String name; };
@@ -74,8 +256,9 @@ namespace kcc
 
         // Attributes
         ScopeMarkers             m_markers;
-        ThreadScopeStack         m_scopes;
-        ThreadScopeStackOrdered  m_scopesOrdered;
+        ScopeStacks              m_stacks;
+        Mutex                    m_registry;
+        ::pthread_key_t          m_key;
         Log::Verbosity           m_verbosity;
         String                   m_file;
         std::FILE*               m_out;
@@ -83,14 +266,32 @@ namespace kcc
         long                     m_maxSize;
         long                     m_entries;
         AutoPtr<ILogDecorator>   m_decorator;
+        AutoPtr<LogRing>         m_ring;
+        Monitor                  m_writing;
+        unsigned long            m_writer;
+        bool                     m_async;
+        PropertyString           m_path;
+        PropertyString           m_name;
+        PropertyString           m_ext;
+        PropertyLong             m_maxFiles;
+        PropertyLong             m_maxSizeConfig;
 
         // LogModuleState: create log file
         LogModuleState() :
             m_verbosity(Log::V_ERROR),
             m_out(NULL),
             m_maxSize(0L),
-            m_entries(0L)
+            m_entries(0L),
+            m_writer(0L),
+            m_async(false),
+            m_path         (Core::properties(), k_keyPath,     k_defPath),
+            m_name         (Core::properties(), k_keyName,     k_defName),
+            m_ext          (Core::properties(), k_keyExt,      k_defExt),
+            m_maxFiles     (Core::properties(), k_keyMaxFiles, k_defMaxFiles),
+            m_maxSizeConfig(Core::properties(), k_keyMaxSize,  k_defMaxSize)
         {
+            ::pthread_key_create(&m_key, k_scopeRelease);
+
             // load decorator
             const String& decoratorComp = Core::properties().get(k_keyDecorator, Strings::empty());
             if (!decoratorComp.empty())
@@ -111,10 +312,39 @@ namespace kcc
 
             // create log
             create(); 
+
+            // start asynchronous writer
+            if (Core::properties().get(k_keyAsync, KCC_PROPERTY_FALSE) == KCC_PROPERTY_TRUE)
+            {
+                long sz = std::max(Core::properties().get(k_keyBuffer, k_defBuffer), 1L);
+                const String& full = Core::properties().get(k_keyFull, k_fullBlock);
+                LogRing::Policy policy = LogRing::P_BLOCK;
+                if      (full == k_fullDrop)  policy = LogRing::P_DROP;
+                else if (full == k_fullCount) policy = LogRing::P_COUNT;
+                m_ring = new LogRing((std::size_t)sz, policy);
+                m_writing.init();
+                (new Thread(this, "LogWriter"))->go(); // entries are written synchronously until writer is identified
+            }
         }
 
-        // ~LogModuleState: close log file
-        ~LogModuleState() { close(); }
+        // ~LogModuleState: close log file and release stacks of exited threads
+        ~LogModuleState() 
+        { 
+            if (!m_ring.null())
+            {
+                m_ring->close();
+                m_writing.wait();
+                {
+                    Mutex::Lock lock(m_sentinel);
+                    m_async = false; // write synchronously while tearing down
+                }
+                m_ring = NULL;
+            }
+            close(); 
+            ::pthread_key_delete(m_key);
+            Mutex::Lock lock(m_registry);
+            reap();
+        }
         
         // verbosity: modifier to current log verbosity
         void verbosity(Log::Verbosity v) 
@@ -154,6 +384,44 @@ namespace kcc
             return e; 
         }
 
+        // dropped: accessor to entries dropped by asynchronous writer
+        long dropped() { return m_ring.null() ? 0L : m_ring->dropped(); }
+
+        // invoke: asynchronous writer, batch entries to log file until ring closed
+        void invoke()
+        {
+            Log::Scope scope(KCC_FILE, "invoke");
+            {
+                // identify writer before entries are handed to it (writer's own entries are written synchronously)
+                Mutex::Lock lock(m_sentinel);
+                m_writer = Thread::current();
+                m_async  = true;
+            }
+            StringVector batch;
+            long dropped = 0L;
+            while (m_ring->pop(batch))
+            {
+                for (StringVector::iterator i = batch.begin(); i != batch.end(); i++)
+                {
+                    std::fwrite(i->data(), sizeof(Char), i->size(), m_out);
+                    i->clear();
+                }
+                std::fflush(m_out);
+
+                // count written, report drops (writer writes synchronously), check max size and roll if over
+                Mutex::Lock lock(m_sentinel);
+                m_entries += (long)batch.size();
+                if (m_ring->m_policy == LogRing::P_COUNT && m_ring->dropped() != dropped)
+                {
+                    dropped = m_ring->dropped();
+                    String msg(Strings::printf("log entries dropped: total=[%ld]", dropped));
+                    write(k_warning, msg.c_str());
+                }
+                if (std::ftell(m_out) > m_maxSize) roll();
+            }
+            m_writing.notify();
+        }
+
         // history: retrieve log history files        
         void history(StringSet& logs, bool clear = true)
         {
@@ -181,11 +449,11 @@ namespace kcc
         }
         
         // Accessors
-        String         path()      { return Core::properties().get(k_keyPath, k_defPath); }
-        String         name()      { return Core::properties().get(k_keyName, k_defName); }
-        String         ext()       { return Core::properties().get(k_keyExt,  k_defExt); }
-        int            maxFiles()  { return (int)Core::properties().get(k_keyMaxFiles, k_defMaxFiles); }
-        long           maxSize()   { return Core::properties().get(k_keyMaxSize, k_defMaxSize); }
+        String         path()      { return m_path(); }
+        String         name()      { return m_name(); }
+        String         ext()       { return m_ext(); }
+        int            maxFiles()  { return (int)m_maxFiles(); }
+        long           maxSize()   { return m_maxSizeConfig(); }
         ILogDecorator* decorator() { return m_decorator; }
 
         // create: create log
@@ -264,23 +532,14 @@ namespace kcc
             }
         }
 
-        // exceptionMark: get scope stack for exception message
+        // exceptionMark: get scope stack for exception message (walks all thread stacks)
         void scopeMark()
         {
             Mutex::Lock lock(m_sentinel);
             if (!m_markers.empty()) return; // keep root stack only
-            for (ThreadScopeStackOrdered::iterator i = m_scopesOrdered.begin(); i != m_scopesOrdered.end(); i++)
-            {
-                ScopeStack* stack = *i;
-                for (ScopeStack::iterator j = stack->begin(); j != stack->end(); j++)
-                {
-                    m_markers.push_back(ScopeMarker());
-                    ScopeMarker& m = m_markers.back();
-                    m.threadId = (*j)->threadId();
-                    m.context  = (*j)->context();
-                    m.name     = (*j)->name();
-                }
-            }
+            Mutex::Lock registry(m_registry);
+            reap();
+            for (ScopeStacks::iterator i = m_stacks.begin(); i != m_stacks.end(); i++) (*i)->mark(m_markers);
         }
 
         // scopeComplete: write scope stack and complete tracking
@@ -328,115 +587,115 @@ namespace kcc
             create();
         }
 
-        // push: add to scope stack
-        void push(Log::Scope* s)
+        // stack: current thread's scope stack, registered on thread's first scope
+        LogScopeStack& stack()
         {
-            Mutex::Lock lock(m_sentinel);
-            ScopeStack& stack = m_scopes[s->threadId()];
-            if (stack.empty()) m_scopesOrdered.push_back(&stack);
-            stack.push(s);
+            if (k_scopeStack == NULL)
+            {
+                LogScopeStack* stack = new LogScopeStack;
+                Mutex::Lock lock(m_registry);
+                reap();
+                m_stacks.push_back(stack);
+                ::pthread_setspecific(m_key, stack);
+                k_scopeStack = stack;
+            }
+            return *k_scopeStack;
         }
 
-        // pop: remove from scope stack
-        void pop(Log::Scope* s)
+        // reap: delete stacks of exited threads (registry locked by caller)
+        void reap()
         {
-            Mutex::Lock lock(m_sentinel);
-            ScopeStack& stack = m_scopes[s->threadId()];
-            stack.pop();
-            if (stack.empty()) 
+            for (ScopeStacks::iterator i = m_stacks.begin(); i != m_stacks.end();)
             {
-                ThreadScopeStackOrdered::iterator find = 
-                    std::find(m_scopesOrdered.begin(), m_scopesOrdered.end(), &stack);
-                if (find != m_scopesOrdered.end())
-                {
-                    m_scopesOrdered.erase(find);
-                }
+                if (!(*i)->released()) i++;
                 else
                 {
-                    std::fprintf(stderr, "kcc::Log::pop - internal state error: scope not found in ordered stack\n");
-                    std::fflush(stderr);
+                    delete *i;
+                    m_stacks.erase(i++);
                 }
             }
         }
 
-        // write: write to log
+        // push/pop: scope stack management for unmanaged scopes
+        void push(Log::Scope* s) { stack().push(s); }
+        void pop(Log::Scope*)    { stack().pop();   }
+
+        // write: write to log (asynchronous writer writes its own entries)
         void write(const Char* prefix, const Char* text, bool toStdOut = false, bool toStdErr = false, bool logFormatStdOut = true)
         {
-            Mutex::Lock lock(m_sentinel);
-
             // fetch scope for log text
             unsigned long threadId = 0L;
             const Char*   context  = "{context-missing}";
             const Char*   name     = "{name-missing}";
-            if (!m_scopes.empty())
+            if (k_scopeStack == NULL)
             {
-                unsigned long curr  = Thread::current();
-                ScopeStack&   stack = m_scopes[curr];
-                if (stack.empty())
+                std::fprintf(stderr, "kcc::Log::write - internal state error: thread id not found in scope stack. missing Log::Scope?\n");
+                std::fflush(stderr);
+            }
+            else
+            {
+                const LogScopeStack::Entry* s = k_scopeStack->top();
+                if (s == NULL)
                 {
-                    std::fprintf(stderr, "kcc::Log::write - internal state error: thread id not found in scope stack. missing Log::Scope?\n");
+                    std::fprintf(stderr, "kcc::Log::write - internal state error: scope stack empty for thread id. missing Log::Scope?\n");
                     std::fflush(stderr);
                 }
                 else
                 {
-                    Log::Scope* s = stack.top();
-                    if (s == NULL)
-                    {
-                        std::fprintf(stderr, "kcc::Log::write - internal state error: scope stack empty for thread id. missing Log::Scope?\n");
-                        std::fflush(stderr);
-                    }
-                    else
-                    {
-                        threadId = s->threadId();
-                        context  = s->context();
-                        name     = s->name();
-
-                        // verify thread state when debugging
-                        #if defined(KCC_DEBUG)
-                            if (threadId != curr)
-                            {
-                                std::fprintf(stderr, "kcc::Log::write - internal state error: scope thread id NOT current thread id\n");
-                                std::fflush(stderr);
-                            }
-                        #endif
-                    }
+                    threadId = k_scopeStack->m_threadId;
+                    context  = s->context;
+                    name     = s->name;
                 }
             }
 
-            // dump log text
-            m_entries++;
+            // dump log text (asynchronous entries are handed to writer outside of lock)
+            bool   async = false;
+            bool   toLog = true;
             String when(ISODate::local().isodatetime());
-            bool toLog = true;
-            if (!m_decorator.null()) toLog = m_decorator->onWrite(prefix, threadId, context, name, when.c_str(), text);
-            if (toLog)
             {
-                std::fprintf(
-                    m_out,
-                    "<Entry what='%s' thd='%ld' ctx='%s' name='%s' when='%s'><![CDATA[%s]]></Entry>\n",
-                    prefix, threadId, context, name, when.c_str(), text);
-                std::fflush(m_out);
-            }
-
-            // dump to std out
-            if (toStdOut || toStdErr)
-            {
-                if (toStdOut)
+                Mutex::Lock lock(m_sentinel);
+                async = m_async && Thread::current() != m_writer;
+                if (!m_decorator.null()) toLog = m_decorator->onWrite(prefix, threadId, context, name, when.c_str(), text);
+                if (toLog && !async)
                 {
-                    if (logFormatStdOut)
-                        std::fprintf(stdout, "%08ld %-10s %-20s %-25s %s %s\n", threadId, prefix, context, name, when.c_str(), text);
-                    else
-                        std::fprintf(stdout, "%s\n", text);
-                    std::fflush(stdout);
+                    std::fprintf(
+                        m_out,
+                        "<Entry what='%s' thd='%ld' ctx='%s' name='%s' when='%s'><![CDATA[%s]]></Entry>\n",
+                        prefix, threadId, context, name, when.c_str(), text);
+                    std::fflush(m_out);
                 }
-                if (toStdErr)
+
+                // dump to std out
+                if (toStdOut || toStdErr)
                 {
-                    std::fprintf(stderr, "%08ld %-10s %-20s %-25s %s %s\n", threadId, prefix, context, name, when.c_str(), text);
-                    std::fflush(stderr);
+                    if (toStdOut)
+                    {
+                        if (logFormatStdOut)
+                            std::fprintf(stdout, "%08ld %-10s %-20s %-25s %s %s\n", threadId, prefix, context, name, when.c_str(), text);
+                        else
+                            std::fprintf(stdout, "%s\n", text);
+                        std::fflush(stdout);
+                    }
+                    if (toStdErr)
+                    {
+                        std::fprintf(stderr, "%08ld %-10s %-20s %-25s %s %s\n", threadId, prefix, context, name, when.c_str(), text);
+                        std::fflush(stderr);
+                    }
                 }
-            }
 
-            // check max size and roll if over
-            if (std::ftell(m_out) > m_maxSize) roll();
+                // count entry (asynchronous entries are counted once written), check max size and roll if over
+                if (!async || !toLog) m_entries++;
+                if (!async && std::ftell(m_out) > m_maxSize) roll();
+            }
+            if (toLog && async)
+            {
+                String entry(Strings::printf(
+                    "<Entry what='%s' thd='%ld' ctx='%s' name='%s' when='%s'><![CDATA[",
+                    prefix, threadId, context, name, when.c_str()));
+                entry += text;
+                entry += "]]></Entry>\n";
+                m_ring->push(entry);
+            }
         }
     };
 
@@ -444,15 +703,17 @@ namespace kcc
     // Scope Implementation
     //
 
-    // Scope: add scope to scope-stack
+    // Scope: add scope to thread's scope-stack (lock-free once thread's stack registered)
     Log::Scope::Scope(const Char* context, const Char* name, bool manage)
         : m_managed(manage), m_threadId(Thread::current()), m_context(context), m_name(name)
     {
-        if (m_managed) KCC_STATE(LogModuleState).push(this);
+        if (!m_managed) return;
+        if (k_scopeStack != NULL) k_scopeStack->push(this);
+        else                      KCC_STATE(LogModuleState).push(this);
     }
 
-    // ~Scope: remove scope from scope-stack
-    Log::Scope::~Scope() { if (m_managed) KCC_STATE(LogModuleState).pop(this); }
+    // ~Scope: remove scope from thread's scope-stack
+    Log::Scope::~Scope() { if (m_managed && k_scopeStack != NULL) k_scopeStack->pop(); }
 
     //
     // Log Implementation
@@ -468,6 +729,7 @@ namespace kcc
     String         Log::ext()       { return KCC_STATE(LogModuleState).ext(); }
     String         Log::file()      { return KCC_STATE(LogModuleState).file(); }
     long           Log::entries()   { return KCC_STATE(LogModuleState).entries(); }
+    long           Log::dropped()   { return KCC_STATE(LogModuleState).dropped(); }
     long           Log::maxSize()   { return KCC_STATE(LogModuleState).maxSize(); }
     int            Log::maxFiles()  { return KCC_STATE(LogModuleState).maxFiles(); }
     void           Log::history(StringSet& logs, bool clear) { return KCC_STATE(LogModuleState).history(logs, clear); }
@@ -22,11 +22,32 @@ namespace kcc
     static const String k_keyConfigFile (KCC_PROPERTY_FILE);
     static const String k_keyAppName    (KCC_APPLICATION_NAME);
     
+    // k_trimmed: query if key has no leading or trailing whitespace (trimws not required)
+    inline static bool k_trimmed(const String& key)
+    {
+        return key.empty() || (!std::isspace((unsigned char)key[0]) && !std::isspace((unsigned char)key[key.size()-1]));
+    }
+
     // k_overrideProperties: override properties
-    inline static void k_overrideProperties(StringMap& target, const StringMap& source)
+    inline static void k_overrideProperties(Properties& target, const StringPairs& source)
+    {
+        for (StringPairs::const_iterator i = source.begin(); i != source.end(); i++) 
+            target.set(i->first, i->second);
+    }
+
+    // Helper functor to order properties by key
+    struct PropertyLess
+    {
+        inline bool operator () (const StringPair* l, const StringPair* r) const { return l->first < r->first; }
+    };
+
+    // k_sorted: properties in key order (serialization order)
+    static void k_sorted(const StringPairs& source, std::vector<const StringPair*>& sorted)
     {
-        for (StringMap::const_iterator i = source.begin(); i != source.end(); i++) 
-            target[i->first] = i->second;
+        sorted.clear();
+        sorted.reserve(source.size());
+        for (StringPairs::const_iterator i = source.begin(); i != source.end(); i++) sorted.push_back(&*i);
+        std::sort(sorted.begin(), sorted.end(), PropertyLess());
     }
     
     // k_chainProperties: chain properties files
@@ -87,14 +108,18 @@ namespace kcc
     {
         if (this != &rhs) 
         {
-            m_properties.clear();
-            m_properties.insert(rhs.m_properties.begin(), rhs.m_properties.end());
+            m_properties = rhs.m_properties;
+            m_index.rebuild(m_properties);
         }
         return *this;
     }
 
     // clear: clear properties
-    void Properties::clear() { m_properties.clear(); }
+    void Properties::clear() 
+    { 
+        m_properties.clear(); 
+        m_index.clear();
+    }
 
     // load: load from vector (each vector: key=value)
     bool Properties::load(const StringVector& args, bool clear)
@@ -106,9 +131,9 @@ namespace kcc
     
         // overrides
         if (!k_chainProperties(load)) return false;
-        if (clear) m_properties.clear();
-        k_overrideProperties(m_properties, load.m_properties);
-        k_overrideProperties(m_properties, save.m_properties);
+        if (clear) this->clear();
+        k_overrideProperties(*this, load.m_properties);
+        k_overrideProperties(*this, save.m_properties);
         return true;
     }
 
@@ -123,9 +148,9 @@ namespace kcc
     
         // overrides
         if (!k_chainProperties(load)) return false;
-        if (clear) m_properties.clear();
-        k_overrideProperties(m_properties, load.m_properties);
-        k_overrideProperties(m_properties, save.m_properties);
+        if (clear) this->clear();
+        k_overrideProperties(*this, load.m_properties);
+        k_overrideProperties(*this, save.m_properties);
         return true;
     }
 
@@ -221,52 +246,63 @@ namespace kcc
 
         // overrides
         if (!k_chainProperties(load)) return false;
-        if (clear) m_properties.clear();
-        k_overrideProperties(m_properties, load.m_properties);
-        k_overrideProperties(m_properties, save.m_properties);
+        if (clear) this->clear();
+        k_overrideProperties(*this, load.m_properties);
+        k_overrideProperties(*this, save.m_properties);
         return true;
     }
 
     // toXML: serialize to stream as XML
     bool Properties::toXML(std::ostream& out, bool noPrologue) const
     {
+        std::vector<const StringPair*> sorted;
+        k_sorted(m_properties, sorted);
         DOMWriter w(out, noPrologue);
         w.start(k_xmlRoot);
         for (
-            StringMap::const_iterator i = m_properties.begin();
-            i != m_properties.end();
+            std::vector<const StringPair*>::const_iterator i = sorted.begin();
+            i != sorted.end();
             i++)
         {
             w.start(k_xmlProperty);
-            w.attr(k_xmlKey,   i->first);
-            w.attr(k_xmlValue, i->second);
+            w.attr(k_xmlKey,   (*i)->first);
+            w.attr(k_xmlValue, (*i)->second);
             w.end(k_xmlProperty);
         }
         w.end(k_xmlRoot);
         return true;
     }
 
+    // find: find value of key (trimming key only if required)
+    const String* Properties::find(const String& key) const
+    {
+        if (!k_trimmed(key)) return find(Strings::trimws(key));
+        const StringIndex::Entry* e = m_index.find(key, m_index.hash(key));
+        return e == NULL ? NULL : &e->first->second;
+    }
+
     // exists: query if key exists
     bool Properties::exists(const String& key) const
     {
-        StringMap::const_iterator v = m_properties.find(Strings::trimws(key));
-        return v != m_properties.end();
+        return find(key) != NULL;
     }
 
     // erase: erase property
     bool Properties::erase(const String& key)
     {
-        StringMap::iterator f = m_properties.find(Strings::trimws(key));
-        bool exists = f != m_properties.end();
-        if (exists) m_properties.erase(f);
-        return exists;
+        String k(Strings::trimws(key));
+        StringIndex::Entry* e = m_index.find(k, m_index.hash(k));
+        if (e == NULL) return false;
+        m_properties.erase(e->first);
+        m_index.erase(*e);
+        return true;
     }
     
     // get: fetch value for key
     const String& Properties::get(const String& key, const String& value) const
     {
-        StringMap::const_iterator v = m_properties.find(Strings::trimws(key));
-        return (v == m_properties.end()) ? value : v->second;
+        const String* v = find(key);
+        return (v == NULL) ? value : *v;
     }
 
     // get: fetch value for key
@@ -286,7 +322,16 @@ namespace kcc
     // set: fetch value for key
     void Properties::set(const String& key, const String& value)
     {
-        m_properties[Strings::trimws(key)] = Strings::trimws(value);
+        String k(Strings::trimws(key));
+        StringIndex::Hash h = m_index.hash(k);
+        StringIndex::Entry* e = m_index.find(k, h);
+        if (e != NULL) 
+        {
+            e->first->second = Strings::trimws(value);
+            return;
+        }
+        m_properties.push_back(StringPair(k, Strings::trimws(value)));
+        m_index.insert(h, --m_properties.end());
     }
 
     // set: fetch value for key
@@ -308,12 +353,13 @@ namespace kcc
         keys.reserve(m_properties.size());
         bool all = prefix.empty();
         for (
-            StringMap::const_iterator i = m_properties.begin();
+            StringPairs::const_iterator i = m_properties.begin();
             i != m_properties.end();
             i++)
         {
             if (all || i->first.find(prefix) == 0) keys.push_back(i->first);
         }
+        std::sort(keys.begin(), keys.end());
     }
 
     // keys: fetch properties keys
@@ -322,7 +368,7 @@ namespace kcc
         keys.clear();
         bool all = prefix.empty();
         for (
-            StringMap::const_iterator i = m_properties.begin();
+            StringPairs::const_iterator i = m_properties.begin();
             i != m_properties.end();
             i++)
         {
@@ -334,7 +380,7 @@ namespace kcc
     void Properties::asMap(StringMap& map, bool clear) const
     {
         if (clear) map.clear();
-        map = m_properties;
+        for (StringPairs::const_iterator i = m_properties.begin(); i != m_properties.end(); i++) map[i->first] = i->second;
     }
 
     // empty: empty properties object
@@ -18,6 +18,7 @@
         ~WinSockets() { WSACleanup(); }
     } k_winSockets;
 #   define KCC_SOCKET_ERRNO ::WSAGetLastError()    
+#   define KCC_SOCKET_POLL  ::WSAPoll
 #elif defined(KCC_LINUX)
 #   include "errno.h"
 #   include "unistd.h"
@@ -25,7 +26,12 @@
 #   include "sys/socket.h"
 #   include "netdb.h"
 #   include "netinet/in.h"
+#   include "netinet/tcp.h"
+#   include "poll.h"
+#   include "sys/sendfile.h"
+#   include "fcntl.h"
 #   define KCC_SOCKET_ERRNO errno
+#   define KCC_SOCKET_POLL  ::poll
 #endif
 
 #define KCC_FILE "Socket"
@@ -36,7 +42,11 @@ namespace kcc
     static const int    k_szBuf    = 1024;         // 1K read buffer
     static const int    k_szBufRes = k_szBuf*10;   // 10K reserve
     static const int    k_szBufMax = k_szBuf*1024; // 1MB max
+    static const int    k_szBlock  = k_szBuf*16;   // 16K block read
     static const String k_notConntected("socket handle not valid (has the socket been connected or listened?)"); 
+    static const String k_keyDNSTTL    (KCC_SOCKET_DNSTTL);
+    static const long   k_defDNSTTL    = 60L;  // secs
+    static const std::size_t k_maxDNS  = 256;  // resolved addresses cached
 
     // k_ip: fetch ip address from sockaddr
     static inline String k_ip(const struct ::sockaddr_in& addr)
@@ -49,6 +59,16 @@ namespace kcc
         return Strings::printf("%d.%d.%d.%d", a1, a2, a3, a4);
     }
     
+    // k_readable: poll handle for data to read, peer close, or error (ms: 0 to not wait)
+    static inline int k_readable(Socket::Handle handle, long ms)
+    {
+        ::pollfd fd;
+        fd.fd      = handle;
+        fd.events  = POLLIN;
+        fd.revents = 0;
+        return KCC_SOCKET_POLL(&fd, 1, (int)ms);
+    }
+
     // k_option: map to BSD socket option
     static inline int k_option(Socket::OptionFlags o) throw (Socket::Failed)
     {
@@ -58,9 +78,16 @@ namespace kcc
             case Socket::O_LINGER:    return SO_LINGER;
             case Socket::O_SNDBUF:    return SO_SNDBUF;
             case Socket::O_RCVBUF:    return SO_RCVBUF;
+            case Socket::O_NODELAY:   return TCP_NODELAY;
         };
         throw Socket::Failed("option not implemented");
     }
+
+    // k_level: map to BSD socket option level
+    static inline int k_level(Socket::OptionFlags o)
+    {
+        return o == Socket::O_NODELAY ? IPPROTO_TCP : SOL_SOCKET;
+    }
     
     // k_timeout: map to BSD socket option
     static inline int k_timeout(Socket::TimeoutFlags t) throw (Socket::Failed)
@@ -79,16 +106,90 @@ namespace kcc
         return Strings::printf("%s: host=[%s] addr=[%s:%d] handle=[%d] errno=[%d]", msg, s->host().c_str(), s->ip().c_str(), s->port(), h, KCC_SOCKET_ERRNO);
     }
 
+    // Module state: cache of resolved host addresses (avoid getaddrinfo per connect)
+    struct SocketModuleState : Core::ModuleState
+    {
+        struct Entry
+        {
+            struct ::sockaddr_in addr;
+            String               ip;
+            std::time_t          expires;
+        };
+        typedef std::map<String, Entry> Entries;
+        SocketModuleState() : m_ttl(Core::properties().get(k_keyDNSTTL, k_defDNSTTL)) {}
+
+        // resolve: lookup cached address, resolving when expired or not cached
+        void resolve(Socket* s, const String& host, int port, struct ::sockaddr_in& addr, String& ip, Socket::Handle h) throw (Socket::Failed)
+        {
+            String key(Strings::printf("%s:%d", host.c_str(), port));
+            std::time_t now = std::time(NULL);
+            if (m_ttl > 0L)
+            {
+                Mutex::Lock lock(m_sentinel);
+                Entries::iterator e = m_entries.find(key);
+                if (e != m_entries.end() && e->second.expires > now)
+                {
+                    addr = e->second.addr;
+                    ip   = e->second.ip;
+                    return;
+                }
+            }
+
+            // resolve outside of lock
+            String p(Strings::printf("%d", port));
+            struct addrinfo hints = {0};
+            struct addrinfo *ai = NULL;
+            std::memset(&hints, 0, sizeof(hints));
+            hints.ai_flags    = AI_PASSIVE|AI_CANONNAME;
+            hints.ai_family   = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_protocol = IPPROTO_TCP;
+            if (::getaddrinfo(host.c_str(), p.c_str(), &hints, &ai) != 0) 
+                throw Socket::Failed(k_message(s, h, "unable to get host addr info"));
+            std::memcpy(&addr, ai->ai_addr, sizeof(addr));
+            ip = ai->ai_canonname == NULL ? host : String(ai->ai_canonname);
+            freeaddrinfo(ai);
+            if (m_ttl <= 0L) return;
+
+            // cache
+            Mutex::Lock lock(m_sentinel);
+            if (m_entries.size() >= k_maxDNS && m_entries.find(key) == m_entries.end()) evict(now);
+            Entry& e  = m_entries[key];
+            e.addr    = addr;
+            e.ip      = ip;
+            e.expires = now + m_ttl;
+        }
+
+    private:
+        // evict: drop expired entries, or failing that the oldest (earliest to expire) -- locked by caller
+        void evict(std::time_t now)
+        {
+            Entries::iterator oldest = m_entries.end();
+            for (Entries::iterator i = m_entries.begin(); i != m_entries.end(); )
+            {
+                Entries::iterator e = i++;
+                if (e->second.expires <= now) m_entries.erase(e);
+                else if (oldest == m_entries.end() || e->second.expires < oldest->second.expires) oldest = e;
+            }
+            if (m_entries.size() >= k_maxDNS) m_entries.erase(oldest);
+        }
+
+        // Attributes
+        long    m_ttl;
+        Mutex   m_sentinel;
+        Entries m_entries;
+    };
+
     //
     // Socket implementation
     //
 
     // Socket: create or attach to socket
-    Socket::Socket() : m_port(0), m_handle(-1)
+    Socket::Socket() : m_port(0), m_handle(-1), m_offset(0)
     {}
-    Socket::Socket(const String& host, int port) : m_host(host), m_port(port), m_handle(-1)
+    Socket::Socket(const String& host, int port) : m_host(host), m_port(port), m_handle(-1), m_offset(0)
     {}
-    Socket::Socket(Handle handle) throw (Socket::Failed) : m_port(0), m_handle(handle)
+    Socket::Socket(Handle handle) throw (Socket::Failed) : m_port(0), m_handle(handle), m_offset(0)
     {
         Log::Scope scope(KCC_FILE, "Socket::Socket");
         if (handle < 0) throw Socket::Failed(k_notConntected);
@@ -121,22 +222,12 @@ namespace kcc
         m_handle = ::socket(PF_INET, SOCK_STREAM, 0);
         if (m_handle < 0) throw Socket::Failed(k_message(this, m_handle, "open socket failed"));
 
-        // socket address
-        String port(Strings::printf("%d", m_port));
-        struct addrinfo hints = {0};
-        struct addrinfo *ai = NULL;
-        std::memset(&hints, 0, sizeof(hints));
-        hints.ai_flags    = AI_PASSIVE|AI_CANONNAME;
-        hints.ai_family   = AF_INET;
-        hints.ai_socktype = SOCK_STREAM;
-        hints.ai_protocol = IPPROTO_TCP;
-        if (::getaddrinfo(m_host.c_str(), port.c_str(), &hints, &ai) != 0) 
-            throw Socket::Failed(k_message(this, m_handle, "unable to get host addr info"));
-        m_ip = ai->ai_canonname;
+        // socket address (resolved addresses cached for kcc.socketDNSTTL secs)
+        struct ::sockaddr_in addr;
+        KCC_STATE(SocketModuleState).resolve(this, m_host, m_port, addr, m_ip, m_handle);
 
         // connect to socket
-        onConnect(ai->ai_addr);
-        freeaddrinfo(ai);
+        onConnect(&addr);
     }
 
     // close: close socket
@@ -156,6 +247,8 @@ namespace kcc
             #endif
             m_handle = -1;
         }
+        m_buffer.clear();
+        m_offset = 0;
     }
 
     // read: read a long
@@ -169,15 +262,96 @@ namespace kcc
         if (actual > 0) l = ntohl(in);
     }
 
-    // read: read into buffer
+    // read: read into buffer (not scoped, called per block)
     void Socket::read(char* buf, int sz, int& actual) throw (Socket::Failed)
     {
-        Log::Scope scope(KCC_FILE, "read");
         if (m_handle < 0) throw Socket::Failed(k_notConntected);
+        if (m_offset < m_buffer.size())
+        {
+            actual = std::min(sz, buffered());
+            std::memcpy(buf, m_buffer.data() + m_offset, actual);
+            m_offset += actual;
+            if (m_offset == m_buffer.size())
+            {
+                m_buffer.clear();
+                m_offset = 0;
+            }
+            return;
+        }
         actual = ::recv(m_handle, buf, sz, 0);
         if (actual < 0) throw Socket::Failed("read failed");
     }
 
+    // readFully: read until sz read or closed by peer
+    void Socket::readFully(char* buf, int sz, int& actual) throw (Socket::Failed)
+    {
+        actual = 0;
+        while (actual < sz)
+        {
+            int n = 0;
+            read(buf + actual, sz - actual, n);
+            if (n == 0) break;
+            actual += n;
+        }
+    }
+
+    // readThrough: read blocks until delimiter, retaining remainder for subsequent reads
+    bool Socket::readThrough(const String& delimiter, String& data, int max) throw (Socket::Failed)
+    {
+        if (m_handle < 0) throw Socket::Failed(k_notConntected);
+        data.clear();
+        String::size_type from = m_offset;
+        while (true)
+        {
+            // delimiter buffered
+            String::size_type found = m_buffer.find(delimiter, from);
+            if (found != String::npos)
+            {
+                String::size_type end = found + delimiter.size();
+                if ((int)(end - m_offset) > max) throw Socket::Failed("socket read exceeded maximum");
+                data.assign(m_buffer, m_offset, end - m_offset);
+                m_offset = end;
+                if (m_offset == m_buffer.size())
+                {
+                    m_buffer.clear();
+                    m_offset = 0;
+                }
+                return true;
+            }
+            if (buffered() > max) throw Socket::Failed("socket read exceeded maximum");
+
+            // compact consumed data then read next block
+            if (m_offset > 0)
+            {
+                m_buffer.erase(0, m_offset);
+                m_offset = 0;
+            }
+            from = m_buffer.size() < delimiter.size() ? 0 : m_buffer.size() - delimiter.size() + 1;
+            char buf[k_szBlock];
+            int  actual = ::recv(m_handle, buf, k_szBlock, 0);
+            if (actual < 0)  throw Socket::Failed("read failed");
+            if (actual == 0) return false;
+            m_buffer.append(buf, actual);
+        }
+    }
+
+    // wait: wait for data to read, or peer close
+    bool Socket::wait(long sec)
+    {
+        if (m_handle < 0) return false;
+        if (buffered() > 0) return true;
+        if (k_readable(m_handle, sec * 1000L) <= 0) return false;
+        char c = 0;
+        return ::recv(m_handle, &c, sizeof(char), MSG_PEEK) > 0;
+    }
+
+    // idle: query if connection is open with nothing pending (readable idle connection == closed or unsolicited data)
+    bool Socket::idle()
+    {
+        if (m_handle < 0 || buffered() > 0) return false;
+        return k_readable(m_handle, 0L) == 0;
+    }
+
     // write: write long
     void Socket::write(long l) throw (Socket::Failed)
     {
@@ -203,13 +377,50 @@ namespace kcc
         if (::send(m_handle, buf, sz, MSG_NOSIGNAL) < 0) throw Socket::Failed("write failed");
     }
 
+    // writeFile: write file region (kernel copy on linux, block copy elsewhere)
+    void Socket::writeFile(const String& file, long offset, long size) throw (Socket::Failed)
+    {
+        Log::Scope scope(KCC_FILE, "writeFile");
+        if (m_handle < 0) throw Socket::Failed(k_notConntected);
+        #if defined(KCC_LINUX)
+            int fd = ::open(file.c_str(), O_RDONLY);
+            if (fd < 0) throw Socket::Failed("unable to open file: " + file);
+            ::off_t off = (::off_t)offset;
+            while (size > 0L)
+            {
+                ::ssize_t sent = ::sendfile(m_handle, fd, &off, (std::size_t)size);
+                if (sent < 0 && errno == EINTR) continue;
+                if (sent <= 0)
+                {
+                    ::close(fd);
+                    throw Socket::Failed("sendfile failed");
+                }
+                size -= (long)sent;
+            }
+            ::close(fd);
+        #else
+            std::FILE* in = std::fopen(file.c_str(), "rb");
+            if (in == NULL) throw Socket::Failed("unable to open file: " + file);
+            char buf[k_szBlock];
+            bool failed = std::fseek(in, offset, SEEK_SET) != 0;
+            while (!failed && size > 0L)
+            {
+                int actual = (int)std::fread(buf, 1, (std::size_t)std::min((long)k_szBlock, size), in);
+                failed = actual <= 0 || ::send(m_handle, buf, actual, MSG_NOSIGNAL) < 0; // file ended short of size, or send failed
+                size -= actual;
+            }
+            std::fclose(in);
+            if (failed) throw Socket::Failed("write file failed");
+        #endif
+    }
+
     // getOption: get socket option
     int Socket::getOption(OptionFlags o) throw (Socket::Failed)
     {
         Log::Scope scope(KCC_FILE, "getOption");
         int value = 0;
         ::socklen_t len = sizeof(int);
-        if (::getsockopt(m_handle, SOL_SOCKET, k_option(o), (char*)&value, &len) < 0)
+        if (::getsockopt(m_handle, k_level(o), k_option(o), (char*)&value, &len) < 0)
             throw Socket::Failed("get socket option");
         return value;
     }
@@ -218,7 +429,7 @@ namespace kcc
     void Socket::setOption(OptionFlags o, int value) throw (Socket::Failed)
     {
         Log::Scope scope(KCC_FILE, "setOption");
-        if (::setsockopt(m_handle, SOL_SOCKET, k_option(o), (const char*)&value, sizeof(int)) < 0)
+        if (::setsockopt(m_handle, k_level(o), k_option(o), (const char*)&value, sizeof(int)) < 0)
             throw Socket::Failed("set socket option");
     }
 
@@ -265,6 +476,17 @@ namespace kcc
         return buf;
     }
 
+    // swap: exchange connection state
+    void Socket::swap(Socket& s)
+    {
+        std::swap(m_handle, s.m_handle);
+        std::swap(m_port,   s.m_port);
+        std::swap(m_offset, s.m_offset);
+        m_ip.swap(s.m_ip);
+        m_host.swap(s.m_host);
+        m_buffer.swap(s.m_buffer);
+    }
+
     //
     // SocketServer implementation
     //
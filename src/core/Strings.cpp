@@ -21,8 +21,6 @@ namespace kcc
     static const String   k_pipe   ("|");
     
     // Constants: regex's
-    static const String   k_rx_word       ("\\w");
-    static const String   k_rx_split      ("\\s+");
     static const String   k_rx_decimal    ("^\\d$");
     static const String   k_rx_fraction   ("^\\d.*\\d$");
     static const String   k_rx_reserved   ("(\\/|\\.|\\*|\\+|\\?|\\||\\(|\\)|\\[|\\]|\\{|\\}|\\\\)");
@@ -84,6 +82,92 @@ namespace kcc
         return std::isalpha(c, loc) || c == '_' || (c >= '0' && c <= '9');
     }
 
+    //
+    // Tokenizer character tables
+    //  - TC_SPACE, TC_WORD, TC_DIGIT are the regex \s, \w, \d classes (C library, as
+    //    the regex component's traits); TC_TRIM and lower are as trim() and toLower()
+    //
+
+    enum TokenClass
+    {
+        TC_SPACE = 1,
+        TC_WORD  = 2,
+        TC_DIGIT = 4,
+        TC_TRIM  = 8
+    };
+
+    struct StringsTokenizerState : Core::ModuleState
+    {
+        // Attributes
+        unsigned char m_classes[256];
+        Char          m_lower[256];
+        StringsTokenizerState()
+        {
+            std::locale loc;
+            for (int c = 0; c < 256; c++)
+            {
+                unsigned char cls = 0;
+                if (std::isspace(c))             cls |= TC_SPACE;
+                if (std::isalnum(c) || c == '_') cls |= TC_WORD;
+                if (std::isdigit(c))             cls |= TC_DIGIT;
+                if (k_isalnum((Char)c, loc))     cls |= TC_TRIM;
+                m_classes[c] = cls;
+                m_lower[c]   = std::tolower((Char)c, loc);
+            }
+        }
+
+        // is: query class of character
+        inline bool is(Char c, unsigned char cls) const { return (m_classes[(unsigned char)c] & cls) != 0; }
+    };
+
+    // k_stopped: query stoplist
+    inline bool k_stopped(const StringSet& stoplist, const String& t)     { return stoplist.find(t) != stoplist.end(); }
+    inline bool k_stopped(const StringHashSet& stoplist, const String& t) { return stoplist.contains(t); }
+
+    // k_tokenize: scan runs of non-white space, filtering as Strings::tokenize()
+    template<class _S> void k_tokenize(const String& text, StringVector& tokens, const _S& stoplist, Strings::TokenOptions ops, bool clear)
+    {
+        const StringsTokenizerState& tc = KCC_STATE(StringsTokenizerState);
+        if (clear) tokens.clear();
+        String      t;
+        const Char* p   = text.data();
+        const Char* end = p + text.size();
+        for (;;)
+        {
+            // token
+            while (p != end && tc.is(*p, TC_SPACE)) p++;
+            if (p == end) break;
+            const Char* b = p;
+            while (p != end && !tc.is(*p, TC_SPACE)) p++;
+            const Char* e = p;
+
+            // trim, lowercase
+            if ((ops & Strings::TF_TRIM) != 0)
+            {
+                while (b != e && !tc.is(*b, TC_TRIM))     b++;
+                while (e != b && !tc.is(*(e - 1), TC_TRIM)) e--;
+            }
+            t.assign(b, e);
+            if ((ops & Strings::TF_LOWERCASE) != 0)
+            {
+                for (String::iterator i = t.begin(); i != t.end(); i++) *i = tc.m_lower[(unsigned char)*i];
+            }
+
+            // filter
+            String::size_type sz = t.size();
+            if ((ops & Strings::TF_BLANKS) != 0)
+            {
+                String::size_type i = 0;
+                while (i < sz && !tc.is(t[i], TC_WORD)) i++;
+                if (i == sz) continue;
+            }
+            if ((ops & Strings::TF_STOPLIST)  != 0 && k_stopped(stoplist, t)) continue;
+            if ((ops & Strings::TF_DECIMALS)  != 0 && sz == 1 && tc.is(t[0], TC_DIGIT)) continue;
+            if ((ops & Strings::TF_FRACTIONS) != 0 && sz >= 2 && tc.is(t[0], TC_DIGIT) && tc.is(t[sz - 1], TC_DIGIT)) continue;
+            tokens.push_back(t);
+        }
+    }
+
     //
     // Strings Implementation
     //
@@ -607,24 +691,16 @@ namespace kcc
         TokenOptions ops,
         bool clear) throw (Exception)
     {
-        Log::Scope scope(KCC_FILE, "tokenize");
-        IRegex* rx = Core::regex();
-        StringVector split;
-        split.reserve(64);
-        rx->split(text, k_rx_split, split);
-        if (clear) tokens.clear();
-        tokens.reserve(split.size());
-        for (StringVector::size_type i = 0; i < split.size(); i++)
-        {
-            String& c = split[i];
-            if ((ops & Strings::TF_TRIM)      != 0) Strings::trim(c);
-            if ((ops & Strings::TF_LOWERCASE) != 0) Strings::toLower(c);
-            if ((ops & Strings::TF_BLANKS)    != 0 && !rx->match(c, k_rx_word))           continue;
-            if ((ops & Strings::TF_STOPLIST)  != 0 && stoplist.find(c) != stoplist.end()) continue;
-            if ((ops & Strings::TF_DECIMALS)  != 0 && rx->match(c, k_rx_decimal))         continue;
-            if ((ops & Strings::TF_FRACTIONS) != 0 && rx->match(c, k_rx_fraction))        continue;
-            tokens.push_back(c);
-        }
+        k_tokenize(text, tokens, stoplist, ops, clear);
+    }
+    void Strings::tokenize(
+        const String& text, 
+        StringVector& tokens, 
+        const StringHashSet& stoplist, 
+        TokenOptions ops,
+        bool clear) throw (Exception)
+    {
+        k_tokenize(text, tokens, stoplist, ops, clear);
     }
 
     // rxEscape: escape regex expression    
@@ -9,16 +9,38 @@
 #   include "windows.h"
 #   include "winpthr/pthread.h"
 #   include "winpthr/semaphore.h"
+#   include "sys/timeb.h"
 #elif defined (KCC_LINUX)
 #   include "pthread.h"
 #   include "semaphore.h"
 #   include "errno.h"
+#   include "unistd.h"
+#   include <sys/syscall.h>
+#   include <linux/futex.h>
+#   include <cxxabi.h>
+#   if !defined(FUTEX_WAIT_PRIVATE)
+#       define FUTEX_WAIT_PRIVATE FUTEX_WAIT
+#       define FUTEX_WAKE_PRIVATE FUTEX_WAKE
+#   endif
 #endif
 
 #define KCC_FILE "Thread"
 
 namespace kcc
 {
+    // Constants
+    static const int k_spins = 100; // SpinMutex spins before sleeping (multi-processor)
+
+    // k_pause: spin-wait hint
+    static inline void k_pause()
+    {
+        #if defined(KCC_WINDOWS)
+            YieldProcessor();
+        #elif defined(__i386__) || defined(__x86_64__)
+            __asm__ __volatile__ ("pause");
+        #endif
+    }
+
     // Helper class to manage thread key
     struct ThreadModuleState : Core::ModuleState
     {
@@ -142,6 +164,12 @@ namespace kcc
             Log::error("uncaught std::exception in thread: [%s]", e.what());
             Log::exception(e);
         }
+#if defined(KCC_LINUX)
+        catch (abi::__forced_unwind&)
+        {
+            throw; // kill(): thread cancellation must unwind to pthread
+        }
+#endif
         catch (...)
         {
             Log::error("uncaught exception [unknown exception]");
@@ -182,6 +210,109 @@ namespace kcc
     void Mutex::lock()    { ::pthread_mutex_lock((pthread_mutex_t*)m_mutex); }
     void Mutex::unlock()  { ::pthread_mutex_unlock((pthread_mutex_t*)m_mutex); }
 
+    //
+    // RWMutex implementation
+    //
+
+    // ctor/dtor
+    RWMutex::RWMutex() : m_rwlock(new ::pthread_rwlock_t)
+    {
+        ::pthread_rwlockattr_t attr;
+        ::pthread_rwlockattr_init(&attr);
+        #if defined(KCC_LINUX) && defined(__GLIBC__)
+            // glibc prefers readers by default, starving writers of read-dominated state
+            ::pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+        #endif
+        ::pthread_rwlock_init((::pthread_rwlock_t*)m_rwlock, &attr);
+        ::pthread_rwlockattr_destroy(&attr);
+    }
+    RWMutex::~RWMutex()
+    {
+        ::pthread_rwlock_destroy((pthread_rwlock_t*)m_rwlock);
+        delete (pthread_rwlock_t*)m_rwlock;
+    }
+
+    // lock management
+    void RWMutex::lockShared()   { ::pthread_rwlock_rdlock((pthread_rwlock_t*)m_rwlock); }
+    void RWMutex::unlockShared() { ::pthread_rwlock_unlock((pthread_rwlock_t*)m_rwlock); }
+    void RWMutex::lock()         { ::pthread_rwlock_wrlock((pthread_rwlock_t*)m_rwlock); }
+    void RWMutex::unlock()       { ::pthread_rwlock_unlock((pthread_rwlock_t*)m_rwlock); }
+
+    //
+    // SpinMutex implementation
+    //  - Linux: futex word (U. Drepper, "Futexes Are Tricky", mutex #3) with a bounded
+    //    spin on a held lock before marking it contended and sleeping
+    //  - Windows: critical section with spin count
+    //
+
+    // ctor/dtor
+    SpinMutex::SpinMutex() : m_state(0), m_spins(Executor::processors() > 1 ? k_spins : 0), m_mutex(NULL)
+    {
+        #if defined(KCC_WINDOWS)
+            m_mutex = new ::CRITICAL_SECTION;
+            ::InitializeCriticalSectionAndSpinCount((::CRITICAL_SECTION*)m_mutex, (DWORD)m_spins);
+        #endif
+    }
+    SpinMutex::~SpinMutex()
+    {
+        #if defined(KCC_WINDOWS)
+            ::DeleteCriticalSection((::CRITICAL_SECTION*)m_mutex);
+            delete (::CRITICAL_SECTION*)m_mutex;
+        #endif
+    }
+
+#if defined(KCC_WINDOWS)
+    // lock management
+    bool SpinMutex::tryLock() { return ::TryEnterCriticalSection((::CRITICAL_SECTION*)m_mutex) != 0; }
+    void SpinMutex::lock()    { ::EnterCriticalSection((::CRITICAL_SECTION*)m_mutex); }
+    void SpinMutex::unlock()  { ::LeaveCriticalSection((::CRITICAL_SECTION*)m_mutex); }
+#elif defined(KCC_LINUX)
+    // tryLock: unlocked -> locked
+    bool SpinMutex::tryLock() { return __sync_val_compare_and_swap(&m_state, 0, 1) == 0; }
+
+    // lock: acquire uncontended, else spin while held, else sleep as contended
+    void SpinMutex::lock()
+    {
+        if (__sync_val_compare_and_swap(&m_state, 0, 1) == 0) return;
+        for (int i = 0; i < m_spins; i++)
+        {
+            k_pause();
+            if (m_state == 0 && __sync_val_compare_and_swap(&m_state, 0, 1) == 0) return;
+        }
+        while (__sync_lock_test_and_set(&m_state, 2) != 0)
+            ::syscall(SYS_futex, &m_state, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+    }
+
+    // unlock: release, waking a sleeper if contended
+    void SpinMutex::unlock()
+    {
+        if (__sync_fetch_and_sub(&m_state, 1) != 1)
+        {
+            __sync_lock_release(&m_state);
+            ::syscall(SYS_futex, &m_state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+        }
+    }
+#endif
+
+    //
+    // ThreadLocal implementation
+    //
+
+    // ctor/dtor
+    ThreadLocal::ThreadLocal(Cleanup cleanup) : m_key(new ::pthread_key_t)
+    {
+        ::pthread_key_create((::pthread_key_t*)m_key, cleanup);
+    }
+    ThreadLocal::~ThreadLocal()
+    {
+        ::pthread_key_delete(*(::pthread_key_t*)m_key);
+        delete (::pthread_key_t*)m_key;
+    }
+
+    // value management
+    void* ThreadLocal::get() const      { return ::pthread_getspecific(*(::pthread_key_t*)m_key); }
+    void  ThreadLocal::set(void* value) { ::pthread_setspecific(*(::pthread_key_t*)m_key, value); }
+
     //
     // SynchCondition implementation
     //
@@ -227,6 +358,33 @@ namespace kcc
         while (onTest()) ::pthread_cond_wait((pthread_cond_t*)m_cond, (pthread_mutex_t*)m_busy.m_mutex);
     }
 
+    // wait: wait for all events to complete, at most ms
+    bool SynchCondition::wait(long ms)
+    {
+        struct ::timespec until = {0};
+        #if defined(KCC_WINDOWS)
+            struct ::_timeb now;
+            ::_ftime(&now);
+            until.tv_sec  = now.time;
+            until.tv_nsec = now.millitm * 1000000L;
+        #elif defined(KCC_LINUX)
+            ::clock_gettime(CLOCK_REALTIME, &until);
+        #endif
+        until.tv_sec  += ms / 1000L;
+        until.tv_nsec += (ms % 1000L) * 1000000L;
+        if (until.tv_nsec >= 1000000000L)
+        {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        Mutex::Lock lock(m_busy);
+        while (onTest()) 
+        {
+            if (::pthread_cond_timedwait((pthread_cond_t*)m_cond, (pthread_mutex_t*)m_busy.m_mutex, &until) == ETIMEDOUT) return !onTest();
+        }
+        return true;
+    }
+
     //
     // Monitor implementation (Template methods (GOF) synch'd by caller)
     //
@@ -252,4 +410,248 @@ namespace kcc
         }
         return c;
     }
+
+    //
+    // Executor implementation
+    //
+
+    // Helper class for executor workers (Template methods (GOF) synch'd by caller)
+    //  - each worker deque is guarded by its worker lock: the owner takes from the back
+    //    (newest), other threads steal from the front (oldest)
+    //  - the condition counts queued tasks so idle workers sleep until work is queued
+    //  - workers exit once stopping and no tasks remain queued
+    struct Executor::Pool : SynchCondition
+    {
+        // Helper class for worker thread & deque
+        struct Worker : IThread
+        {
+            Pool&                  pool;
+            long                   index;
+            volatile unsigned long id;
+            Mutex                  lock;
+            std::deque<Future*>    tasks;
+            Worker(Pool& p, long i) : pool(p), index(i), id(0UL) {}
+            virtual void invoke() { pool.work(*this); }
+        };
+        typedef std::vector<Worker*> Workers;
+
+        // Attributes
+        Workers     workers;
+        Monitor     running;
+        long        queued;
+        long        next;
+        bool        stopping;
+        AtomicCount executed;
+        AtomicCount stolen;
+        Pool() : queued(0L), next(0L), stopping(false), executed(0L), stolen(0L) {}
+        ~Pool()
+        {
+            for (Workers::iterator i = workers.begin(); i != workers.end(); i++) delete *i;
+        }
+
+        // Template methods: task taken, task queued, idle
+        virtual void onBegin() { queued--; }
+        virtual void onEnd()   { queued++; }
+        virtual bool onTest()  { return queued <= 0L && !stopping; }
+
+        // self: worker of calling thread (or NULL)
+        Worker* self()
+        {
+            unsigned long t = Thread::current();
+            for (Workers::iterator i = workers.begin(); i != workers.end(); i++)
+            {
+                if ((*i)->id == t) return *i;
+            }
+            return NULL;
+        }
+
+        // queue: queue task to calling worker or next worker (false if stopping)
+        bool queue(Future* task)
+        {
+            Mutex::Lock lock(m_busy);
+            if (stopping) return false;
+            Worker* w = self();
+            if (w == NULL) w = workers[next++ % (long)workers.size()];
+            {
+                Mutex::Lock wlock(w->lock);
+                w->tasks.push_back(task);
+            }
+            notify();
+            return true;
+        }
+
+        // take: take newest task of worker, else steal oldest task of another worker
+        Future* take(Worker* w)
+        {
+            Future* task = NULL;
+            if (w != NULL)
+            {
+                Mutex::Lock wlock(w->lock);
+                if (!w->tasks.empty())
+                {
+                    task = w->tasks.back();
+                    w->tasks.pop_back();
+                }
+            }
+            long n     = (long)workers.size();
+            long first = w == NULL ? 0L : w->index + 1L;
+            for (long i = 0L; task == NULL && i < n; i++)
+            {
+                Worker* v = workers[(first + i) % n];
+                if (v == w) continue;
+                Mutex::Lock vlock(v->lock);
+                if (!v->tasks.empty())
+                {
+                    task = v->tasks.front();
+                    v->tasks.pop_front();
+                    stolen.increment();
+                }
+            }
+            if (task != NULL) init();
+            return task;
+        }
+
+        // run: run task
+        void run(Future* task)
+        {
+            executed.increment();
+            task->run();
+        }
+
+        // drained: query if stopping with no tasks queued
+        bool drained()
+        {
+            Mutex::Lock lock(m_busy);
+            return stopping && queued <= 0L;
+        }
+
+        // stop: stop accepting tasks and wake idle workers (false if already stopping)
+        bool stop()
+        {
+            Mutex::Lock lock(m_busy);
+            if (stopping) return false;
+            stopping = true;
+            ::pthread_cond_broadcast((pthread_cond_t*)m_cond);
+            return true;
+        }
+
+        // work: worker thread loop
+        void work(Worker& w)
+        {
+            w.id = Thread::current();
+            for (;;)
+            {
+                Future* task = take(&w);
+                if (task != NULL) run(task);
+                else if (drained()) break;
+                else wait();
+            }
+            running.notify();
+        }
+    };
+
+    // Executor: start workers
+    Executor::Executor(int threads, const Char* name) : m_pool(new Pool)
+    {
+        Log::Scope scope(KCC_FILE, "Executor");
+        if (threads <= 0) threads = processors();
+        for (long i = 0L; i < threads; i++) m_pool->workers.push_back(new Pool::Worker(*m_pool, i));
+        for (Pool::Workers::iterator i = m_pool->workers.begin(); i != m_pool->workers.end(); i++)
+        {
+            m_pool->running.init();
+            (new Thread(*i, name))->go();
+        }
+        Log::info3("executor started: name=[%s] threads=[%d]", name, threads);
+    }
+
+    // ~Executor: shut down and delete workers
+    Executor::~Executor()
+    {
+        shutdown();
+        delete m_pool;
+    }
+
+    // submit: queue task (run on calling thread once shut down)
+    void Executor::submit(Future* task)
+    {
+        KCC_ASSERT(task != NULL && task->completed(), KCC_FILE, "submit", "task null or already submitted");
+        task->m_executor = this;
+        task->m_error.clear();
+        task->m_done.init();
+        if (!m_pool->queue(task)) m_pool->run(task);
+    }
+
+    // shutdown: run queued tasks and wait for workers to exit
+    void Executor::shutdown()
+    {
+        Log::Scope scope(KCC_FILE, "Executor::shutdown");
+        if (!m_pool->stop()) return;
+        m_pool->running.wait();
+        Log::info3("executor stopped: executed=[%ld] stolen=[%ld]", executed(), stolen());
+    }
+
+    // help: run a queued task on calling thread
+    bool Executor::help()
+    {
+        Future* task = m_pool->take(m_pool->self());
+        if (task == NULL) return false;
+        m_pool->run(task);
+        return true;
+    }
+
+    // accessors
+    int  Executor::threads () const { return (int)m_pool->workers.size(); }
+    long Executor::executed() const { return m_pool->executed.get(); }
+    long Executor::stolen  () const { return m_pool->stolen.get(); }
+
+    // processors: online processors (queried once)
+    int Executor::processors()
+    {
+        static int k_processors = 0;
+        if (k_processors == 0)
+        {
+            long n = 1L;
+            #if defined(KCC_WINDOWS)
+                ::SYSTEM_INFO si;
+                ::GetSystemInfo(&si);
+                n = (long)si.dwNumberOfProcessors;
+            #elif defined(KCC_LINUX)
+                n = ::sysconf(_SC_NPROCESSORS_ONLN);
+            #endif
+            k_processors = n < 1L ? 1 : (int)n;
+        }
+        return k_processors;
+    }
+
+    // wait: wait for task, running queued tasks meanwhile if helping
+    bool Executor::Future::wait(bool help)
+    {
+        if (help && m_executor != NULL) while (!completed() && m_executor->help()) {}
+        m_done.wait();
+        return m_error.empty();
+    }
+
+    // run: run task, capturing uncaught exception
+    void Executor::Future::run()
+    {
+        Log::Scope scope(KCC_FILE, "Executor::Future::run");
+        try
+        {
+            invoke();
+        }
+        catch (Exception& e)
+        {
+            m_error = e.what();
+        }
+        catch (std::exception& e)
+        {
+            m_error = e.what();
+        }
+        catch (...)
+        {
+            m_error = "unknown exception";
+        }
+        if (!m_error.empty()) Log::info2("uncaught exception in task: [%s]", m_error.c_str());
+        m_done.notify();
+    }
 }
@@ -6,13 +6,20 @@
 #include <inc/core/Core.h>
 #include <inc/inet/IHTTP.h>
 
+#if defined(KCC_LINUX)
+#   include "errno.h"
+#   include "unistd.h"
+#   include "sys/socket.h"
+#   include "sys/epoll.h"
+#endif
+
 #define KCC_FILE    "HTTPServer"
 #define KCC_VERSION "$Id: HTTPServer.cpp 22625 2008-03-09 22:51:49Z tvk $"
 
 namespace kcc
 {
     // Constants
-    static const String k_httpHost      ("Host");
+    static const Dictionary::Key k_httpHost      ("Host");
     static const String k_notifyStartup ("startup");
     static const String k_notifyShutdown("shutdown");
     static const String k_notifyAction  ("action");
@@ -21,40 +28,132 @@ namespace kcc
     static const String k_notifyPort    ("port");
     static const String k_notifyWhen    ("when");
     static const String k_notifySep     (",");
+    static const String k_keyMode       ("HTTPServer.mode");
+    static const String k_keyIOThreads  ("HTTPServer.ioThreads");
+    static const String k_keyWorkers    ("HTTPServer.workers");
+    static const String k_keyWorkQueue  ("HTTPServer.workQueue");
+    static const String k_keyIdle       ("HTTPServer.idle");
+    static const String k_modeThreads   ("threads");
+    static const String k_modeReactor   ("reactor");
+    static const String k_defMode       (k_modeThreads);
+    static const long   k_defIOThreads  = 1L;
+    static const long   k_defWorkers    = 16L;
+    static const long   k_defWorkQueue  = 1024L;
+    static const long   k_defIdle       = 60L;  // secs
+    static const String k_keyKeepAliveMax  ("HTTPServer.keepAliveMax");
+    static const String k_keyKeepAliveIdle ("HTTPServer.keepAliveIdle");
+    static const long   k_defKeepAliveMax  = 100L;
+    static const long   k_defKeepAliveIdle = 15L; // secs
+    static const long   k_maxDrain         = 1024L*64L;
+    static const int    k_streamBuffer     = 1024*16; // streamed response buffer
+    static const String k_httpVersion11      ("HTTP/1.1");
+    static const Dictionary::Key k_httpContentType    ("Content-Type");
+    static const Dictionary::Key k_httpContentLength  ("Content-Length");
+    static const String k_httpContentTypeForm("application/x-www-form-urlencoded");
+
+    // Reactor constants
+    static const int               k_reactorPacket      = 1024*4;       //   4kb reads
+    static const String::size_type k_reactorMaxHeader   = 1024*256;     // 256kb max
+    static const String::size_type k_reactorMaxContent  = 1024*1024*64; //  64mb max
+    static const String::size_type k_reactorMaxChunked  = k_reactorMaxContent + k_reactorMaxHeader; // encoded (chunk lines & trailers)
+    static const int               k_reactorEvents      = 256;
+    static const int               k_reactorWaitMs      = 1000;
+    static const String            k_reactorEOL         ("\r\n");
+    static const String            k_reactorEOH         ("\r\n\r\n");
+    static const String            k_reactorUnavailable(
+        "HTTP/1.1 503 Service Unavailable\r\n"
+        "Server: KCC/1.0.0\r\n"
+        "Connection: close\r\n"
+        "Content-Length: 0\r\n\r\n");
     
-    // Helper class to parse an incoming request and delegate to a response handler
-    struct HTTPHandler : Thread, IHTTPRequestReader, IHTTPResponseWriter
+    // k_requestFraming: request content framing (see HTTP::contentLength), rejecting ambiguous
+    // framing (Content-Length with chunked, or repeated) that a proxy may frame differently
+    static long k_requestFraming(const Dictionary& attrs) throw (Socket::Failed)
+    {
+        long length = HTTP::contentLength(attrs);
+        if (attrs.count(k_httpContentLength) > 1 || (length == HTTP::F_CHUNKED && attrs.exists(k_httpContentLength)))
+            throw Socket::Failed("ambiguous request framing (Content-Length with chunked or repeated)");
+        return length;
+    }
+
+    // Helper class to stream a response through a bounded buffer (sent framed by Content-Length
+    // if content completes within the buffer, otherwise chunked)
+    struct HTTPExchange;
+    struct ResponseBuffer : std::streambuf
+    {
+        // Attributes
+        HTTPExchange*     m_exchange;
+        std::vector<char> m_buf;
+        Dictionary        m_headers;
+        int               m_response;
+        bool              m_open;
+        bool              m_committed;
+        ResponseBuffer(HTTPExchange* e) : m_exchange(e), m_buf(k_streamBuffer), m_response(HTTP::C_OK), m_open(false), m_committed(false) {}
+
+        // Implementation
+        void begin(const Dictionary& headers, int response);
+        void end() throw (Socket::Failed);
+        void discard() { m_open = false; setp(NULL, NULL); }
+        void send(bool last) throw (Socket::Failed);
+        int_type overflow(int_type c);
+        int sync() { return 0; } // content is sent when buffer fills (or response completes), not on flush
+    };
+
+    // Helper class to parse requests from a client and delegate to a response handler
+    struct HTTPExchange : IHTTPRequestReader, IHTTPResponseWriter
     {
         // Attributes
         Socket         m_client;
-        IHTTPResponse* m_reponse;
-        HTTPHandler(Socket::Handle h, IHTTPResponse* r, long send, long recv) :
-            Thread("HTTPHandler"), m_client(h), m_reponse(r)
+        IHTTPResponse* m_response;
+        long           m_maxRequests;
+        long           m_idleSec;
+        long           m_requests;
+        long           m_unread;
+        bool           m_persist;
+        bool           m_chunkable;
+        bool           m_chunked;
+        bool           m_responded;
+        ResponseBuffer m_streamBuf;
+        std::ostream   m_stream;
+        HTTPExchange(Socket::Handle h, IHTTPResponse* r, long send, long recv, long maxRequests, long idleSec) :
+            m_client(h), m_response(r), m_maxRequests(maxRequests), m_idleSec(idleSec), m_requests(0L), m_unread(0L),
+            m_persist(false), m_chunkable(false), m_chunked(false), m_responded(false), m_streamBuf(this), m_stream(&m_streamBuf)
         {
-            Log::Scope scope(KCC_FILE, "HTTPHandler::HTTPHandler");
+            Log::Scope scope(KCC_FILE, "HTTPExchange::HTTPExchange");
             m_client.setTimeout(Socket::T_SEND,    send, 0);
             m_client.setTimeout(Socket::T_RECEIVE, recv, 0);
+            if (maxRequests > 1L) m_client.setOption(Socket::O_NODELAY, 1); // keep-alive: don't hold response writes for delayed acks
         }
 
-        // invoke: parse request and delegate to response
-        void invoke()
+        // exchange: parse request and delegate to response, returning true if connection persists
+        bool exchange()
         {
-            Log::Scope scope(KCC_FILE, "HTTPHandler::invoke");
+            Log::Scope scope(KCC_FILE, "HTTPExchange::exchange");
             try
             {
                 // log request start
                 String addr(Strings::printf("%s:%d", m_client.ip().c_str(), m_client.port()));
                 if (Log::verbosity() >= Log::V_INFO_4)
-                    Log::info4("request started: client=[%s]", addr.c_str());
+                    Log::info4("request started: client=[%s] requests=[%d]", addr.c_str(), m_requests);
                 
-                // dispatch request to handler
+                // dispatch request to handler (last request on connection closes)
                 Timer t;
                 t.start();
                 HTTPRequest request;
-                HTTP::request(m_client, request);
-                m_reponse->onResponse(request, this, this);
-                m_client.close();
+                onRequest(request);
+                m_requests++;
+                m_persist   = m_requests < m_maxRequests && HTTP::keepAlive(request);
+                m_chunkable = request.version == k_httpVersion11;
+                m_chunked   = false;
+                m_responded = false;
+                m_streamBuf.discard();
+                m_response->onResponse(request, this, this);
+                m_streamBuf.end();
+                if (m_chunked) HTTP::chunk(m_client, NULL, 0);
                 t.stop();
+
+                // connection persists if response is complete and request content is consumed
+                bool persist = m_persist && m_responded && drain();
                 
                 // log request completion
                 if (Log::verbosity() >= Log::V_INFO_4)
@@ -74,61 +173,720 @@ namespace kcc
                         
                     }
                     Log::info4(
-                        "request completed: client=[%s] method=[%s] time=[%.3f] uri=[%s]", 
-                        addr.c_str(), request.method.c_str(), t.secs(), uri.c_str());
+                        "request completed: client=[%s] method=[%s] time=[%.3f] persist=[%d] uri=[%s]", 
+                        addr.c_str(), request.method.c_str(), t.secs(), persist, uri.c_str());
                 }
+                return persist;
             }
             catch (Exception& e)
             {
                 Log::exception(e);
-                m_client.close();
             }
+            return false;
+        }
+
+        // onRequest: Template method (GOF) - read request header from client
+        virtual void onRequest(HTTPRequest& request) throw (Socket::Failed) 
+        { 
+            HTTP::request(m_client, request); 
+
+            // request content remaining on socket (form content read with request)
+            m_unread = k_requestFraming(request.attributes);
+            if (m_unread == HTTP::F_CLOSE) m_unread = 0L; // request without framing has no content
+            if (request.method == HTTP::POST() && request.attributes[k_httpContentType] == k_httpContentTypeForm) m_unread = 0L;
+        }
+
+        // drain: Template method (GOF) - read unconsumed request content, false if connection can't persist
+        virtual bool drain() throw (Socket::Failed)
+        {
+            if (m_unread == 0L) return true;
+            if (m_unread < 0L || m_unread > k_maxDrain) return false;
+            char buf[k_reactorPacket];
+            int  actual = 0;
+            while (m_unread > 0L)
+            {
+                read(buf, k_reactorPacket, actual);
+                if (actual <= 0) return false;
+            }
+            return true;
         }
 
         // Implementation
-        void content (const Dictionary& attrs, String& data)     throw (Socket::Failed) { HTTP::content(m_client, attrs, data); }
-        void request (StringVector& headers, int& size)          throw (Socket::Failed) { HTTP::requestHeaders(m_client, headers, size); }
-        void read    (char* buf, int sz, int& actual)            throw (Socket::Failed) { m_client.read(buf, sz, actual); }
-        void write   (const char* buf, int sz)                   throw (Socket::Failed) { m_client.write(buf, sz); }
-        void response(const Dictionary& hdrs, int len, int resp) throw (Socket::Failed) { HTTP::response(m_client, hdrs, len, resp); }
-        void response(int resp)                                  throw (Socket::Failed) { HTTP::response(m_client, Dictionary::empty(), 0, resp); }
+        void content(const Dictionary& attrs, String& data) throw (Socket::Failed) 
+        { 
+            if (m_unread == 0L) data.clear();
+            else                HTTP::content(m_client, attrs, data); 
+            m_unread = 0L;
+        }
+        void request(StringVector& headers, int& size) throw (Socket::Failed) 
+        { 
+            HTTP::requestHeaders(m_client, headers, size); 
+            if (m_unread > 0L) m_unread = std::max(0L, m_unread - size);
+        }
+        void read(char* buf, int sz, int& actual) throw (Socket::Failed) 
+        { 
+            actual = 0;
+            if (m_unread == 0L) return;
+            if (m_unread > 0L) sz = (int)std::min((long)sz, m_unread);
+            m_client.read(buf, sz, actual); 
+            if (m_unread > 0L) m_unread -= actual;
+        }
+        void write(const char* buf, int sz) throw (Socket::Failed) 
+        { 
+            if (!m_chunked)  m_client.write(buf, sz); 
+            else if (sz > 0) HTTP::chunk(m_client, buf, sz);
+        }
+        void file(const String& path, long size) throw (Socket::Failed)
+        {
+            if (!m_chunked) 
+            {
+                m_client.writeFile(path, 0L, size);
+                return;
+            }
+            std::FILE* in = std::fopen(path.c_str(), "rb");
+            if (in == NULL) throw Socket::Failed("unable to open file: " + path);
+            char buf[k_reactorPacket];
+            int  actual = 0;
+            while (size > 0L && (actual = (int)std::fread(buf, 1, (std::size_t)std::min((long)k_reactorPacket, size), in)) > 0)
+            {
+                HTTP::chunk(m_client, buf, actual);
+                size -= actual;
+            }
+            std::fclose(in);
+        }
+        void response(const Dictionary& hdrs, int len, int resp) throw (Socket::Failed) 
+        { 
+            abandon();
+            commit(hdrs, len, resp);
+        }
+        void abandon() throw (Socket::Failed)
+        {
+            if (!m_streamBuf.m_open) return;
+            if (m_streamBuf.m_committed) 
+            {
+                m_persist = false;
+                throw Socket::Failed("response already streamed");
+            }
+            m_streamBuf.discard();
+        }
+        void commit(const Dictionary& hdrs, int len, int resp) throw (Socket::Failed) 
+        { 
+            if (len == HTTP::F_CHUNKED && !m_chunkable) len = HTTP::F_CLOSE; // HTTP/1.0 client
+            if (len == HTTP::F_CLOSE) m_persist = false;
+            m_chunked   = len == HTTP::F_CHUNKED;
+            m_responded = true;
+            HTTP::response(m_client, hdrs, len, resp, m_persist); 
+        }
+        void response(int resp) throw (Socket::Failed) { response(Dictionary::empty(), 0, resp); }
         void response(std::istream& in, const Dictionary& hdrs, int resp) throw (Socket::Failed)
         {
-            Log::Scope scope(KCC_FILE, "HTTPHandler::response");
-
-            // stream size (required for well-formed HTTP header, Content-Length, attribute)
-            in.seekg(0, std::ios::end);
-            int sz = (int)in.tellg();
-            in.seekg(0, std::ios::beg);
-            
-            // stream header and data
-            response(hdrs, sz, resp);
-            HTTP::write(m_client, in);
+            Log::Scope scope(KCC_FILE, "HTTPExchange::response");
+            std::ostream& out = stream(hdrs, resp);
+            char buf[k_reactorPacket];
+            while (in.good())
+            {
+                in.read(buf, k_reactorPacket);
+                out.write(buf, in.gcount());
+            }
+            m_streamBuf.end();
+        }
+        std::ostream& stream(const Dictionary& hdrs, int resp) throw (Socket::Failed)
+        {
+            abandon();
+            m_streamBuf.begin(hdrs, resp);
+            m_stream.clear();
+            return m_stream;
         }
         void xml(std::istream& in) throw (Socket::Failed)
         {
-            Log::Scope scope(KCC_FILE, "HTTPHandler::xml");
+            Log::Scope scope(KCC_FILE, "HTTPExchange::xml");
             Dictionary headers;
             HTTP::setHeadersXml(headers);
             response(in, headers, HTTP::C_OK);
         }
     };
 
+    //
+    // ResponseBuffer implementation
+    //
+
+    // begin: open buffer for response
+    void ResponseBuffer::begin(const Dictionary& headers, int response)
+    {
+        m_headers   = headers;
+        m_response  = response;
+        m_open      = true;
+        m_committed = false;
+        setp(&m_buf[0], &m_buf[0] + m_buf.size());
+    }
+
+    // end: send buffered content and complete response
+    void ResponseBuffer::end() throw (Socket::Failed)
+    {
+        if (!m_open) return;
+        send(true);
+        discard();
+    }
+
+    // send: send buffered content, committing response headers on first send
+    void ResponseBuffer::send(bool last) throw (Socket::Failed)
+    {
+        int sz = (int)(pptr() - pbase());
+        if (!m_committed)
+        {
+            m_exchange->commit(m_headers, last ? sz : HTTP::F_CHUNKED, m_response);
+            m_committed = true;
+        }
+        if (sz > 0) m_exchange->write(pbase(), sz);
+        setp(&m_buf[0], &m_buf[0] + m_buf.size());
+    }
+
+    // overflow: buffer full, send then buffer character
+    ResponseBuffer::int_type ResponseBuffer::overflow(int_type c)
+    {
+        if (!m_open) return traits_type::eof();
+        try
+        {
+            send(false);
+        }
+        catch (Socket::Failed& e)
+        {
+            Log::exception(e);
+            m_exchange->m_persist = false;
+            discard();
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    // Helper class to handle requests on a dedicated thread (thread-per-connection mode)
+    struct HTTPHandler : Thread, HTTPExchange
+    {
+        HTTPHandler(Socket::Handle h, IHTTPResponse* r, long send, long recv, long maxRequests, long idleSec) :
+            Thread("HTTPHandler"), HTTPExchange(h, r, send, recv, maxRequests, idleSec)
+        {}
+
+        // invoke: exchange requests (in order) while connection persists
+        void invoke() 
+        { 
+            while (exchange() && m_client.wait(m_idleSec));
+            m_client.close();
+        }
+    };
+
+    // Helper interface to receive accepted client connections
+    interface IHTTPAcceptor : IComponent
+    {
+        virtual void accept(Socket::Handle h) = 0;
+    };
+
+#if defined(KCC_LINUX)
+    // Reactor connection: request read without blocking by an I/O thread then exchanged by a worker
+    struct ReactorIO;
+    struct ReactorConnection : HTTPExchange
+    {
+        /** Read states */
+        enum ReadState { R_PENDING, R_COMPLETE, R_CLOSED };
+
+        // Attributes
+        ReactorIO*        m_io;
+        Socket::Handle    m_handle;
+        String            m_buffer;
+        String            m_content;
+        HTTPRequest       m_request; // header framed (parameters parsed once content is read)
+        HTTP::Chunked     m_chunks;  // chunked content decoded so far
+        String            m_query;
+        String::size_type m_header;
+        String::size_type m_length;
+        String::size_type m_offset;
+        bool              m_framed;
+        bool              m_requestChunked; // request content chunked (HTTPExchange::m_chunked: response)
+        std::time_t       m_accessed;
+        ReactorConnection(Socket::Handle h, IHTTPResponse* r, long send, long recv, long maxRequests, long idleSec) :
+            HTTPExchange(h, r, send, recv, maxRequests, idleSec),
+            m_io(NULL), m_handle(h), m_header(String::npos), m_length(0), m_offset(0), 
+            m_framed(false), m_requestChunked(false), m_accessed(std::time(NULL))
+        {
+            m_buffer.reserve(k_reactorPacket);
+        }
+
+        // onReadable: read available data (I/O thread), returning when the request is complete
+        ReadState onReadable()
+        {
+            char buf[k_reactorPacket];
+            while (true)
+            {
+                int actual = ::recv(m_handle, buf, k_reactorPacket, MSG_DONTWAIT);
+                if (actual == 0) return R_CLOSED;
+                if (actual < 0)
+                {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    return R_CLOSED;
+                }
+                m_buffer.append(buf, actual);
+                if (actual < k_reactorPacket) break;
+            }
+            std::time(&m_accessed);
+            return frame();
+        }
+
+        // next: discard exchanged request and frame next (pipelined) request
+        ReadState next()
+        {
+            m_buffer.erase(0, m_header + m_length);
+            m_content.clear();
+            m_request.attributes.clear();
+            m_query.clear();
+            m_chunks         = HTTP::Chunked();
+            m_header         = String::npos;
+            m_length         = 0;
+            m_offset         = 0;
+            m_framed         = false;
+            m_requestChunked = false;
+            std::time(&m_accessed);
+            return frame();
+        }
+
+        // frame: frame request header and content in buffer
+        ReadState frame()
+        {
+            // header: EOL+EOL then content framing
+            if (m_header == String::npos)
+            {
+                String::size_type eoh = m_buffer.find(k_reactorEOH);
+                if (eoh == String::npos)
+                {
+                    if (m_buffer.size() > k_reactorMaxHeader) 
+                    {
+                        Log::warning("http header too large: client=[%s:%d]", m_client.ip().c_str(), m_client.port());
+                        return R_CLOSED;
+                    }
+                    return R_PENDING;
+                }
+                m_header = eoh + k_reactorEOH.size();
+                long length = HTTP::F_CLOSE;
+                try
+                {
+                    m_query = HTTP::requestHeader(m_buffer.substr(0, m_header), m_request);
+                    length  = k_requestFraming(m_request.attributes);
+                }
+                catch (Socket::Failed& e)
+                {
+                    Log::warning("%s: client=[%s:%d]", e.what(), m_client.ip().c_str(), m_client.port());
+                    return R_CLOSED;
+                }
+                if (length == HTTP::F_CHUNKED)
+                {
+                    m_requestChunked = true;
+                }
+                else if (length != HTTP::F_CLOSE) // request without framing has no content
+                {
+                    if (length < 0L || length > (long)k_reactorMaxContent)
+                    {
+                        Log::warning("maximum content size exceeded: client=[%s:%d] sz=[%ld]", m_client.ip().c_str(), m_client.port(), length);
+                        return R_CLOSED;
+                    }
+                    m_length = (String::size_type)length;
+                    m_framed = true;
+                }
+            }
+
+            // chunked content
+            if (m_requestChunked)
+            {
+                try
+                {
+                    String::size_type length = HTTP::dechunk(m_buffer, m_header, m_chunks, m_content);
+                    if (length == String::npos) 
+                    {
+                        if (m_buffer.size() - m_header <= k_reactorMaxChunked) return R_PENDING;
+                        Log::warning("maximum chunked content size exceeded: client=[%s:%d] sz=[%ld]", m_client.ip().c_str(), m_client.port(), (long)(m_buffer.size() - m_header));
+                        return R_CLOSED;
+                    }
+                    m_length = length;
+                    m_framed = true;
+                    return R_COMPLETE;
+                }
+                catch (Socket::Failed& e)
+                {
+                    Log::warning("%s: client=[%s:%d]", e.what(), m_client.ip().c_str(), m_client.port());
+                    return R_CLOSED;
+                }
+            }
+
+            // content
+            return m_buffer.size() >= m_header + m_length ? R_COMPLETE : R_PENDING;
+        }
+
+        // idle: query if connection has been idle (awaiting request or keep-alive idle)
+        bool idle(std::time_t now, long timeout) 
+        { 
+            if (m_requests > 0L && m_buffer.empty()) timeout = m_idleSec;
+            return (long)(now - m_accessed) > timeout; 
+        }
+
+        // body: buffered request content
+        const char*       body()     { return m_requestChunked ? m_content.data() : m_buffer.data() + m_header; }
+        String::size_type bodySize() { return m_requestChunked ? m_content.size() : m_length; }
+
+        // onRequest: take request header framed from buffer and parse parameters from content
+        void onRequest(HTTPRequest& request) throw (Socket::Failed)
+        {
+            request.ip   = m_client.ip();
+            request.port = m_client.port();
+            m_offset = 0;
+            m_unread = 0L; // content is buffered
+            request.method.swap(m_request.method);
+            request.path.swap(m_request.path);
+            request.version.swap(m_request.version);
+            request.attributes.swap(m_request.attributes);
+            HTTP::requestParameters(m_query, String(body(), bodySize()), request);
+        }
+
+        // unavailable: refuse request without blocking (best effort, connection is closed)
+        void unavailable()
+        {
+            ::send(m_handle, k_reactorUnavailable.data(), k_reactorUnavailable.size(), MSG_DONTWAIT|MSG_NOSIGNAL);
+        }
+
+        // drain: buffered content is discarded by next()
+        bool drain() throw (Socket::Failed) { return true; }
+
+        // Implementation: serve request content from buffer
+        void request(StringVector& headers, int& size) throw (Socket::Failed)
+        {
+            // headers within content (e.g. multi-part form)
+            headers.clear();
+            size = 0;
+            String content(body() + m_offset, bodySize() - m_offset);
+            String::size_type eoh = content.find(k_reactorEOH);
+            if (eoh == String::npos) throw Socket::Failed("http header not read; content ended");
+            size = (int)(eoh + k_reactorEOH.size());
+            Strings::tokenize(content.substr(0, eoh), k_reactorEOL, headers);
+            m_offset += size;
+        }
+        void content(const Dictionary& attrs, String& data) throw (Socket::Failed)
+        {
+            data.assign(body() + m_offset, bodySize() - m_offset);
+            m_offset = bodySize();
+        }
+        void read(char* buf, int sz, int& actual) throw (Socket::Failed)
+        {
+            actual = (int)std::min(bodySize() - m_offset, (String::size_type)sz);
+            std::memcpy(buf, body() + m_offset, actual);
+            m_offset += actual;
+        }
+    };
+    typedef std::set<ReactorConnection*> ReactorConnections;
+
+    // Reactor work queue: bounded queue of complete requests pending a worker
+    struct ReactorQueue : SynchCondition
+    {
+        // Attributes
+        std::deque<ReactorConnection*> m_pending;
+        std::size_t                    m_max;
+        bool                           m_closed;
+        ReactorQueue(std::size_t max) : m_max(max), m_closed(false) {}
+        ~ReactorQueue() { close(); }
+
+        // push: queue connection, false if queue full or closed
+        bool push(ReactorConnection* c)
+        {
+            {
+                Mutex::Lock lock(m_busy);
+                if (m_closed || m_pending.size() >= m_max) return false;
+                m_pending.push_back(c);
+            }
+            notify();
+            return true;
+        }
+
+        // pop: wait for connection, NULL if queue closed
+        ReactorConnection* pop()
+        {
+            while (true)
+            {
+                wait();
+                Mutex::Lock lock(m_busy);
+                if (m_closed) return NULL;
+                if (!m_pending.empty())
+                {
+                    ReactorConnection* c = m_pending.front();
+                    m_pending.pop_front();
+                    return c;
+                }
+            }
+        }
+
+        // close: close queue, release pending connections, and wake all workers
+        void close()
+        {
+            {
+                Mutex::Lock lock(m_busy);
+                m_closed = true;
+                for (std::deque<ReactorConnection*>::iterator i = m_pending.begin(); i != m_pending.end(); i++) delete *i;
+                m_pending.clear();
+            }
+            notifyAll();
+        }
+
+    protected:
+        // Implementation
+        void onBegin() {}
+        void onEnd()   {}
+        bool onTest()  { return m_pending.empty() && !m_closed; }
+    };
+
+    // Reactor I/O thread: multiplex client sockets until requests are complete
+    struct ReactorIO : Thread
+    {
+        // Attributes
+        int                m_epoll;
+        ReactorConnections m_connections;
+        ReactorQueue&      m_queue;
+        Monitor&           m_running;
+        long               m_idle;
+        volatile bool      m_stopped;
+        Mutex              m_sentinel;
+        ReactorIO(ReactorQueue& q, Monitor& running, long idle) : 
+            Thread("ReactorIO"), m_epoll(::epoll_create(k_reactorEvents)), m_queue(q), m_running(running), m_idle(idle), m_stopped(false)
+        {
+            m_running.init();
+        }
+        ~ReactorIO() { if (m_epoll >= 0) ::close(m_epoll); }
+
+        // add: register connection for read events (ownership consumed)
+        void add(ReactorConnection* c)
+        {
+            Mutex::Lock lock(m_sentinel);
+            struct ::epoll_event e = {0};
+            e.events   = EPOLLIN|EPOLLONESHOT;
+            e.data.ptr = c;
+            c->m_io    = this;
+            if (m_stopped || ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, c->m_handle, &e) < 0)
+            {
+                Log::warning("reactor connection not registered: client=[%s:%d] errno=[%d]", c->m_client.ip().c_str(), c->m_client.port(), errno);
+                delete c;
+                return;
+            }
+            m_connections.insert(c);
+        }
+
+        // stop: stop on next event wait
+        void stop() { m_stopped = true; }
+
+        // invoke: wait for events, handing complete requests to workers
+        void invoke()
+        {
+            Log::Scope scope(KCC_FILE, "ReactorIO::invoke");
+            struct ::epoll_event events[k_reactorEvents];
+            std::time_t swept = std::time(NULL);
+            while (!m_stopped)
+            {
+                int n = ::epoll_wait(m_epoll, events, k_reactorEvents, k_reactorWaitMs);
+                if (n < 0 && errno != EINTR) 
+                {
+                    Log::error("reactor event wait failed: errno=[%d]", errno);
+                    Thread::sleep(k_reactorWaitMs);
+                    continue;
+                }
+                for (int i = 0; i < n; i++) onEvent(static_cast<ReactorConnection*>(events[i].data.ptr));
+                
+                // sweep idle connections
+                std::time_t now = std::time(NULL);
+                if (now != swept)
+                {
+                    swept = now;
+                    Mutex::Lock lock(m_sentinel);
+                    for (ReactorConnections::iterator c = m_connections.begin(); c != m_connections.end();)
+                    {
+                        ReactorConnection* idle = *c++;
+                        if (!idle->idle(now, m_idle)) continue;
+                        Log::info4("reactor connection idle: client=[%s:%d]", idle->m_client.ip().c_str(), idle->m_client.port());
+                        remove(idle);
+                        delete idle;
+                    }
+                }
+            }
+            
+            // release open connections
+            {
+                Mutex::Lock lock(m_sentinel);
+                m_stopped = true;
+                for (ReactorConnections::iterator c = m_connections.begin(); c != m_connections.end(); c++) delete *c;
+                m_connections.clear();
+            }
+            m_running.notify();
+        }
+
+        // onEvent: read from connection and dispatch if complete
+        void onEvent(ReactorConnection* c)
+        {
+            ReactorConnection* refused = NULL;
+            {
+                Mutex::Lock lock(m_sentinel);
+                switch (c->onReadable())
+                {
+                    case ReactorConnection::R_PENDING:
+                    {
+                        // re-arm for next read
+                        struct ::epoll_event e = {0};
+                        e.events   = EPOLLIN|EPOLLONESHOT;
+                        e.data.ptr = c;
+                        if (::epoll_ctl(m_epoll, EPOLL_CTL_MOD, c->m_handle, &e) == 0) break;
+                        remove(c);
+                        delete c;
+                        break;
+                    }
+                    case ReactorConnection::R_COMPLETE:
+                    {
+                        // hand request to worker, ownership of connection passed to queue
+                        remove(c);
+                        if (!m_queue.push(c)) refused = c;
+                        break;
+                    }
+                    case ReactorConnection::R_CLOSED:
+                    {
+                        remove(c);
+                        delete c;
+                        break;
+                    }
+                }
+            }
+
+            // work queue full: refuse request (unregistered connection is owned here)
+            if (refused != NULL)
+            {
+                Log::warning("reactor work queue full: client=[%s:%d]", refused->m_client.ip().c_str(), refused->m_client.port());
+                refused->unavailable();
+                delete refused;
+            }
+        }
+
+        // remove: unregister connection (caller owns connection)
+        void remove(ReactorConnection* c)
+        {
+            ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, c->m_handle, NULL);
+            m_connections.erase(c);
+        }
+    };
+    typedef std::vector<ReactorIO*> ReactorIOs;
+
+    // Reactor worker: exchange complete requests, returning persistent connections to their I/O thread
+    struct ReactorWorker : Thread
+    {
+        // Attributes
+        ReactorQueue& m_queue;
+        Monitor&      m_running;
+        ReactorWorker(ReactorQueue& q, Monitor& running) : Thread("ReactorWorker"), m_queue(q), m_running(running)
+        {
+            m_running.init();
+        }
+
+        // invoke: exchange requests until queue closed
+        void invoke()
+        {
+            Log::Scope scope(KCC_FILE, "ReactorWorker::invoke");
+            ReactorConnection* c = NULL;
+            while ((c = m_queue.pop()) != NULL)
+            {
+                // exchange buffered (pipelined) requests in order
+                ReactorConnection::ReadState state = ReactorConnection::R_CLOSED;
+                while (c->exchange() && (state = c->next()) == ReactorConnection::R_COMPLETE);
+                if (state == ReactorConnection::R_PENDING) c->m_io->add(c);
+                else                                       delete c;
+            }
+            m_running.notify();
+        }
+    };
+
+    // Reactor: accept connections onto I/O threads that hand complete requests to a bounded worker pool
+    struct HTTPReactor : IHTTPAcceptor
+    {
+        // Attributes
+        ReactorQueue   m_queue;
+        ReactorIOs     m_io;
+        Monitor        m_ioRunning;
+        Monitor        m_workersRunning;
+        IHTTPResponse* m_response;
+        long           m_send;
+        long           m_recv;
+        long           m_maxRequests;
+        long           m_idleSec;
+        std::size_t    m_next;
+        HTTPReactor(
+            IHTTPResponse* r, long send, long recv, long maxRequests, long idleSec,
+            long ioThreads, long workers, long queue, long idle) 
+            :
+            m_queue((std::size_t)queue), m_response(r), m_send(send), m_recv(recv), 
+            m_maxRequests(maxRequests), m_idleSec(idleSec), m_next(0)
+        {
+            Log::Scope scope(KCC_FILE, "HTTPReactor::HTTPReactor");
+            for (long i = 0; i < workers; i++) (new ReactorWorker(m_queue, m_workersRunning))->go();
+            for (long i = 0; i < ioThreads; i++) 
+            {
+                ReactorIO* io = new ReactorIO(m_queue, m_ioRunning, idle);
+                m_io.push_back(io);
+                io->go();
+            }
+        }
+
+        // accept: assign connection to an I/O thread (round robin)
+        void accept(Socket::Handle h)
+        {
+            ReactorConnection* c = NULL;
+            try
+            {
+                c = new ReactorConnection(h, m_response, m_send, m_recv, m_maxRequests, m_idleSec);
+            }
+            catch (Socket::Failed& e)
+            {
+                Log::exception(e);
+                return;
+            }
+            m_io[m_next++ % m_io.size()]->add(c);
+        }
+
+        // stop: stop workers, then I/O threads (workers return connections to I/O threads), and wait for completion
+        void stop()
+        {
+            Log::Scope scope(KCC_FILE, "HTTPReactor::stop");
+            m_queue.close();
+            m_workersRunning.wait();
+            for (ReactorIOs::iterator i = m_io.begin(); i != m_io.end(); i++) (*i)->stop();
+            m_ioRunning.wait();
+            m_io.clear();
+        }
+    };
+#endif
+
     // Helper class to listen for incoming HTTP requests
     struct HTTPListener : Thread
     {
         // Attributes
         SocketServer   m_server;
         IHTTPResponse* m_response;
+        IHTTPAcceptor* m_acceptor;
         long           m_send;
         long           m_recv;
-        HTTPListener(const String& host, int port, IHTTPResponse* r, int queue, long send, long recv) :
+        long           m_maxRequests;
+        long           m_idleSec;
+        HTTPListener(
+            const String& host, int port, IHTTPResponse* r, IHTTPAcceptor* a, int queue, 
+            long send, long recv, long maxRequests, long idleSec) 
+            :
             Thread("HTTPListener"),
             m_server(host, port, queue),
-            m_response(r), m_send(send), m_recv(recv)
+            m_response(r), m_acceptor(a), m_send(send), m_recv(recv), m_maxRequests(maxRequests), m_idleSec(idleSec)
         {}
 
-        // invoke: delegate requests to request handler
+        // invoke: delegate requests to request handler or acceptor
         void invoke()
         {
             Log::Scope scope(KCC_FILE, "HTTPListener::invoke");
@@ -137,7 +895,8 @@ namespace kcc
                 while (true)
                 {
                     Socket::Handle h = m_server.accept();
-                    (new HTTPHandler(h, m_response, m_send, m_recv))->go();
+                    if (m_acceptor != NULL) m_acceptor->accept(h);
+                    else                    (new HTTPHandler(h, m_response, m_send, m_recv, m_maxRequests, m_idleSec))->go();
                 }
             }
             catch (SocketServer::Closed&)
@@ -437,7 +1196,17 @@ namespace kcc
         int            m_queue;
         long           m_send;
         long           m_recv;
+        String         m_mode;
+        long           m_ioThreads;
+        long           m_workers;
+        long           m_workQueue;
+        long           m_idle;
+        long           m_keepAliveMax;
+        long           m_keepAliveIdle;
         Mutex          m_sentinel;
+        #if defined(KCC_LINUX)
+        AutoPtr<HTTPReactor> m_reactor;
+        #endif
         HTTPServer() : m_listener(NULL) 
         {}
 
@@ -453,9 +1222,46 @@ namespace kcc
             m_queue     = queue;
             m_send      = sendWaitSec;
             m_recv      = recvWaitSec;
+            m_mode      = Core::properties().get(k_keyMode,      k_defMode);
+            m_ioThreads = Core::properties().get(k_keyIOThreads, k_defIOThreads);
+            m_workers   = Core::properties().get(k_keyWorkers,   k_defWorkers);
+            m_workQueue = Core::properties().get(k_keyWorkQueue, k_defWorkQueue);
+            m_idle      = Core::properties().get(k_keyIdle,      m_recv > 0L ? m_recv : k_defIdle);
+            m_keepAliveMax  = Core::properties().get(k_keyKeepAliveMax,  k_defKeepAliveMax);
+            m_keepAliveIdle = Core::properties().get(k_keyKeepAliveIdle, k_defKeepAliveIdle);
+            if (m_mode != k_modeThreads && m_mode != k_modeReactor)
+            {
+                Log::error("HTTPServer mode not supported: mode=[%s]", m_mode.c_str());
+                return false;
+            }
+            #if !defined(KCC_LINUX)
+                if (m_mode == k_modeReactor)
+                {
+                    Log::warning("HTTPServer reactor mode not available on platform, using threads");
+                    m_mode = k_modeThreads;
+                }
+            #endif
+            if (m_mode == k_modeReactor && (m_ioThreads < 1L || m_workers < 1L || m_workQueue < 1L))
+            {
+                Log::error(
+                    "HTTPServer reactor not configured: ioThreads=[%d] workers=[%d] workQueue=[%d]", 
+                    m_ioThreads, m_workers, m_workQueue);
+                return false;
+            }
+            if (m_keepAliveMax < 1L || m_keepAliveIdle < 0L)
+            {
+                Log::error(
+                    "HTTPServer keep-alive not configured: keepAliveMax=[%d] keepAliveIdle=[%d]", 
+                    m_keepAliveMax, m_keepAliveIdle);
+                return false;
+            }
             Log::info2(
-                "HTTPServer initialized: service=[%s:%d] notify=[%s] queue=[%d] sendWait=[%d] recvWait=[%d]", 
-                m_host.c_str(), m_port, m_notifyURL.c_str(), m_queue, m_send, m_recv);
+                "HTTPServer initialized: service=[%s:%d] notify=[%s] queue=[%d] sendWait=[%d] recvWait=[%d] mode=[%s] keepAliveMax=[%d] keepAliveIdle=[%d]", 
+                m_host.c_str(), m_port, m_notifyURL.c_str(), m_queue, m_send, m_recv, m_mode.c_str(), m_keepAliveMax, m_keepAliveIdle);
+            if (m_mode == k_modeReactor)
+                Log::info2(
+                    "HTTPServer reactor: ioThreads=[%d] workers=[%d] workQueue=[%d] idle=[%d]", 
+                    m_ioThreads, m_workers, m_workQueue, m_idle);
             return true;
         }
         
@@ -470,8 +1276,17 @@ namespace kcc
             KCC_ASSERT(NULL == m_listener, KCC_FILE, "start", "HTTPServer already running");
             Mutex::Lock lock(m_sentinel);
             
-            // start server listener
-            m_listener = new HTTPListener(m_host, m_port, m_response, m_queue, m_send, m_recv);
+            // start server listener (and reactor)
+            IHTTPAcceptor* acceptor = NULL;
+            #if defined(KCC_LINUX)
+                if (m_mode == k_modeReactor)
+                {
+                    m_reactor = new HTTPReactor(
+                        m_response, m_send, m_recv, m_keepAliveMax, m_keepAliveIdle, m_ioThreads, m_workers, m_workQueue, m_idle);
+                    acceptor  = m_reactor;
+                }
+            #endif
+            m_listener = new HTTPListener(m_host, m_port, m_response, acceptor, m_queue, m_send, m_recv, m_keepAliveMax, m_keepAliveIdle);
             try
             {
                 m_listener->start();
@@ -480,6 +1295,7 @@ namespace kcc
             {
                 delete m_listener;
                 m_listener = NULL;
+                stopReactor();
                 throw;
             }
             
@@ -492,6 +1308,7 @@ namespace kcc
             {
                 m_listener->stop();
                 m_listener = NULL;
+                stopReactor();
                 throw;
             }
         }
@@ -503,13 +1320,24 @@ namespace kcc
             Mutex::Lock lock(m_sentinel);
             if (m_listener == NULL) return;
 
-            // stop server listener                
+            // stop server listener (and reactor once no longer accepting)
             m_listener->stop();
             m_listener = NULL;
+            stopReactor();
             
             // notify of shutdown
             notify(k_notifyShutdown);
        }
+
+       // stopReactor: stop reactor threads if running
+       void stopReactor()
+       {
+            #if defined(KCC_LINUX)
+                if (m_reactor == NULL) return;
+                m_reactor->stop();
+                m_reactor.reset();
+            #endif
+       }
        
        // notify: notify of action
        void notify(const String& action) throw (Socket::Failed)
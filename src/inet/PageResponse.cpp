@@ -5,6 +5,7 @@
  */
 #include <inc/core/Core.h>
 #include <inc/inet/IPageResponse.h>
+#include <inc/zip/IZip.h>
 
 #define KCC_FILE    "PageResponse"
 #define KCC_VERSION "$Id: PageResponse.cpp 22776 2008-03-24 20:36:12Z tvk $"
@@ -14,7 +15,13 @@ namespace kcc
     // Configuration
     static const String k_keyXformComponent("PageResponse.xformComponent");
     static const String k_keyAppPath       ("PageResponse.appPath");
+    static const String k_keyZipComponent  ("PageResponse.zipComponent");
+    static const String k_keyCacheSize     ("PageResponse.cacheSize");
+    static const String k_keyCacheResource ("PageResponse.cacheResourceMax");
     static const String k_defXformComponent("k_transform");
+    static const String k_defZipComponent  ("k_zlib");
+    static const long   k_defCacheSize     = 1024L*1024L*4L; // 4mb of cached resources
+    static const long   k_defCacheResource = 1024L*64L;      // 64kb largest cached resource (larger use sendfile)
 
     // Constants
     static const std::size_t k_sz = 1024;
@@ -40,21 +47,157 @@ namespace kcc
         { ".xslt",  k_xml                   },
         {}
     };
+    static const unsigned long k_gzipMin = 256UL; // smallest resource worth compressing
     static const String k_httpLastModified      ("Last-Modified");
-    static const String k_httpIfModifiedSince   ("If-Modified-Since");
+    static const String k_httpETag              ("ETag");
+    static const Dictionary::Key k_httpIfNoneMatch       ("If-None-Match");
+    static const Dictionary::Key k_httpAcceptEncoding    ("Accept-Encoding");
+    static const String k_httpContentEncoding   ("Content-Encoding");
+    static const String k_httpVary              ("Vary");
+    static const String k_httpGZip              ("gzip");
+    static const String k_httpAnyMatch          ("*");
+    static const Dictionary::Key k_httpIfModifiedSince   ("If-Modified-Since");
     static const String k_httpValueLength       ("length");
-    static const String k_httpContentType       ("Content-Type");
-    static const String k_httpContentLength     ("Content-Length");
+    static const Dictionary::Key k_httpContentType       ("Content-Type");
+    static const Dictionary::Key k_httpContentLength     ("Content-Length");
     static const String k_httpContentDisposition("Content-Disposition");
     static const String k_httpContentTypeMPForm ("multipart/form-data");
     static const String k_httpMPFormBoundary    ("boundary=");
     static const String k_httpMPMarker          ("--");
-    static const String k_httpMPFormTrailer     (k_httpMPMarker + "\r\n");
+    static const String k_httpEOL               ("\r\n");
+    static const String k_httpHeadersEnd        ("\r\n\r\n");
+    static const int    k_formBlock = 1024*64; // multi-part form read buffer (bounds part headers)
+
+    // Mime table: open addressed hash of extension to mime type (built once, read-only after)
+    struct MimeTable
+    {
+        enum { szBuckets = 64 }; // power of 2, well over twice the extensions
+        const String* m_ext [szBuckets];
+        const String* m_mime[szBuckets];
+        MimeTable()
+        {
+            std::memset(m_ext,  0, sizeof(m_ext));
+            std::memset(m_mime, 0, sizeof(m_mime));
+            for (int i = 0; !k_mimes[i][0].empty(); i++)
+            {
+                const String& ext = k_mimes[i][0];
+                unsigned long b = hash(ext.data(), ext.data() + ext.size());
+                while (m_ext[b] != NULL) b = (b + 1) & (szBuckets - 1);
+                m_ext [b] = &k_mimes[i][0];
+                m_mime[b] = &k_mimes[i][1];
+            }
+        }
+
+        // hash: FNV-1a of extension, reduced to bucket
+        static unsigned long hash(const char* b, const char* e)
+        {
+            unsigned long h = 2166136261UL;
+            for (; b != e; b++) h = (h ^ (unsigned char)*b) * 16777619UL;
+            return h & (szBuckets - 1);
+        }
+
+        // lookup: mime of file name by extension (text if unknown)
+        const String& lookup(const String& name) const
+        {
+            String::size_type dot = name.rfind('.');
+            if (dot == String::npos || dot == 0) return k_text;
+            const char* b = name.data() + dot;
+            const char* e = name.data() + name.size();
+            std::size_t sz = e - b;
+            for (unsigned long i = hash(b, e); m_ext[i] != NULL; i = (i + 1) & (szBuckets - 1))
+            {
+                if (m_ext[i]->size() == sz && std::memcmp(m_ext[i]->data(), b, sz) == 0) return *m_mime[i];
+            }
+            return k_text;
+        }
+    };
+    static const MimeTable k_mimeTable;
+
+    // acceptsGZip: Accept-Encoding lists gzip (or "*") with a non-zero quality; q=0 is a refusal
+    static bool acceptsGZip(const String& acceptEncoding)
+    {
+        StringVector codings, params;
+        Strings::tokenize(acceptEncoding, ",", codings);
+        int any = -1; // quality of "*": unlisted (-1), refused (0), accepted (1)
+        for (StringVector::const_iterator i = codings.begin(); i != codings.end(); i++)
+        {
+            Strings::tokenize(*i, ";", params);
+            if (params.empty()) continue;
+            bool accepted = true;
+            for (StringVector::size_type j = 1; j < params.size(); j++)
+            {
+                String::size_type eq = params[j].find('=');
+                if (eq != String::npos && Strings::trimws(params[j].substr(0, eq)) == "q") 
+                    accepted = Strings::parseFraction(params[j].substr(eq + 1)) > 0.0;
+            }
+            String coding(params[0]);
+            Strings::toLower(coding);
+            if (coding == k_httpGZip) return accepted;
+            if (coding == k_httpAnyMatch) any = accepted ? 1 : 0;
+        }
+        return any == 1;
+    }
 
     //
     // Declarations
     //
 
+    // Cached resource: content with precomputed headers and gzip variant (refcounted, cache holds a reference)
+    struct Resource
+    {
+        typedef std::list<Resource*> LRU;
+        String        m_path;
+        std::time_t   m_modified;
+        unsigned long m_size;
+        String        m_etag;
+        String        m_gzipETag;
+        Dictionary    m_headers;
+        Dictionary    m_gzipHeaders;
+        String        m_content;
+        String        m_gzip;
+        long          m_refs;
+        LRU::iterator m_lru;
+        Resource(const String& fp, const Platform::File& res) : m_path(fp), m_modified(res.modified), m_size(res.size), m_refs(1L) {}
+        inline unsigned long bytes() const { return (unsigned long)(m_content.size() + m_gzip.size()); }
+    };
+
+    // Resource cache: bounded LRU of small resources, invalidated by modified time and size
+    struct ResourceCache
+    {
+        typedef std::map<String, Resource*> Entries;
+
+        // Handle: holds reference on a resource for its lifetime
+        struct Handle
+        {
+            ResourceCache& m_cache;
+            Resource*      m_resource;
+            Handle(ResourceCache& c, Resource* r) : m_cache(c), m_resource(r) {}
+            ~Handle() { if (m_resource != NULL) m_cache.release(m_resource); }
+        private:
+            Handle(const Handle&);
+            Handle& operator = (const Handle&);
+        };
+
+        // Attributes
+        Mutex         m_sentinel;
+        Entries       m_entries;
+        Resource::LRU m_lru;
+        unsigned long m_bytes;
+        unsigned long m_maxBytes;
+        unsigned long m_maxResource;
+        IZipFactory*  m_zip;
+        ResourceCache() : m_bytes(0UL), m_maxBytes(0UL), m_maxResource(0UL), m_zip(NULL) {}
+        ~ResourceCache() { clear(); }
+
+        // Implementation
+        void      init(const Properties& config);
+        void      clear();
+        Resource* acquire(const String& fp, const Platform::File& res, const String& mime, const String& modified);
+        Resource* load(const String& fp, const Platform::File& res, const String& mime, const String& modified);
+        void      release(Resource* r);
+        void      remove(Entries::iterator e);
+    };
+
     // Page response
     struct PageResponse : IPageResponse
     {
@@ -63,6 +206,7 @@ namespace kcc
         StringMap              m_xforms;
         String                 m_appPath;
         AutoPtr<IXMLTransform> m_transform;
+        ResourceCache          m_cache;
 
         // Implementation
         bool init(const Properties& config, const Handlers& handlers, const StringMap& xforms);
@@ -86,33 +230,48 @@ namespace kcc
         IPageFormReader* beginForm(const Dictionary& attributes) throw (Socket::Failed);
     };
 
-    // Page form reader
+    // Page form reader: streaming multipart/form-data parser over block reads. Parts are delimited
+    // by CRLF "--" boundary, located with a Boyer-Moore-Horspool search of the read buffer.
     struct PageFormReader : IPageFormReader
     {
         // Attributes
-        enum { szMarker = 64, szContent = 2048 };
+        enum State { S_BOUNDARY, S_CONTENT, S_DONE };
         IHTTPRequestReader* m_in;
-        bool                m_marker;
-        char                m_markerBuf[szMarker];
-        char                m_contentBuf[szContent];
-        int                 m_markerOff;
-        int                 m_contentOff;
-        int                 m_size;
-        int                 m_contentLength;
-        String              m_boundary;
-        int                 m_szBoundary;
+        State               m_state;
+        long                m_contentLength;
+        long                m_size;        // bytes read from request
+        String              m_delimiter;   // CRLF "--" boundary
+        std::size_t         m_skip[256];   // BMH shift by last byte of window
+        std::vector<char>   m_buf;
+        std::size_t         m_begin;       // buffered unparsed content is [m_begin, m_end)
+        std::size_t         m_end;
         PageFormReader(IHTTPRequestReader* in) : 
-            m_in(in), m_marker(false), m_markerOff(0), m_contentOff(0), m_size(0), m_contentLength(-1), m_szBoundary(0) 
+            m_in(in), m_state(S_DONE), m_contentLength(0L), m_size(0L), m_buf(k_formBlock), m_begin(0), m_end(0)
         {}
-        ~PageFormReader() { end(); }
+        ~PageFormReader() 
+        { 
+            try 
+            { 
+                end(); 
+            }
+            catch (Socket::Failed& e) 
+            { 
+                Log::exception(e); 
+            } 
+        }
 
         // Implementation
         void begin(const Dictionary& attrs)       throw (Socket::Failed);
         bool next(Part& part)                     throw (Socket::Failed);
         bool read(char* buf, int sz, int& actual) throw (Socket::Failed);
         void read(String& data)                   throw (Socket::Failed);
+        long read(IPageFormSink* sink)            throw (Socket::Failed);
+        bool save(const String& path)             throw (Socket::Failed);
         void end()                                throw (Socket::Failed);
-        bool readToBoundary(int max, int& total)  throw (Socket::Failed);
+        bool content(const char*& b, int& sz, int max) throw (Socket::Failed);
+        void discard()                            throw (Socket::Failed);
+        bool fill()                               throw (Socket::Failed);
+        const char* find(const char* b, const char* e) const;
     };
 
     // Page writer
@@ -128,6 +287,8 @@ namespace kcc
         void response(int resp)                                          throw (Socket::Failed);
         void response(const Dictionary& hdr, int len, int resp)          throw (Socket::Failed);
         void write(const char* buf, int sz)                              throw (Socket::Failed);
+        void file(const String& path, long size)                         throw (Socket::Failed);
+        std::ostream& stream(const Dictionary& hdr, int resp)            throw (Socket::Failed);
         void xml(std::istream& xml)                                      throw (Socket::Failed);
         void transform(
             std::istream& xml, 
@@ -164,7 +325,10 @@ namespace kcc
             m_appPath   = Platform::fsNormalize(config.get(k_keyAppPath, Strings::empty()));
             m_transform = KCC_COMPONENT(IXMLTransform, config.get(k_keyXformComponent, k_defXformComponent));
             if (!m_transform->init(config)) return false;
-            Log::info2("PageResponse initialized: appPath=[%s]", m_appPath.c_str());
+            m_cache.init(config);
+            Log::info2(
+                "PageResponse initialized: appPath=[%s] cacheSize=[%ld] cacheResourceMax=[%ld] gzip=[%d]", 
+                m_appPath.c_str(), m_cache.m_maxBytes, m_cache.m_maxResource, m_cache.m_zip != NULL);
         }
         catch (Exception& e)
         {
@@ -188,6 +352,140 @@ namespace kcc
         else                          writer.resource(request.path.substr(1), request.attributes);
     }
 
+    //
+    // ResourceCache Implementation
+    //
+
+    // init: size bounds and (optional) compressor for gzip variants
+    void ResourceCache::init(const Properties& config)
+    {
+        Log::Scope scope(KCC_FILE, "ResourceCache::init");
+        m_maxBytes    = (unsigned long)std::max(0L, config.get(k_keyCacheSize,     k_defCacheSize));
+        m_maxResource = (unsigned long)std::max(0L, config.get(k_keyCacheResource, k_defCacheResource));
+        String zip(config.get(k_keyZipComponent, k_defZipComponent));
+        if (zip.empty()) return;
+        try
+        {
+            m_zip = KCC_FACTORY(IZipFactory, zip);
+        }
+        catch (Exception&)
+        {
+            Log::warning("gzip variants disabled, zip component not available: component=[%s]", zip.c_str());
+            m_zip = NULL;
+        }
+    }
+
+    // clear: drop cache references
+    void ResourceCache::clear()
+    {
+        Mutex::Lock lock(m_sentinel);
+        while (!m_entries.empty()) remove(m_entries.begin());
+    }
+
+    // acquire: reference cached resource, (re)loading if missing or stale (NULL if not cacheable)
+    Resource* ResourceCache::acquire(const String& fp, const Platform::File& res, const String& mime, const String& modified)
+    {
+        if (res.size > m_maxResource || res.size > m_maxBytes) return NULL;
+        {
+            Mutex::Lock lock(m_sentinel);
+            Entries::iterator e = m_entries.find(fp);
+            if (e != m_entries.end())
+            {
+                Resource* r = e->second;
+                if (r->m_modified == res.modified && r->m_size == res.size)
+                {
+                    m_lru.splice(m_lru.begin(), m_lru, r->m_lru);
+                    r->m_refs++;
+                    return r;
+                }
+                remove(e);
+            }
+        }
+
+        // load outside lock, concurrent loads of the same resource keep the last
+        Resource* r = load(fp, res, mime, modified);
+        if (r == NULL) return NULL;
+        Mutex::Lock lock(m_sentinel);
+        Entries::iterator e = m_entries.find(fp);
+        if (e != m_entries.end()) remove(e);
+        r->m_refs++;
+        r->m_lru = m_lru.insert(m_lru.begin(), r);
+        m_entries[fp] = r;
+        m_bytes += r->bytes();
+        while (m_bytes > m_maxBytes && !m_lru.empty())
+        {
+            Resource* victim = m_lru.back();
+            if (victim == r) break;
+            remove(m_entries.find(victim->m_path));
+        }
+        return r;
+    }
+
+    // load: read resource and build headers and gzip variant (NULL if resource changed while reading)
+    Resource* ResourceCache::load(const String& fp, const Platform::File& res, const String& mime, const String& modified)
+    {
+        Log::Scope scope(KCC_FILE, "ResourceCache::load");
+        std::FILE* in = std::fopen(fp.c_str(), "rb");
+        if (in == NULL) return NULL;
+        AutoPtr<Resource> r(new Resource(fp, res));
+        r->m_content.resize(res.size);
+        std::size_t actual = res.size == 0 ? 0 : std::fread(&r->m_content[0], 1, res.size, in);
+        bool ok = actual == res.size && std::fgetc(in) == EOF;
+        std::fclose(in);
+        if (!ok) return NULL;
+
+        // headers
+        r->m_etag = Strings::printf("\"%lx-%lx\"", res.size, (unsigned long)res.modified);
+        r->m_headers(k_httpContentType)  = mime;
+        r->m_headers(k_httpLastModified) = modified;
+        r->m_headers(k_httpETag)         = r->m_etag;
+
+        // gzip variant for text, kept only if smaller
+        bool compressible = 
+            mime.compare(0, 5, "text/") == 0 || 
+            mime.find("xml") != String::npos || 
+            mime.find("javascript") != String::npos;
+        if (m_zip != NULL && compressible && res.size >= k_gzipMin)
+        {
+            if (!m_zip->compress(r->m_content.data(), (int)r->m_content.size(), r->m_gzip) || r->m_gzip.size() >= r->m_content.size())
+                r->m_gzip.clear();
+        }
+        if (!r->m_gzip.empty())
+        {
+            r->m_headers(k_httpVary)                = k_httpAcceptEncoding;
+            r->m_gzipHeaders                        = r->m_headers;
+            r->m_gzipHeaders(k_httpContentEncoding) = k_httpGZip;
+            r->m_gzipETag                           = r->m_etag.substr(0, r->m_etag.size() - 1) + "-gz\"";
+            r->m_gzipHeaders.erase(k_httpETag);
+            r->m_gzipHeaders(k_httpETag)            = r->m_gzipETag;
+        }
+        Log::info4(
+            "resource cached: resource=[%s] size=[%ld] gzip=[%ld]", 
+            fp.c_str(), res.size, (unsigned long)r->m_gzip.size());
+        return r.release();
+    }
+
+    // release: dereference resource, deleting when no longer referenced
+    void ResourceCache::release(Resource* r)
+    {
+        bool unused = false;
+        {
+            Mutex::Lock lock(m_sentinel);
+            unused = --r->m_refs == 0L;
+        }
+        if (unused) delete r;
+    }
+
+    // remove: unlink entry and drop cache reference (sentinel held)
+    void ResourceCache::remove(Entries::iterator e)
+    {
+        Resource* r = e->second;
+        m_bytes -= r->bytes();
+        m_lru.erase(r->m_lru);
+        m_entries.erase(e);
+        if (--r->m_refs == 0L) delete r;
+    }
+
     //
     // PageReader Implementation
     //
@@ -212,29 +510,37 @@ namespace kcc
         {
             // validate type
             const String& ct = attrs[k_httpContentType];
-            if (ct.find(k_httpContentTypeMPForm) == String::npos) Socket::Failed Exception("invalid content type: " + ct);
+            if (ct.find(k_httpContentTypeMPForm) == String::npos) throw Socket::Failed("invalid content type: " + ct);
             m_contentLength = Strings::parseInteger(attrs[k_httpContentLength]);
 
-            // boundart marker
-            m_boundary.clear();
+            // boundary delimiter (boundary parameter may be quoted)
             String::size_type bsep = ct.find(k_httpMPFormBoundary);
             if (bsep == String::npos) throw Socket::Failed("missing boundary in multi-part form Content-Type");
-            m_boundary = k_httpMPMarker + ct.substr(bsep + k_httpMPFormBoundary.size());
-            m_szBoundary = (int)m_boundary.size();
-            if (m_szBoundary > (int)szMarker) throw Socket::Failed("boundary marker size out of bounds");
-
-            // read to first boundary
-            int actual = 0;
-            bool part = readToBoundary(szMarker, actual);
-            if (!part || actual >= szMarker) throw Socket::Failed("boundary/marker mismatch");
+            String boundary(ct.substr(bsep + k_httpMPFormBoundary.size(), ct.find(';', bsep) - bsep - k_httpMPFormBoundary.size()));
+            boundary.erase(boundary.find_last_not_of(" \t") + 1);
+            if (boundary.size() > 1 && boundary[0] == '"' && boundary[boundary.size()-1] == '"') boundary = boundary.substr(1, boundary.size()-2);
+            if (boundary.empty()) throw Socket::Failed("empty boundary in multi-part form Content-Type");
+            m_delimiter = k_httpEOL + k_httpMPMarker + boundary;
+            std::size_t n = m_delimiter.size();
+            for (int i = 0; i < 256; i++) m_skip[i] = n;
+            for (std::size_t i = 0; i + 1 < n; i++) m_skip[(unsigned char)m_delimiter[i]] = n - 1 - i;
+
+            // read through first boundary, body is primed with CRLF as first boundary may start the body
+            m_buf[0] = '\r';
+            m_buf[1] = '\n';
+            m_begin  = 0;
+            m_end    = 2;
+            m_size   = 0L;
+            m_state  = S_CONTENT;
+            discard();
+            if (m_state != S_BOUNDARY) throw Socket::Failed("boundary/marker mismatch");
         }
         catch (Socket::Failed&)
         {
             // invalidate iterator
-            m_contentLength = -1;
-            m_size          = 0;
-            m_szBoundary    = 0;
-            m_boundary.clear();
+            m_contentLength = -1L;
+            m_state         = S_DONE;
+            m_delimiter.clear();
             throw;
         }
     }
@@ -247,81 +553,73 @@ namespace kcc
         part.contentType.clear();
         part.contentDisposition.clear();
         part.parameters.clear();
-        if (m_size >= m_contentLength) return false;
-        
-        // read boundary header
-        bool next      = false;
-        int  szTrailer = (int) k_httpMPFormTrailer.size();
-        if (m_size < m_contentLength-szTrailer)
+        if (m_state == S_CONTENT) discard(); // skip unread content of current part
+        if (m_state != S_BOUNDARY) return false;
+
+        // close delimiter ends form
+        while (m_end - m_begin < 2 && fill());
+        if (m_end - m_begin < 2) throw Socket::Failed("multi-part form truncated");
+        if (std::memcmp(&m_buf[m_begin], k_httpMPMarker.data(), 2) == 0)
+        {
+            end();
+            return false;
+        }
+
+        // part headers: rest of boundary line through empty line
+        String::size_type found = String::npos;
+        while (true)
         {
-            // boundary headers
-            StringVector headers;
-            int read = 0;
-            m_in->request(headers, read);
-            m_size += read;
-            next = true;
-            
-            // parse into part features
-            for (StringVector::size_type i = 0; i < headers.size(); i++)
+            const char* b = &m_buf[0] + m_begin;
+            const char* e = &m_buf[0] + m_end;
+            const char* h = std::search(b, e, k_httpHeadersEnd.data(), k_httpHeadersEnd.data() + k_httpHeadersEnd.size());
+            if (h != e)
             {
-                String::size_type ct = headers[i].find(k_httpContentType);
-                if (ct == 0)
-                {
-                    part.contentType = Strings::trim(headers[i].substr(k_httpContentType.size()+1));
-                    continue;
-                }
-                String::size_type cd = headers[i].find(k_httpContentDisposition);
-                if (cd == 0)
-                {
-                    if (
-                        !HTTP::parseAttributeValue(
-                            headers[i].substr(k_httpContentDisposition.size()+1), 
-                            part.contentDisposition, 
-                            part.parameters))
-                    {
-                        Log::warning("error parsing form params header");
-                        next = false;
-                        break;
-                    }
-                    continue;
-                }
+                found = h - &m_buf[0];
+                break;
             }
+            if (!fill()) throw Socket::Failed("multi-part form headers not terminated");
         }
-        else
+        StringVector headers;
+        Strings::tokenize(String(&m_buf[0] + m_begin, found - m_begin), k_httpEOL, headers);
+        m_begin = found + k_httpHeadersEnd.size();
+        m_state = S_CONTENT;
+
+        // parse into part features
+        for (StringVector::size_type i = 0; i < headers.size(); i++)
         {
-            // read trailer
-            char trailer[szMarker];
-            int actual = 0;
-            m_in->read(trailer, szTrailer, actual);
-            m_size += actual;
-            bool ok = actual == szTrailer;
-            if (ok)
+            String::size_type ct = headers[i].find(k_httpContentType);
+            if (ct == 0)
+            {
+                part.contentType = Strings::trim(headers[i].substr(k_httpContentType.size()+1));
+                continue;
+            }
+            String::size_type cd = headers[i].find(k_httpContentDisposition);
+            if (cd == 0)
             {
-                trailer[szTrailer] = 0;
-                ok = trailer == k_httpMPFormTrailer;
+                if (
+                    !HTTP::parseAttributeValue(
+                        headers[i].substr(k_httpContentDisposition.size()+1), 
+                        part.contentDisposition, 
+                        part.parameters))
+                {
+                    Log::warning("error parsing form params header");
+                    end();
+                    return false;
+                }
+                continue;
             }
-            if (!ok) Log::warning("form trailer boundary not found");
         }
-        
-        // flush remaining content
-        if (!next) end();
-        
-        return next;
+        return true;
     }
     
     // read: read into buf
     bool PageFormReader::read(char* buf, int sz, int& actual) throw (Socket::Failed)
     {
         Log::Scope scope(KCC_FILE, "PageFormReader::read");
-        sz = std::min((int)szContent, sz); // maximum read buffer size == szContent
-        actual = 0;
-        bool part = false;
-        if (m_size < m_contentLength)
-        {
-            part = readToBoundary(sz, actual);
-            std::memcpy(buf, m_contentBuf, actual);
-        }
-        return m_size < m_contentLength && !part;
+        const char* b = NULL;
+        bool more = content(b, actual, sz);
+        if (actual > 0) std::memcpy(buf, b, actual);
+        return more;
     }
     
     // read: read string content
@@ -329,93 +627,158 @@ namespace kcc
     {
         Log::Scope scope(KCC_FILE, "PageFormReader::read");
         data.clear();
-        data.reserve(szContent);
-        int actual = 0;
-        bool part = false;
-        while (m_size < m_contentLength && !part)
+        const char* b  = NULL;
+        int         sz = 0;
+        bool more = true;
+        while (more)
+        {
+            more = content(b, sz, k_formBlock);
+            data.append(b, sz);
+        }
+    }
+
+    // read: stream content to sink
+    long PageFormReader::read(IPageFormSink* sink) throw (Socket::Failed)
+    {
+        Log::Scope scope(KCC_FILE, "PageFormReader::read");
+        long        total = 0L;
+        const char* b     = NULL;
+        int         sz    = 0;
+        bool more = true;
+        while (more)
         {
-            part = readToBoundary(szContent-1, actual); // -1 for null
-            m_contentBuf[actual] = 0;
-            data += m_contentBuf;
+            more = content(b, sz, k_formBlock);
+            if (sz > 0) sink->onContent(b, sz);
+            total += sz;
         }
+        return total;
+    }
+
+    // Helper sink to spill part content to file
+    struct PageFormFileSink : IPageFormSink
+    {
+        std::FILE* m_file;
+        bool       m_ok;
+        PageFormFileSink(std::FILE* f) : m_file(f), m_ok(true) {}
+        void onContent(const char* buf, int sz) throw (Socket::Failed) 
+        { 
+            if (m_ok) m_ok = std::fwrite(buf, 1, sz, m_file) == (std::size_t)sz; 
+        }
+    };
+
+    // save: spill content to file
+    bool PageFormReader::save(const String& path) throw (Socket::Failed)
+    {
+        Log::Scope scope(KCC_FILE, "PageFormReader::save");
+        std::FILE* out = std::fopen(path.c_str(), "wb");
+        if (out == NULL)
+        {
+            Log::warning("unable to open form part file: path=[%s]", path.c_str());
+            discard();
+            return false;
+        }
+        PageFormFileSink sink(out);
+        long sz = read(&sink);
+        bool ok = std::fclose(out) == 0 && sink.m_ok;
+        if (!ok) Log::warning("unable to write form part file: path=[%s]", path.c_str());
+        Log::info4("form part saved: path=[%s] size=[%ld]", path.c_str(), sz);
+        return ok;
     }
     
-    // end: read to end of part
+    // end: read to end of form
     void PageFormReader::end() throw (Socket::Failed)
     {
         Log::Scope scope(KCC_FILE, "PageFormReader::end");
-        char ch     = 0;
-        int  actual = 0;
+        m_state = S_DONE;
+        m_begin = m_end = 0;
+        int actual = 0;
         while (m_size < m_contentLength)
         {
-            m_in->read(&ch, 1, actual);
+            m_in->read(&m_buf[0], (int)std::min((long)m_buf.size(), m_contentLength - m_size), actual);
+            if (actual <= 0) break;
             m_size += actual;
         }
     }
 
-    // readToBoundary: read from stream until boundary located
-    bool PageFormReader::readToBoundary(int max, int& total) throw (Socket::Failed)
+    // content: next block of part content in buffer (up to max), false when part is complete
+    bool PageFormReader::content(const char*& b, int& sz, int max) throw (Socket::Failed)
     {
-        total = 0;
-        m_contentOff = 0;
-        char ch     = 0;
-        int  actual = 0;
-        bool part   = false;
-        while (total < max && m_size < m_contentLength && m_contentOff < szContent && !part)
+        b  = NULL;
+        sz = 0;
+        if (m_state != S_CONTENT) return false;
+        std::size_t n = m_delimiter.size();
+        while (true)
         {
-            m_in->read(&ch, 1, actual);
-            m_size += actual;
-            if (m_marker)
+            const char* data  = &m_buf[0];
+            const char* found = find(data + m_begin, data + m_end);
+
+            // content through delimiter
+            if (found != NULL)
             {
-                m_markerBuf[m_markerOff++] = ch;
-                if (m_markerOff == m_szBoundary)
-                {
-                    if (std::memcmp(m_markerBuf, m_boundary.c_str(), m_szBoundary) == 0)
-                    {
-                        part        = true;
-                        m_marker    = false;
-                        m_markerOff = 0;
-                    }
-                    else                 
-                    {
-                        int markerSize = m_markerOff;
-                        int overrun = 0;
-                        if (total + m_markerOff > max) 
-                        {
-                            overrun = (total+m_markerOff) - max;
-                            markerSize -= overrun;
-                        }
-                        std::memcpy(m_contentBuf+m_contentOff, m_markerBuf, markerSize);
-                        m_contentOff += markerSize;
-                        total        += markerSize;
-                        if (overrun > 0)
-                        {
-                            std::memmove(m_markerBuf, m_markerBuf+markerSize, overrun);
-                            m_markerOff = overrun;
-                        }
-                        else
-                        {
-                            m_marker    = false;
-                            m_markerOff = 0;
-                        }
-                    }
-                }
+                std::size_t available = (std::size_t)(found - data) - m_begin;
+                sz = (int)std::min((std::size_t)max, available);
+                b  = data + m_begin;
+                m_begin += sz;
+                if (m_begin < (std::size_t)(found - data)) return true;
+                m_begin += n;
+                m_state = S_BOUNDARY;
+                return false;
             }
-            else
+
+            // content that can't begin a delimiter
+            std::size_t buffered = m_end - m_begin;
+            if (buffered >= n)
             {
-                if (ch == '-')
-                {
-                    m_marker = true;
-                    m_markerBuf[m_markerOff++] = ch;
-                }
-                else
-                {
-                    m_contentBuf[m_contentOff++] = ch;
-                    total++;
-                }
+                sz = (int)std::min((std::size_t)max, buffered - (n - 1));
+                b  = data + m_begin;
+                m_begin += sz;
+                return true;
             }
+            if (!fill()) 
+            {
+                m_state = S_DONE;
+                throw Socket::Failed("multi-part form boundary not found");
+            }
+        }
+    }
+
+    // discard: skip rest of part content
+    void PageFormReader::discard() throw (Socket::Failed)
+    {
+        const char* b  = NULL;
+        int         sz = 0;
+        while (content(b, sz, k_formBlock));
+    }
+
+    // fill: compact buffer and read next block of request, false if no more request or buffer full
+    bool PageFormReader::fill() throw (Socket::Failed)
+    {
+        if (m_begin > 0)
+        {
+            std::memmove(&m_buf[0], &m_buf[0] + m_begin, m_end - m_begin);
+            m_end  -= m_begin;
+            m_begin = 0;
         }
-        return part;
+        if (m_end == m_buf.size() || m_size >= m_contentLength) return false;
+        int actual = 0;
+        m_in->read(&m_buf[0] + m_end, (int)std::min((long)(m_buf.size() - m_end), m_contentLength - m_size), actual);
+        if (actual <= 0) return false;
+        m_end  += actual;
+        m_size += actual;
+        return true;
+    }
+
+    // find: Boyer-Moore-Horspool search for delimiter in [b, e)
+    const char* PageFormReader::find(const char* b, const char* e) const
+    {
+        std::size_t n    = m_delimiter.size();
+        const char* d    = m_delimiter.data();
+        char        last = d[n-1];
+        for (const char* p = b; (std::size_t)(e - p) >= n; p += m_skip[(unsigned char)p[n-1]])
+        {
+            if (p[n-1] == last && std::memcmp(p, d, n-1) == 0) return p;
+        }
+        return NULL;
     }
 
     //
@@ -428,6 +791,8 @@ namespace kcc
     void PageWriter::response(const Dictionary& hdr, int len, int resp)          throw (Socket::Failed) { m_out->response(hdr, len, resp); }
     void PageWriter::write   (const char* buf, int sz)                           throw (Socket::Failed) { m_out->write(buf, sz); }
     void PageWriter::xml     (std::istream& in)                                  throw (Socket::Failed) { m_out->xml(in); }
+    void PageWriter::file    (const String& path, long size)                     throw (Socket::Failed) { m_out->file(path, size); }
+    std::ostream& PageWriter::stream(const Dictionary& hdr, int resp)            throw (Socket::Failed) { return m_out->stream(hdr, resp); }
 
     // transform: transform xml using xform
     void PageWriter::transform(
@@ -443,18 +808,14 @@ namespace kcc
         StringMap::iterator find = m_resp->m_xforms.find(xform);
         String fp = (find != m_resp->m_xforms.end()) ? m_resp->fullPath(find->second) : xform;
 
-        // transform
-        StringStream buf;
-        m_resp->m_transform->apply(xml, fp, params, buf);
-        
-        // stream transformation
+        // stream transformation (sent as it is serialized)
         String mime = k_html;
         if      (type == IPageWriter::TT_XML)  mime = k_xml;
         else if (type == IPageWriter::TT_TEXT) mime = k_text;
-        Log::info4("streaming transformation: xform=[%s] mime=[%s] size=[%d]", fp.c_str(), mime.c_str(), (int)buf.tellp());
+        Log::info4("streaming transformation: xform=[%s] mime=[%s]", fp.c_str(), mime.c_str());
         Dictionary respHeaders(headers);
         HTTP::setHeaders(respHeaders, mime, true);
-        m_out->response(buf, respHeaders);
+        m_resp->m_transform->apply(xml, fp, params, m_out->stream(respHeaders));
     }
 
     // transform: transform xml using xform
@@ -471,18 +832,14 @@ namespace kcc
         StringMap::iterator find = m_resp->m_xforms.find(xform);
         String fp = (find != m_resp->m_xforms.end()) ? m_resp->fullPath(find->second) : xform;
 
-        // transform
-        StringStream buf;
-        m_resp->m_transform->apply(xml, fp, params, buf);
-        
-        // stream transformation
+        // stream transformation (sent as it is serialized)
         String mime = k_html;
         if      (type == IPageWriter::TT_XML)  mime = k_xml;
         else if (type == IPageWriter::TT_TEXT) mime = k_text;
-        Log::info4("streaming transformation: xml=[%s] xform=[%s] mime=[%s] size=[%d]", xml.c_str(), fp.c_str(), mime.c_str(), (int)buf.tellp());
+        Log::info4("streaming transformation: xml=[%s] xform=[%s] mime=[%s]", xml.c_str(), fp.c_str(), mime.c_str());
         Dictionary respHeaders(headers);
         HTTP::setHeaders(respHeaders, mime, true);
-        m_out->response(buf, respHeaders);
+        m_resp->m_transform->apply(xml, fp, params, m_out->stream(respHeaders));
     }
 
     // resource: stream resource
@@ -520,36 +877,41 @@ namespace kcc
             }
         }
 
-        // mimes
-        String mime(k_text);
-        int i = 0;
-        while (!k_mimes[i][0].empty())
+        // cached resource, sent from memory
+        const String& mime = k_mimeTable.lookup(res.name);
+        ResourceCache::Handle cached(m_resp->m_cache, m_resp->m_cache.acquire(fp, res, mime, modified));
+        Resource* r = cached.m_resource;
+        String etag(r != NULL ? r->m_etag : Strings::printf("\"%lx-%lx\"", res.size, (unsigned long)res.modified));
+        const String& match = attributes[k_httpIfNoneMatch];
+        bool matched = 
+            match == k_httpAnyMatch || match.find(etag) != String::npos || 
+            (r != NULL && !r->m_gzipETag.empty() && match.find(r->m_gzipETag) != String::npos);
+        if (!match.empty() && matched)
         {
-            String::size_type ext = k_mimes[i][0].size();
-            String::size_type sz  = res.name.size();
-            if (sz > ext && res.name.substr(sz - ext) == k_mimes[i][0])
-            {
-                mime = k_mimes[i][1];
-                break;
-            }
-            i++;
+            Log::info4("resource not modified: resource=[%s] etag=[%s]", fp.c_str(), etag.c_str());
+            m_out->response(HTTP::C_NOT_MODIFIED);
+            return;
+        }
+        if (r != NULL)
+        {
+            bool gzip = !r->m_gzip.empty() && acceptsGZip(attributes[k_httpAcceptEncoding]);
+            const String& content = gzip ? r->m_gzip : r->m_content;
+            Log::info4(
+                "streaming cached resource: path=[%s] mime=[%s] size=[%d] gzip=[%d] modified=[%s]", 
+                fp.c_str(), mime.c_str(), (int)content.size(), gzip, modified.c_str());
+            response(gzip ? r->m_gzipHeaders : r->m_headers, (int)content.size(), HTTP::C_OK);
+            m_out->write(content.data(), (int)content.size());
+            return;
         }
         
-        // stream response
+        // stream response, sent from file
         Log::info4("streaming resource: path=[%s] mime=[%s] size=[%d] modified=[%s]", fp.c_str(), mime.c_str(), res.size, modified.c_str());
         Dictionary headers;
         headers(k_httpContentType)  = mime;
         headers(k_httpLastModified) = modified;
+        headers(k_httpETag)         = etag;
         response(headers, res.size, HTTP::C_OK);
-        const std::size_t k_sz = 4096;
-        char buf[k_sz];
-        std::FILE* in = std::fopen(fp.c_str(), "rb");
-        while (!feof(in))
-        {
-            int actual = std::fread(buf, 1, k_sz, in);
-            m_out->write(buf, actual);
-        }
-        std::fclose(in);
+        m_out->file(fp, (long)res.size);
     }
     
     //
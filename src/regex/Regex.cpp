@@ -11,8 +11,17 @@
 
 namespace kcc
 {
+    // Properties
+    static const String k_keyCacheMax(KCC_REGEX_CACHEMAX);
+
     // Constants
-    static const int k_maxMatches = 2048;
+    static const int  k_maxMatches   = 2048;
+    static const long k_defCacheMax  = 512L; // shared cache expressions
+    static const int  k_frontSlots   = 8;    // thread front cache expressions
+    static const long k_frontPublish = 256L; // thread front cache hits counted before publishing
+    
+    // Boost regex type
+    typedef boost::reg_expression<Char, boost::regex_traits<Char>, BOOST_DEFAULT_ALLOCATOR(Char)> RxBoost;
     
     // kcc_flagsBoost: convert to boost regex flags
     inline boost::regbase::flag_type kcc_flagsBoost(IRegex::Options ops)
@@ -27,174 +36,161 @@ namespace kcc
         return flags;
     }
     
-    // kcc_rxid: build unique id of regex
-    inline StringRC kcc_rxid(const String& rx, IRegex::Options ops) 
+    // kcc_rxhash: hash of regex and options (cache key, NOT unique: expressions are compared on hit)
+    inline StringIndex::Hash kcc_rxhash(const String& rx, IRegex::Options ops) 
     {
-        return MD5::hash(rx + Strings::printf("__%d", ops));
+        return (StringIndex::hash(rx, StringIndex::K_EXACT) ^ ((StringIndex::Hash)ops * 0x9e3779b1UL)) & 0xffffffffUL;
     }
 
-    // Helper class to manage regex cache
-    struct RegexModuleState : Core::ModuleState
+    // Compiled expression: immutable once compiled, so shared without locking by the
+    // cache, thread front caches and expressions
+    struct Compiled
     {
         // Attributes
-        typedef SharedPtr<IRegexExpression> RxValue;
-        typedef std::map<String, RxValue>   RxCache;
-        Mutex   m_sentinel;
-        RxCache m_cache;
-        ~RegexModuleState() { flushAll(); }
+        const StringIndex::Hash m_hash;
+        const IRegex::Options   m_ops;
+        const String            m_expr;
+        const String            m_id;
+        const RxBoost           m_rx;
 
-        // get: get a cached regular expression
-        RxValue get(const String& regex, IRegex::Options ops) throw (IRegex::Failed)
+        // compile: construct and compile expression
+        static Compiled* compile(const String& expr, IRegex::Options ops) throw (IRegex::Failed)
         {
-            Mutex::Lock lock(m_sentinel);
-            Log::Scope scope(KCC_FILE, "RegexModuleState::get");
-            StringRC id(kcc_rxid(regex, ops));
-            RxValue rx;
-            RxCache::iterator find = m_cache.find(id);
-            if (find != m_cache.end()) rx = find->second;
-            else
+            try
             {
-                rx.reset(build(regex, ops));
-                if (id != rx->id()) throw IRegex::Failed("regex expression id mismatch");
-                m_cache[rx->id()] = rx;
+                return new Compiled(expr, ops);
             }
-            return rx;
-        }
-        
-        // flush: flush compiled expression
-        void flush(IRegexExpression* rx)
-        {
-            Mutex::Lock lock(m_sentinel);
-            Log::Scope scope(KCC_FILE, "RegexModuleState::flush");
-            RxCache::iterator find = m_cache.find(rx->id());
-            if (find != m_cache.end()) m_cache.erase(find);
-            else                       
+            catch (std::exception& e)
             {
-                Log::warning("compiled regex not found, deleting instance: id=[" + rx->id() + "]");
-                delete rx;
+                throw IRegex::Failed(e.what(), Strings::empty(), expr);
             }
         }
-        
-        // flush: flush compiled expression
-        void flushAll()
-        {
-            Mutex::Lock lock(m_sentinel);
-            m_cache.clear();
-        }
-        
-        // build: construct and compile expression
-        IRegexExpression* build(const String& regex, IRegex::Options ops) throw (IRegex::Failed);
-    };
 
-    // Regex implementation
-    struct Regex : IRegex
-    {
-        // Lifecycle management
-        void flush   (IRegexExpression* rx) { KCC_STATE(RegexModuleState).flush(rx);  }
-        void flushAll()                     { KCC_STATE(RegexModuleState).flushAll(); }
-        
-        // Accessor
-        IRegexExpression* expression(const String& regex, Options ops) 
-            throw (IRegex::Failed)
-        {
-            return KCC_STATE(RegexModuleState).get(regex, ops);
-        }
-    
-        // split: split regex into vector
-        void split(String& target, const String& regex, StringVector& out, Options ops, bool clear)
-            throw (IRegex::Failed)
+        // is: query if compiled from expression & options
+        inline bool is(StringIndex::Hash h, const String& expr, IRegex::Options ops) const
         {
-            return expression(regex, ops)->split(target, out, clear);
+            return m_hash == h && m_ops == ops && m_expr == expr;
         }
 
-        // split: split regex into vector
-        void split(const String& target, const String& regex, StringVector& out, Options ops, bool clear)
-            throw (IRegex::Failed)
+        // split: regex split
+        void split(String& target, StringVector& out, bool clear) const throw (IRegex::Failed)
         {
-            expression(regex, ops)->split(target, out, clear);
+            if (clear) out.clear();
+            try
+            {
+                boost::regex_split(std::back_inserter(out), target, m_rx);
+            }
+            catch (std::exception& e)
+            {
+                throw IRegex::Failed(e.what(), target, m_expr);
+            }
         }
-
-        // match: match target on regex
-        bool match(const String& target, const String& regex, Options ops)
-            throw (IRegex::Failed)
+        
+        // match: regex match
+        bool match(const String& target) const throw (IRegex::Failed)
         {
-            return expression(regex, ops)->match(target);
+            try
+            {
+                boost::smatch what;
+                return boost::regex_search(target, what, m_rx);
+            }
+            catch (std::exception& e)
+            {
+                throw IRegex::Failed(e.what(), target, m_expr);
+            }
         }
-
-        // match: match target on regex
-        bool match(const String& target, const String& regex, StringParts& out, Options ops, bool clear)
-            throw (IRegex::Failed)
+        
+        // match: regex match
+        bool match(const String& target, StringParts& out, bool clear) const throw (IRegex::Failed)
         {
-            return expression(regex, ops)->match(target, out, clear);
+            if (clear) out.clear();
+            try
+            {
+                std::string::const_iterator start   = target.begin();
+                std::string::const_iterator end     = target.end(); 
+                unsigned int                flags   = boost::match_default;
+                boost::smatch               what;
+                bool                        matches = false;
+                while (boost::regex_search(start, end, what, m_rx, flags)) 
+                {
+                    matches = true;
+                
+                    // add matches
+                    for (boost::smatch::size_type i = 1; i < what.size(); i++) 
+                        out.push_back(StringPart(what[i].first, what[i].second));
+                        
+                    // get next match from previous start
+                    start = what[0].second; 
+                    flags |= boost::match_prev_avail; 
+                    flags |= boost::match_not_bob; 
+                } 
+                return matches;
+            }
+            catch (std::exception& e)
+            {
+                throw IRegex::Failed(e.what(), target, m_expr);
+            }
         }
-
-        // replace: replace target string against a regex
-        String replace(const String& target, const String& regex, const String& format, Options ops)
-            throw (IRegex::Failed)
+        
+        // replace: regex replace
+        void replace(String& target, const String& format) const throw (IRegex::Failed)
         {
-            return expression(regex, ops)->replace(target, format);
+            try
+            {
+                target = boost::regex_merge(target, m_rx, format);
+            }
+            catch (std::exception& e)
+            {
+                throw IRegex::Failed(e.what(), target, m_expr);
+            }
         }
 
-        // replace: replace target string against a regex
-        void replace(String& target, const String& regex, const String& format, Options ops)
-            throw (IRegex::Failed)
+    private:
+        Compiled(const String& expr, IRegex::Options ops) :
+            m_hash(kcc_rxhash(expr, ops)),
+            m_ops (ops),
+            m_expr(expr),
+            m_id  (Strings::printf("%08lx.%d", m_hash, ops)),
+            m_rx  (expr, kcc_flagsBoost(ops))
         {
-            expression(regex, ops)->replace(target, format);
+            Log::info4("compiled regex: id=[%s] ops=[%d] rx=[%s]", m_id.c_str(), m_ops, m_expr.substr(0, 1024).c_str());
         }
+        Compiled(const Compiled&);
+        Compiled& operator = (const Compiled&);
     };
+    typedef SharedPtr<Compiled, AtomicCount> RxCompiled; // MT-safe ref-count (released outside cache lock)
 
     // Expression implementation
     struct Expression : IRegexExpression
     {
         // Attributes
-        StringRC              m_id;
-        String                m_expr;
-        IRegex::Options       m_ops;
-        AutoPtr<boost::regex> m_rx;
-        Expression() : m_id(kcc::Strings::emptyRC()), m_ops(IRegex::O_NORMAL) {}
+        RxCompiled m_rx;
+        Expression() {}
+        explicit Expression(const RxCompiled& rx) : m_rx(rx) {}
         ~Expression()
         {
             Log::Scope scope(KCC_FILE, "Expression::~Expression");
-            Log::info4("deleting regex: id=[%s]", m_id.c_str());
+            Log::info4("deleting regex: id=[%s]", id().c_str());
         }
 
         // compile: compile expression
         void compile(const String& expr, IRegex::Options ops) throw (IRegex::Failed)
         {
             Log::Scope scope(KCC_FILE, "Expression::compile");
-            
-            // compile/recompile expression
-            m_id   = kcc_rxid(expr, ops);
-            m_expr = expr;
-            m_ops  = ops;
-            try
-            {
-                bool recompile = m_rx != NULL;
-                boost::regbase::flag_type flags = kcc_flagsBoost(m_ops);
-                m_rx.reset(new boost::reg_expression<Char, boost::regex_traits<Char>, BOOST_DEFAULT_ALLOCATOR(Char)>(expr, flags));
-                Log::info4(
-                    "%s regex: id=[%s] ops=[%d] rx=[%s]", 
-                    (recompile ? "recompiling" : "compiled"), 
-                    m_id.c_str(), 
-                    m_ops, 
-                    m_expr.substr(0, 1024).c_str());
-            }
-            catch (std::exception& e)
-            {
-                throw IRegex::Failed(e.what(), Strings::empty(), expr);
-            }
+            m_rx = Compiled::compile(expr, ops);
         }
         
         // validate: validate expression is compiled
-        inline void validate() throw (IRegex::Failed) 
+        inline const Compiled& validate() throw (IRegex::Failed) 
         { 
-            if (m_rx == NULL) throw IRegex::Failed("regex not compiled");
+            if (m_rx.null()) throw IRegex::Failed("regex not compiled");
+            return *m_rx;
         }
         
         // Accessors
-        const String&   id        () { return m_id; }
-        const String&   expression() { return m_expr; }
-        IRegex::Options options   () { return m_ops; }
+        const String&   id        () { return m_rx.null() ? Strings::empty() : m_rx->m_id;   }
+        const String&   expression() { return m_rx.null() ? Strings::empty() : m_rx->m_expr; }
+        IRegex::Options options   () { return m_rx.null() ? IRegex::O_NORMAL : m_rx->m_ops;  }
         
         // split: regex split
         void split(const String& target, StringVector& out, bool clear) throw (IRegex::Failed)
@@ -207,66 +203,21 @@ namespace kcc
         void split(String& target, StringVector& out, bool clear) throw (IRegex::Failed)
         {
             Log::Scope scope(KCC_FILE, "Expression::split");
-            validate();
-            if (clear) out.clear();
-            try
-            {
-                boost::regex_split(std::back_inserter(out), target, *m_rx);
-            }
-            catch (std::exception& e)
-            {
-                throw IRegex::Failed(e.what(), target, m_expr);
-            }
+            validate().split(target, out, clear);
         }
         
         // match: regex match
         bool match(const String& target) throw (IRegex::Failed)
         {
             Log::Scope scope(KCC_FILE, "Expression::match");
-            validate();
-            try
-            {
-                boost::smatch what;
-                return boost::regex_search(target, what, *m_rx);
-            }
-            catch (std::exception& e)
-            {
-                throw IRegex::Failed(e.what(), target, m_expr);
-            }
+            return validate().match(target);
         }
         
         // match: regex match
         bool match(const String& target, StringParts& out, bool clear) throw (IRegex::Failed)
         {
             Log::Scope scope(KCC_FILE, "Expression::match");
-            validate();
-            if (clear) out.clear();
-            try
-            {
-                std::string::const_iterator start   = target.begin();
-                std::string::const_iterator end     = target.end(); 
-                unsigned int                flags   = boost::match_default;
-                boost::smatch               what;
-                bool                        matches = false;
-                while (boost::regex_search(start, end, what, *m_rx, flags)) 
-                {
-                    matches = true;
-                
-                    // add matches
-                    for (boost::smatch::size_type i = 1; i < what.size(); i++) 
-                        out.push_back(StringPart(what[i].first, what[i].second));
-                        
-                    // get next match from previous start
-                    start = what[0].second; 
-                    flags |= boost::match_prev_avail; 
-                    flags |= boost::match_not_bob; 
-                } 
-                return matches;
-            }
-            catch (std::exception& e)
-            {
-                throw IRegex::Failed(e.what(), target, m_expr);
-            }
+            return validate().match(target, out, clear);
         }
         
         // replace: regex replace
@@ -281,26 +232,303 @@ namespace kcc
         void replace(String& target, const String& format) throw (IRegex::Failed)
         {
             Log::Scope scope(KCC_FILE, "Expression::replace");
-            validate();
-            try
+            validate().replace(target, format);
+        }
+    };
+
+    // Thread front cache: most recently missed expressions of a thread (no locking)
+    struct RxFront
+    {
+        long       m_generation; // cache generation of slots (flushes invalidate front caches)
+        long       m_hits;       // hits not yet published
+        int        m_next;       // next slot to replace (round-robin)
+        RxCompiled m_slots[k_frontSlots];
+        explicit RxFront(long generation) : m_generation(generation), m_hits(0L), m_next(0) {}
+
+        // clear: release slots
+        void clear(long generation)
+        {
+            for (int i = 0; i < k_frontSlots; i++) m_slots[i].reset();
+            m_generation = generation;
+        }
+    };
+
+    // Helper class to manage regex cache: least recently used compiled expressions shared
+    // by hash, fronted by a cache per thread; expression() pins expressions until flushed
+    struct RegexModuleState : Core::ModuleState
+    {
+        // Attributes
+        typedef std::list<RxCompiled>                             RxLRU;    // most recently used first
+        typedef std::multimap<StringIndex::Hash, RxLRU::iterator> RxCache;
+        typedef std::multimap<StringIndex::Hash, Expression*>     RxPinned;
+        typedef std::vector<Expression*>                          RxFlushed;
+        Mutex       m_sentinel;
+        RxLRU       m_lru;
+        RxCache     m_cache;
+        RxPinned    m_pinned;
+        ThreadLocal m_front;
+        AtomicCount m_generation;
+        long        m_max;
+        long        m_frontHits;
+        long        m_hits;
+        long        m_misses;
+        long        m_evictions;
+        RegexModuleState() : 
+            m_front     (RegexModuleState::frontRelease),
+            m_generation(0L),
+            m_max       (std::max(1L, Core::properties().get(k_keyCacheMax, k_defCacheMax))),
+            m_frontHits (0L),
+            m_hits      (0L),
+            m_misses    (0L),
+            m_evictions (0L)
+        {}
+        ~RegexModuleState() 
+        { 
+            // front caches of other running threads are abandoned with the thread key
+            frontRelease(m_front.get());
+            m_front.set(NULL);
+            flushAll(); 
+        }
+
+        // compiled: compiled expression of the calling thread's front cache (valid until
+        //           the thread's next lookup)
+        const Compiled& compiled(const String& regex, IRegex::Options ops) throw (IRegex::Failed)
+        {
+            StringIndex::Hash h = kcc_rxhash(regex, ops);
+            RxFront* f = front();
+            for (int i = 0; i < k_frontSlots; i++)
             {
-                target = boost::regex_merge(target, *m_rx, format);
+                const RxCompiled& rx = f->m_slots[i];
+                if (!rx.null() && rx->is(h, regex, ops))
+                {
+                    if (++f->m_hits >= k_frontPublish) publish(f);
+                    return *rx;
+                }
             }
-            catch (std::exception& e)
+            RxCompiled& slot = f->m_slots[f->m_next];
+            slot = get(regex, ops, h, f);
+            f->m_next = (f->m_next + 1) % k_frontSlots;
+            return *slot;
+        }
+
+        // get: get a cached compiled expression, compiling on miss
+        RxCompiled get(const String& regex, IRegex::Options ops, StringIndex::Hash h, RxFront* f = NULL) 
+            throw (IRegex::Failed)
+        {
             {
-                throw IRegex::Failed(e.what(), target, m_expr);
+                Mutex::Lock lock(m_sentinel);
+                if (f != NULL) publish(f);
+                RxLRU::iterator i = find(regex, ops, h);
+                if (i != m_lru.end())
+                {
+                    m_hits++;
+                    m_lru.splice(m_lru.begin(), m_lru, i);
+                    return *i;
+                }
+                m_misses++;
+            }
+
+            // compile outside of cache lock (concurrent misses of an expression may both compile)
+            RxCompiled rx(Compiled::compile(regex, ops));
+            RxLRU      evicted;
+            Mutex::Lock lock(m_sentinel);
+            RxLRU::iterator i = find(regex, ops, h);
+            if (i != m_lru.end()) return *i;
+            while ((long)m_lru.size() >= m_max)
+            {
+                erase(--m_lru.end(), evicted);
+                m_evictions++;
+            }
+            m_lru.push_front(rx);
+            m_cache.insert(std::make_pair(h, m_lru.begin()));
+            return rx;
+        }
+        
+        // expression: pin a cached compiled expression until flushed
+        IRegexExpression* expression(const String& regex, IRegex::Options ops) throw (IRegex::Failed)
+        {
+            Log::Scope scope(KCC_FILE, "RegexModuleState::expression");
+            StringIndex::Hash h = kcc_rxhash(regex, ops);
+            RxCompiled rx(get(regex, ops, h));
+            Mutex::Lock lock(m_sentinel);
+            std::pair<RxPinned::iterator, RxPinned::iterator> pinned = m_pinned.equal_range(h);
+            for (RxPinned::iterator i = pinned.first; i != pinned.second; i++)
+            {
+                if (i->second->m_rx->is(h, regex, ops)) return i->second;
+            }
+            AutoPtr<Expression> expr(new Expression(rx));
+            m_pinned.insert(std::make_pair(h, (Expression*)expr));
+            return expr.release();
+        }
+        
+        // flush: flush compiled expression
+        void flush(IRegexExpression* rx)
+        {
+            Log::Scope scope(KCC_FILE, "RegexModuleState::flush");
+            AutoPtr<IRegexExpression> expr(rx); // deleted outside of cache lock
+            RxLRU evicted;
+            Mutex::Lock lock(m_sentinel);
+            m_generation.increment();
+            StringIndex::Hash h = kcc_rxhash(rx->expression(), rx->options());
+            RxLRU::iterator cached = find(rx->expression(), rx->options(), h);
+            if (cached != m_lru.end()) erase(cached, evicted);
+            for (RxPinned::iterator i = m_pinned.begin(); i != m_pinned.end(); i++)
+            {
+                if (i->second != rx) continue;
+                m_pinned.erase(i);
+                return;
+            }
+            Log::warning("compiled regex not pinned, deleting instance: id=[" + rx->id() + "]");
+        }
+        
+        // flushAll: flush all compiled expressions
+        void flushAll()
+        {
+            RxLRU     evicted;
+            RxFlushed flushed;
+            {
+                Mutex::Lock lock(m_sentinel);
+                m_generation.increment();
+                evicted.swap(m_lru);
+                m_cache.clear();
+                for (RxPinned::iterator i = m_pinned.begin(); i != m_pinned.end(); i++) flushed.push_back(i->second);
+                m_pinned.clear();
+            }
+            for (RxFlushed::iterator i = flushed.begin(); i != flushed.end(); i++) delete *i;
+        }
+
+        // statistics: cache counters (including the calling thread's unpublished front hits)
+        void statistics(RegexCacheStatistics& stats)
+        {
+            Mutex::Lock lock(m_sentinel);
+            RxFront* f = (RxFront*)m_front.get();
+            if (f != NULL) publish(f);
+            stats.entries   = (long)m_lru.size();
+            stats.max       = m_max;
+            stats.frontHits = m_frontHits;
+            stats.hits      = m_hits;
+            stats.misses    = m_misses;
+            stats.evictions = m_evictions;
+            stats.pinned    = (long)m_pinned.size();
+        }
+
+        // front: calling thread's front cache (cleared if flushed since last lookup)
+        RxFront* front()
+        {
+            RxFront* f = (RxFront*)m_front.get();
+            if (f == NULL)
+            {
+                f = new RxFront(m_generation.get());
+                m_front.set(f);
             }
+            else if (f->m_generation != m_generation.get()) f->clear(m_generation.get());
+            return f;
+        }
+
+        // frontRelease: release front cache of exiting thread
+        static void frontRelease(void* f) { delete (RxFront*)f; }
+
+        // publish: add front cache hits to statistics
+        inline void publish(RxFront* f)
+        {
+            Mutex::Lock lock(m_sentinel);
+            m_frontHits += f->m_hits;
+            f->m_hits    = 0L;
+        }
+
+        // find: find cached compiled expression (cache must be locked)
+        RxLRU::iterator find(const String& regex, IRegex::Options ops, StringIndex::Hash h)
+        {
+            std::pair<RxCache::iterator, RxCache::iterator> cached = m_cache.equal_range(h);
+            for (RxCache::iterator i = cached.first; i != cached.second; i++)
+            {
+                if ((*i->second)->is(h, regex, ops)) return i->second;
+            }
+            return m_lru.end();
+        }
+
+        // erase: move cached compiled expression to be released outside of lock (cache must be locked)
+        void erase(RxLRU::iterator rx, RxLRU& evicted)
+        {
+            std::pair<RxCache::iterator, RxCache::iterator> cached = m_cache.equal_range((*rx)->m_hash);
+            for (RxCache::iterator i = cached.first; i != cached.second; i++)
+            {
+                if (i->second != rx) continue;
+                m_cache.erase(i);
+                break;
+            }
+            evicted.splice(evicted.begin(), m_lru, rx);
         }
     };
-    
-    // build: build expression using default impl.
-    IRegexExpression* RegexModuleState::build(const String& regex, IRegex::Options ops) 
-        throw (IRegex::Failed)
+
+    // Regex implementation
+    struct Regex : IRegex
     {
-        AutoPtr<IRegexExpression> rx(new Expression());
-        rx->compile(regex, ops);
-        return rx.release();
-    }
+        // Lifecycle management
+        void flush   (IRegexExpression* rx) { KCC_STATE(RegexModuleState).flush(rx);  }
+        void flushAll()                     { KCC_STATE(RegexModuleState).flushAll(); }
+        
+        // Statistics
+        void cacheStatistics(RegexCacheStatistics& stats) { KCC_STATE(RegexModuleState).statistics(stats); }
+
+        // Accessor
+        IRegexExpression* expression(const String& regex, Options ops) 
+            throw (IRegex::Failed)
+        {
+            return KCC_STATE(RegexModuleState).expression(regex, ops);
+        }
+
+        // compiled: compiled expression from cache
+        inline const Compiled& compiled(const String& regex, Options ops) throw (IRegex::Failed)
+        {
+            return KCC_STATE(RegexModuleState).compiled(regex, ops);
+        }
+    
+        // split: split regex into vector
+        void split(String& target, const String& regex, StringVector& out, Options ops, bool clear)
+            throw (IRegex::Failed)
+        {
+            compiled(regex, ops).split(target, out, clear);
+        }
+
+        // split: split regex into vector
+        void split(const String& target, const String& regex, StringVector& out, Options ops, bool clear)
+            throw (IRegex::Failed)
+        {
+            String t(target);
+            compiled(regex, ops).split(t, out, clear);
+        }
+
+        // match: match target on regex
+        bool match(const String& target, const String& regex, Options ops)
+            throw (IRegex::Failed)
+        {
+            return compiled(regex, ops).match(target);
+        }
+
+        // match: match target on regex
+        bool match(const String& target, const String& regex, StringParts& out, Options ops, bool clear)
+            throw (IRegex::Failed)
+        {
+            return compiled(regex, ops).match(target, out, clear);
+        }
+
+        // replace: replace target string against a regex
+        String replace(const String& target, const String& regex, const String& format, Options ops)
+            throw (IRegex::Failed)
+        {
+            String t(target);
+            compiled(regex, ops).replace(t, format);
+            return t;
+        }
+
+        // replace: replace target string against a regex
+        void replace(String& target, const String& regex, const String& format, Options ops)
+            throw (IRegex::Failed)
+        {
+            compiled(regex, ops).replace(target, format);
+        }
+    };
     
     //
     // Regex factory
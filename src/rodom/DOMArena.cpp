@@ -0,0 +1,254 @@
+/*
+ * Kuumba C++ Core
+ *
+ * $Id$
+ */
+#include <inc/core/Core.h>
+#include "DOMArena.h"
+
+#define KCC_FILE "DOMArena"
+
+namespace kcc
+{
+    // Constants
+    static const long   k_nodesPerBlock = 1024L;
+    static const long   k_itemsPerBlock = 4096L;
+    static const String k_domDocument("#document");
+    static const String k_domComment ("#comment");
+    static const String k_domText    ("#text");
+    static const String k_domCDATA   ("#cdata-section");
+
+    // Helper class for shallow search results (nodes are NOT owned)
+    struct ArenaNodeSelection : IDOMNodeList
+    {
+        std::vector<const IDOMNode*> m_list;
+        const IDOMNode* getItem(long index) const { return (index < 0 || index >= getLength()) ? NULL : m_list[index]; }
+        long getLength() const                    { return (long)m_list.size(); }
+    };
+
+    //
+    // ArenaNode implementation
+    //
+
+    // ctor
+    ArenaNode::ArenaNode(DOMArena* arena, IDOMNode::Type type, const String* name) :
+        m_arena(arena), m_index(-1), m_type(type), m_parent(NULL), m_next(NULL),
+        m_firstChild(NULL), m_lastChild(NULL), m_firstAttr(NULL), m_lastAttr(NULL),
+        m_name(NULL), m_nameLength(0L), m_nameString(name),
+        m_value(NULL), m_valueLength(0L), m_valueString(NULL)
+    {
+        if (name != NULL)
+        {
+            m_name       = name->data();
+            m_nameLength = (long)name->size();
+        }
+    }
+
+    // ArenaNode - accessors/modifiers
+    IDOMNode::Type ArenaNode::getNodeType() const         { return m_type; }
+    const IDOMNode* ArenaNode::getParentNode() const      { return m_parent; }
+    const IDOMNodeList* ArenaNode::getChildNodes() const  { return &m_children; }
+    const IDOMNode* ArenaNode::getFirstChild() const      { return m_children.getItem(0); }
+    const IDOMNode* ArenaNode::getLastChild() const       { return m_children.getItem(m_children.getLength() - 1); }
+    const IDOMNode* ArenaNode::getPreviousSibling() const { return m_parent == NULL ? NULL : m_parent->m_children.getItem(m_index - 1); }
+    const IDOMNode* ArenaNode::getNextSibling() const     { return m_parent == NULL ? NULL : m_parent->m_children.getItem(m_index + 1); }
+    const IDOMNamedNodeMap* ArenaNode::getAttributes() const { return &m_attributes; }
+    int ArenaNode::getIndex() const                       { return m_index; }
+    bool ArenaNode::hasChildNodes() const                 { return m_children.getLength() > 0; }
+    bool ArenaNode::hasAttributes() const                 { return m_attributes.getLength() > 0; }
+    void ArenaNode::name(const Char* begin, const Char* end)  { m_name  = begin; m_nameLength  = (long)(end - begin); }
+    void ArenaNode::value(const Char* begin, const Char* end) { m_value = begin; m_valueLength = (long)(end - begin); }
+
+    // isNamed: compare name without materializing it
+    bool ArenaNode::isNamed(const String& name) const
+    {
+        return
+            (long)name.size() == m_nameLength &&
+            std::memcmp(name.data(), m_name, m_nameLength) == 0;
+    }
+
+    // getNodeName: name, materialized (interned) on first read
+    const String& ArenaNode::getNodeName() const
+    {
+        if (m_nameString == NULL) m_arena->name(m_nameString, m_name, m_nameLength);
+        return *m_nameString;
+    }
+
+    // getNodeValue: value, materialized on first read
+    const String& ArenaNode::getNodeValue() const
+    {
+        if (m_value == NULL) return Strings::empty();
+        if (m_valueString == NULL) m_arena->value(m_valueString, m_value, m_valueLength);
+        return *m_valueString;
+    }
+
+    // findNodesByTagName: find nodes, shallow search, ownership consumed
+    IDOMNodeList* ArenaNode::findNodesByTagName(const String& tagName) const
+    {
+        ArenaNodeSelection* nodes = new ArenaNodeSelection();
+        long sz = m_children.getLength();
+        for (long i = 0; i < sz; i++)
+        {
+            ArenaNode* n = m_children.getItemImpl(i);
+            if (n->isNamed(tagName)) nodes->m_list.push_back(n);
+        }
+        return nodes;
+    }
+
+    // addAttributeImpl: link attribute node
+    void ArenaNode::addAttributeImpl(ArenaNode* node)
+    {
+        node->m_index = (m_lastAttr == NULL) ? 0 : m_lastAttr->m_index + 1;
+        if (m_lastAttr == NULL) m_firstAttr = node;
+        else                    m_lastAttr->m_next = node;
+        m_lastAttr = node;
+    }
+
+    // addNodeImpl: link child node
+    void ArenaNode::addNodeImpl(ArenaNode* node)
+    {
+        node->m_parent = this;
+        node->m_index  = (m_lastChild == NULL) ? 0 : m_lastChild->m_index + 1;
+        if (m_lastChild == NULL) m_firstChild = node;
+        else                     m_lastChild->m_next = node;
+        m_lastChild = node;
+    }
+
+    // finalize: move child and attribute links into indexed arena arrays
+    void ArenaNode::finalize()
+    {
+        if (m_lastChild != NULL)
+        {
+            long sz = m_lastChild->m_index + 1;
+            ArenaNode** items = m_arena->items(sz);
+            for (ArenaNode* n = m_firstChild; n != NULL; n = n->m_next) items[n->m_index] = n;
+            m_children.assign(items, sz);
+        }
+        if (m_lastAttr != NULL)
+        {
+            long sz = m_lastAttr->m_index + 1;
+            ArenaNode** items = m_arena->items(sz);
+            for (ArenaNode* n = m_firstAttr; n != NULL; n = n->m_next) items[n->m_index] = n;
+            m_attributes.assign(items, sz);
+        }
+    }
+
+    //
+    // ArenaDocument implementation
+    //
+
+    ArenaDocument::ArenaDocument(const String& input) :
+        ArenaNode(new DOMArena(input), IDOMNode::DOCUMENT_NODE, &k_domDocument)
+    {}
+    ArenaDocument::~ArenaDocument() { delete m_arena; }
+
+    //
+    // ArenaNodeList/ArenaNamedNodeMap implementation
+    //
+
+    long ArenaNodeList::getLength() const                    { return m_length; }
+    ArenaNode* ArenaNodeList::getItemImpl(long index) const  { return (index < 0 || index >= m_length) ? NULL : m_items[index]; }
+    const IDOMNode* ArenaNodeList::getItem(long index) const { return getItemImpl(index); }
+    long ArenaNamedNodeMap::getLength() const                { return m_length; }
+    const IDOMNode* ArenaNamedNodeMap::getItem(long index) const
+    {
+        return (index < 0 || index >= m_length) ? NULL : m_items[index];
+    }
+
+    // getNamedItem: accessor to named node
+    const IDOMNode* ArenaNamedNodeMap::getNamedItem(const String& name) const
+    {
+        for (long i = 0L; i < m_length; i++)
+        {
+            if (m_items[i]->isNamed(name)) return m_items[i];
+        }
+        return NULL;
+    }
+
+    //
+    // DOMArena implementation
+    //
+
+    // ctor/dtor
+    DOMArena::DOMArena(const String& input) :
+        m_input(input), m_nodesUsed(k_nodesPerBlock), m_itemsUsed(k_itemsPerBlock)
+    {}
+    DOMArena::~DOMArena()
+    {
+        for (std::vector<ArenaNode*>::size_type i = 0; i < m_nodes.size(); i++)
+        {
+            ArenaNode* block = m_nodes[i];
+            long used = (i + 1 == m_nodes.size()) ? m_nodesUsed : k_nodesPerBlock;
+            for (long j = 0L; j < used; j++) block[j].~ArenaNode();
+            ::operator delete(block);
+        }
+        for (std::vector<ArenaNode**>::iterator i = m_items.begin(); i != m_items.end(); i++)
+            ::operator delete(*i);
+    }
+
+    // construct: allocate node from current node block
+    ArenaNode* DOMArena::construct(IDOMNode::Type type, const String* name)
+    {
+        if (m_nodesUsed == k_nodesPerBlock)
+        {
+            m_nodes.push_back(static_cast<ArenaNode*>(::operator new(sizeof(ArenaNode) * k_nodesPerBlock)));
+            m_nodesUsed = 0L;
+        }
+        return new (m_nodes.back() + m_nodesUsed++) ArenaNode(this, type, name);
+    }
+
+    // node factory
+    ArenaNode* DOMArena::constructCommentNode() { return construct(IDOMNode::COMMENT_NODE,       &k_domComment); }
+    ArenaNode* DOMArena::constructTextNode()    { return construct(IDOMNode::TEXT_NODE,          &k_domText);    }
+    ArenaNode* DOMArena::constructCDATANode()   { return construct(IDOMNode::CDATA_SECTION_NODE, &k_domCDATA);   }
+
+    // items: allocate node pointer array (oversized arrays get their own block)
+    ArenaNode** DOMArena::items(long count)
+    {
+        if (count > k_itemsPerBlock / 4L)
+        {
+            ArenaNode** block = static_cast<ArenaNode**>(::operator new(sizeof(ArenaNode*) * count));
+            m_items.insert(m_items.begin(), block); // keep current block last
+            return block;
+        }
+        if (m_itemsUsed + count > k_itemsPerBlock)
+        {
+            m_items.push_back(static_cast<ArenaNode**>(::operator new(sizeof(ArenaNode*) * k_itemsPerBlock)));
+            m_itemsUsed = 0L;
+        }
+        ArenaNode** items = m_items.back() + m_itemsUsed;
+        m_itemsUsed += count;
+        return items;
+    }
+
+    // finalize: index children and attributes of every arena node
+    void DOMArena::finalize()
+    {
+        for (std::vector<ArenaNode*>::size_type i = 0; i < m_nodes.size(); i++)
+        {
+            ArenaNode* block = m_nodes[i];
+            long used = (i + 1 == m_nodes.size()) ? m_nodesUsed : k_nodesPerBlock;
+            for (long j = 0L; j < used; j++) block[j].finalize();
+        }
+    }
+
+    // name: intern name (read-only documents may be shared so materialization is locked)
+    const String* DOMArena::name(const String*& cache, const Char* b, long len)
+    {
+        Mutex::Lock lock(m_sentinel);
+        if (cache == NULL) cache = &*m_names.insert(String(b, len)).first;
+        return cache;
+    }
+
+    // value: materialize value
+    const String* DOMArena::value(const String*& cache, const Char* b, long len)
+    {
+        Mutex::Lock lock(m_sentinel);
+        if (cache == NULL)
+        {
+            m_values.push_back(String(b, len));
+            cache = &m_values.back();
+        }
+        return cache;
+    }
+}
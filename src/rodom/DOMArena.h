@@ -0,0 +1,163 @@
+/*
+ * Kuumba C++ Core
+ *
+ * $Id$
+ */
+#ifndef DOMArena_h
+#define DOMArena_h
+
+namespace kcc
+{
+    class ArenaNode;
+    class DOMArena;
+
+    /** Arena NodeList implementation (items allocated from arena) */
+    class ArenaNodeList : public IDOMNodeList
+    {
+    public:
+        // Modifiers
+        ArenaNodeList() : m_items(NULL), m_length(0L) {}
+        void assign(ArenaNode** items, long length) { m_items = items; m_length = length; }
+        ArenaNode* getItemImpl(long index) const;
+
+        // Accessors
+        const IDOMNode* getItem(long index) const;
+        long getLength() const;
+
+    protected:
+        // Attributes
+        ArenaNode** m_items;
+        long        m_length;
+
+    private:
+        ArenaNodeList(const ArenaNodeList&);
+        ArenaNodeList& operator = (const ArenaNodeList&);
+    };
+
+    /** Arena NamedNodeMap implementation (linear search, attribute counts are small) */
+    class ArenaNamedNodeMap : public IDOMNamedNodeMap
+    {
+    public:
+        // Modifiers
+        ArenaNamedNodeMap() : m_items(NULL), m_length(0L) {}
+        void assign(ArenaNode** items, long length) { m_items = items; m_length = length; }
+
+        // Accessors
+        const IDOMNode* getItem     (long index) const;
+        const IDOMNode* getNamedItem(const String& name) const;
+        long            getLength   () const;
+
+    protected:
+        // Attributes
+        ArenaNode** m_items;
+        long        m_length;
+
+    private:
+        ArenaNamedNodeMap(const ArenaNamedNodeMap&);
+        ArenaNamedNodeMap& operator = (const ArenaNamedNodeMap&);
+    };
+
+    /** Arena Node implementation: name and value are views into the arena input */
+    class ArenaNode : public IDOMNode
+    {
+    public:
+        // Modifiers
+        ArenaNode(DOMArena* arena, IDOMNode::Type type, const String* name = NULL);
+        void addAttributeImpl(ArenaNode* node);
+        void addNodeImpl     (ArenaNode* node);
+        void name            (const Char* begin, const Char* end);
+        void value           (const Char* begin, const Char* end);
+        void finalize        ();
+        DOMArena& arena      () { return *m_arena; }
+
+        // Accessors
+        bool                    isNamed           (const String& name) const;
+        const String&           getNodeName       () const;
+        const String&           getNodeValue      () const;
+        Type                    getNodeType       () const;
+        const IDOMNode*         getParentNode     () const;
+        const IDOMNodeList*     getChildNodes     () const;
+        const IDOMNode*         getFirstChild     () const;
+        const IDOMNode*         getLastChild      () const;
+        const IDOMNode*         getPreviousSibling() const;
+        const IDOMNode*         getNextSibling    () const;
+        const IDOMNamedNodeMap* getAttributes     () const;
+        int                     getIndex          () const;
+        bool                    hasChildNodes     () const;
+        bool                    hasAttributes     () const;
+        IDOMNodeList*           findNodesByTagName(const String& tagName) const; // shallow search, ownership consumed
+
+    protected:
+        // Attributes
+        DOMArena*             m_arena;
+        int                   m_index;
+        IDOMNode::Type        m_type;
+        ArenaNode*            m_parent;
+        ArenaNode*            m_next;        // sibling link while parsing
+        ArenaNode*            m_firstChild;  // child links while parsing
+        ArenaNode*            m_lastChild;
+        ArenaNode*            m_firstAttr;   // attribute links while parsing
+        ArenaNode*            m_lastAttr;
+        const Char*           m_name;
+        long                  m_nameLength;
+        mutable const String* m_nameString;  // materialized on first read
+        const Char*           m_value;
+        long                  m_valueLength;
+        mutable const String* m_valueString; // materialized on first read
+        ArenaNodeList         m_children;
+        ArenaNamedNodeMap     m_attributes;
+
+    private:
+        ArenaNode(const ArenaNode&);
+        const ArenaNode& operator = (const ArenaNode&);
+    };
+
+    /** Arena document node: owns the arena (and with it every other node) */
+    class ArenaDocument : public ArenaNode
+    {
+    public:
+        ArenaDocument(const String& input);
+        virtual ~ArenaDocument();
+    };
+
+    /**
+     * Per-document arena. Holds the single copy of the parsed input, allocates
+     * nodes and child arrays in blocks and materializes names and values as
+     * they are read. Interned names are shared by all nodes of the same name.
+     */
+    class DOMArena
+    {
+    public:
+        // Modifiers
+        DOMArena(const String& input);
+        ~DOMArena();
+        ArenaNode*  construct(IDOMNode::Type type, const String* name = NULL);
+        ArenaNode*  constructCommentNode();
+        ArenaNode*  constructTextNode   ();
+        ArenaNode*  constructCDATANode  ();
+        ArenaNode** items    (long count);
+        void        finalize ();
+
+        // Accessors
+        inline const Char* begin() const { return m_input.data(); }
+        inline const Char* end  () const { return m_input.data() + m_input.size(); }
+        const String* name (const String*& cache, const Char* b, long len);
+        const String* value(const String*& cache, const Char* b, long len);
+
+    private:
+        DOMArena(const DOMArena&);
+        DOMArena& operator = (const DOMArena&);
+
+        // Attributes
+        String                   m_input;
+        std::vector<ArenaNode*>  m_nodes;
+        long                     m_nodesUsed;
+        std::vector<ArenaNode**> m_items;
+        long                     m_itemsUsed;
+        std::set<String>         m_names;
+        std::deque<String>       m_values;
+        Mutex                    m_sentinel;
+    };
+}
+
+#endif // DOMArena_h
@@ -5,6 +5,7 @@
  */
 #include <inc/core/Core.h>
 #include "DOM.h"
+#include "DOMArena.h"
 
 #define KCC_FILE    "RODOM"
 #define KCC_VERSION "$Id: RODOM.cpp 21066 2007-10-15 15:58:24Z tvk $"
@@ -342,6 +343,16 @@ namespace kcc
             return parse(text.data(), text.data() + text.size(), true);
         }
 
+        // parse: parse XML string into RODOM using allocation
+        IDOMNode* parseXML(const String& text, IRODOM::Allocation allocation) throw (IRODOM::ParseFailed)
+        {
+            Log::Scope scope(KCC_FILE, "parseXML");
+            if (allocation != IRODOM::A_ARENA) return parse(text.data(), text.data() + text.size(), true);
+            AutoPtr<ArenaDocument> root(new ArenaDocument(text));
+            parseArena(root);
+            return root.release();
+        }
+
         // parse: parse HTML string into RODOM
         IDOMNode* parseHTML(const String& text) throw (IRODOM::ParseFailed)
         {
@@ -371,11 +382,40 @@ namespace kcc
             }
         }
 
+        // attribute: add attribute to node (valueless html attributes have a null value)
+        void attribute(
+            DOMNode* node,
+            const Char* nameBegin, const Char* nameEnd,
+            const Char* valueBegin, const Char* valueEnd,
+            bool xml)
+        {
+            // html name is unform-case: lower
+            String name(nameBegin, nameEnd);
+            if (!xml) Strings::toLower(name);
+
+            // html valueless attribute: set its value to be its own name (per HTML 4.0 spec)
+            if (valueBegin == NULL) node->addAttributeImpl(new DOMNode(IDOMNode::ATTRIBUTE_NODE, name, name));
+            else                    node->addAttributeImpl(new DOMNode(IDOMNode::ATTRIBUTE_NODE, name, String(valueBegin, valueEnd)));
+        }
+        void attribute(
+            ArenaNode* node,
+            const Char* nameBegin, const Char* nameEnd,
+            const Char* valueBegin, const Char* valueEnd,
+            bool)
+        {
+            ArenaNode* attr = node->arena().construct(IDOMNode::ATTRIBUTE_NODE);
+            attr->name(nameBegin, nameEnd);
+            if (valueBegin == NULL) attr->value(nameBegin, nameEnd);
+            else                    attr->value(valueBegin, valueEnd);
+            node->addAttributeImpl(attr);
+        }
+
         // parseAttributes: parse attributes into currNode
+        template <class Node>
         void parseAttributes(
             register const Char* c,
             register const Char* end,
-            DOMNode* currNode,
+            Node* currNode,
             bool xml)
         {
             // skip element name
@@ -400,11 +440,6 @@ namespace kcc
                     ++c;
                 const Char* const name_end = c;
 
-                // attribute name found
-                String name(name_begin, name_end);
-                // html name is unform-case: lower
-                if (!xml) Strings::toLower(name);
-
                 // move to start of attribute separator: first non-' '
                 while (c != end && Strings::isSpace(*c))
                     ++c;
@@ -419,11 +454,7 @@ namespace kcc
                     
                     if (c == end || *c != '=')
                     {
-                        currNode->addAttributeImpl(
-                            new DOMNode(
-                                IDOMNode::ATTRIBUTE_NODE,
-                                name,
-                                name));
+                        attribute(currNode, name_begin, name_end, NULL, NULL, xml);
                         continue;
                     }
                 }
@@ -482,16 +513,57 @@ namespace kcc
                     }
                 }
 
-                // attribute value found
-                String value(b, c);
-
                 // add attribute a child node
-                currNode->addAttributeImpl(new DOMNode(IDOMNode::ATTRIBUTE_NODE, name, value));
+                attribute(currNode, name_begin, name_end, b, c, xml);
                 if (c == end) break;
                 ++c;
             }
         }
 
+        // skipComment: move c past comment end ('<!' consumed, c at '--')
+        bool skipComment(register const Char*& c, register const Char* end)
+        {
+            c += 2;
+            while (c < end)
+            {
+                if (*c++ == '-' && c != end && *c == '-')
+                {
+                    const Char* const d = c;
+
+                    // skip past space
+                    while (++c != end && Strings::isSpace(*c))
+                        ;
+
+                    // found end
+                    if (c == end || *c++ == '>') break;
+                    c = d;
+                }
+            }
+            return c != end;
+        }
+
+        // skipCDATA: move c past CDATA end ('<!' consumed, c at '[CDATA[')
+        bool skipCDATA(register const Char*& c, register const Char* end)
+        {
+            c += k_domCDATA.length();
+            while (c < end)
+            {
+                if (*c++ == ']' && c != end && *c == ']')
+                {
+                    const Char* const d = c;
+
+                    // skip past space
+                    while (++c != end && Strings::isSpace(*c))
+                        ;
+
+                    // found end
+                    if (c == end || *c++ == '>') break;
+                    c = d;
+                }
+            }
+            return c < end;
+        }
+
         // parse: parse text returning root node
         DOMNode* parse(register const Char* c, register const Char* end, bool xml)
         {
@@ -524,23 +596,7 @@ namespace kcc
                     // comment
                     if (*c == '-' && c + 1 != end && c[1] == '-')
                     {
-                        c += 2;
-                        while (c < end)
-                        {
-                            if (*c++ == '-' && c != end && *c == '-')
-                            {
-                                const Char* const d = c;
-
-                                // skip past space
-                                while (++c != end && Strings::isSpace(*c))
-                                    ;
-
-                                // found end
-                                if (c == end || *c++ == '>') break;
-                                c = d;
-                            }
-                        }
-                        if (c != end) // end of comment
+                        if (skipComment(c, end)) // end of comment
                         {
                             DOMNode* comment = DOMNodeFactory::constructCommentNode();
                             comment->value() = String(b+4, c-3);
@@ -553,23 +609,7 @@ namespace kcc
                     int const len = k_domCDATA.length();
                     if (*c == '[' && c + len < end && std::memcmp(c, k_domCDATA.data(), len) == 0)
                     {
-                        c += len;
-                        while (c < end)
-                        {
-                            if (*c++ == ']' && c != end && *c == ']')
-                            {
-                                const Char* const d = c;
-
-                                // skip past space
-                                while (++c != end && Strings::isSpace(*c))
-                                    ;
-
-                                // found end
-                                if (c == end || *c++ == '>') break;
-                                c = d;
-                            }
-                        }
-                        if (c < end) // end of doc
+                        if (skipCDATA(c, end)) // end of doc
                         {
                             DOMNode* cdata = DOMNodeFactory::constructCDATANode();
                             cdata->value() = String(b+len+2, c-3);
@@ -902,6 +942,141 @@ namespace kcc
                 currNode = node;
             }
         }
+
+        // parseArena: parse xml into arena document (follows parse() for xml)
+        //  - names and values are left in the input and read on demand
+        void parseArena(ArenaDocument* rootNode)
+        {
+            DOMArena& arena = rootNode->arena();
+            register const Char* c   = arena.begin();
+            register const Char* end = arena.end();
+            std::vector<ArenaNode*> nodeStack;
+            nodeStack.push_back(rootNode);
+
+            // parse document adding to root
+            ArenaNode* currNode = rootNode;
+            while (c != end)
+            {
+                const Char* const b = c;
+                if (*c == '<')
+                {
+                    c++;
+                    if (c == end) break;
+
+                    // tag
+                    if (Strings::isAlpha(*c) || *c == '/')
+                    {
+                        parseArenaTag(nodeStack, c, end, currNode);
+                        continue;
+                    }
+                    c++;
+                    if (c == end) break;
+
+                    // comment
+                    if (*c == '-' && c + 1 != end && c[1] == '-')
+                    {
+                        if (skipComment(c, end)) // end of comment
+                        {
+                            ArenaNode* comment = arena.constructCommentNode();
+                            comment->value(b+4, c-3);
+                            currNode->addNodeImpl(comment);
+                        }
+                        continue;
+                    }
+
+                    // CDATA
+                    int const len = k_domCDATA.length();
+                    if (*c == '[' && c + len < end && std::memcmp(c, k_domCDATA.data(), len) == 0)
+                    {
+                        if (skipCDATA(c, end)) // end of doc
+                        {
+                            ArenaNode* cdata = arena.constructCDATANode();
+                            cdata->value(b+len+2, c-3);
+                            currNode->addNodeImpl(cdata);
+                        }
+                        continue;
+                    }
+
+                    // < always begins a tag
+                    moveToTagEnd(c, end);
+                }
+                else
+                {
+                    // text
+                    for (; c != end; c++)
+                    {
+                        // a new tag has been found so stop parsing text
+                        if (*c == '<') break;
+                    }
+                }
+
+                // ws between nodes is discarded
+                const Char* ws = b;
+                while (ws != c && Strings::isSpace(*ws)) ws++;
+                if (ws != c)
+                {
+                    ArenaNode* text = arena.constructTextNode();
+                    text->value(b, c);
+                    currNode->addNodeImpl(text);
+                }
+            }
+
+            // index children & attributes
+            arena.finalize();
+            rootNode->finalize();
+        }
+
+        // parseArenaTag: parse the xml tag (follows parseXMLTag())
+        void parseArenaTag(
+            std::vector<ArenaNode*>& nodeStack,
+            register const Char*& c,
+            register const Char* end,
+            ArenaNode*& currNode)
+        {
+            if (c == end) return;
+            const Char* const tagBegin = c;
+            moveToTagEnd(c, end);
+            const Char* const tagEnd = c - 1;
+            bool const isEndTag = *tagBegin == '/';
+            bool const isSimpleTag = *(tagEnd-1) == '/';
+
+            // tag name: up to 1st whitespace or end
+            const Char* nameEnd = tagBegin;
+            while (nameEnd != tagEnd && !Strings::isSpace(*nameEnd) && nameEnd - tagBegin < MAX_TAG)
+                nameEnd++;
+
+            // check for malformed tags that don't put a space on closed elements
+            // e.g. '<foo/>' which should be '<foo />
+            if (*(nameEnd-1) == '/' && *nameEnd == '>') nameEnd--;
+
+            // end of tag: pop current node off parse stack 
+            if (isEndTag)
+            {
+                if (nodeStack.size() <= 1) 
+                {
+                    String msg("malformed xml. unbalanced xml node: tag=[");
+                    msg.append(tagBegin+1, nameEnd);
+                    msg += "]";
+                    throw IRODOM::ParseFailed(msg);
+                }
+                nodeStack.pop_back();
+                currNode = nodeStack.back();
+                return;
+            }
+
+            // add element
+            ArenaNode* node = currNode->arena().construct(IDOMNode::ELEMENT_NODE);
+            node->name(tagBegin, nameEnd);
+            parseAttributes(tagBegin, tagEnd, node, true);
+            currNode->addNodeImpl(node);
+
+            // simple tag has collapsed start/end tags so don't set current
+            if (!isSimpleTag)
+            {
+                nodeStack.push_back(node);
+                currNode = node;
+            }
+        }
     };
     
     //
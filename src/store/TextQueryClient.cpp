@@ -7,6 +7,8 @@
 #include <inc/store/ITextStore.h>
 #include <inc/store/TextQueryXml.h>
 #include <inc/store/TextQueryRest.h>
+#include <inc/store/TextQueryBinary.h>
+#include <inc/store/TextQueryXmlCodec.h>
 
 #define KCC_FILE    "TextQueryClient"
 #define KCC_VERSION "$Id: TextQueryClient.cpp 22694 2008-03-17 18:49:19Z tvk $"
@@ -16,7 +18,10 @@ namespace kcc
     // Configuration 
     static const String k_keyConnections("TextQueryClient.connections");
     static const String k_keyMaxDocs    ("TextQueryClient.maxDocs");
+    static const String k_keyFormat     ("TextQueryClient.format");
+    static const String k_keyIOThreads  ("TextQueryClient.ioThreads");
     static const long   k_defMaxDocs    = 25L;
+    static const String k_defFormat     ("xml");
 
     // Constants
     static const String k_sep     (",");
@@ -24,62 +29,87 @@ namespace kcc
     static const String k_urlSep  ("&");
 
     // Helper class for results
+    //  - documents is the shard's fetched window: rows [start, start+size)
+    //  - row is the shard's merge cursor (next shard row not yet merged)
+    //  - scale is the shard's score scale (its scores are normalized to its own top score)
     struct ResultSet
     {
         URL    url;
         String id;
-        bool   next;
         long   row;
         long   total;
         long   size;
         long   start;
+        double scale;
         String error;
         TextDocuments documents;
-        ResultSet(const URL& _url) : url(_url), next(false), row(-1L), total(0L), size(0L), start(-1L) {}
+        ResultSet(const URL& _url) : url(_url), row(0L), total(0L), size(0L), start(-1L), scale(1.0) {}
         inline bool operator == (const String& rhs) const { return id == rhs; }
+        inline bool windowed() const { return start >= 0L && row >= start && row < start + size; }
+        inline const TextDocument& current() const { return documents[row - start]; }
     };
     typedef std::list<ResultSet> Results;
 
     // Results of text query
+    //  - shard results are merged by score using a k-way heap of shard heads; a shard
+    //    is only fetched from when its window is exhausted, and then only for as many
+    //    rows as the requested page still needs
+    //  - each shard normalizes scores to its own top score, so heads are ordered by raw
+    //    score (score * shard scale) and documents are renormalized to the top shard scale
     struct TextQueryClientResults : ITextResults
     {
-        // Helper thread to run initial query in parallel
-        struct QueryBeginThread : Thread
+        // Helper task to run initial query in parallel (on the client's I/O executor)
+        struct QueryBeginTask : Executor::Future
         {
             TextQueryClientResults* client;
             ResultSet&              results;
-            Monitor&                done;
-            QueryBeginThread(TextQueryClientResults* c, ResultSet& r, Monitor& d)
-                : Thread("QueryBeginThread"), client(c), results(r), done(d) 
-            {
-                done.init();
-            }
+            QueryBeginTask(TextQueryClientResults* c, ResultSet& r) : client(c), results(r) {}
             virtual void invoke()
             {
-                Log::Scope scope(KCC_FILE, "QueryBeginThread::begin");
+                Log::Scope scope(KCC_FILE, "QueryBeginTask::begin");
                 try
                 {
-                    client->query(results, 0L, 0L);
+                    client->query(results, 0L, client->m_maxDocs);
                 }
                 catch (TextException&)
                 {
                     // error handled by query client
                 }
-                done.notify();
             }
         };
+        typedef std::vector<QueryBeginTask*> QueryBeginTasks;
+
+        // Helper class for merge heap entry (ordered best raw score first, then shard order)
+        struct Head
+        {
+            double score;
+            long   shard;
+            Head(double s, long i) : score(s), shard(i) {}
+            inline bool operator < (const Head& rhs) const 
+            { 
+                return score < rhs.score || (score == rhs.score && shard > rhs.shard); 
+            }
+        };
+        typedef std::vector<Head>       Heads;
+        typedef std::vector<ResultSet*> Shards;
 
         // Attributes
         long                   m_total;
         long                   m_row;
+        long                   m_pageEnd;
         long                   m_maxDocs;
+        double                 m_scale;
+        bool                   m_binary;
         TextDocument::Contents m_contents;
         String                 m_expression;
         Results                m_results;
-        Results::iterator      m_itResults;
+        Shards                 m_shards;
+        Heads                  m_heads;
+        ResultSet*             m_current;
         TextQueryClientResults() : 
-            m_total(0L), m_row(-1L), m_maxDocs(1L), 
-            m_contents(TextDocument::C_TEXT|TextDocument::C_METADATA)
+            m_total(0L), m_row(-1L), m_pageEnd(0L), m_maxDocs(1L), m_scale(1.0), m_binary(false),
+            m_contents(TextDocument::C_TEXT|TextDocument::C_METADATA),
+            m_current(NULL)
         {}
 
         // dtor: flush any pending results
@@ -111,13 +141,14 @@ namespace kcc
         }
 
         // begin: begin query
-        void begin(const StringVector& connections, long maxDocs, const String& expression, TextDocument::Contents contents)
+        void begin(Executor& io, const StringVector& connections, long maxDocs, bool binary, const String& expression, TextDocument::Contents contents)
             throw (TextException)
         {
             Log::Scope scope(KCC_FILE, "TextQueryClientResults::begin");
 
             // init
-            m_maxDocs    = maxDocs;
+            m_maxDocs    = maxDocs < 1L ? 1L : maxDocs;
+            m_binary     = binary;
             m_expression = URL::encode(expression);
             m_contents   = contents;
             for (StringVector::const_iterator i = connections.begin(); i != connections.end(); i++)
@@ -129,6 +160,7 @@ namespace kcc
                 url.path = TextQueryRest::query();
                 m_results.push_back(ResultSet(url));
             }
+            for (Results::iterator i = m_results.begin(); i != m_results.end(); i++) m_shards.push_back(&*i);
             Log::info3("query begin: expr=[%s]", expression.c_str());
 
             // initial query
@@ -138,11 +170,21 @@ namespace kcc
             m_row   = -1L;
 
             // dispatch initial text query to each service
-            //  - return no documents, just queue up the index cache
-            Monitor done;
-            for (Results::iterator i = m_results.begin(); i != m_results.end(); i++)
-                (new QueryBeginThread(this, *i, done))->go();
-            done.wait();
+            //  - each shard returns at most the first page, which is all page 0 can use
+            //  - the calling thread blocks rather than helping (queued tasks may be other queries')
+            {
+                QueryBeginTasks tasks;
+                for (Results::iterator i = m_results.begin(); i != m_results.end(); i++)
+                {
+                    tasks.push_back(new QueryBeginTask(this, *i));
+                    io.submit(tasks.back());
+                }
+                for (QueryBeginTasks::iterator i = tasks.begin(); i != tasks.end(); i++)
+                {
+                    (*i)->wait(false);
+                    delete *i;
+                }
+            }
 
             // check for errors            
             String errors;
@@ -156,14 +198,17 @@ namespace kcc
             }
             if (!errors.empty()) throw TextException(errors);            
 
-            // fetch total documents            
+            // fetch total documents and scale of top scoring shard
             for (Results::iterator i = m_results.begin(); i != m_results.end(); i++) 
+            {
                 m_total += i->total;
+                m_scale  = std::max(m_scale, i->scale);
+            }
             if (m_total == 0L) m_total = -1L; // invalidate results (nothing to iterate)
             else
             {
-                // iterate results from beginning
-                m_itResults = m_results.begin();
+                // merge results from beginning
+                reset(m_maxDocs);
                 Log::info4("begin results: total=[%d] time=[%.3f]", m_total, t.now());
             }
         }
@@ -173,30 +218,28 @@ namespace kcc
         { 
             Log::Scope scope(KCC_FILE, "TextQueryClientResults::next");
 
-            if (m_total == -1L || m_row >= m_total) return false;
+            if (m_total == -1L || m_row + 1L >= m_total) return false;
 
-            // check current resultset cache first
-            m_itResults->row++;
-            m_row++;
-            if (m_itResults->size > 0L && m_itResults->row < m_itResults->size) return true;
+            // extend page when crossing its end
+            long target = m_row + 1L;
+            if (target >= m_pageEnd) m_pageEnd = target + m_maxDocs;
 
-            // refresh cache
-            bool next = false;
-            do
+            // advance shard of current document (kept in its window until now)
+            if (m_current != NULL)
             {
-                if (m_itResults->start + m_itResults->row < m_itResults->total)
-                {
-                    query(*m_itResults, m_itResults->start + m_itResults->row, m_maxDocs);
-                    next = true;
-                    break;
-                }
-                m_itResults++;
-                if (m_itResults != m_results.end() && m_itResults->start < 0L) 
-                    m_itResults->start = m_itResults->row = 0L; // move to initial row if newly created
+                ResultSet* rs = m_current;
+                m_current = NULL;
+                rs->row++;
+                push(rs, m_pageEnd - target);
             }
-            while (m_itResults != m_results.end());
-            
-            return next;
+            if (m_heads.empty()) return false;
+
+            // take best remaining head
+            std::pop_heap(m_heads.begin(), m_heads.end());
+            m_current = m_shards[m_heads.back().shard];
+            m_heads.pop_back();
+            m_row = target;
+            return true;
         }
 
         // total: total across all results
@@ -204,8 +247,13 @@ namespace kcc
 
         // row: virtual row across all results
         long row() { return m_row; }
+
+        // scale: score scale of top scoring shard
+        double scale() { return m_scale; }
         
         // seek: seek to row
+        //  - forward seeks merge through the skipped rows, fetching no shard row twice
+        //  - backward seeks restart the merge, reusing windows still positioned at row 0
         void seek(long row) throw (TextException) 
         { 
             Log::Scope scope(KCC_FILE, "TextQueryClientResults::seek");
@@ -213,31 +261,16 @@ namespace kcc
             if (m_total == -1L) throw TextException("query state not valid: seek() called on invalid cursor.");
             if (row < 0L || row >= m_total) throw TextException("row seek out of bounds");
             
-            long total  = 0L;
-            long offset = row;    // offset into resultset of seek row
-            for (Results::iterator i = m_results.begin(); i != m_results.end(); i++)
+            if (row == m_row) return;
+            if (row < m_row) reset(row + m_maxDocs);
+            else             m_pageEnd = row + m_maxDocs;
+            while (m_row < row) 
             {
-                long start = total;
-                long end   = total + i->total;
-                if (row >= start && row < end)
-                {
-                    // seek row to result offset
-                    m_row = row;
-                    m_itResults = i;
-                    query(*m_itResults, offset, m_maxDocs);
-                }
-                else
-                {
-                    // reset result cursor
-                    i->row = i->start = -1L;
-                    i->documents.clear();
-                }
-                offset -= i->total;
-                total  += i->total;
+                if (!next()) throw TextException("query state not valid: shard results ended before seek row");
             }
         }
 
-        // results: fetch next document from cache
+        // results: fetch current document from window
         void results(TextDocument& txtdoc) throw (TextException)
         {
             Log::Scope scope(KCC_FILE, "TextQueryClientResults::results");
@@ -246,19 +279,56 @@ namespace kcc
                 m_total == -1L ||
                 m_row == -1L || 
                 m_row >= m_total ||
-                m_itResults == m_results.end()) 
+                m_current == NULL) 
             {
                 throw TextException("query state not valid: results() called on invalid cursor.");
             }
             
-            if (m_itResults->size <= 0L || m_itResults->row >= m_itResults->size)
+            if (!m_current->windowed())
             {
                 throw TextException("query state not valid: results() called on invalid result set cache.");
             }
-            txtdoc = m_itResults->documents[m_itResults->row];
+            txtdoc = m_current->current();
+            txtdoc.score *= m_current->scale / m_scale;
+        }
+
+        // reset: restart merge at row 0 of every shard
+        void reset(long pageEnd) throw (TextException)
+        {
+            m_heads.clear();
+            m_current = NULL;
+            m_row     = -1L;
+            m_pageEnd = pageEnd;
+            for (Shards::iterator i = m_shards.begin(); i != m_shards.end(); i++)
+            {
+                (*i)->row = 0L;
+                push(*i, m_pageEnd);
+            }
+        }
+
+        // push: push shard head onto merge heap, fetching up to need rows if window exhausted
+        void push(ResultSet* rs, long need) throw (TextException)
+        {
+            if (rs->row >= rs->total) return;
+            if (!rs->windowed())
+            {
+                long remain = rs->total - rs->row;
+                if (need < 1L)     need = 1L;
+                if (need > remain) need = remain;
+                query(*rs, rs->row, need);
+                if (!rs->windowed()) 
+                {
+                    Log::error("shard results ended early: host=[%s:%d] row=[%d] total=[%d]", 
+                        rs->url.host.c_str(), rs->url.port, rs->row, rs->total);
+                    return;
+                }
+            }
+            long shard = std::find(m_shards.begin(), m_shards.end(), rs) - m_shards.begin();
+            m_heads.push_back(Head(rs->current().score * rs->scale, shard));
+            std::push_heap(m_heads.begin(), m_heads.end());
         }
 
-        // query: update results cache
+        // query: update results window
         void query(ResultSet& results, long row, long max) throw (TextException)
         {
             Log::Scope scope(KCC_FILE, "TextQueryClientResults::query");
@@ -280,106 +350,112 @@ namespace kcc
                 {
                     results.url.query = TextQueryRest::queryId() + k_urlValue + results.id;
                     Log::info4(
-                        "cursor results: host=[%s:%d] id=[%s] total=[%d] row=[%d]", 
-                        results.url.host.c_str(), results.url.port, results.id.c_str(), results.total, row);
+                        "cursor results: host=[%s:%d] id=[%s] total=[%d] row=[%d] max=[%d]", 
+                        results.url.host.c_str(), results.url.port, results.id.c_str(), results.total, row, max);
                 }
                 results.url.query += 
                     k_urlSep + TextQueryRest::queryMax() + k_urlValue + Strings::printf("%d", max) +
                     k_urlSep + TextQueryRest::queryRow() + k_urlValue + Strings::printf("%d", row);
-                String xml;
-                HTTP::getxml(results.url, xml);
-
-                // parse xml
-                AutoPtr<IDOMNode> root(Core::rodom()->parseXML(xml));
-                DOMReader r(root);
-                const IDOMNode* doc = r.doc(TextQueryXml::root());
-
-                // error
-                String error;
-                if (r.attrOp(doc, TextQueryXml::rootError(), error)) throw TextException(error);
-                
-                // status
-                const IDOMNode* status = r.node(doc, TextQueryXml::status());
-                results.id    = r.attr(status, TextQueryXml::statusId());
-                results.total = Strings::parseInteger(r.attr(status, TextQueryXml::statusTotal()));
-                results.start = Strings::parseInteger(r.attr(status, TextQueryXml::statusRow()));
-                results.size  = Strings::parseInteger(r.attr(status, TextQueryXml::statusSize()));
-                results.row   = 0L;
-
-                // documents
-                String k, v;
-                results.documents.clear();
-                results.documents.reserve(results.size);
-                AutoPtr<IDOMNodeList> docs(r.nodes(doc, TextQueryXml::document()));
-                long sz = docs->getLength();
-                if (sz != results.size)
-                { 
-                    Log::error("xml corrupted during streaming, rows: expected=[%d] received=[%d]", results.size, sz);
-                    results.size = sz;
-                }
-                for (long i = 0L; i < sz && i < results.total; i++)
-                {
-                    const IDOMNode* d = docs->getItem(i);
-                    results.documents.push_back(TextDocument());
-                    TextDocument& txtdoc = results.documents.back();
-
-                    // text
-                    const IDOMNode* txt = r.nodeOp(d, TextQueryXml::text());
-                    if (txt != NULL) txtdoc.text = r.text(txt);
-
-                    // metadata
-                    AutoPtr<IDOMNodeList> md(r.nodes(d, TextQueryXml::metadata()));
-                    long mdsz = md->getLength();
-                    for (long j = 0L; j < mdsz; j++)
-                    {
-                        const IDOMNode* m = md->getItem(j);
-                        k = r.attr(m, TextQueryXml::metadataKey());
-                        r.attrOp(m, TextQueryXml::metadataValue(), v);
-                        txtdoc.metadata[k] = v;
-                    }
-
-                    // terms
-                    AutoPtr<IDOMNodeList> tfv(r.nodes(d, TextQueryXml::term()));
-                    long tfvsz = tfv->getLength();
-                    for (long j = 0L; j < tfvsz; j++)
-                    {
-                        const IDOMNode* t = tfv->getItem(j);
-                        k = r.attr(t, TextQueryXml::termTerm());
-                        r.attrOp(t, TextQueryXml::termFrequency(), v);
-                        txtdoc.terms[k] = Strings::parseInteger(v);
-                    }
-                    
-                    // matches
-                    AutoPtr<IDOMNodeList> match(r.nodes(d, TextQueryXml::match()));
-                    long matchsz = match->getLength();
-                    for (long j = 0L; j < matchsz; j++)
-                    {
-                        const IDOMNode* m = match->getItem(j);
-                        long so = Strings::parseInteger(r.attr(m, TextQueryXml::matchStartOffset()));
-                        long eo = Strings::parseInteger(r.attr(m, TextQueryXml::matchEndOffset()));
-                        txtdoc.matches.push_back(TextDocument::Match(so, eo));
-                    }
-                }
+                if (m_binary) 
+                    results.url.query += k_urlSep + TextQueryRest::queryFormat() + k_urlValue + TextQueryRest::queryFormatBinary();
+                String data;
+                HTTP::getxml(results.url, data);
+
+                // parse results (errors are always xml)
+                if (TextQueryBinary::isBinary(data)) parseBinary(results, data);
+                else                                 parseXml   (results, data);
+                results.size = (long)results.documents.size();
                 results.error.clear();
             }
             catch (Exception& e)
             {
-                // invalidate results cache and cursor
-                results.row = results.start = -1L;
-                results.size = 0L;
+                // invalidate results window
+                results.start = -1L;
+                results.size  = 0L;
                 results.documents.clear();
                 results.error = e.what();
                 throw TextException(e.what());
             }
         }
+
+        // parseXml: replace results window from xml results
+        void parseXml(ResultSet& results, const String& xml) throw (Exception)
+        {
+            AutoPtr<IDOMNode> root(Core::rodom()->parseXML(xml));
+            DOMReader r(root);
+            const IDOMNode* doc = r.doc(TextQueryXml::root());
+
+            // error
+            String error;
+            if (r.attrOp(doc, TextQueryXml::rootError(), error)) throw TextException(error);
+            
+            // status
+            const IDOMNode* status = r.node(doc, TextQueryXml::status());
+            results.id    = r.attr(status, TextQueryXml::statusId());
+            results.total = Strings::parseInteger(r.attr(status, TextQueryXml::statusTotal()));
+            results.start = Strings::parseInteger(r.attr(status, TextQueryXml::statusRow()));
+            results.size  = Strings::parseInteger(r.attr(status, TextQueryXml::statusSize()));
+            String scale;
+            results.scale = r.attrOp(status, TextQueryXml::statusScale(), scale) ? Strings::parseFraction(scale) : 1.0;
+
+            // documents (replaces window)
+            results.documents.clear();
+            results.documents.reserve(results.size);
+            AutoPtr<IDOMNodeList> docs(r.nodes(doc, TextQueryXml::document()));
+            long sz = docs->getLength();
+            if (sz != results.size)
+            { 
+                Log::error("xml corrupted during streaming, rows: expected=[%d] received=[%d]", results.size, sz);
+                results.size = sz;
+            }
+            for (long i = 0L; i < sz && i < results.total; i++)
+            {
+                results.documents.push_back(TextDocument());
+                TextQueryXmlCodec::document(r, docs->getItem(i), results.documents.back());
+            }
+        }
+
+        // parseBinary: replace results window from binary results (documents precede status)
+        void parseBinary(ResultSet& results, const String& data) throw (Exception)
+        {
+            TextQueryBinary::Reader r(data);
+            TextQueryBinary::Status status;
+            TextQueryBinary::Tag    tag;
+            long row = 0L;
+            bool statusRead = false;
+            results.documents.clear();
+            results.documents.reserve(m_maxDocs);
+            while ((tag = r.next()) != TextQueryBinary::T_END)
+            {
+                if (tag == TextQueryBinary::T_STATUS)
+                {
+                    r.status(status);
+                    statusRead = true;
+                    continue;
+                }
+                results.documents.push_back(TextDocument());
+                r.document(row, results.documents.back());
+            }
+            if (!statusRead) throw TextException("binary results missing status");
+            results.id    = status.id;
+            results.total = status.total;
+            results.start = status.row;
+            results.size  = status.size;
+            results.scale = status.scale;
+            if ((long)results.documents.size() != results.size)
+                Log::error("binary results corrupted during streaming, rows: expected=[%d] received=[%d]", results.size, results.documents.size());
+            if ((long)results.documents.size() > results.total) results.documents.resize(results.total);
+        }
     };
 
     // Results of text query
     struct TextQueryClient : ITextQuery
     {
         // Attributes
-        StringVector m_connections;
-        long         m_maxDocs;
+        StringVector      m_connections;
+        long              m_maxDocs;
+        bool              m_binary;
+        AutoPtr<Executor> m_io;
 
         // init: initialize query
         bool init(const Properties& config)
@@ -395,8 +471,15 @@ namespace kcc
                 return false;
             }
             m_maxDocs = config.get(k_keyMaxDocs, k_defMaxDocs);
+            m_binary  = config.get(k_keyFormat, k_defFormat) == TextQueryRest::queryFormatBinary();
+
+            // shard queries block on I/O: own pool, sized to the connections (not the processors)
+            long ioThreads = std::max(config.get(k_keyIOThreads, (long)m_connections.size()), 1L);
+            m_io.reset(new Executor((int)ioThreads, "TextQueryClientIO"));
 
-            Log::info2("TextQueryClient initialized: connections=[%d] maxDocs=[%d]", m_connections.size(), m_maxDocs);
+            Log::info2(
+                "TextQueryClient initialized: connections=[%d] maxDocs=[%d] binary=[%d] ioThreads=[%d]", 
+                m_connections.size(), m_maxDocs, m_binary, ioThreads);
             return true;
         }
 
@@ -404,7 +487,8 @@ namespace kcc
         ITextResults* query(const String& expression, TextDocument::Contents contents) throw (TextException)
         {
             AutoPtr<TextQueryClientResults> tr(new TextQueryClientResults());
-            tr->begin(m_connections, m_maxDocs, expression, contents);
+            if (m_io.null()) throw TextException("text query not initialized");
+            tr->begin(*m_io, m_connections, m_maxDocs, m_binary, expression, contents);
             return tr.release();
         }
     };
@@ -32,12 +32,22 @@ namespace kcc
     static const String k_keyMaxMergeDocs  ("TextStore.maxMergeDocs");
     static const String k_keyMergeFactor   ("TextStore.mergeFactor");
     static const String k_keyStopWords     ("TextStore.stopWords");
+    static const String k_keyReopen        ("TextStore.reopenInterval");
+    static const String k_keyBulkThreads   ("TextStore.bulkThreads");
+    static const String k_keyBulkMerge     ("TextStore.bulkDocsPerMerge");
+    static const String k_keyCacheMax      ("TextStore.queryCacheMax");
+    static const String k_keyCacheHits     ("TextStore.queryCacheHits");
     static const String k_defPath          ("store");
     static const long   k_defCreate         = KCC_PROPERTY_FALSE;
     static const long   k_defDocsPerOpt     = -1L;
     static const long   k_defMaxFieldLength = 8096L;
     static const long   k_defMaxMergeDocs   = -1L;
     static const long   k_defMergeFactor    = -1L;
+    static const long   k_defReopen         = 1000L; // ms
+    static const long   k_defBulkThreads    = 4L;
+    static const long   k_defBulkMerge      = 100000L;
+    static const long   k_defCacheMax       = 256L;  // queries
+    static const long   k_defCacheHits      = 1000L; // top documents per query
     static const String k_defStopWords(
         "a,an,and,are,as,at,"
         "be,but,by,for,if,"
@@ -49,92 +59,313 @@ namespace kcc
 
     // Constants
     static const String k_text("#text");
+    static const String k_offsets("#offsets");
+    static const long   k_bulkMinMergeDocs = 1000L; // documents buffered in memory per bulk segment
+    static const long   k_bulkMinSlice     = 64L;   // fewest documents worth a bulk thread
     
-    // Utility class to manage shared query state
-    struct QuerySharedState
+    // Refcounted index searcher snapshot: searcher opened on the index as of version (read before opening)
+    struct IndexSnapshot
     {
-        // Finder
-        struct Finder
+        // Attributes
+        lucene::search::IndexSearcher* m_searcher;
+        int64_t                        m_version;
+        long                           m_lastModified;
+        long                           m_refs;
+        IndexSnapshot(const String& path, int64_t version, long lastModified) : 
+            m_searcher(_CLNEW lucene::search::IndexSearcher(path.c_str())), m_version(version), m_lastModified(lastModified), m_refs(1L)
+        {}
+        ~IndexSnapshot() { _CLDELETE(m_searcher); }
+
+    private:
+        IndexSnapshot(const IndexSnapshot&);
+        IndexSnapshot& operator = (const IndexSnapshot&);
+    };
+
+    // Refcounted query hits: top documents (id/score) of a normalized query expression as of an index version
+    struct QueryHits
+    {
+        // Attributes
+        String               m_key;
+        int64_t              m_generation;
+        long                 m_total;
+        std::vector<int32_t> m_ids;
+        std::vector<float_t> m_scores;
+        float_t              m_scale;
+        long                 m_refs;
+        QueryHits(const String& key, int64_t generation) : 
+            m_key(key), m_generation(generation), m_total(0L), m_scale(1.0f), m_refs(1L)
+        {}
+
+        // search: collect top documents, scores normalized as lucene::search::Hits does
+        void search(lucene::search::IndexSearcher* searcher, lucene::search::Query* query, long max)
         {
-            // Accessor: locks state
-            Finder(QuerySharedState& s) : m_queryState(s) { m_queryState.m_sentinel->lock(); }
-            ~Finder()                                     { m_queryState.m_sentinel->unlock(); }
-            
-            // Analyzer
-            inline lucene::analysis::standard::StandardAnalyzer* analyzer() { return m_queryState.m_analyzer; }
-            
-            // Searcher: creates if locked, out of date, or uncreated
-            inline lucene::search::IndexSearcher* searcher()
+            lucene::search::TopDocs* td = searcher->_search(query, NULL, (int32_t)max);
+            m_total = td->totalHits;
+            lucene::search::ScoreDoc** sd = td->scoreDocs;
+            m_scale = (sd[0] != NULL && sd[0]->score > 1.0f) ? sd[0]->score : 1.0f;
+            float_t norm = 1.0f / m_scale;
+            for (long i = 0L; sd[i] != NULL; i++)
             {
-				m_queryState.prepare();
-                return m_queryState.m_searcher; 
+                m_ids.push_back(sd[i]->doc);
+                m_scores.push_back(sd[i]->score * norm);
             }
+            _CLDELETE(td);
+        }
+        
+    private:
+        QueryHits(const QueryHits&);
+        QueryHits& operator = (const QueryHits&);
+    };
+    typedef std::list<QueryHits*>                      QueryHitsLRU;   // most recently used first
+    typedef std::map<String, QueryHitsLRU::iterator>   QueryHitsCache;
+
+    // Utility class to manage shared query state: current snapshot swapped in by a reopen thread
+    struct QuerySharedState : IThread
+    {
+        // Snapshot: holds reference on a snapshot for its lifetime
+        struct Snapshot
+        {
+            Snapshot(QuerySharedState& s) : m_queryState(s), m_snapshot(s.acquire()) {}
+            ~Snapshot() { m_queryState.release(m_snapshot); }
+            
+            // Accessors
+            inline lucene::analysis::standard::StandardAnalyzer* analyzer() { return m_queryState.m_analyzer; }
+            inline lucene::search::IndexSearcher*                searcher() { return m_snapshot->m_searcher; }
+            inline int64_t                                       generation() { return m_snapshot->m_version; }
+            inline QuerySharedState&                             state() { return m_queryState; }
             
         private:
-            Finder(const Finder&);
-            Finder& operator = (const Finder&);
+            Snapshot(const Snapshot&);
+            Snapshot& operator = (const Snapshot&);
         
             // Attributes
             QuerySharedState& m_queryState;
+            IndexSnapshot*    m_snapshot;
         };
         
         // Init
         QuerySharedState() :
-            m_lastModified(0L), 
-            m_path(Strings::emptyRC()),
-            m_sentinel(new Mutex()),
-            m_searcher(NULL),
-            m_analyzer(NULL) 
+            m_current(NULL),
+            m_analyzer(NULL),
+            m_interval(0L),
+            m_cacheMax(0L),
+            m_cacheHits(0L),
+            m_hits(0L),
+            m_misses(0L),
+            m_evictions(0L),
+            m_invalidations(0L)
         {}
+        ~QuerySharedState() 
+        { 
+            cacheClear();
+            if (m_current != NULL) release(m_current); 
+        }
         void init(
             const String& p, 
-            lucene::analysis::standard::StandardAnalyzer* s) 
+            lucene::analysis::standard::StandardAnalyzer* s,
+            long interval,
+            long cacheMax,
+            long cacheHits) 
         { 
-            m_path     = p; 
-            m_analyzer = s;
+            m_path      = p; 
+            m_analyzer  = s;
+            m_interval  = interval;
+            m_cacheMax  = cacheMax;
+            m_cacheHits = cacheHits;
+        }
+
+        // acquire: reference current snapshot, opening initial snapshot if needed (no filesystem check)
+        IndexSnapshot* acquire() throw (TextException)
+        {
+            {
+                Mutex::Lock lock(m_sentinel);
+                if (m_current != NULL)
+                {
+                    m_current->m_refs++;
+                    return m_current;
+                }
+            }
+            reopen(true);
+            Mutex::Lock lock(m_sentinel);
+            if (m_current == NULL) throw TextException("index searcher not available");
+            m_current->m_refs++;
+            return m_current;
         }
 
-		// prepare: prepare finder for searching
-		void prepare()
-		{
-            Log::Scope scope(KCC_FILE, "QuerySharedState::prepare");
-			Mutex::Lock lock(*m_sentinel);
+        // release: dereference snapshot, deleting when no longer referenced
+        void release(IndexSnapshot* s)
+        {
+            bool unused = false;
+            {
+                Mutex::Lock lock(m_sentinel);
+                unused = --s->m_refs == 0L;
+            }
+            if (unused) delete s;
+        }
+
+        // reopen: open new searcher off the query path if index modified, then swap it in
+        void reopen(bool initial = false) throw (TextException)
+        {
+            Mutex::Lock lock(m_opening);
             if (m_path.empty()) throw TextException("shared state not initialized with path");
-            
-            // if index is locked or has modified create new searcher to ensure
-            // most recent segments are available
-            lucene::index::IndexReader* r = NULL;
-            bool initial  = m_searcher == NULL;
-            bool modified = false;
-            bool locked   = false;
-            if (!initial)
-            {
-                r        = m_searcher->getReader();
-                modified = (long)r->lastModified(r->getDirectory()) != m_lastModified;
-                locked   = r->isLocked(r->getDirectory());
+            int64_t current = 0;
+            {
+                Mutex::Lock lock(m_sentinel);
+                if (initial && m_current != NULL) return; // opened by another query
+                if (m_current != NULL) current = m_current->m_version;
             }
-            
-            // lazy creation of searcher
-            if (initial || modified || locked)
+            try
+            {
+                // version changes on every commit (modified time has 1 sec resolution)
+                int64_t version = lucene::index::IndexReader::getCurrentVersion(m_path.c_str());
+                if (!initial && version == current) return;
+                long lastModified = (long)lucene::index::IndexReader::lastModified(m_path.c_str());
+                IndexSnapshot* s = new IndexSnapshot(m_path, version, lastModified);
+                Log::info3("index searcher created: initial=[%d] version=[%lld] modified=[%ld]", initial, (long long)version, lastModified);
+                IndexSnapshot* previous = NULL;
+                {
+                    Mutex::Lock lock(m_sentinel);
+                    previous  = m_current;
+                    m_current = s;
+                    if (!m_cache.empty()) m_invalidations++;
+                    cacheClear(); // hits of previous generation
+                }
+                if (previous != NULL) release(previous);
+            }
+            catch (CLuceneError& e)
+            {
+                if (initial) throw TextException(e.what());
+                Log::info4("index searcher not reopened: what=[%s]", e.what());
+            }
+        }
+
+        // cacheAcquire: reference query hits for key of snapshot generation (NULL if not cached)
+        QueryHits* cacheAcquire(const String& key, int64_t generation)
+        {
+            Mutex::Lock lock(m_sentinel);
+            QueryHitsCache::iterator i = m_cache.find(key);
+            if (i == m_cache.end() || (*i->second)->m_generation != generation)
+            {
+                m_misses++;
+                return NULL;
+            }
+            m_hits++;
+            m_lru.splice(m_lru.begin(), m_lru, i->second);
+            QueryHits* h = *i->second;
+            h->m_refs++;
+            return h;
+        }
+        
+        // cacheInsert: cache query hits if of current generation, evicting least recently used
+        void cacheInsert(QueryHits* h)
+        {
+            Mutex::Lock lock(m_sentinel);
+            if (m_cacheMax <= 0L || m_current == NULL || m_current->m_version != h->m_generation) return;
+            QueryHitsCache::iterator i = m_cache.find(h->m_key);
+            if (i != m_cache.end())
+            {
+                // cached by a concurrent query
+                cacheRelease(*i->second);
+                m_lru.erase(i->second);
+                m_cache.erase(i);
+            }
+            while ((long)m_cache.size() >= m_cacheMax)
+            {
+                QueryHits* evict = m_lru.back();
+                m_cache.erase(evict->m_key);
+                m_lru.pop_back();
+                cacheRelease(evict);
+                m_evictions++;
+            }
+            h->m_refs++;
+            m_lru.push_front(h);
+            m_cache[h->m_key] = m_lru.begin();
+        }
+
+        // cacheRelease: dereference query hits, deleting when no longer referenced
+        void cacheRelease(QueryHits* h)
+        {
+            Mutex::Lock lock(m_sentinel);
+            if (--h->m_refs == 0L) delete h;
+        }
+        
+        // cacheClear: release all cached query hits
+        void cacheClear()
+        {
+            Mutex::Lock lock(m_sentinel);
+            for (QueryHitsLRU::iterator i = m_lru.begin(); i != m_lru.end(); i++) cacheRelease(*i);
+            m_lru.clear();
+            m_cache.clear();
+        }
+        
+        // cacheStatistics: query cache counters
+        void cacheStatistics(TextCacheStatistics& stats)
+        {
+            Mutex::Lock lock(m_sentinel);
+            stats.entries       = (long)m_cache.size();
+            stats.max           = m_cacheMax;
+            stats.hits          = m_hits;
+            stats.misses        = m_misses;
+            stats.evictions     = m_evictions;
+            stats.invalidations = m_invalidations;
+            stats.generation    = m_current == NULL ? 0LL : (long long)m_current->m_version;
+        }
+        
+        // cacheHits: top documents held per cached query
+        inline long cacheHits() const { return m_cacheHits; }
+
+        // start/stop: manage reopen thread
+        void start() 
+        { 
+            m_running.init(); 
+            m_stopping.init();
+            (new Thread(this, "TextStoreReopen"))->go(); 
+        }
+        void stop() 
+        { 
+            m_stopping.notify();
+            m_running.wait(); 
+        }
+
+        // invoke: check for index changes each interval (completed early by stop())
+        void invoke()
+        {
+            Log::Scope scope(KCC_FILE, "QuerySharedState::invoke");
+            while (!m_stopping.wait(m_interval))
             {
-				Log::info3(
-					"index searcher created: initial=[%d] modified=[%d] locked=[%d]",
-					initial, modified, locked);
-                m_searcher.reset(new lucene::search::IndexSearcher(m_path.c_str()));
-                r = m_searcher->getReader();
-                m_lastModified = (long)r->lastModified(r->getDirectory());
+                try
+                {
+                    reopen();
+                }
+                catch (std::exception& e)
+                {
+                    Log::exception(e);
+                }
             }
-		}
+            m_running.notify();
+        }
         
     private:
+        QuerySharedState(const QuerySharedState&);
         QuerySharedState& operator = (const QuerySharedState&);
     
         // Attributes
-        long                                          m_lastModified;
-        StringRC                                      m_path;
-        kcc::SharedPtr<Mutex>                         m_sentinel;
-        kcc::SharedPtr<lucene::search::IndexSearcher> m_searcher;
+        String                                        m_path;
+        Mutex                                         m_sentinel;
+        Mutex                                         m_opening;
+        Monitor                                       m_running;
+        Monitor                                       m_stopping; // begun by start(), ended by stop()
+        IndexSnapshot*                                m_current;
         lucene::analysis::standard::StandardAnalyzer* m_analyzer;
+        long                                          m_interval;
+        QueryHitsCache                                m_cache;
+        QueryHitsLRU                                  m_lru;
+        long                                          m_cacheMax;
+        long                                          m_cacheHits;
+        long                                          m_hits;
+        long                                          m_misses;
+        long                                          m_evictions;
+        long                                          m_invalidations;
     };
     
     // Utility class to manage query matches
@@ -156,28 +387,82 @@ namespace kcc
     };
     typedef std::list<TextToken> TextTokens;
 
+    // k_textOffsets: encode analyzed token positions & offsets of text by term (C_TERM_OFFSETS); stored
+    // with the document so query matches are selected by looking up the query terms instead of re-tokenizing
+    //   encoding: "{tokens}\n" followed by "{term} {position}:{start}:{length}...\n" per term in term order,
+    //             position and start relative to the previous occurrence of the term
+    static void k_textOffsets(lucene::analysis::Analyzer* analyzer, const String& text, String& encoded)
+    {
+        typedef std::map<String, std::vector<long> > Occurrences; // position, start, length triples
+        Occurrences occurrences;
+        long position = 0L;
+        lucene::util::Reader*          reader = _CLNEW lucene::util::StringReader(text.c_str());
+        lucene::analysis::TokenStream* source = analyzer->tokenStream(k_text.c_str(), reader);
+        lucene::analysis::Token        token;
+        try
+        {
+            while (source->next(&token))
+            {
+                std::vector<long>& o = occurrences[token.termText()];
+                o.push_back(position++);
+                o.push_back(token.startOffset());
+                o.push_back(token.endOffset() - token.startOffset());
+            }
+        }
+        catch (CLuceneError&)
+        {
+            _CLDELETE(source);
+            _CLDELETE(reader);
+            throw;
+        }
+        _CLDELETE(source);
+        _CLDELETE(reader);
+
+        Char num[64];
+        std::sprintf(num, "%ld\n", position);
+        encoded = num;
+        for (Occurrences::iterator i = occurrences.begin(); i != occurrences.end(); i++)
+        {
+            encoded += i->first;
+            const std::vector<long>& o = i->second;
+            long prevPosition = 0L, prevStart = 0L;
+            for (std::vector<long>::size_type j = 0; j < o.size(); j += 3)
+            {
+                std::sprintf(num, " %ld:%ld:%ld", o[j] - prevPosition, o[j+1] - prevStart, o[j+2]);
+                encoded += num;
+                prevPosition = o[j];
+                prevStart    = o[j+1];
+            }
+            encoded += '\n';
+        }
+    }
+
     // Results of text query
     struct TextResults : ITextResults
     {
-        // Attributes
-        QuerySharedState       m_queryState;
-        Mutex                  m_sentinel;
-        TextDocument::Contents m_contents;
-        long                   m_row;
-        lucene::search::Query* m_query;
-        lucene::search::Hits*  m_hits;
-        QueryMatches           m_matches;
-        TextResults(QuerySharedState state, TextDocument::Contents contents) 
+        // Attributes (results keep their snapshot of the index for their lifetime)
+        QuerySharedState::Snapshot m_snapshot;
+        Mutex                      m_sentinel;
+        TextDocument::Contents     m_contents;
+        long                       m_row;
+        lucene::search::Query*     m_query;
+        lucene::search::Hits*      m_hits;   // rows beyond cached top documents
+        QueryHits*                 m_cached; // top documents
+        QueryMatches               m_matches;
+        StringSet                  m_matchTerms;
+        TextResults(QuerySharedState& state, TextDocument::Contents contents) 
             : 
-            m_queryState(state),
+            m_snapshot(state),
             m_contents(contents), 
             m_row(-1L), 
             m_query(NULL), 
-            m_hits(NULL)
+            m_hits(NULL),
+            m_cached(NULL)
         {}
         ~TextResults() 
         {
             Mutex::Lock lock(m_sentinel);
+            if (m_cached != NULL) m_snapshot.state().cacheRelease(m_cached);
             _CLDELETE(m_hits);
             _CLDELETE(m_query);
         }
@@ -187,13 +472,25 @@ namespace kcc
         {
             Mutex::Lock lock(m_sentinel);
             Log::Scope scope(KCC_FILE, "TextResults::begin");
-            if (m_hits != NULL) throw TextException("attempt to begin() again. only once allowed");
+            if (m_cached != NULL) throw TextException("attempt to begin() again. only once allowed");
             try
             {
-                QuerySharedState::Finder finder(m_queryState);
+                QuerySharedState::Snapshot& finder = m_snapshot;
                 m_query = lucene::queryParser::QueryParser::parse(expr.c_str(), k_text.c_str(), finder.analyzer());
-		        m_hits  = finder.searcher()->search(m_query);
                 m_row   = -1L;
+
+                // top documents: cached by normalized (parsed) expression for the snapshot generation
+                TCHAR* key = m_query->toString();
+                String normalized(key);
+                _CLDELETE_ARRAY(key);
+                QuerySharedState& state = finder.state();
+                m_cached = state.cacheAcquire(normalized, finder.generation());
+                if (m_cached == NULL)
+                {
+                    m_cached = new QueryHits(normalized, finder.generation());
+                    m_cached->search(finder.searcher(), m_query, state.cacheHits());
+                    state.cacheInsert(m_cached);
+                }
                 queryMatchBuild(finder);
                 
                 // log expressions
@@ -225,7 +522,7 @@ namespace kcc
         long total()
         {
             Mutex::Lock lock(m_sentinel);
-            long t = m_hits->length();
+            long t = m_cached->m_total;
             return t; 
         }
 
@@ -237,12 +534,20 @@ namespace kcc
             return r; 
         }
 
+        // scale: score scale (top raw score as normalized by hits beyond cached top documents too)
+        double scale()
+        {
+            Mutex::Lock lock(m_sentinel);
+            double s = m_cached->m_scale;
+            return s;
+        }
+
         // next: check for next row
         bool next() throw (TextException)
         {
             Mutex::Lock lock(m_sentinel);
             m_row++;
-            bool n = m_row < m_hits->length();
+            bool n = m_row < m_cached->m_total;
             return n;
         }
         
@@ -250,7 +555,7 @@ namespace kcc
         void seek(long row) throw (TextException)
         {
             Mutex::Lock lock(m_sentinel);
-            if (row < 0L || row >= m_hits->length()) throw TextException("invalid seek position");
+            if (row < 0L || row >= m_cached->m_total) throw TextException("invalid seek position");
             m_row = row;
         }
 
@@ -259,13 +564,28 @@ namespace kcc
         {
             Mutex::Lock lock(m_sentinel);
             Log::Scope scope(KCC_FILE, "TextResults::results");
-            if (m_row < 0L || m_row >= m_hits->length()) throw TextException("invalid cursor position");
+            if (m_row < 0L || m_row >= m_cached->m_total) throw TextException("invalid cursor position");
+            lucene::document::Document* stored = NULL;
             try
             {
-                QuerySharedState::Finder finder(m_queryState);
+                QuerySharedState::Snapshot& finder = m_snapshot;
                 
+                // document: from cached top documents, or searched hits beyond them
                 txtdoc.clear();
-			    lucene::document::Document& doc = m_hits->doc(m_row);
+                long id = -1L;
+                if (m_row < (long)m_cached->m_ids.size())
+                {
+                    id           = m_cached->m_ids[m_row];
+                    txtdoc.score = m_cached->m_scores[m_row];
+                    stored       = finder.searcher()->doc((int32_t)id);
+                }
+                else
+                {
+                    if (m_hits == NULL) m_hits = finder.searcher()->search(m_query);
+                    id           = m_hits->id(m_row);
+                    txtdoc.score = m_hits->score(m_row);
+                }
+                lucene::document::Document& doc = stored != NULL ? *stored : m_hits->doc(m_row);
 
                 // metadata
                 if ((m_contents & TextDocument::C_METADATA) != 0)
@@ -274,7 +594,7 @@ namespace kcc
                     while (fields->hasMoreElements())
                     {
                         lucene::document::Field* f = fields->nextElement();
-                        if (f->name() != k_text) txtdoc.metadata[f->name()] = f->stringValue();
+                        if (f->name() != k_text && f->name() != k_offsets) txtdoc.metadata[f->name()] = f->stringValue();
                     }
                     _CLDELETE(fields);
                 }
@@ -282,7 +602,6 @@ namespace kcc
                 // terms
                 if ((m_contents & TextDocument::C_TERMS) != 0)
                 {
-                    long id = m_hits->id(m_row);
                     lucene::index::TermFreqVector* tfv = finder.searcher()->getReader()->getTermFreqVector(id, k_text.c_str());
                     if (tfv != NULL)
                     {
@@ -305,22 +624,113 @@ namespace kcc
                 if ((m_contents & TextDocument::C_QUERY_MATCHES) != 0) 
                 {
                     TextDocument::Matches matches;
-                    selectMatches(finder, txtdoc.text, matches);
+                    const Char* offsets = doc.get(k_offsets.c_str());
+                    if (offsets != NULL) offsetMatches(offsets, matches);
+                    else                 selectMatches(finder, txtdoc.text, matches); // index without term offsets
                     mergeMatches(matches, txtdoc.matches);
                 }
+                _CLDELETE(stored);
             }
             catch (CLuceneError& e)
             {
+                _CLDELETE(stored);
                 throw TextException(e.what());
             }
             catch (Exception& e)
             {
+                _CLDELETE(stored);
                 throw TextException(e.what());
             }
         }
         
+        // offsetMatches: select offsets where query expression matches stored term offsets (see selectMatches)
+        void offsetMatches(const Char* encoded, TextDocument::Matches& matches)
+        {
+            // no-lock: called by synch'd method
+
+            // decode occurrences of query terms only (indexed by token position)
+            typedef std::map<long, TextToken> Positions;
+            Positions positions;
+            Char* p = NULL;
+            long tokens = std::strtol(encoded, &p, 10);
+            while (*p == '\n')
+            {
+                const Char* term = ++p;
+                while (*p != ' ' && *p != '\n' && *p != 0) p++;
+                StringSet::iterator t = m_matchTerms.find(String(term, p - term));
+                if (t == m_matchTerms.end())
+                {
+                    while (*p != '\n' && *p != 0) p++;
+                    continue;
+                }
+                long position = 0L, start = 0L;
+                while (*p == ' ')
+                {
+                    position += std::strtol(p + 1, &p, 10);
+                    start    += std::strtol(p + 1, &p, 10);
+                    long len  = std::strtol(p + 1, &p, 10);
+                    positions.insert(Positions::value_type(position, TextToken(*t, start, start + len)));
+                }
+            }
+
+            // select matches in token order as selectMatches does; tokens between positions are non-matching
+            for (Positions::iterator tti = positions.begin(); tti != positions.end(); tti++)
+            {
+                long       pos = tti->first;
+                TextToken& tt  = tti->second;
+                for (QueryMatches::iterator mi = m_matches.begin(); mi != m_matches.end(); mi++)
+                {
+                    QueryMatch& m = *mi;
+                    bool matched = std::find(m.terms.begin(), m.terms.end(), tt.token) != m.terms.end();
+                    if (!matched) continue;
+
+                    // match selections
+                    if (m.terms.size() == 1)
+                    {
+                        // phrase: single term
+                        matches.push_back(TextDocument::Match(tt.start, tt.end));
+                    }
+                    else if (m.dist == 0)
+                    {
+                        // phrase: exact; phrase terms at consecutive positions
+                        long start = tt.start;
+                        long end   = tt.start;
+                        long curr  = pos;
+                        for (
+                            StringVector::iterator itExpr = m.terms.begin();
+                            curr < tokens && itExpr != m.terms.end() && matched;
+                            curr++, itExpr++)
+                        {
+                            Positions::iterator itTok = curr == pos ? tti : positions.find(curr);
+                            if (itTok == positions.end() || itTok->second.token != *itExpr) matched = false;
+                            else                                                           end     = itTok->second.end;
+                        }
+                        if (matched) matches.push_back(TextDocument::Match(start, end));
+                    }
+                    else
+                    {
+                        // phrase: approximate; select terms in any order no further than dist tokens apart
+                        StringSet             exprMatches;
+                        TextDocument::Matches potentialMatches;
+                        long                  prev = pos;
+                        for (Positions::iterator itTok = tti; itTok != positions.end(); itTok++)
+                        {
+                            TextToken& curr = itTok->second;
+                            if (std::find(m.terms.begin(), m.terms.end(), curr.token) == m.terms.end()) continue;
+                            if (itTok->first - prev - 1L > m.dist) break;
+                            exprMatches.insert(curr.token);
+                            potentialMatches.push_back(TextDocument::Match(curr.start, curr.end));
+                            prev = itTok->first;
+                        }
+                        matched = exprMatches.size() == m.terms.size(); // must match all expr tokens
+                        if (matched) matches.insert(matches.end(), potentialMatches.begin(), potentialMatches.end());
+                    }
+                }
+            }
+        }
+
         // selectMatches: select offsets where query expression matches document text
-        void selectMatches(QuerySharedState::Finder& finder, const kcc::String& text, TextDocument::Matches& matches)
+        void selectMatches(QuerySharedState::Snapshot& finder, const kcc::String& text, TextDocument::Matches& matches)
         {
             TextTokens tokens;
             textTokenize(finder, tokens, text);
@@ -420,7 +830,7 @@ namespace kcc
         }
         
         // textTokenize: tokenize text
-        void textTokenize(QuerySharedState::Finder& finder, TextTokens& tokens, const String& text)
+        void textTokenize(QuerySharedState::Snapshot& finder, TextTokens& tokens, const String& text)
         {
             // no-lock: called by synch'd method
             lucene::util::Reader*          reader = _CLNEW lucene::util::StringReader(text.c_str());
@@ -433,15 +843,18 @@ namespace kcc
         }
 
         // queryMatchBuild: build query match
-        void queryMatchBuild(QuerySharedState::Finder& finder)
+        void queryMatchBuild(QuerySharedState::Snapshot& finder)
         {
             // no-lock: called by synch'd method
             m_matches.clear();
+            m_matchTerms.clear();
             if ((m_contents & TextDocument::C_QUERY_MATCHES) != 0) 
             {
                 lucene::search::Query* q = m_query->rewrite(finder.searcher()->getReader());
                 queryMatchBuild(m_matches, q);
                 if (q != m_query) _CLDELETE(q);
+                for (QueryMatches::iterator i = m_matches.begin(); i != m_matches.end(); i++) 
+                    m_matchTerms.insert(i->terms.begin(), i->terms.end());
             }
         }
         
@@ -513,6 +926,174 @@ namespace kcc
         }
     };
 
+    // k_textDocument: build index document from text document (ownership consumed)
+    static lucene::document::Document* k_textDocument(
+        lucene::analysis::Analyzer*         analyzer,
+        const TextDocument&                 txtdoc, 
+        const TextDocument::MetadataFields& fields, 
+        TextDocument::Contents              contents)
+    {
+        lucene::document::Document* doc = _CLNEW lucene::document::Document();
+        try
+        {
+            // metadata: always stored & indexed; no term counts; tokenized if not an enumeration
+            if ((contents & TextDocument::C_METADATA) != 0)
+            {
+                if (fields.empty())
+                {
+                    // all fields tokenized
+                    for (StringMap::const_iterator i = txtdoc.metadata.begin(); i != txtdoc.metadata.end(); i++)
+                    {
+                        doc->add(
+                            *new lucene::document::Field(
+                                i->first.c_str(), 
+                                i->second.c_str(), 
+                                true, true, true, false));
+                    }
+                }
+                else
+                {
+                    // per field tokenization
+                    TextDocument::MetadataFields::const_iterator notFound = fields.end();
+                    for (StringMap::const_iterator i = txtdoc.metadata.begin(); i != txtdoc.metadata.end(); i++)
+                    {
+                        const String& key = i->first;
+                        bool tokenize = true;
+                        TextDocument::MetadataFields::const_iterator md = fields.find(key);
+                        if (md != notFound && md->second == TextDocument::MD_ENUM) tokenize = false;
+                        doc->add(
+                            *new lucene::document::Field(
+                                key.c_str(), 
+                                i->second.c_str(), 
+                                true, true, tokenize, false));
+                    }
+                }
+            }
+
+            // text: always tokenized & indexed; text stored if specified, terms counts stored if specified
+            bool text = (contents & TextDocument::C_TEXT)  != 0;
+            bool tfv  = (contents & TextDocument::C_TERMS) != 0;
+            doc->add(*new lucene::document::Field(k_text.c_str(), txtdoc.text.c_str(), text, true, true, tfv));
+
+            // term offsets: stored only, for query match selection
+            if ((contents & TextDocument::C_TERM_OFFSETS) != 0)
+            {
+                String offsets;
+                k_textOffsets(analyzer, txtdoc.text, offsets);
+                doc->add(*new lucene::document::Field(k_offsets.c_str(), offsets.c_str(), true, false, false, false));
+            }
+        }
+        catch (CLuceneError&)
+        {
+            _CLDELETE(doc);
+            throw;
+        }
+        return doc;
+    }
+
+    // Bulk indexing worker: analyzes one slice of a batch into a private RAM directory (merged in batch & slice order)
+    struct BulkIndexer : IThread
+    {
+        // Attributes
+        lucene::store::RAMDirectory*                  m_dir;
+        lucene::analysis::standard::StandardAnalyzer* m_analyzer;
+        lucene::index::IndexWriter*                   m_writer;
+        Monitor                                       m_done;
+        const TextDocuments*                          m_docs;
+        const TextDocument::MetadataFields*           m_fields;
+        TextDocument::Contents                        m_contents;
+        TextDocuments::size_type                      m_begin;
+        TextDocuments::size_type                      m_end;
+        String                                        m_error;
+        BulkIndexer(Char** stopWords, long maxFieldLength, long minMergeDocs) :
+            m_dir(_CLNEW lucene::store::RAMDirectory()),
+            m_analyzer(_CLNEW lucene::analysis::standard::StandardAnalyzer(stopWords)),
+            m_writer(NULL),
+            m_docs(NULL),
+            m_fields(NULL),
+            m_contents(0),
+            m_begin(0),
+            m_end(0)
+        {
+            m_writer = _CLNEW lucene::index::IndexWriter(m_dir, m_analyzer, true);
+            if (maxFieldLength > 0L) m_writer->setMaxFieldLength(maxFieldLength);
+            if (minMergeDocs > 0L)   m_writer->setMinMergeDocs(minMergeDocs);
+        }
+        ~BulkIndexer()
+        {
+            if (m_writer != NULL) _CLDELETE(m_writer);
+            _CLDELETE(m_analyzer);
+            m_dir->close();
+            _CLDECDELETE(m_dir);
+        }
+
+        // start: analyze documents [begin,end) in a worker thread
+        void start(
+            const TextDocuments&                docs,
+            TextDocuments::size_type            begin,
+            TextDocuments::size_type            end,
+            const TextDocument::MetadataFields& fields,
+            TextDocument::Contents              contents)
+        {
+            m_docs     = &docs;
+            m_fields   = &fields;
+            m_contents = contents;
+            m_begin    = begin;
+            m_end      = end;
+            m_error.clear();
+            m_done.init();
+            (new Thread(this, "TextStoreBulk"))->go();
+        }
+
+        // wait: wait for worker to complete
+        void wait() throw (TextException)
+        {
+            m_done.wait();
+            if (!m_error.empty()) throw TextException(m_error);
+        }
+
+        // directory: directory for merge (writer closed by the worker)
+        lucene::store::Directory* directory()
+        {
+            return m_dir;
+        }
+
+        // invoke: add slice of documents to private writer, closing it (flushing buffered documents)
+        void invoke()
+        {
+            lucene::document::Document* doc = NULL;
+            try
+            {
+                for (TextDocuments::size_type i = m_begin; i < m_end; i++)
+                {
+                    doc = k_textDocument(m_analyzer, (*m_docs)[i], *m_fields, m_contents);
+                    m_writer->addDocument(doc);
+                    _CLDELETE(doc);
+                    doc = NULL;
+                }
+                m_writer->close();
+                _CLDELETE(m_writer);
+                m_writer = NULL;
+            }
+            catch (CLuceneError& e)
+            {
+                if (doc != NULL) _CLDELETE(doc);
+                m_error = e.what();
+            }
+            catch (std::exception& e)
+            {
+                if (doc != NULL) _CLDELETE(doc);
+                m_error = e.what();
+            }
+            m_done.notify();
+        }
+
+    private:
+        BulkIndexer(const BulkIndexer&);
+        BulkIndexer& operator = (const BulkIndexer&);
+    };
+    typedef std::vector<BulkIndexer*> BulkIndexers;
+
     // Text store indexing & query
     struct TextStore : ITextStore
     {
@@ -528,6 +1109,10 @@ namespace kcc
         long             m_mergeFactor;
         Char**           m_stopWordsArray;
         StringVector     m_stopWords;
+        long             m_bulkThreads;
+        long             m_bulkMerge;
+        long             m_bulkDocs;
+        BulkIndexers     m_bulk;
         lucene::index::IndexWriter*                   m_writer;
         lucene::analysis::standard::StandardAnalyzer* m_analyzer;
         TextStore() : 
@@ -538,12 +1123,17 @@ namespace kcc
             m_maxMergeDocs(-1L), 
             m_mergeFactor(-1L),
             m_stopWordsArray(NULL),
+            m_bulkThreads(1L),
+            m_bulkMerge(-1L),
+            m_bulkDocs(0L),
             m_writer(NULL),
             m_analyzer(NULL)
         {}
         ~TextStore() 
         { 
+            if (!m_path.empty()) m_queryState.stop();
             Mutex::Lock lock(m_sentinel);
+            bulkDiscard();
             if (m_writer != NULL)         _CLDELETE(m_writer);
             if (m_analyzer != NULL)       _CLDELETE(m_analyzer);
             if (m_stopWordsArray != NULL) delete [] m_stopWordsArray;
@@ -569,15 +1159,30 @@ namespace kcc
                 Log::error("index repository path not found: path=[%s]", path.c_str());
                 return false;
             }
+            long reopen = config.get(k_keyReopen, k_defReopen);
+            if (reopen <= 0L)
+            {
+                Log::error("index reopen interval invalid: interval=[%d]", reopen);
+                return false;
+            }
+            long cacheMax  = config.get(k_keyCacheMax,  k_defCacheMax);
+            long cacheHits = config.get(k_keyCacheHits, k_defCacheHits);
+            if (cacheHits <= 0L)
+            {
+                Log::error("query cache hits invalid: hits=[%d]", cacheHits);
+                return false;
+            }
             m_path           = path;
             m_create         = config.get(k_keyCreate,         k_defCreate) == KCC_PROPERTY_TRUE;
             m_docsPerOpt     = config.get(k_keyDocsPerOpt,     k_defDocsPerOpt);
             m_maxFieldLength = config.get(k_keyMaxFieldLength, k_defMaxFieldLength);
             m_maxMergeDocs   = config.get(k_keyMaxMergeDocs,   k_defMaxMergeDocs);
             m_mergeFactor    = config.get(k_keyMergeFactor,    k_defMergeFactor);
+            m_bulkThreads    = std::max(config.get(k_keyBulkThreads, k_defBulkThreads), 1L);
+            m_bulkMerge      = config.get(k_keyBulkMerge,      k_defBulkMerge);
             Log::info2(
-                "TextStore initialized: clucene=[%s] path=[%s] create=[%d] docs/optimize=[%d] maxFieldLength=[%d] maxMergeDocs=[%d] mergeFactor=[%d]", 
-                KCC_CLUCENE_VERSION, m_path.c_str(), m_create, m_docsPerOpt, m_maxFieldLength, m_maxMergeDocs, m_mergeFactor);
+                "TextStore initialized: clucene=[%s] path=[%s] create=[%d] docs/optimize=[%d] maxFieldLength=[%d] maxMergeDocs=[%d] mergeFactor=[%d] reopen=[%d] bulkThreads=[%d] bulkDocs/merge=[%d]", 
+                KCC_CLUCENE_VERSION, m_path.c_str(), m_create, m_docsPerOpt, m_maxFieldLength, m_maxMergeDocs, m_mergeFactor, reopen, m_bulkThreads, m_bulkMerge);
             
             // analyzer
             String stopWords(config.get(k_keyStopWords, k_defStopWords));
@@ -588,8 +1193,10 @@ namespace kcc
             Log::info3("stop words=[%d:%s]", m_stopWords.size(), stopWords.c_str());
             m_analyzer = _CLNEW lucene::analysis::standard::StandardAnalyzer(m_stopWordsArray);
             
-            // shared query state
-            m_queryState.init(path, m_analyzer);
+            // shared query state (searcher snapshots reopened in background)
+            m_queryState.init(path, m_analyzer, reopen, cacheMax, cacheHits);
+            Log::info3("query cache: max=[%d] hits=[%d]", cacheMax, cacheHits);
+            m_queryState.start();
 
             return true;
         }
@@ -629,12 +1236,12 @@ namespace kcc
             {
                 if (m_writer != NULL)
                 {
-                    count = m_writer->docCount();
+                    count = m_writer->docCount() + m_bulkDocs;
                 }
                 else
                 {
-                    QuerySharedState::Finder finder(m_queryState);
-                    count = finder.searcher()->getReader()->numDocs();
+                    QuerySharedState::Snapshot snapshot(m_queryState);
+                    count = snapshot.searcher()->getReader()->numDocs();
                 }
             }
             catch (CLuceneError& e)
@@ -660,46 +1267,7 @@ namespace kcc
             lucene::document::Document* doc = NULL;
             try
             {
-                doc = _CLNEW lucene::document::Document();
-
-                // metadata: always stored & indexed; no term counts; tokenized if not an enumeration
-                if ((contents & TextDocument::C_METADATA) != 0)
-                {
-                    if (fields.empty())
-                    {
-                        // all fields tokenized
-                        for (StringMap::const_iterator i = txtdoc.metadata.begin(); i != txtdoc.metadata.end(); i++)
-                        {
-                            doc->add(
-                                *new lucene::document::Field(
-                                    i->first.c_str(), 
-                                    i->second.c_str(), 
-                                    true, true, true, false));
-                        }
-                    }
-                    else
-                    {
-                        // per field tokenization
-                        TextDocument::MetadataFields::const_iterator notFound = fields.end();
-                        for (StringMap::const_iterator i = txtdoc.metadata.begin(); i != txtdoc.metadata.end(); i++)
-                        {
-                            const String& key = i->first;
-                            bool tokenize = true;
-                            TextDocument::MetadataFields::const_iterator md = fields.find(key);
-                            if (md != notFound && md->second == TextDocument::MD_ENUM) tokenize = false;
-                            doc->add(
-                                *new lucene::document::Field(
-                                    key.c_str(), 
-                                    i->second.c_str(), 
-                                    true, true, tokenize, false));
-                        }
-                    }
-                }
-
-                // text: always tokenized & indexed; text stored if specified, terms counts stored if specified
-                bool text = (contents & TextDocument::C_TEXT)  != 0;
-                bool tfv  = (contents & TextDocument::C_TERMS) != 0;
-                doc->add(*new lucene::document::Field(k_text.c_str(), txtdoc.text.c_str(), text, true, true, tfv));
+                doc = k_textDocument(m_analyzer, txtdoc, fields, contents);
 
                 // index document
                 m_writer->addDocument(doc);
@@ -717,6 +1285,97 @@ namespace kcc
             }
         }
         
+        // indexBulk: analyze batch of documents in worker threads; merged into index every bulkDocsPerMerge and on optimize/close
+        void indexBulk(const TextDocuments& txtdocs, const TextDocument::MetadataFields& fields, TextDocument::Contents contents) throw (TextException)
+        {
+            Mutex::Lock lock(m_sentinel);
+            Log::Scope scope(KCC_FILE, "indexBulk");
+            if (m_writer == NULL) throw TextException("index not open");
+            if (txtdocs.empty()) return;
+            BulkIndexers batch;
+            try
+            {
+                // workers: one per slice of at least k_bulkMinSlice documents, each into its own directory
+                long size    = (long)txtdocs.size();
+                long workers = std::min(m_bulkThreads, std::max(size / k_bulkMinSlice, 1L));
+                for (long w = 0L; w < workers; w++) 
+                    batch.push_back(new BulkIndexer(m_stopWordsArray, m_maxFieldLength, k_bulkMinMergeDocs));
+
+                // analyze slices concurrently then wait for all workers (first error reported)
+                long slice = (size + workers - 1L) / workers;
+                for (long w = 0L; w < workers; w++)
+                {
+                    long begin = w * slice, end = std::min(begin + slice, size);
+                    batch[w]->start(txtdocs, begin, end, fields, contents);
+                }
+                String error;
+                for (long w = 0L; w < workers; w++)
+                {
+                    try
+                    {
+                        batch[w]->wait();
+                    }
+                    catch (TextException& e)
+                    {
+                        if (error.empty()) error = e.what();
+                    }
+                }
+
+                if (!error.empty())
+                {
+                    // failed batch is discarded whole (batches already pending are unaffected)
+                    for (BulkIndexers::iterator i = batch.begin(); i != batch.end(); i++) delete *i;
+                    throw TextException(error);
+                }
+                m_bulk.insert(m_bulk.end(), batch.begin(), batch.end());
+                batch.clear();
+                m_bulkDocs += size;
+                Log::info4("bulk documents analyzed: documents=[%d] workers=[%d] pending=[%d]", size, workers, m_bulkDocs);
+
+                // merge when pending segments reach limit
+                if (m_bulkMerge > 0L && m_bulkDocs >= m_bulkMerge) bulkMerge();
+            }
+            catch (CLuceneError& e)
+            {
+                for (BulkIndexers::iterator i = batch.begin(); i != batch.end(); i++) delete *i;
+                throw TextException(e.what());
+            }
+        }
+
+        // bulkMerge: merge worker RAM directories into index in batch & slice order (index optimized by merge)
+        void bulkMerge()
+        {
+            // no-lock: called by synch'd method
+            if (m_bulk.empty()) return;
+            Timer t;
+            t.start();
+            std::vector<lucene::store::Directory*> dirs;
+            for (BulkIndexers::iterator i = m_bulk.begin(); i != m_bulk.end(); i++) dirs.push_back((*i)->directory());
+            dirs.push_back(NULL); // EOF
+            long pending = m_bulkDocs;
+            try
+            {
+                m_writer->addIndexes(&dirs[0]);
+            }
+            catch (CLuceneError&)
+            {
+                bulkDiscard();
+                throw;
+            }
+            bulkDiscard();
+            t.stop();
+            Log::info3("bulk documents merged: documents=[%d] index=[%d] secs=[%f]", pending, m_writer->docCount(), t.secs());
+        }
+
+        // bulkDiscard: release worker RAM directories
+        void bulkDiscard()
+        {
+            // no-lock: called by synch'd method
+            for (BulkIndexers::iterator i = m_bulk.begin(); i != m_bulk.end(); i++) delete *i;
+            m_bulk.clear();
+            m_bulkDocs = 0L;
+        }
+
         // indexIsOpen: is index open
         bool indexIsOpen() throw (TextException) 
         { 
@@ -733,6 +1392,7 @@ namespace kcc
             if (m_writer == NULL) throw TextException("index not open");
             try
             {
+                bulkMerge();
                 m_writer->optimize();
                 Log::info3("index optimized: documents=[%d]", m_writer->docCount());
             }
@@ -750,6 +1410,7 @@ namespace kcc
             if (m_writer == NULL) throw TextException("index not open");
             try
             {
+                bulkMerge();
                 m_writer->close();
                 _CLDELETE(m_writer);
                 m_writer = NULL;
@@ -757,17 +1418,23 @@ namespace kcc
             }
             catch (CLuceneError& e)
             {
+                bulkDiscard();
                 _CLDELETE(m_writer);
                 m_writer = NULL;
                 throw TextException(e.what());
             }
         }
 
+        // queryCacheStatistics: query result cache counters
+        void queryCacheStatistics(TextCacheStatistics& stats)
+        {
+            m_queryState.cacheStatistics(stats);
+        }
+
         // query: execute text query
         ITextResults* query(const String& expression, TextDocument::Contents contents) throw (TextException) 
         {
             Log::Scope scope(KCC_FILE, "query");
-            m_queryState.prepare();
             AutoPtr<TextResults> tr(new TextResults(m_queryState, contents)); 
             tr->begin(expression);
             return tr.release();
@@ -113,7 +113,7 @@ CL_NS_DEF(index)
 	   CND_PRECONDITION(directory != NULL, "directory is NULL");
 
 	   //Instantiate SegmentInfos
-       SegmentInfos* infos = _CLNEW SegmentInfos;
+       SegmentInfos* infos = _CLNEW SegmentInfos(true);
 	   try{
 			//Have SegmentInfos read the segments file in directory
 			infos->read(directory);
@@ -24,7 +24,7 @@ CL_NS_DEF(index)
   IndexWriter::IndexWriter(const char* path, Analyzer* a, const bool create, const bool _closeDir):
 		directory( FSDirectory::getDirectory(path, create) ),
 		analyzer(a),
-		segmentInfos (_CLNEW SegmentInfos),
+		segmentInfos (_CLNEW SegmentInfos(true)),
     closeDir(_closeDir){
   //Func - Constructor
   //       Constructs an IndexWriter for the index in path.
@@ -43,7 +43,7 @@ CL_NS_DEF(index)
   IndexWriter::IndexWriter(Directory* d, Analyzer* a, const bool create, const bool _closeDir):
 	  directory(_CL_POINTER(d)),
 	  analyzer(a),
-	  segmentInfos (_CLNEW SegmentInfos),
+	  segmentInfos (_CLNEW SegmentInfos(true)),
       closeDir(_closeDir)
   {
   //Func - Constructor
@@ -46,8 +46,9 @@ CL_NS_DEF(index)
   //Post - The instance has been destroyed. Depending on the constructor used
   //       the SegmentInfo instances that this instance managed have been deleted or not.
 
-	  //Clear the list of SegmentInfo instances - make sure everything is deleted
-	  infos.setDoDelete(true); //todo: should this always be set to true?
+	  //Clear the list of SegmentInfo instances - deleted only if constructed to delete
+	  //members: owning instances are SegmentInfos(true); IndexWriter::addIndexes hands
+	  //the infos of a SegmentInfos(false) to the writer (see DSR:CL_BUG in IndexWriter.cpp)
       infos.clear();
   }
   
@@ -217,7 +218,7 @@ CL_NS_DEF(index)
 
     // We cannot be sure about the format of the file.
     // Therefore we have to read the whole file and cannot simply seek to the version entry.
-    SegmentInfos* sis = _CLNEW SegmentInfos();
+    SegmentInfos* sis = _CLNEW SegmentInfos(true);
     sis->read(directory);
     version = sis->getVersion();
     _CLDELETE(sis);
@@ -6,6 +6,7 @@ CL_NS_DEF(util)
 	bool blanksinitd=false;
 	__wcsintrntype CLStringIntern::stringPool(true);
 	__strintrntype CLStringIntern::stringaPool(true);
+	DEFINE_MUTEX(CLStringIntern::THIS_LOCK);
 
     void CLStringIntern::shutdown(){
     #if _DEBUG
@@ -30,6 +31,7 @@ CL_NS_DEF(util)
     }
 
 	const TCHAR* CLStringIntern::intern(const TCHAR* str CL_FILELINEPARAM){
+		SCOPED_LOCK_MUTEX(THIS_LOCK);
 		if ( str == NULL )
 			return NULL;
 		if ( str[0] == 0 )
@@ -51,6 +53,7 @@ CL_NS_DEF(util)
 	}
 
 	bool CLStringIntern::unintern(const TCHAR* str){
+		SCOPED_LOCK_MUTEX(THIS_LOCK);
 		if ( str == NULL )
 			return false;
 		if ( str[0] == 0 )
@@ -67,6 +70,7 @@ CL_NS_DEF(util)
 	}
 	
 	const char* CLStringIntern::internA(const char* str CL_FILELINEPARAM){
+		SCOPED_LOCK_MUTEX(THIS_LOCK);
 		if ( str == NULL )
 			return NULL;
 		if ( str[0] == 0 )
@@ -83,6 +87,7 @@ CL_NS_DEF(util)
 	}
 	
 	bool CLStringIntern::uninternA(const char* str){
+		SCOPED_LOCK_MUTEX(THIS_LOCK);
 		if ( str == NULL )
 			return false;
 		if ( str[0] == 0 )
@@ -100,6 +105,7 @@ CL_NS_DEF(util)
 
 	
 	__wcsintrntype::iterator CLStringIntern::internitr(const TCHAR* str CL_FILELINEPARAM){
+		SCOPED_LOCK_MUTEX(THIS_LOCK);
 		if ( str[0] == 0 ){
 			if ( !blanksinitd ){
 				CLStringIntern::stringPool.put(LUCENE_BLANK_STRING,1);
@@ -123,6 +129,7 @@ CL_NS_DEF(util)
 		}
 	}
 	bool CLStringIntern::uninternitr(__wcsintrntype::iterator itr){
+		SCOPED_LOCK_MUTEX(THIS_LOCK);
 		if ( itr!=stringPool.end() ){
 			if ( itr==wblank )
 				return false;	
@@ -23,6 +23,8 @@ typedef CL_NS(util)::CLHashMap<const char*,int,Compare::Char,Deletor::acArray ,D
 	  static __wcsintrntype stringPool;
 	  static __strintrntype stringaPool;
 #endif
+	//pools are shared by all threads (fields and terms intern their names)
+	STATIC_DEFINE_MUTEX(THIS_LOCK);
 
 	//internalise an ucs2 string and return an iterator for fast un-iteration
 	static __wcsintrntype::iterator internitr(const TCHAR* str CL_FILELINEPARAM);
@@ -8,6 +8,8 @@
 #include <inc/store/ITextStore.h>
 #include <inc/store/TextQueryXml.h>
 #include <inc/store/TextQueryRest.h>
+#include <inc/store/TextQueryBinary.h>
+#include <inc/store/TextQueryXmlCodec.h>
 
 #define KCC_FILE    "httptextquery"
 #define KCC_VERSION "$Id: httptextquery.cpp 22776 2008-03-24 20:36:12Z tvk $"
@@ -20,9 +22,10 @@ namespace kcc
     static const long                   k_defDocsPerPage = 25L;
     static const TextDocument::Contents k_defContents    = TextDocument::C_METADATA;
     static const float                  k_reviveFactor   = 0.333F;
+    static const String::size_type      k_szBinary       = 1024*64; // binary page reserve
 
     // Query cursor
-    typedef SharedPtr<struct QueryCursorValue> QueryCursor;
+    typedef SharedPtr<struct QueryCursorValue, AtomicCount> QueryCursor; // released outside service lock
     struct QueryCursorValue
     {
         // Ctor
@@ -34,6 +37,7 @@ namespace kcc
             m_row(-1L),
             m_size(0L), 
             m_total(0L),
+            m_scale(1.0),
             m_accessed(0L),
             m_expired(false),
             m_created(false)
@@ -83,8 +87,8 @@ namespace kcc
             return a; 
         }
 
-        // results: query results
-        void results(ITextStore* store, StringStream& buf, long offset, long max) throw (TextException)
+        // results: query results (XML or binary encoded)
+        void results(ITextStore* store, StringStream& buf, long offset, long max, bool binary) throw (TextException)
         {
             Mutex::Lock lock(m_sentinel);
             Log::Scope scope(KCC_FILE, "QueryCursorValue::results");
@@ -102,6 +106,7 @@ namespace kcc
                 m_query.reset(store->query(m_expression, m_contents));
                 m_expired = false;
                 m_total   = m_query->total();
+                m_scale   = m_query->scale();
                 m_created = true;
                 
                 // reclaim text resources for empty result set
@@ -116,11 +121,22 @@ namespace kcc
             // log access
             std::time(&m_accessed);
 
-            // write documents as xml
-            DOMWriter w(buf);
-            w.start(TextQueryXml::root());
-            w.attr(TextQueryXml::rootService(), KCC_FILE);
-            w.attr(TextQueryXml::rootWhen(),    ISODate::local().isodatetime());
+            // write documents as xml or binary records
+            String                           bin;
+            AutoPtr<TextQueryBinary::Writer> b;
+            AutoPtr<DOMWriter>               w;
+            if (binary)
+            {
+                bin.reserve(k_szBinary);
+                b.reset(new TextQueryBinary::Writer(bin));
+            }
+            else
+            {
+                w.reset(new DOMWriter(buf));
+                w->start(TextQueryXml::root());
+                w->attr(TextQueryXml::rootService(), KCC_FILE);
+                w->attr(TextQueryXml::rootWhen(),    ISODate::local().isodatetime());
+            }
             
             m_size = 0L;
             if (m_total > 0L && max > 0L)
@@ -135,36 +151,8 @@ namespace kcc
                 while (cont)
                 {
                     m_query->results(txtdoc);
-                    w.start(TextQueryXml::document());
-                    w.attr(TextQueryXml::documentRow(), Strings::printf("%d", offset));
-                    if (!txtdoc.text.empty())
-                    {
-                        w.start(TextQueryXml::text());
-                        w.text(txtdoc.text);
-                        w.end(TextQueryXml::text());
-                    }
-                    for (StringMap::iterator i = txtdoc.metadata.begin(); i != txtdoc.metadata.end(); i++)
-                    {
-                        w.start(TextQueryXml::metadata());
-                        w.attr(TextQueryXml::metadataKey(),   i->first);
-                        w.attr(TextQueryXml::metadataValue(), i->second);
-                        w.end(TextQueryXml::metadata());
-                    }
-                    for (TextDocument::Terms::iterator i = txtdoc.terms.begin(); i != txtdoc.terms.end(); i++)
-                    {
-                        w.start(TextQueryXml::term());
-                        w.attr(TextQueryXml::termTerm(),      i->first);
-                        w.attr(TextQueryXml::termFrequency(), Strings::printf("%d", i->second));
-                        w.end(TextQueryXml::term());
-                    }
-                    for (TextDocument::Matches::iterator i = txtdoc.matches.begin(); i != txtdoc.matches.end(); i++)
-                    {
-                        w.start(TextQueryXml::match());
-                        w.attr(TextQueryXml::matchStartOffset(), Strings::printf("%d", i->startOffset));
-                        w.attr(TextQueryXml::matchEndOffset(),   Strings::printf("%d", i->endOffset));
-                        w.end(TextQueryXml::match());
-                    }
-                    w.end(TextQueryXml::document());
+                    if (binary) b->document(offset, txtdoc);
+                    else        TextQueryXmlCodec::document(*w, offset, txtdoc);
                     
                     offset++;
                     m_size++;
@@ -172,24 +160,41 @@ namespace kcc
                     if (cont) m_query->next();
                 }
             }
-            w.start(TextQueryXml::status());
-            w.attr(TextQueryXml::statusId(),         m_id);
-            w.attr(TextQueryXml::statusExpression(), m_expression);
-            w.attr(TextQueryXml::statusContents(),   Strings::printf("%d",   m_contents));
-            w.attr(TextQueryXml::statusRow(),        Strings::printf("%d",   m_row));
-            w.attr(TextQueryXml::statusSize(),       Strings::printf("%d",   m_size));
-            w.attr(TextQueryXml::statusTotal(),      Strings::printf("%d",   m_total));
-            w.attr(TextQueryXml::time(),             Strings::printf("%.3f", t.now()));
-            w.end(TextQueryXml::status());
-            
-            w.end(TextQueryXml::root());
+            if (binary)
+            {
+                TextQueryBinary::Status status;
+                status.id         = m_id;
+                status.expression = m_expression;
+                status.contents   = m_contents;
+                status.row        = m_row;
+                status.size       = m_size;
+                status.total      = m_total;
+                status.time       = t.now();
+                status.scale      = m_scale;
+                b->status(status);
+                buf.write(bin.data(), bin.size());
+            }
+            else
+            {
+                w->start(TextQueryXml::status());
+                w->attr(TextQueryXml::statusId(),         m_id);
+                w->attr(TextQueryXml::statusExpression(), m_expression);
+                w->attr(TextQueryXml::statusContents(),   Strings::printf("%d",   m_contents));
+                w->attr(TextQueryXml::statusRow(),        Strings::printf("%d",   m_row));
+                w->attr(TextQueryXml::statusSize(),       Strings::printf("%d",   m_size));
+                w->attr(TextQueryXml::statusTotal(),      Strings::printf("%d",   m_total));
+                w->attr(TextQueryXml::statusScale(),      Strings::printf("%.9g", m_scale));
+                w->attr(TextQueryXml::time(),             Strings::printf("%.3f", t.now()));
+                w->end(TextQueryXml::status());
+                w->end(TextQueryXml::root());
+            }
 
             Log::info4(
-                "query results: id=[%s] row=[%d] size=[%d] total=[%d] accessed=[%s] time=[%.3f]", 
+                "query results: id=[%s] row=[%d] size=[%d] total=[%d] accessed=[%s] binary=[%d] time=[%.3f]", 
                 m_id.c_str(), m_row, m_size, m_total,
-                ISODate::local(m_accessed).isodatetime().c_str(), t.secs());
+                ISODate::local(m_accessed).isodatetime().c_str(), binary, t.secs());
         }
-        
+
         // status: write query status as XML
         void status(DOMWriter& w)
         {
@@ -206,12 +211,12 @@ namespace kcc
             w.end(TextQueryXml::status());
         }
         
-        // expire: expire query
-        bool expire(long timeout) throw (TextException)
+        // expire: expire query unless accessed after sampled (time cursor was chosen to expire)
+        bool expire(std::time_t sampled) throw (TextException)
         {
             Mutex::Lock lock(m_sentinel);
             if (m_expired) return true; // already expired
-            if (m_created && (long)(std::time(NULL) - m_accessed) > timeout)            
+            if (m_created && m_accessed <= sampled)
             {
                 m_query.reset();
                 m_expired = true;
@@ -227,6 +232,7 @@ namespace kcc
         long                   m_row;
         long                   m_size;
         long                   m_total;
+        double                 m_scale;
         std::time_t            m_accessed;
         AutoPtr<ITextResults>  m_query;
         bool                   m_expired;
@@ -234,29 +240,84 @@ namespace kcc
         Mutex                  m_sentinel;
     };
 
-    // Query utility
-    typedef std::map<String, QueryCursor> NamedQueryCursors;
-    struct QueryCursorPriority { bool operator () (QueryCursor a, QueryCursor b) { return a->accessed() > b->accessed(); } };
-    typedef std::priority_queue<QueryCursor, std::vector<QueryCursor>, QueryCursorPriority> ExpiredQueryCursors;
+    // Query cursor table: cursors by id with an access ordered (most recent first) list of ids
+    typedef std::list<String> QueryCursorLRU;
+    struct QueryCursorEntry
+    {
+        QueryCursor              cursor;
+        std::time_t              touched;
+        bool                     expired;
+        QueryCursorLRU::iterator lru;
+    };
+    typedef std::map<String, QueryCursorEntry> NamedQueryCursors;
+    typedef std::vector<QueryCursor>           QueryCursors;
 
     // Query service
     struct QueryService : IHTTPResponse
     {
+        // Helper thread to expire and evict cursors, and sample mem in use, in the background
+        struct QueryReaper : Thread
+        {
+            QueryService& service;
+            Monitor&      done;
+            QueryReaper(QueryService& s, Monitor& d) : Thread("QueryReaper"), service(s), done(d)
+            {
+                done.init();
+            }
+            virtual void invoke()
+            {
+                Log::Scope scope(KCC_FILE, "QueryReaper::invoke");
+                while (service.reap());
+                done.notify();
+            }
+        };
+
         // Ctor
         QueryService(
             ITextStore* store, 
             long expire, 
             long maxCursors,
             long memInUseWarnPer,
-            long memInUseMax)
+            long memInUseMax,
+            long reap)
             : 
             m_store(store), 
             m_expire(expire), 
             m_nextId(1L), 
             m_maxCursors(maxCursors),
             m_memInUseWarnKB((long)(memInUseMax * (memInUseWarnPer / 100.0))),
-            m_memInUseMaxKB(memInUseMax)
+            m_memInUseMaxKB(memInUseMax),
+            m_memInUseKB(0L),
+            m_reap(reap < 1L ? 1L : reap),
+            m_expired(0L),
+            m_expirations(0L),
+            m_evictions(0L),
+            m_revives(0L),
+            m_running(false)
         {}
+        ~QueryService() { stop(); }
+
+        // start: sample mem in use and start reaper
+        void start()
+        {
+            Mutex::Lock lock(m_sentinel);
+            m_memInUseKB = Platform::procMemInUseKB();
+            m_running    = true;
+            m_stopping.init();
+            (new QueryReaper(*this, m_reaper))->go();
+        }
+
+        // stop: signal reaper to stop and wait for it
+        void stop()
+        {
+            {
+                Mutex::Lock lock(m_sentinel);
+                if (!m_running) return;
+                m_running = false;
+            }
+            m_stopping.notify();
+            m_reaper.wait();
+        }
 
         // onResponse: handle response
         void onResponse(const HTTPRequest& request, IHTTPRequestReader* in, IHTTPResponseWriter* out)
@@ -264,11 +325,9 @@ namespace kcc
             Log::Scope scope(KCC_FILE, "QueryService::onResponse");
             try
             {
-                // expire cursors if needed
-                expire(); // TODO: background thread?
-
                 // response
-                bool ok = true;
+                bool ok     = true;
+                bool binary = false;
                 StringStream xml;
                 if (request.path == TextQueryRest::close()) 
                 {
@@ -293,7 +352,8 @@ namespace kcc
                     long   row         = strRow.empty()      ? -1L : Strings::parseInteger(strRow);
                     long   contents    = strContents.empty() ? -1L : Strings::parseInteger(strContents);
                     long   max         = strMax.empty()      ? -1L : Strings::parseInteger(strMax);
-                    query(xml, id, row, expr, flush, contents, max);
+                    bool   format      = request.parameters[TextQueryRest::queryFormat()] == TextQueryRest::queryFormatBinary();
+                    binary = query(xml, id, row, expr, flush, contents, max, format);
                 }
                 else
                 {
@@ -304,7 +364,13 @@ namespace kcc
                 }
                 
                 // response if success
-                if (ok) out->xml(xml);
+                if (ok && binary)
+                {
+                    Dictionary headers;
+                    HTTP::setHeaders(headers, TextQueryBinary::contentType(), true);
+                    out->response(xml, headers);
+                }
+                else if (ok) out->xml(xml);
             }
             catch (Exception& e)
             {
@@ -315,40 +381,122 @@ namespace kcc
             }
         }
 
-        // expire: expire queries
-        void expire()
+        // reap: sample mem in use, expire idle cursors (and oldest active cursors under mem pressure),
+        //       and prune expired cursors past the revive threshold; returns false when stopped
+        bool reap()
         {
-            Mutex::Lock lock(m_sentinel);
-            Log::Scope scope(KCC_FILE, "QueryService::expire");
+            // wait out interval (completed early by stop())
+            if (m_stopping.wait(m_reap * 1000L)) return false;
+            Log::Scope scope(KCC_FILE, "QueryService::reap");
+            long memInUseKB = Platform::procMemInUseKB();
             
-            // collect expired queries
-            ExpiredQueryCursors expired;
-            for (NamedQueryCursors::iterator i = m_cursors.begin(); i != m_cursors.end(); i++)
+            // collect cursors to expire, oldest accessed first (stops at first cursor still in use)
+            QueryCursors expiring;
+            std::vector<bool> evicted; // per expiring cursor: evicted under mem pressure (else idle)
+            std::time_t  now = 0;
             {
-                QueryCursor q = i->second;
-                if (q->expire(m_expire))
-                { 
-                    expired.push(q);
+                Mutex::Lock lock(m_sentinel);
+                m_memInUseKB = memInUseKB;
+                now = std::time(NULL);
+                long evict = 0L;
+                if (memInUseKB > m_memInUseWarnKB)
+                {
+                    evict = std::max(1L, ((long)m_cursors.size() - m_expired) / 4L);
+                    Log::warning(
+                        "approaching maximum mem resource, evicting cursors: memInUseKB=[%d] memInUseMaxKB=[%d] evict=[%d]", 
+                        memInUseKB, m_memInUseMaxKB, evict);
+                }
+                for (QueryCursorLRU::reverse_iterator i = m_lru.rbegin(); i != m_lru.rend(); i++)
+                {
+                    QueryCursorEntry& e = m_cursors[*i];
+                    if (e.expired) continue;
+                    bool idle = (long)(now - e.touched) > m_expire;
+                    if (!idle && evict-- <= 0L) break;
+                    e.expired = true;
+                    m_expired++;
+                    expiring.push_back(e.cursor);
+                    evicted.push_back(!idle);
+                }
+            }
+
+            // expire outside of table lock (cursor may be busy fetching results), keeping
+            // cursors accessed since collected (retained for the table to revive); only
+            // cursors actually expired count as expirations or evictions
+            QueryCursors retained;
+            long expirations = 0L, evictions = 0L;
+            for (QueryCursors::iterator i = expiring.begin(); i != expiring.end(); i++)
+            {
+                try
+                {
+                    if (!(*i)->expire(now))
+                    {
+                        retained.push_back(*i);
+                        continue;
+                    }
+                    if (evicted[i - expiring.begin()]) evictions++;
+                    else                                 expirations++;
                     Log::info3(
                         "query expired: id=[%s] accessed=[%s]", 
-                        q->id().c_str(), 
-                        ISODate::local(q->accessed()).isodatetime().c_str());
+                        (*i)->id().c_str(), 
+                        ISODate::local((*i)->accessed()).isodatetime().c_str());
+                }
+                catch (Exception& e)
+                {
+                    Log::exception(e);
                 }
             }
-            
+
             // prune cursors in oldest accessed order retaining newer expired queries for potential revive
-            ExpiredQueryCursors::size_type reviveThreshold = (ExpiredQueryCursors::size_type) std::ceil(m_maxCursors * k_reviveFactor);
-            while (!expired.empty() && expired.size() > reviveThreshold)
+            Mutex::Lock lock(m_sentinel);
+            m_expirations += expirations;
+            m_evictions   += evictions;
+            expiring.clear();
+            for (QueryCursors::iterator i = retained.begin(); i != retained.end(); i++)
             {
-                QueryCursor q = expired.top();
-                Log::info3(
-                    "query flushing expired: id=[%s] accessed=[%s] threshold=[%d]", 
-                    q->id().c_str(), 
-                    ISODate::local(q->accessed()).isodatetime().c_str(),
-                    reviveThreshold);
-                m_cursors.erase(q->id());
-                expired.pop();
+                NamedQueryCursors::iterator find = m_cursors.find((*i)->id());
+                if (find == m_cursors.end() || !find->second.expired || (QueryCursorValue*)find->second.cursor != (QueryCursorValue*)*i) continue;
+                find->second.expired = false;
+                m_expired--;
+            }
+            retained.clear();
+            long reviveThreshold = (long) std::ceil(m_maxCursors * k_reviveFactor);
+            QueryCursorLRU::iterator i = m_lru.end();
+            while (m_expired > reviveThreshold && i != m_lru.begin())
+            {
+                QueryCursorLRU::iterator prior = i;
+                prior--;
+                if (m_cursors[*prior].expired)
+                {
+                    Log::info3("query flushing expired: id=[%s] threshold=[%d]", prior->c_str(), reviveThreshold);
+                    remove(*prior);
+                }
+                else i = prior;
             }
+            return true;
+        }
+
+        // touch: move cursor to front of access order, reviving if expired (table must be locked)
+        QueryCursor touch(QueryCursorEntry& e)
+        {
+            if (e.expired)
+            {
+                e.expired = false;
+                m_expired--;
+                m_revives++;
+            }
+            std::time(&e.touched);
+            m_lru.splice(m_lru.begin(), m_lru, e.lru);
+            return e.cursor;
+        }
+
+        // remove: remove cursor from table (table must be locked)
+        void remove(const String& id)
+        {
+            NamedQueryCursors::iterator find = m_cursors.find(id);
+            if (find == m_cursors.end()) return;
+            if (find->second.expired) m_expired--;
+            m_lru.erase(find->second.lru);
+            m_cursors.erase(find);
         }
 
         // status: server status
@@ -367,6 +515,31 @@ namespace kcc
             w.attr(TextQueryXml::rootMaxCursors(), Strings::printf("%d", m_maxCursors));
             w.attr(TextQueryXml::rootCursors(),    Strings::printf("%d", m_cursors.size()));
             w.attr(TextQueryXml::rootExpire(),     Strings::printf("%d", m_expire));
+            w.attr(TextQueryXml::rootActive(),     Strings::printf("%d", (long)m_cursors.size() - m_expired));
+            w.attr(TextQueryXml::rootExpired(),    Strings::printf("%d", m_expired));
+            w.attr(TextQueryXml::rootExpirations(),Strings::printf("%d", m_expirations));
+            w.attr(TextQueryXml::rootEvictions(),  Strings::printf("%d", m_evictions));
+            w.attr(TextQueryXml::rootRevives(),    Strings::printf("%d", m_revives));
+            w.attr(TextQueryXml::rootMemInUse(),   Strings::printf("%d", m_memInUseKB));
+            TextCacheStatistics cache;
+            m_store->queryCacheStatistics(cache);
+            w.attr(TextQueryXml::rootCacheEntries(),       Strings::printf("%d", cache.entries));
+            w.attr(TextQueryXml::rootCacheMax(),           Strings::printf("%d", cache.max));
+            w.attr(TextQueryXml::rootCacheHits(),          Strings::printf("%d", cache.hits));
+            w.attr(TextQueryXml::rootCacheMisses(),        Strings::printf("%d", cache.misses));
+            w.attr(TextQueryXml::rootCacheEvictions(),     Strings::printf("%d", cache.evictions));
+            w.attr(TextQueryXml::rootCacheInvalidations(), Strings::printf("%d", cache.invalidations));
+            w.attr(TextQueryXml::rootGeneration(),         Strings::printf("%lld", cache.generation));
+            RegexCacheStatistics rx;
+            Core::regex()->cacheStatistics(rx);
+            long rxLookups = rx.frontHits + rx.hits + rx.misses;
+            w.attr(TextQueryXml::rootRegexCacheEntries(),   Strings::printf("%d", rx.entries));
+            w.attr(TextQueryXml::rootRegexCacheMax(),       Strings::printf("%d", rx.max));
+            w.attr(TextQueryXml::rootRegexCacheFrontHits(), Strings::printf("%d", rx.frontHits));
+            w.attr(TextQueryXml::rootRegexCacheHits(),      Strings::printf("%d", rx.hits));
+            w.attr(TextQueryXml::rootRegexCacheMisses(),    Strings::printf("%d", rx.misses));
+            w.attr(TextQueryXml::rootRegexCacheEvictions(), Strings::printf("%d", rx.evictions));
+            w.attr(TextQueryXml::rootRegexCacheHitRatio(),  Strings::printf("%.3f", rxLookups > 0L ? (double)(rx.frontHits + rx.hits) / rxLookups : 0.0));
             w.attr(TextQueryXml::rootWhen(),       ISODate::local().isodatetime());
             if (detail)
             {
@@ -374,11 +547,8 @@ namespace kcc
                 long         docs = m_store->indexDocuments();
                 StringStream bufQueries;
                 DOMWriter    wQueries(bufQueries, true);
-                for (NamedQueryCursors::iterator i = m_cursors.begin(); i != m_cursors.end(); i++)
-                {
-                    QueryCursor q = i->second;
-                    q->status(wQueries);
-                }
+                for (QueryCursorLRU::iterator i = m_lru.begin(); i != m_lru.end(); i++)
+                    m_cursors[*i].cursor->status(wQueries);
                 String xmlQueries(bufQueries.str());
                 
                 // index size (TODO: ?? refactor to k_textstore component ??)
@@ -412,12 +582,12 @@ namespace kcc
             w.end(TextQueryXml::root());
         }
 
-        // query: new or continue query
-        void query(
+        // query: new or continue query, returning true if binary results written
+        bool query(
             StringStream& xml, 
             const String& id, long row, 
             const String& expr, bool flush, 
-            long contents, long max) throw (TextException)
+            long contents, long max, bool binary) throw (TextException)
         {
             Log::Scope scope(KCC_FILE, "QueryService::query");
             QueryCursor qry;
@@ -426,13 +596,13 @@ namespace kcc
                 // existing query
                 Mutex::Lock lock(m_sentinel);
                 NamedQueryCursors::iterator find = m_cursors.find(id);
-                if (find != m_cursors.end()) qry = find->second;
+                if (find != m_cursors.end()) qry = touch(find->second);
                 if (qry != NULL)
                 {
                     // flush
                     if (flush)
                     {
-                        m_cursors.erase(id);
+                        remove(id);
                         qry.reset();
                         String msg("query flushed: id=[" + id + "]");
                         Log::info3(msg);
@@ -452,13 +622,17 @@ namespace kcc
                 Mutex::Lock lock(m_sentinel);
                 if (!expr.empty())
                 {
-                    long memInUseKB = Platform::procMemInUseKB();
-                    if (memInUseKB < m_memInUseMaxKB && memInUseKB > m_memInUseWarnKB) 
+                    // mem in use as last sampled by reaper; oldest expired cursor gives way at max cursors
+                    long memInUseKB = m_memInUseKB;
+                    if (m_cursors.size() >= (NamedQueryCursors::size_type)m_maxCursors && m_expired > 0L)
                     {
-                        // warn mem in use
-                        Log::warning(
-                            "approaching maximum mem resource: memInUseKB=[%d] memInUseMaxKB=[%d]", 
-                            memInUseKB, m_memInUseMaxKB);
+                        for (QueryCursorLRU::reverse_iterator i = m_lru.rbegin(); i != m_lru.rend(); i++)
+                        {
+                            if (!m_cursors[*i].expired) continue;
+                            Log::info3("query flushing expired for new query: id=[%s]", i->c_str());
+                            remove(*i);
+                            break;
+                        }
                     }
                     if (memInUseKB > m_memInUseMaxKB)
                     {
@@ -482,7 +656,11 @@ namespace kcc
                     {
                         // create query definition
                         qry = QueryCursor(new QueryCursorValue(Strings::printf("%x", m_nextId++), expr, contents));
-                        m_cursors[qry->id()] = qry;
+                        QueryCursorEntry& e = m_cursors[qry->id()];
+                        e.cursor  = qry;
+                        e.expired = false;
+                        e.lru     = m_lru.insert(m_lru.begin(), qry->id());
+                        std::time(&e.touched);
                     }
                 }
                 else
@@ -492,7 +670,9 @@ namespace kcc
             }
 
             // query results using query mutex instead of collection mutex
-            if (qry != NULL) qry->results(m_store, xml, row, max);
+            if (qry == NULL) return false;
+            qry->results(m_store, xml, row, max, binary);
+            return binary;
         }
 
         // close: close all query cursors
@@ -502,13 +682,16 @@ namespace kcc
             Log::Scope scope(KCC_FILE, "QueryService::close");
             Log::info3("closing all queries: cached=[%d]", m_cursors.size());
             for (NamedQueryCursors::iterator i = m_cursors.begin(); i != m_cursors.end(); i++)
-                Log::info3("query close: id=[%s] rc=[%d]", i->first.c_str(), i->second.rc());
+                Log::info3("query close: id=[%s] rc=[%d]", i->first.c_str(), i->second.cursor.rc());
             m_cursors.clear();
+            m_lru.clear();
+            m_expired = 0L;
         }
 
     private:
         // Attributes
         NamedQueryCursors m_cursors;
+        QueryCursorLRU    m_lru;
         ITextStore*       m_store;
         Mutex             m_sentinel;
         long              m_expire;
@@ -516,6 +699,15 @@ namespace kcc
         long              m_maxCursors;
         long              m_memInUseWarnKB;
         long              m_memInUseMaxKB;
+        long              m_memInUseKB;
+        long              m_reap;
+        long              m_expired;
+        long              m_expirations;
+        long              m_evictions;
+        long              m_revives;
+        bool              m_running;
+        Monitor           m_stopping; // begun by start(), ended by stop()
+        Monitor           m_reaper;
     };
 
     // Query home handler
@@ -566,13 +758,14 @@ int main(int argc, const char* argv[])
         long        cursors         = props.get("cursors", 64L);                 // 64 cursors
         long        memInUseWarnPer = props.get("memInUseWarnPer", 90L);         // 90%
         long        memInUseMaxKB   = props.get("memInUseMaxKB",   1024L*1024L); // 1GB
+        long        reap            = props.get("reap", 5L);                     // 5 secs
         if (path.empty()) path = props.get("TextStore.path", kcc::Strings::empty());
         path = kcc::Platform::fsNormalize(path);
         kcc::Log::out(
             "%s: service=[%s:%d] remoteShutdown=[%d] notifyURL=[%s] "
-            "path=[%s] expires=[%d] cursors=[%d] memInUseWarnPer=[%d] memInUseMaxKB=[%d]",
+            "path=[%s] expires=[%d] cursors=[%d] memInUseWarnPer=[%d] memInUseMaxKB=[%d] reap=[%d]",
             KCC_FILE, host.c_str(), port, remoteShutdown, notifyURL.c_str(),
-            path.c_str(), expires, cursors, memInUseWarnPer, memInUseMaxKB);
+            path.c_str(), expires, cursors, memInUseWarnPer, memInUseMaxKB, reap);
 
         // text store
         if (!path.empty()) props.set("TextStore.path", path);
@@ -585,7 +778,7 @@ int main(int argc, const char* argv[])
         kcc::AutoPtr<kcc::IHTTPResponseShutdown>   shutdown;
         kcc::AutoPtr<kcc::IHTTPResponse>           service(httpFactory->constructServiceStatus());
         kcc::QueryHome    home;
-        kcc::QueryService query(textStore, expires, cursors, memInUseWarnPer, memInUseMaxKB);
+        kcc::QueryService query(textStore, expires, cursors, memInUseWarnPer, memInUseMaxKB, reap);
         kcc::IHTTPResponseDispatcher::ResponseHandlers& handlers = dispatcher->handlers();
         handlers[kcc::k_home]                   = &home;
         handlers[kcc::TextQueryRest::query()]   = &query;
@@ -607,6 +800,7 @@ int main(int argc, const char* argv[])
         // http server
         kcc::AutoPtr<kcc::IHTTPServer> s(httpFactory->constructServer());
         if (!s->init(host, port, dispatcher, notifyURL, 512)) return 1;
+        query.start();
         s->start();
 
         // run server until stopped
@@ -624,6 +818,7 @@ int main(int argc, const char* argv[])
         std::cout << KCC_FILE << " stopping..." << std::endl;
         std::cout.flush();
         s->stop();
+        query.stop();
         query.close();
         std::cout << KCC_FILE << " stopped" << std::endl;
     }
@@ -10,6 +10,7 @@ namespace libxml
 {
     #include "libxslt/transform.h"
     #include "libxslt/xsltutils.h"
+    #include "libxslt/imports.h"
     #include "libexslt/exslt.h"
 };
 
@@ -19,11 +20,14 @@ namespace libxml
 namespace kcc
 {
     // Configuration 
-    static const String k_keyCache ("XMLTransform.cache");
-    static const long   k_defCache = KCC_PROPERTY_TRUE;
+    static const String k_keyCache   ("XMLTransform.cache");
+    static const long   k_defCache   = KCC_PROPERTY_TRUE;
+    static const String k_keyContexts("XMLTransform.contexts");
+    static const long   k_defContexts= 16L;
     
     // Constants
     const int SZ = 1024*4;
+    const int k_parseOptions = libxml::XML_PARSE_NOENT | libxml::XML_PARSE_DTDLOAD; // as xmlSubstituteEntitiesDefault & xmlLoadExtDtdDefaultValue
 
     // Helper to manage libxml/libxslt init & clean-up
     static struct LibXmlClean
@@ -75,11 +79,77 @@ namespace kcc
         const char** params() { return (const char**) m_params; }
     };
 
+    // Helper to free xml document on stack boundary
+    struct XMLDoc
+    {
+        libxml::xmlDocPtr doc;
+        XMLDoc(libxml::xmlDocPtr d) : doc(d) {}
+        ~XMLDoc() { if (doc != NULL) libxml::xmlFreeDoc(doc); }
+    };
+
+    // lastError: last libxml error of calling thread
+    static String lastError()
+    {
+        libxml::xmlErrorPtr e = libxml::xmlGetLastError();
+        return (e == NULL || e->message == NULL) ? String("unknown libxml error") : String(e->message);
+    }
+
+    // readStream: read stream into data (stream is rewound)
+    static void readStream(std::istream& in, String& data)
+    {
+        in.seekg(0, std::ios::end);
+        int sz = (int)in.tellg();
+        in.seekg(0, std::ios::beg);
+        data.reserve(sz);
+        char buf[SZ+1];
+        while (in.good() && !in.eof())
+        {
+            in.read(buf, SZ);
+            buf[in.gcount()] = 0;
+            data += buf;
+        }
+        in.clear();
+        in.seekg(0, std::ios::beg);
+    }
+
+    // outputWrite: libxml output buffer callback writing serialized result to stream
+    static int outputWrite(void* context, const char* buf, int len)
+    {
+        std::ostream& out = *static_cast<std::ostream*>(context);
+        out.write(buf, len);
+        return out.good() ? len : -1;
+    }
+
+    // transform: apply compiled stylesheet to xml (stylesheet is only read so may be shared)
+    // result is serialized to the stream as libxml fills its output buffer, not as one string
+    static void transform(
+        libxml::xsltStylesheetPtr xslt, libxml::xmlDocPtr xml, 
+        const StringMap& params, std::ostream& out) throw (IXMLTransform::TransformException)
+    {
+        XSLTParams xp(params);
+        XMLDoc res(libxml::xsltApplyStylesheet(xslt, xml, xp.params()));
+        if (res.doc == NULL) throw IXMLTransform::TransformException(lastError());
+
+        // output encoding of stylesheet (or its imports), utf-8 needs no encoder
+        libxml::xsltStylesheetPtr style = xslt;
+        while (style != NULL && style->encoding == NULL) style = libxml::xsltNextImport(style);
+        libxml::xmlCharEncodingHandlerPtr encoder = NULL;
+        if (style != NULL) encoder = libxml::xmlFindCharEncodingHandler((const char*)style->encoding);
+        if (encoder != NULL && libxml::xmlStrEqual((const libxml::xmlChar*)encoder->name, (const libxml::xmlChar*)"UTF-8")) encoder = NULL;
+
+        // serialize
+        libxml::xmlOutputBufferPtr buf = libxml::xmlOutputBufferCreateIO(outputWrite, NULL, &out, encoder);
+        if (buf == NULL) throw IXMLTransform::TransformException("unable to create xslt output buffer");
+        int written = libxml::xsltSaveResultTo(buf, res.doc, xslt);
+        int closed  = libxml::xmlOutputBufferClose(buf);
+        if (written < 0 || closed < 0) throw IXMLTransform::TransformException(lastError());
+    }
+
     // Implementation of XSLTApply
     struct XSLTApply : IXSLTApply
     {
         // Attributes
-        Mutex                     m_sentinel; // libxml/xslt are not thread safe
+        Mutex                     m_sentinel; // libxml/xslt documents are not thread safe
         libxml::xmlDocPtr         m_xml;
         libxml::xsltStylesheetPtr m_xslt;
         XSLTApply() : m_xml(NULL), m_xslt(NULL) {}
@@ -96,21 +166,10 @@ namespace kcc
             Mutex::Lock lock(m_sentinel);
             Log::Scope scope(KCC_FILE, "XMLApply::loadXml");
             if (m_xml != NULL) libxml::xmlFreeDoc(m_xml);
-            xml.seekg(0, std::ios::end);
-            int sz = (int)xml.tellg();
-            xml.seekg(0, std::ios::beg);
             kcc::String data;
-            data.reserve(sz);
-            char buf[SZ+1];
-            while (xml.good() && !xml.eof())
-            {
-                xml.read(buf, SZ);
-                buf[xml.gcount()] = 0;
-                data += buf;
-            }
-            xml.seekg(0, std::ios::beg);
+            readStream(xml, data);
             m_xml = libxml::xmlParseMemory(data.c_str(), data.size());
-            if (m_xml == NULL) throw IXMLTransform::TransformException(libxml::xmlGetLastError()->message);
+            if (m_xml == NULL) throw IXMLTransform::TransformException(lastError());
         }
 
         // loadXml: load xml from path
@@ -120,7 +179,7 @@ namespace kcc
             Log::Scope scope(KCC_FILE, "XMLApply::loadXml");
             if (m_xml != NULL) libxml::xmlFreeDoc(m_xml);
             m_xml = libxml::xmlParseFile(xmlPath.c_str());
-            if (m_xml == NULL) throw IXMLTransform::TransformException(libxml::xmlGetLastError()->message);
+            if (m_xml == NULL) throw IXMLTransform::TransformException(lastError());
         }
         
         // loadXslt: load xslt from istream
@@ -129,24 +188,13 @@ namespace kcc
             Mutex::Lock lock(m_sentinel);
             Log::Scope scope(KCC_FILE, "XMLApply::loadXslt");
             if (m_xslt != NULL) libxml::xsltFreeStylesheet(m_xslt);
-            xslt.seekg(0, std::ios::end);
-            int sz = (int)xslt.tellg();
-            xslt.seekg(0, std::ios::beg);
             kcc::String data;
-            data.reserve(sz);
-            char buf[SZ+1];
-            while (xslt.good() && !xslt.eof())
-            {
-                xslt.read(buf, SZ);
-                buf[xslt.gcount()] = 0;
-                data += buf;
-            }
-            xslt.seekg(0, std::ios::beg);
+            readStream(xslt, data);
             libxml::xmlDocPtr xsltDoc = libxml::xmlParseMemory(data.c_str(), data.size());
-            if (xsltDoc == NULL) throw IXMLTransform::TransformException(libxml::xmlGetLastError()->message);
+            if (xsltDoc == NULL) throw IXMLTransform::TransformException(lastError());
             m_xslt = libxml::xsltParseStylesheetDoc(xsltDoc);
             libxml::xmlFreeDoc(xsltDoc);
-            if (m_xslt == NULL) throw IXMLTransform::TransformException(libxml::xmlGetLastError()->message);
+            if (m_xslt == NULL) throw IXMLTransform::TransformException(lastError());
         }
         
         // loadXslt: load xslt from path
@@ -156,7 +204,7 @@ namespace kcc
             Log::Scope scope(KCC_FILE, "XMLApply::loadXslt");
             if (m_xslt != NULL) libxml::xsltFreeStylesheet(m_xslt);
             m_xslt = libxml::xsltParseStylesheetFile((const libxml::xmlChar *)xsltPath.c_str());
-            if (m_xslt == NULL) throw IXMLTransform::TransformException(libxml::xmlGetLastError()->message);
+            if (m_xslt == NULL) throw IXMLTransform::TransformException(lastError());
         }
 
         // apply: apply transformation
@@ -166,78 +214,133 @@ namespace kcc
             Log::Scope scope(KCC_FILE, "XMLApply::apply");
             if (m_xml  == NULL) throw IXMLTransform::TransformException("xml document not loaded: must call loadXml() before apply()");
             if (m_xslt == NULL) throw IXMLTransform::TransformException("xslt document not loaded: must call loadXslt() before apply()");
-            XSLTParams xp(params);
-            libxml::xmlDocPtr res = libxml::xsltApplyStylesheet(m_xslt, m_xml, xp.params());
-            if (res == NULL) throw IXMLTransform::TransformException(libxml::xmlGetLastError()->message);
-            libxml::xmlChar* dump = NULL;
-            int sz = 0;
-            if (libxml::xsltSaveResultToString(&dump, &sz, res, m_xslt) < 0) 
+            transform(m_xslt, m_xml, params, out);
+        }
+    };
+
+    // Helper class to pool xml parser contexts across transforming threads
+    //  - a context is checked out for the duration of one transform, so each
+    //    concurrent transform has its own; idle contexts are kept up to max
+    struct ParserPool
+    {
+        // Helper to check out/in a context on stack boundary
+        struct Context
+        {
+            ParserPool&              pool;
+            libxml::xmlParserCtxtPtr parser;
+            Context(ParserPool& p) : pool(p), parser(p.checkout()) {}
+            ~Context() { pool.checkin(parser); }
+        };
+
+        // Attributes
+        typedef std::vector<libxml::xmlParserCtxtPtr> Contexts;
+        SpinMutex m_sentinel; // held only to push/pop an idle context
+        Contexts  m_idle;
+        long      m_max;
+        ParserPool() : m_max(k_defContexts) {}
+        ~ParserPool()
+        {
+            for (Contexts::iterator i = m_idle.begin(); i != m_idle.end(); i++) libxml::xmlFreeParserCtxt(*i);
+        }
+
+        // checkout: idle context or new if none
+        libxml::xmlParserCtxtPtr checkout() throw (IXMLTransform::TransformException)
+        {
             {
-                libxml::xmlFreeDoc(res);
-                throw IXMLTransform::TransformException(libxml::xmlGetLastError()->message);
+                SpinMutex::Lock lock(m_sentinel);
+                if (!m_idle.empty())
+                {
+                    libxml::xmlParserCtxtPtr ctxt = m_idle.back();
+                    m_idle.pop_back();
+                    return ctxt;
+                }
             }
-            if (sz > 0 && dump != NULL)
+            libxml::xmlParserCtxtPtr ctxt = libxml::xmlNewParserCtxt();
+            if (ctxt == NULL) throw IXMLTransform::TransformException("unable to create xml parser context");
+            return ctxt;
+        }
+
+        // checkin: return context to idle list (or free if at max)
+        void checkin(libxml::xmlParserCtxtPtr ctxt)
+        {
             {
-                out << dump;
-                out.flush();
-                libxml::xmlFree(dump);
+                SpinMutex::Lock lock(m_sentinel);
+                if ((long)m_idle.size() < m_max)
+                {
+                    m_idle.push_back(ctxt);
+                    return;
+                }
             }
-            libxml::xmlFreeDoc(res);
+            libxml::xmlFreeParserCtxt(ctxt);
         }
     };
 
-    // Helper structure to manager compiled stylesheets
+    // Helper structure to manage compiled stylesheets
+    //  - compiled stylesheet is shared read-only: transforms of the same stylesheet run
+    //    concurrently, each with its own parser context and libxslt transform context
     struct CompiledStylesheetValue
     {
         // Attributes
-        std::time_t modified;
-        XSLTApply   apply;
+        std::time_t               modified;
+        libxml::xsltStylesheetPtr xslt;
         CompiledStylesheetValue(const String& xsltPath) 
-            throw (IXMLTransform::TransformException)
+            throw (IXMLTransform::TransformException) : xslt(NULL)
+        {
+            Log::Scope scope(KCC_FILE, "CompiledStylesheetValue");
+            Platform::File f;
+            if (!Platform::fsFile(xsltPath, f)) throw IXMLTransform::TransformException("xslt not found: path=[" + xsltPath + "]");
+            modified = f.modified;
+            xslt = libxml::xsltParseStylesheetFile((const libxml::xmlChar *)xsltPath.c_str());
+            if (xslt == NULL) throw IXMLTransform::TransformException(lastError());
+        }
+        ~CompiledStylesheetValue()
         {
-            Platform::File xslt;
-            if (!Platform::fsFile(xsltPath, xslt)) throw IXMLTransform::TransformException("xslt not found: path=[" + xsltPath + "]");
-            modified = xslt.modified;
-            apply.loadXslt(xsltPath);
+            if (xslt != NULL) libxml::xsltFreeStylesheet(xslt);
         }
         
         // xform: transform xml path
-        void xform(const String& xmlPath, const StringMap& params, std::ostream& out) 
+        void xform(ParserPool& pool, const String& xmlPath, const StringMap& params, std::ostream& out) 
             throw (IXMLTransform::TransformException)
         {
-            Mutex::Lock lock(apply.m_sentinel);
-            apply.loadXml(xmlPath);
-            apply.apply(params, out);
+            ParserPool::Context ctxt(pool);
+            XMLDoc xml(libxml::xmlCtxtReadFile(ctxt.parser, xmlPath.c_str(), NULL, k_parseOptions));
+            if (xml.doc == NULL) throw IXMLTransform::TransformException(lastError());
+            transform(xslt, xml.doc, params, out);
         }
 
         // xform: transform xml stream
-        void xform(std::istream& xml, const StringMap& params, std::ostream& out) 
+        void xform(ParserPool& pool, std::istream& in, const StringMap& params, std::ostream& out) 
             throw (IXMLTransform::TransformException)
         {
-            Mutex::Lock lock(apply.m_sentinel);
-            apply.loadXml(xml);
-            apply.apply(params, out);
+            kcc::String data;
+            readStream(in, data);
+            ParserPool::Context ctxt(pool);
+            XMLDoc xml(libxml::xmlCtxtReadMemory(ctxt.parser, data.c_str(), data.size(), NULL, NULL, k_parseOptions));
+            if (xml.doc == NULL) throw IXMLTransform::TransformException(lastError());
+            transform(xslt, xml.doc, params, out);
         }
     };
-    typedef SharedPtr<CompiledStylesheetValue>   CompiledStylesheet;
-    typedef std::map<String, CompiledStylesheet> Cache;
+    typedef SharedPtr<CompiledStylesheetValue, AtomicCount> CompiledStylesheet; // released outside cache lock
+    typedef std::map<String, CompiledStylesheet>              Cache;
 
     // Implementation of XML transformation
     struct XMLTransform : IXMLTransform
     {
         
         // Attributes
-        Mutex m_sentinel;
-        bool  m_useCache;
-        Cache m_cache;
+        RWMutex    m_sentinel; // cache (read-dominated: stylesheets rarely change)
+        bool       m_useCache;
+        Cache      m_cache;
+        ParserPool m_parsers;
         XMLTransform() : m_useCache(true) {}
         
         // init: init component
         bool init(const Properties& config) 
         {
             Log::Scope scope(KCC_FILE, "init");
-            m_useCache = config.get(k_keyCache, k_defCache) == KCC_PROPERTY_TRUE;
-            Log::info2("XMLTransform init: cache=[%d]", m_useCache);
+            m_useCache      = config.get(k_keyCache, k_defCache) == KCC_PROPERTY_TRUE;
+            m_parsers.m_max = config.get(k_keyContexts, k_defContexts);
+            Log::info2("XMLTransform init: cache=[%d] contexts=[%d]", m_useCache, m_parsers.m_max);
             return true; 
         }
         
@@ -246,7 +349,7 @@ namespace kcc
             throw (IXMLTransform::TransformException)
         {
             Log::Scope scope(KCC_FILE, "apply");
-            stylesheet(xsltPath)->xform(xmlPath, params, out);
+            stylesheet(xsltPath)->xform(m_parsers, xmlPath, params, out);
         }
 
         // apply: apply transformation
@@ -254,7 +357,7 @@ namespace kcc
             throw (IXMLTransform::TransformException)
         {
             Log::Scope scope(KCC_FILE, "apply");
-            stylesheet(xsltPath)->xform(xml, params, out);
+            stylesheet(xsltPath)->xform(m_parsers, xml, params, out);
         }
         
         // stylesheet: get style sheet for xslt from cache or create and cache
@@ -265,12 +368,25 @@ namespace kcc
             CompiledStylesheet ss;
             if (m_useCache)
             {
-                Mutex::Lock lock(m_sentinel);
+                Platform::File xslt;
+                if (!Platform::fsFile(xsltPath, xslt)) throw IXMLTransform::TransformException("xslt not found: path=[" + xsltPath + "]");
+
+                // cached & current
+                {
+                    RWMutex::SharedLock lock(m_sentinel);
+                    Cache::iterator find = m_cache.find(xsltPath);
+                    if (find != m_cache.end() && xslt.modified == find->second->modified)
+                    {
+                        Log::info4("using cached compiled stylesheet: xslt=[%s]", xsltPath.c_str());
+                        return find->second;
+                    }
+                }
+
+                // (re)compile & cache, unless cached by another thread meanwhile
+                RWMutex::ExclusiveLock lock(m_sentinel);
                 Cache::iterator find = m_cache.find(xsltPath);
                 if (find != m_cache.end()) 
                 {
-                    Platform::File xslt;
-                    if (!Platform::fsFile(xsltPath, xslt)) throw IXMLTransform::TransformException("xslt not found: path=[" + xsltPath + "]");
                     if (xslt.modified == find->second->modified)
                     {
                         Log::info4("using cached compiled stylesheet: xslt=[%s]", xsltPath.c_str());
@@ -157,6 +157,25 @@ namespace kcc
         IComponent* construct()       { return constructReader(); }
         IZipReader* constructReader() { return new BZip2Reader; }
         IZipWriter* constructWriter() { return new BZip2Writer; }
+
+        // compress: compress buffer into a bzip2 stream (bzip2 bound is 1% + 600 bytes)
+        bool compress(const char* buf, int sz, String& out, int blocksz)
+        {
+            Log::Scope scope(KCC_FILE, "compress");
+            if (blocksz > 9)      blocksz = 9;
+            else if (blocksz < 1) blocksz = 1;
+            out.resize(sz + sz/100 + 600);
+            unsigned int actual = (unsigned int)out.size();
+            int status = bzip2::BZ2_bzBuffToBuffCompress(&out[0], &actual, (char*)buf, sz, blocksz, 0, 0);
+            if (status != BZ_OK)
+            {
+                Log::error("bzip2 compress failed: status=[%d]", status);
+                out.clear();
+                return false;
+            }
+            out.resize(actual);
+            return true;
+        }
     };
 
     KCC_COMPONENT_FACTORY_CUST(BZip2Factory)
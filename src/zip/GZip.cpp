@@ -162,6 +162,37 @@ namespace kcc
         IComponent* construct()       { return constructReader(); }
         IZipReader* constructReader() { return new GZipReader; }
         IZipWriter* constructWriter() { return new GZipWriter; }
+
+        // compress: deflate buffer into a gzip stream (window bits + 16 selects gzip header/trailer)
+        bool compress(const char* buf, int sz, String& out, int blocksz)
+        {
+            Log::Scope scope(KCC_FILE, "compress");
+            if (blocksz > 9)      blocksz = 9;
+            else if (blocksz < 1) blocksz = 1;
+            out.clear();
+            gzip::z_stream z;
+            std::memset(&z, 0, sizeof(z));
+            if (gzip::deflateInit2_(&z, blocksz, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY, ZLIB_VERSION, (int)sizeof(z)) != Z_OK)
+            {
+                Log::error("unable to initialize gzip deflate stream");
+                return false;
+            }
+            out.resize(gzip::deflateBound(&z, sz));
+            z.next_in   = (gzip::Bytef*)buf;
+            z.avail_in  = sz;
+            z.next_out  = (gzip::Bytef*)&out[0];
+            z.avail_out = (gzip::uInt)out.size();
+            int status = gzip::deflate(&z, Z_FINISH);
+            out.resize(z.total_out);
+            gzip::deflateEnd(&z);
+            if (status != Z_STREAM_END)
+            {
+                Log::error("gzip deflate failed: status=[%d]", status);
+                out.clear();
+                return false;
+            }
+            return true;
+        }
     };
 
     KCC_COMPONENT_FACTORY_CUST(GZipFactory)
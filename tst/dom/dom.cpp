@@ -203,6 +203,74 @@ void htmlspeed(kcc::IRODOM* rodom, const kcc::String& path)
     kcc::Log::out("rodom html tot=[%d] secs=[%f] avg=[%f]", htmlDocs, secs, avg);
 }
 
+// xmlspeed: compare heap and arena xml parsing of a generated document
+void xmlspeed(kcc::IRODOM* rodom, long docs, long passes)
+{
+    // build document (text query style results)
+    kcc::String text;
+    {
+        kcc::StringStream xml;
+        kcc::DOMWriter w(xml);
+        w.start("TextQuery");
+        w.attr("service", KCC_FILE);
+        for (long i = 0L; i < docs; i++)
+        {
+            w.start("Document");
+            w.attr("row",   kcc::Strings::printf("%d", i));
+            w.attr("score", kcc::Strings::printf("%.6g", 1.0 / (i + 1)));
+            w.start("Text");
+            w.text("travelocity & orbitz <compare> fares for a 'weekend' trip; booked through corporate travel");
+            w.end("Text");
+            for (long j = 0L; j < 4L; j++)
+            {
+                w.start("Metadata");
+                w.attr("k", kcc::Strings::printf("key%d", j));
+                w.attr("v", kcc::Strings::printf("value %d of document %d", j, i));
+                w.end("Metadata");
+            }
+            w.end("Document");
+        }
+        w.end("TextQuery");
+        text = xml.str();
+    }
+
+    // verify arena document reads the same as heap document
+    {
+        kcc::AutoPtr<kcc::IDOMNode> heap (rodom->parseXML(text, kcc::IRODOM::A_HEAP));
+        kcc::AutoPtr<kcc::IDOMNode> arena(rodom->parseXML(text, kcc::IRODOM::A_ARENA));
+        kcc::StringStream h, a;
+        kcc::DOMWriter hw(h), aw(a);
+        hw.node(heap);
+        aw.node(arena);
+        kcc::DOMReader r(arena);
+        kcc::AutoPtr<kcc::IDOMNodeList> l(r.nodes("TextQuery", "Document"));
+        bool same = h.str() == a.str() && l->getLength() == docs;
+        kcc::Log::out(
+            "rodom xml verify: size=[%d] docs=[%d] same=[%d] text=[%s]",
+            text.size(), l->getLength(), same, (l->getLength() > 0 ? r.nodeTx(l->getItem(0), "Text") : kcc::String()).c_str());
+        if (!same) throw kcc::Exception(kcc::Strings::printf("rodom arena document differs from heap document: docs=[%d]", l->getLength()));
+    }
+
+    // parse: heap vs arena
+    for (int mode = kcc::IRODOM::A_HEAP; mode <= kcc::IRODOM::A_ARENA; mode++)
+    {
+        kcc::Timer t;
+        t.start();
+        for (long i = 0L; i < passes; i++)
+        {
+            kcc::AutoPtr<kcc::IDOMNode> root(rodom->parseXML(text, (kcc::IRODOM::Allocation)mode));
+            kcc::DOMReader r(root);
+            kcc::AutoPtr<kcc::IDOMNodeList> l(r.nodes("TextQuery", "Document"));
+            for (long j = 0L; j < l->getLength(); j++) r.attr(l->getItem(j), "score");
+        }
+        double secs = t.now();
+        kcc::Log::out(
+            "rodom xml %s: passes=[%d] secs=[%f] avg=[%f] MB/s=[%.1f]",
+            mode == kcc::IRODOM::A_HEAP ? "heap" : "arena", passes, secs, secs / passes,
+            (text.size() * passes) / (secs * 1024.0 * 1024.0));
+    }
+}
+
 // htmlclean: clean html by parsing (which will fix-up html) and rewriting
 void htmlclean(kcc::IRODOM* rodom, const kcc::String& path)
 {
@@ -231,6 +299,7 @@ int main(int argc, const char* argv[])
         std::ofstream out("tst-out/domtest.txt");
         test(kcc::Core::rodom(), "tst-in", out);
         out.close();
+        xmlspeed(kcc::Core::rodom(), props.get("xmlDocs", 20000L), props.get("xmlPasses", 5L));
 
         /*
         htmlspeed(kcc::Core::rodom(), "/Work/Sandbox/tst-dom-spd/cache-205");
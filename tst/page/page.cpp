@@ -60,11 +60,141 @@ struct PageHandler : kcc::IPageHandler
     }
 };
 
+// Sink to count and checksum uploaded content
+struct UploadSink : kcc::IPageFormSink
+{
+    unsigned long sum;
+    UploadSink() : sum(0UL) {}
+    void onContent(const char* buf, int sz) throw (kcc::Socket::Failed)
+    {
+        for (int i = 0; i < sz; i++) sum = sum * 31UL + (unsigned char)buf[i];
+    }
+};
+
+// Multi-part form upload handler (file parts counted, or spilled to disk if spill path set)
+struct UploadHandler : kcc::IPageHandler
+{
+    kcc::String spill;
+    void onHandle(
+        const kcc::HTTPRequest& request, 
+        kcc::IPageReader* in, 
+        kcc::IPageWriter* out, 
+        kcc::IPageResponse* response)
+    {
+        kcc::Log::Scope scope(KCC_FILE, "UploadHandler::onHandle");
+        kcc::StringStream xml;
+        kcc::DOMWriter w(xml);
+        w.start("Upload");
+        kcc::AutoPtr<kcc::IPageFormReader> form(in->beginForm(request.attributes));
+        kcc::IPageFormReader::Part part;
+        while (form->next(part))
+        {
+            const kcc::String& file = part.parameters["filename"];
+            w.start("Part");
+            w.attr("name", part.parameters["name"]);
+            if (file.empty())
+            {
+                kcc::String value;
+                form->read(value);
+                w.attr("value", value);
+            }
+            else if (!spill.empty())
+            {
+                kcc::String path(kcc::Platform::fsFullPath(spill, file));
+                kcc::Platform::File f;
+                bool ok = form->save(path) && kcc::Platform::fsFile(path, f);
+                w.attr("file", path);
+                w.attr("size", ok ? (long)f.size : -1L, "%ld");
+            }
+            else
+            {
+                UploadSink sink;
+                long sz = form->read(&sink);
+                w.attr("size", sz, "%ld");
+                w.attr("sum",  kcc::Strings::printf("%lu", sink.sum));
+            }
+            w.end("Part");
+        }
+        w.end("Upload");
+        out->xml(xml);
+    }
+};
+
+// upload: benchmark multi-part upload throughput (local client posting generated file parts)
+static bool upload(const kcc::String& host, int port, long mb, long uploads)
+{
+    static const kcc::String k_boundary("----kccUploadBoundary7d93b1");
+    static const int         k_block = 1024*64;
+
+    // payload block: boundary-like runs force the parser to test and reject partial delimiters
+    kcc::String block;
+    block.reserve(k_block);
+    for (int i = 0; (int)block.size() < k_block; i++)
+    {
+        if (i % 97 == 0) block += "\r\n--" + k_boundary.substr(0, i % k_boundary.size());
+        block += (char)('a' + i % 26);
+    }
+    block.resize(k_block);
+    long blocks = mb * 16L;
+    unsigned long sum = 0UL;
+    for (long b = 0; b < blocks; b++)
+        for (int i = 0; i < k_block; i++) sum = sum * 31UL + (unsigned char)block[i];
+
+    // form
+    kcc::String head(
+        "--" + k_boundary + "\r\n"
+        "Content-Disposition: form-data; name=\"title\"\r\n\r\n"
+        "upload benchmark\r\n"
+        "--" + k_boundary + "\r\n"
+        "Content-Disposition: form-data; name=\"file\"; filename=\"upload.bin\"\r\n"
+        "Content-Type: application/octet-stream\r\n\r\n");
+    kcc::String tail("\r\n--" + k_boundary + "--\r\n");
+    long length = (long)head.size() + blocks * k_block + (long)tail.size();
+    kcc::String request(kcc::Strings::printf(
+        "POST /upload HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n"
+        "Content-Type: multipart/form-data; boundary=%s\r\nContent-Length: %ld\r\n\r\n",
+        host.c_str(), k_boundary.c_str(), length));
+
+    bool ok = true;
+    kcc::Timer t;
+    t.start();
+    for (long u = 0; u < uploads && ok; u++)
+    {
+        kcc::Socket s(host, port);
+        s.connect();
+        s.write(request);
+        s.write(head);
+        for (long b = 0; b < blocks; b++) s.write(block.data(), k_block);
+        s.write(tail);
+
+        // response: expect file size and checksum
+        kcc::String response;
+        char buf[4096];
+        int actual = 0;
+        do
+        {
+            s.read(buf, sizeof(buf), actual);
+            response.append(buf, actual);
+        } while (actual > 0);
+        kcc::String expected(kcc::Strings::printf("size='%ld'", blocks * k_block));
+        if (response.find(" sum='") != kcc::String::npos) expected += kcc::Strings::printf(" sum='%lu'", sum); // not spilled
+        ok = response.find(expected) != kcc::String::npos;
+        if (!ok) std::cout << "upload failed: expected [" << expected << "] response:" << std::endl << response << std::endl;
+    }
+    t.stop();
+    double secs = t.secs();
+    std::cout << kcc::Strings::printf(
+        "upload: uploads=[%ld] mb=[%ld] secs=[%.3f] rate=[%.1f MB/s] ok=[%d]", 
+        uploads, mb, secs, secs > 0.0 ? (double)(mb * uploads) / secs : 0.0, ok) << std::endl;
+    return ok;
+}
+
 int main(int argc, const char* argv[])
 {
     std::cout <<
         "page - Kuumba test page service." << std::endl << 
-        "page host=(host) port=(port) appPath=(path to app files)" << std::endl;
+        "page host=(host) port=(port) appPath=(path to app files) (spill=upload path)" << std::endl <<
+        "     (upload=MB uploads=n to benchmark multi-part uploads and exit)" << std::endl;
 
     // initialize kcc
     kcc::Properties props;
@@ -85,16 +215,26 @@ int main(int argc, const char* argv[])
         bool        remoteShutdown = props.get("remoteShutdown", KCC_PROPERTY_FALSE) == KCC_PROPERTY_TRUE;
         kcc::String page   (props.get("page",    "k_pageresponse"));
         kcc::String appPath(props.get("appPath", "../../../tst/page"));
+        long        uploadMB = props.get("upload",  0L);
+        long        uploads  = props.get("uploads", 3L);
         kcc::Log::out("page service @ %s:%d ['stop' to exit]", host.c_str(), port);
     
         // create handlers
         kcc::IHTTPServerFactory* httpFactory = KCC_FACTORY(kcc::IHTTPServerFactory, http);
-        kcc::AutoPtr<kcc::IHTTPResponseShutdown> shutdown;
+        kcc::PageResponseWrapper<kcc::IHTTPResponseShutdown> shutdown;
 
         // register handlers
         PageHandler pageHandler;
+        UploadHandler uploadHandler;
+        uploadHandler.spill = props.get("spill", kcc::Strings::empty());
         kcc::IPageResponse::Handlers handlers;
-        handlers["/"] = &pageHandler;
+        handlers["/"]       = &pageHandler;
+        handlers["/upload"] = &uploadHandler;
+        if (remoteShutdown)
+        {
+            shutdown.handler = httpFactory->constructShutdown();
+            handlers["/shutdown"] = &shutdown;
+        }
 
         // transforms
         kcc::StringMap xforms;
@@ -108,8 +248,6 @@ int main(int argc, const char* argv[])
 
         if (remoteShutdown)
         {
-            shutdown = httpFactory->constructShutdown();
-            handlers["/shutdown"] = shutdown;
             std::cout << "remote shutdown: dispatch '/shutdown' to shutdown" << std::endl;
         }
         else
@@ -123,8 +261,13 @@ int main(int argc, const char* argv[])
         s->init(host, port, dispatcher);
         s->start();
 
-        // run server until stopped
-        if (remoteShutdown) 
+        // run server until stopped (or upload benchmark completes)
+        bool ok = true;
+        if (uploadMB > 0L)
+        {
+            ok = upload(host, port, uploadMB, uploads);
+        }
+        else if (remoteShutdown) 
         {
             shutdown->waitForShutdown();
         }
@@ -139,6 +282,7 @@ int main(int argc, const char* argv[])
         std::cout.flush();
         s->stop();
         std::cout << "page service stopped" << std::endl;
+        if (!ok) return 1;
     }
     catch (std::exception& e)
     {
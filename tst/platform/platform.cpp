@@ -31,6 +31,76 @@ void fileList(const kcc::String& p)
     }
 }
 
+// Lock contention: threads share a small table, 1 in 10 operations updates it (exclusive)
+// and the rest read it (shared where the lock supports it)
+typedef std::map<long, long> Table;
+template<class _M> struct Locks
+{
+    typedef typename _M::Lock Shared;
+    typedef typename _M::Lock Exclusive;
+};
+template<> struct Locks<kcc::RWMutex>
+{
+    typedef kcc::RWMutex::SharedLock    Shared;
+    typedef kcc::RWMutex::ExclusiveLock Exclusive;
+};
+template<class _M> struct Contender : kcc::IThread
+{
+    _M&           m;
+    Table&        table;
+    long          n;
+    long          sum;
+    kcc::Monitor& start;
+    kcc::Monitor& done;
+    Contender(_M& _m, Table& t, long _n, kcc::Monitor& s, kcc::Monitor& d) 
+        : m(_m), table(t), n(_n), sum(0L), start(s), done(d) 
+    { 
+        done.init(); 
+    }
+    void invoke()
+    {
+        start.wait();
+        for (long i = 0; i < n; i++)
+        {
+            if (i % 10 == 0)
+            {
+                typename Locks<_M>::Exclusive lock(m);
+                table[i & 63]++;
+            }
+            else
+            {
+                typename Locks<_M>::Shared lock(m);
+                sum += table.find(i & 63)->second;
+            }
+        }
+        done.notify();
+    }
+};
+template<class _M> double contention(int threads, long n)
+{
+    _M m;
+    Table table;
+    for (long i = 0; i < 64; i++) table[i] = 0L;
+    kcc::Monitor start, done;
+    start.init();
+    std::vector<Contender<_M>*> contenders;
+    for (int i = 0; i < threads; i++)
+    {
+        contenders.push_back(new Contender<_M>(m, table, n / threads, start, done));
+        (new kcc::Thread(contenders.back(), "contender"))->go();
+    }
+    kcc::Timer t;
+    t.start();
+    start.notifyAll();
+    done.wait();
+    double time = t.now();
+    for (int i = 0; i < threads; i++) delete contenders[i];
+    long writes = 0L;
+    for (Table::iterator i = table.begin(); i != table.end(); i++) writes += i->second;
+    if (writes != threads * ((n / threads + 9L) / 10L)) throw kcc::Exception(kcc::Strings::printf("lock contention mismatch: writes=[%ld]", writes));
+    return time;
+}
+
 int main(int argc, const char* argv[])
 {
     kcc::Properties props;
@@ -92,6 +162,18 @@ int main(int argc, const char* argv[])
         FS_OK(" 15. fsFile",      kcc::Platform::fsFile(fp, where));
         fileOut(where);
 
+        std::cout << "testing lock contention" << std::endl;
+        long locks = props.get("locks", 1000000L);
+        for (int threads = 1; threads <= props.get("lockThreads", 32L); threads *= 2)
+        {
+            double mutex = contention<kcc::Mutex>    (threads, locks);
+            double spin  = contention<kcc::SpinMutex>(threads, locks);
+            double rw    = contention<kcc::RWMutex>  (threads, locks);
+            std::cout << kcc::Strings::printf(
+                "threads: %2d  Mutex: %.3fs  SpinMutex: %.3fs  RWMutex: %.3fs (%ld locks)", 
+                threads, mutex, spin, rw, locks) << std::endl;
+        }
+
         kcc::Log::out("completed platform testing");
     }
     catch (std::exception& e)
@@ -12,6 +12,28 @@ void dump(const kcc::String& subj, kcc::StringMap& p)
     kcc::Log::out(out.str());
 }
 
+// Interned header & parameter keys
+static const kcc::Dictionary::Key k_connection   ("Connection");
+static const kcc::Dictionary::Key k_contentLength("Content-Length");
+static const kcc::Dictionary::Key k_contentType  ("Content-Type");
+static const kcc::Dictionary::Key k_cookie       ("Cookie");
+static const kcc::Dictionary::Key k_expr         ("expr");
+static const kcc::Dictionary::Key k_max          ("max");
+
+// HTTP request header (typical browser request)
+static const kcc::String k_header(
+    "GET /query?expr=hotel+OR+travel&max=25&contents=9&id=1f HTTP/1.1\r\n"
+    "Host: localhost:5901\r\n"
+    "User-Agent: Mozilla/5.0 (X11; U; Linux i686; en-US; rv:1.8.1.13) Gecko/20080325 Firefox/2.0.0.13\r\n"
+    "Accept: text/xml,application/xml,application/xhtml+xml,text/html;q=0.9,text/plain;q=0.8,*/*;q=0.5\r\n"
+    "Accept-Language: en-us,en;q=0.5\r\n"
+    "Accept-Encoding: gzip,deflate\r\n"
+    "Accept-Charset: ISO-8859-1,utf-8;q=0.7,*;q=0.7\r\n"
+    "Keep-Alive: 300\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: session=4f2a9c; theme=plain\r\n"
+    "Cache-Control: max-age=0");
+
 int main(int argc, const char* argv[])
 {
     kcc::Properties props;
@@ -48,6 +70,95 @@ int main(int argc, const char* argv[])
         bool match = p1 == p2 && p2 == p1;
         kcc::Log::out("properties == xml: %s", (match ? "yes" : "no"));
 
+        // header parse & lookup
+        long n = props.get("iterations", 100000L);
+        kcc::Timer tp, tl, tk;
+        long found = 0L, foundKeys = 0L;
+        for (long i = 0; i < n; i++)
+        {
+            kcc::HTTPRequest request;
+            tp.start();
+            kcc::HTTP::request(k_header, kcc::Strings::empty(), request);
+            tp.stop();
+            tl.start();
+            if (!request.attributes["Connection"].empty())     found++;
+            if (!request.attributes["Content-Length"].empty()) found++;
+            if (!request.attributes["Content-Type"].empty())   found++;
+            if (!request.attributes["Cookie"].empty())         found++;
+            if (!request.parameters["expr"].empty())           found++;
+            if (!request.parameters["max"].empty())            found++;
+            tl.stop();
+            tk.start();
+            if (!request.attributes[k_connection].empty())    foundKeys++;
+            if (!request.attributes[k_contentLength].empty()) foundKeys++;
+            if (!request.attributes[k_contentType].empty())   foundKeys++;
+            if (!request.attributes[k_cookie].empty())        foundKeys++;
+            if (!request.parameters[k_expr].empty())          foundKeys++;
+            if (!request.parameters[k_max].empty())           foundKeys++;
+            tk.stop();
+        }
+        kcc::Log::out("header parse:  %.3fs (%d requests)", tp.secs(), n);
+        kcc::Log::out("header lookup: %.3fs (%d found)", tl.secs(), found);
+        kcc::Log::out("header keys:   %.3fs (%d found)", tk.secs(), foundKeys);
+
+        // case-insensitive headers, multiple values
+        kcc::HTTPRequest request;
+        kcc::HTTP::request(k_header, kcc::Strings::empty(), request);
+        kcc::Dictionary d(request.parameters);
+        d.insert(std::make_pair(kcc::String("max"), kcc::String("50")));
+        d("id") = "2f";
+        bool headers =
+            request.attributes["connection"] == "keep-alive" &&
+            request.attributes["ACCEPT-ENCODING"] == "gzip,deflate" &&
+            !request.parameters.exists("EXPR") &&
+            d.count("max") == 2 && d.count("id") == 2 && d.size() == 6 &&
+            d.finder("max").first->second == "25" && (++d.finder("max").first)->second == "50";
+        d.erase("max");
+        headers = headers && !d.exists("max") && d["id"] == "1f" && d.size() == 4;
+        kcc::HTTPRequest framed;
+        kcc::HTTP::request("POST / HTTP/1.1\r\ncontent-length:7\r\nTRANSFER-ENCODING: \t chunked", kcc::Strings::empty(), framed);
+        headers = headers && 
+            framed.attributes[k_contentLength] == "7" && kcc::HTTP::contentLength(framed.attributes) == kcc::HTTP::F_CHUNKED;
+        kcc::Log::out("headers case-insensitive, parameters multi-valued: %s", (headers ? "yes" : "no"));
+
+        // interleaved duplicates (insert into earlier group), erase by iterator, stable references
+        kcc::Dictionary dup;
+        kcc::Timer td;
+        td.start();
+        for (long i = 0; i < n; i++) dup.insert(std::make_pair(kcc::String(i % 2 == 0 ? "a" : "b"), kcc::Strings::printf("%d", i)));
+        const kcc::String& a0 = dup["a"];
+        for (kcc::Dictionary::iterator i = dup.begin(); i != dup.end(); )
+        {
+            kcc::Dictionary::iterator e = i++;
+            if (e->first == "b") dup.erase(e);
+        }
+        td.stop();
+        props.set("dictionary.reference", "stable");
+        bool duplicates =
+            dup.count("a") == (kcc::Dictionary::size_type)((n + 1) / 2) && !dup.exists("b") &&
+            &a0 == &dup["a"] && a0 == "0" && props.get("dictionary.reference", "") == "stable";
+        kcc::Log::out("duplicates:    %.3fs (%d pairs, grouped & stable: %s)", td.secs(), n, (duplicates ? "yes" : "no"));
+
+        // property lookup
+        const kcc::Properties& config = kcc::Core::properties();
+        kcc::Timer tg;
+        long sum = 0L;
+        tg.start();
+        for (long i = 0; i < n * 10L; i++) sum += config.get("kcc.logMax", 0L);
+        tg.stop();
+        kcc::Log::out("property get:  %.3fs (%d)", tg.secs(), sum);
+        kcc::PropertyLong logMax(config, "kcc.logMax", 0L);
+        kcc::Timer th;
+        sum = 0L;
+        th.start();
+        for (long i = 0; i < n * 10L; i++) sum += logMax();
+        th.stop();
+        kcc::Log::out("property handle: %.3fs (%d)", th.secs(), sum);
+        kcc::PropertyBool   missing(config, "kcc.missing", true);
+        kcc::PropertyString name   (config, "kcc.LogName", "");
+        bool handles = missing() && name() == KCC_FILE && logMax() == 1L;
+        kcc::Log::out("property handles resolved: %s", (handles ? "yes" : "no"));
+
         kcc::Log::out("\ncompleted properties testing");
     }
     catch (std::exception& e)
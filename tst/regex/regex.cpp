@@ -24,12 +24,49 @@ void match(const kcc::String& expr, const kcc::String& target)
     }
 }
 
+// Cached expression matcher: matches targets of distinct expressions, counting mismatches
+struct Matcher : kcc::IThread
+{
+    long          n;
+    int           exprs;
+    long          failed;
+    kcc::Monitor& done;
+    Matcher(long _n, int _exprs, kcc::Monitor& d) : n(_n), exprs(_exprs), failed(0L), done(d) { done.init(); }
+    void invoke()
+    {
+        kcc::IRegex* rx = kcc::Core::regex();
+        for (long i = 0L; i < n; i++)
+        {
+            int x = (int)(i % exprs);
+            kcc::String expr(kcc::Strings::printf("^item(%d)$", x));
+            if (!rx->match(kcc::Strings::printf("item%d", x), expr)) failed++;
+            if ( rx->match(kcc::Strings::printf("item%d", x + 1), expr)) failed++;
+        }
+        done.notify();
+    }
+};
+
+// cacheStatus: log regex cache statistics
+void cacheStatus(const kcc::Char* what)
+{
+    kcc::RegexCacheStatistics stats;
+    kcc::Core::regex()->cacheStatistics(stats);
+    long lookups = stats.frontHits + stats.hits + stats.misses;
+    kcc::Log::out(
+        "cache %s: entries=[%d] max=[%d] frontHits=[%d] hits=[%d] misses=[%d] evictions=[%d] pinned=[%d] hitRatio=[%.3f]",
+        what, stats.entries, stats.max, stats.frontHits, stats.hits, stats.misses, stats.evictions, stats.pinned,
+        lookups > 0L ? (double)(stats.frontHits + stats.hits) / lookups : 0.0);
+}
+
 int main(int argc, const char** argv)
 {
     kcc::Properties props;
     props.set("kcc.logName",      KCC_FILE);
     props.set("kcc.logMax",       1L);
     props.set("kcc.logVerbosity", (long) kcc::Log::V_INFO_3);
+    props.set(KCC_REGEX_CACHEMAX, 16L);
+    props.set("passes",           200000L);
+    props.set("threads",          4L);
     if(argc > 1) props.load(argc, argv, false);
     kcc::Core::init(props, KCC_VERSION);
 
@@ -122,6 +159,84 @@ int main(int argc, const char** argv)
         rx->replace(sub, rx1);
         rx->replace(sub, rx2);
         kcc::Log::out("[%s]", sub.c_str());
+
+        //
+        // regex: cache
+        //
+
+        kcc::Log::out("\n---rx cache");
+        cacheStatus("begin");
+        kcc::RegexCacheStatistics stats;
+        rx->cacheStatistics(stats);
+        long max = stats.max;
+
+        // evicts least recently used expressions beyond cache max
+        for (long i = 0L; i < max * 2L; i++)
+        {
+            if (!rx->match(kcc::Strings::printf("x%d", i), kcc::Strings::printf("^x%d$", i)))
+                throw kcc::Exception("cached expression failed to match");
+        }
+        rx->cacheStatistics(stats);
+        if (stats.entries > max || stats.evictions < max) throw kcc::Exception("regex cache not bounded");
+        cacheStatus("after evicting");
+
+        // expression handle is pinned (not evicted) until flushed
+        kcc::IRegexExpression* pinned = rx->expression("^(p+)inned$", kcc::IRegex::O_NORMAL);
+        if (pinned != rx->expression("^(p+)inned$", kcc::IRegex::O_NORMAL)) throw kcc::Exception("expression not pinned");
+        for (long i = 0L; i < max * 2L; i++) rx->match("y", kcc::Strings::printf("^y%d$", i));
+        if (!pinned->match("pppinned", parts) || kcc::String(parts[0].first, parts[0].second) != "ppp") 
+            throw kcc::Exception("pinned expression failed to match");
+        kcc::Log::out("pinned: id=[%s] expression=[%s]", pinned->id().c_str(), pinned->expression().c_str());
+        rx->flush(pinned);
+        rx->cacheStatistics(stats);
+        if (stats.pinned != 0L) throw kcc::Exception("flushed expression still pinned");
+
+        // expressions hashing alike are still distinct
+        if (!rx->match("abc", "b") || rx->match("ABC", "b") || !rx->match("ABC", "b", kcc::IRegex::O_NORMAL|kcc::IRegex::O_ICASE))
+            throw kcc::Exception("expression options not distinct");
+
+        // hot expressions served by the thread front cache; front cache invalidated by flush
+        kcc::Timer tCached;
+        long passes = props.get("passes", 0L);
+        tCached.start();
+        for (long i = 0L; i < passes; i++) rx->match("word 1234", i % 2 == 0 ? "\\d+" : "^\\w+");
+        tCached.stop();
+        kcc::IRegexExpression* handle = rx->expression("\\d+", kcc::IRegex::O_NORMAL);
+        kcc::Timer tHandle;
+        tHandle.start();
+        for (long i = 0L; i < passes; i++) handle->match("word 1234");
+        tHandle.stop();
+        rx->flushAll();
+        if (!rx->match("word 1234", "\\d+")) throw kcc::Exception("flushed expression failed to match");
+        kcc::Log::out(
+            "cached match: passes=[%d] cached=[%.3fs %.0f/s] expression=[%.3fs %.0f/s]", 
+            passes, 
+            tCached.secs(), tCached.secs() > 0.0 ? passes / tCached.secs() : 0.0,
+            tHandle.secs(), tHandle.secs() > 0.0 ? passes / tHandle.secs() : 0.0);
+        cacheStatus("after hot expressions");
+
+        // concurrent matching through front caches smaller than working set
+        long threads = props.get("threads", 0L);
+        std::vector<Matcher*> matchers;
+        kcc::Monitor done;
+        kcc::Timer tThreads;
+        tThreads.start();
+        for (long i = 0L; i < threads; i++)
+        {
+            matchers.push_back(new Matcher(passes / threads, 12, done));
+            (new kcc::Thread(matchers.back(), "matcher"))->go();
+        }
+        done.wait();
+        tThreads.stop();
+        long failed = 0L;
+        for (std::vector<Matcher*>::iterator m = matchers.begin(); m != matchers.end(); m++)
+        {
+            failed += (*m)->failed;
+            delete *m;
+        }
+        if (failed > 0L) throw kcc::Exception(kcc::Strings::printf("concurrent matches failed: failed=[%d]", failed));
+        kcc::Log::out("concurrent match: threads=[%d] matches=[%d] time=[%.3fs]", threads, passes * 2L, tThreads.secs());
+        cacheStatus("after concurrent matching");
     }
     catch (std::exception& e)
     {
@@ -3,6 +3,26 @@
 #define KCC_FILE    "string"
 #define KCC_VERSION "$Id: string.cpp 21778 2007-12-27 00:55:36Z tvk $"
 
+// rxTokenize: regex tokenizer (reference for Strings::tokenize)
+void rxTokenize(const kcc::String& text, kcc::StringVector& tokens, const kcc::StringSet& stoplist, kcc::Strings::TokenOptions ops)
+{
+    kcc::IRegex* rx = kcc::Core::regex();
+    kcc::StringVector split;
+    rx->split(text, "\\s+", split);
+    tokens.clear();
+    for (kcc::StringVector::size_type i = 0; i < split.size(); i++)
+    {
+        kcc::String& c = split[i];
+        if ((ops & kcc::Strings::TF_TRIM)      != 0) kcc::Strings::trim(c);
+        if ((ops & kcc::Strings::TF_LOWERCASE) != 0) kcc::Strings::toLower(c);
+        if ((ops & kcc::Strings::TF_BLANKS)    != 0 && !rx->match(c, "\\w"))               continue;
+        if ((ops & kcc::Strings::TF_STOPLIST)  != 0 && stoplist.find(c) != stoplist.end()) continue;
+        if ((ops & kcc::Strings::TF_DECIMALS)  != 0 && rx->match(c, "^\\d$"))             continue;
+        if ((ops & kcc::Strings::TF_FRACTIONS) != 0 && rx->match(c, "^\\d.*\\d$"))       continue;
+        tokens.push_back(c);
+    }
+}
+
 int main(int argc, const char* argv[])
 {
     kcc::Properties props;
@@ -257,6 +277,82 @@ int main(int argc, const char* argv[])
             "\n---select value=[%s] expr=[%s] def=[%s] match=[%d]", 
             val.c_str(), exp.c_str(), SELDEF(sd), kcc::Strings::select(val, exp, sd));
 
+        //
+        // tokenize text: differential (regex reference) & throughput
+        //
+
+        kcc::StringSet stopset;
+        kcc::StringVector stopwords;
+        kcc::Strings::tokenize("a an and are as at be but by for if in into is it no not of on or s such t that the their then there these they this to was will with", " ", stopwords);
+        stopset.insert(stopwords.begin(), stopwords.end());
+        kcc::StringHashSet stophash(stopset);
+
+        kcc::StringVector corpus;
+        {
+            std::ifstream in(props.get("corpus", "../../../tst/textstore/test.csv").c_str());
+            kcc::String line;
+            while (std::getline(in, line)) corpus.push_back(line);
+        }
+        kcc::String bytes("0 1 22 3.4 _ -- 9x x9 \t\v\f\r\n");
+        for (int c = 1; c < 256; c++) 
+        {
+            bytes += (kcc::Char)c;
+            if (c % 7 == 0) bytes += ' ';
+        }
+        corpus.push_back(bytes);
+        kcc::Log::out("\n---tokenize text: corpus lines=[%d]", corpus.size());
+
+        kcc::Strings::TokenOptions options[] = 
+        {
+            kcc::Strings::TF_NONE, kcc::Strings::TF_TRIM, kcc::Strings::TF_LOWERCASE, kcc::Strings::TF_BLANKS,
+            kcc::Strings::TF_STOPLIST, kcc::Strings::TF_DECIMALS, kcc::Strings::TF_FRACTIONS, 
+            kcc::Strings::TF_BLANKS|kcc::Strings::TF_DECIMALS|kcc::Strings::TF_FRACTIONS,
+            kcc::Strings::TF_ALL
+        };
+        long differences = 0L, compared = 0L;
+        kcc::StringVector expected, actual;
+        for (std::size_t o = 0; o < sizeof(options)/sizeof(options[0]); o++)
+        {
+            for (kcc::StringVector::iterator i = corpus.begin(); i != corpus.end(); i++)
+            {
+                rxTokenize(*i, expected, stopset, options[o]);
+                kcc::Strings::tokenize(*i, actual, stopset, options[o]);
+                if (actual != expected) differences++;
+                kcc::Strings::tokenize(*i, actual, stophash, options[o]);
+                if (actual != expected) differences++;
+                compared += (long)expected.size();
+            }
+        }
+        if (differences != 0L) throw kcc::Exception(kcc::Strings::printf("tokenize differs from regex tokenizer: lines=[%ld]", differences));
+        kcc::Log::out("tokenize matches regex tokenizer: tokens=[%ld]", compared);
+
+        long passes = props.get("passes", 5L);
+        long bytesIn = 0L, tokensOut = 0L;
+        kcc::Timer rxTimer, tableTimer;
+        rxTimer.start();
+        for (long p = 0; p < passes; p++)
+        {
+            for (kcc::StringVector::iterator i = corpus.begin(); i != corpus.end(); i++) 
+            {
+                rxTokenize(*i, expected, stopset, kcc::Strings::TF_ALL);
+                bytesIn   += (long)i->size();
+                tokensOut += (long)expected.size();
+            }
+        }
+        double rxTime = rxTimer.now();
+        tableTimer.start();
+        for (long p = 0; p < passes; p++)
+        {
+            for (kcc::StringVector::iterator i = corpus.begin(); i != corpus.end(); i++) 
+                kcc::Strings::tokenize(*i, actual, stophash, kcc::Strings::TF_ALL);
+        }
+        double tableTime = tableTimer.now();
+        kcc::Log::out(
+            "tokenize throughput: regex=[%.3fs %.1fMB/s] table=[%.3fs %.1fMB/s] tokens=[%ld]",
+            rxTime,    bytesIn / 1048576.0 / (rxTime    > 0.0 ? rxTime    : 0.001),
+            tableTime, bytesIn / 1048576.0 / (tableTime > 0.0 ? tableTime : 0.001),
+            tokensOut);
+
         // done
         kcc::Log::out("\ncompleted string testing");
     }
@@ -1,5 +1,10 @@
 #include <inc/core/Core.h>
+#include <inc/inet/IHTTP.h>
 #include <inc/store/ITextStore.h>
+#include <inc/store/TextQueryXml.h>
+#include <inc/store/TextQueryRest.h>
+#include <inc/store/TextQueryBinary.h>
+#include <inc/store/TextQueryXmlCodec.h>
 
 #define KCC_FILE    "textquery"
 #define KCC_VERSION "$Id: textquery.cpp 15199 2007-03-09 17:57:17Z tvk $"
@@ -10,13 +15,14 @@ void results(kcc::ITextQuery* query, const kcc::String& expression)
     kcc::Log::out("textquery: expr=[%s]", expression.c_str());
     long rows = 0L;
     kcc::TextDocument txtdoc;
-    kcc::AutoPtr<kcc::ITextResults> tr(query->query(expression, kcc::TextDocument::C_ALL));
+    kcc::AutoPtr<kcc::ITextResults> tr(query->query(
+        expression, kcc::TextDocument::C_TEXT|kcc::TextDocument::C_METADATA|kcc::TextDocument::C_TERMS));
     while (tr->next())
     {
         tr->results(txtdoc);
 
         // dump results
-        std::cout << "\nresults \n[\nmetadata: ";
+        std::cout << "\nresults \n[\nscore: " << txtdoc.score << "\nmetadata: ";
         for (kcc::StringMap::iterator i = txtdoc.metadata.begin(); i != txtdoc.metadata.end(); i++)
         {
             if (i != txtdoc.metadata.begin()) std::cout << ", ";
@@ -35,26 +41,150 @@ void results(kcc::ITextQuery* query, const kcc::String& expression)
     std::cout << "\nrows: received=[" << rows << "] actual=[" << tr->total() << "]\n";
 }
 
+// Canned query shard: pages of documents with raw scores normalized to the shard's top score
+struct QueryShard : kcc::IHTTPResponse
+{
+    kcc::String         name;
+    std::vector<double> raw; // descending
+    double              scale;
+    QueryShard(const kcc::String& n, const double* scores, long sz) : name(n), raw(scores, scores + sz), scale(std::max(1.0, scores[0])) {}
+    void onResponse(const kcc::HTTPRequest& request, kcc::IHTTPRequestReader* in, kcc::IHTTPResponseWriter* out)
+    {
+        const kcc::String& strRow = request.parameters[kcc::TextQueryRest::queryRow()];
+        const kcc::String& strMax = request.parameters[kcc::TextQueryRest::queryMax()];
+        long row   = strRow.empty() ? 0L  : kcc::Strings::parseInteger(strRow);
+        long max   = strMax.empty() ? 25L : kcc::Strings::parseInteger(strMax);
+        long total = (long)raw.size();
+        if (row < 0L || row > total) row = total;
+        long end = std::min(total, row + max);
+        kcc::TextQueryBinary::Status status;
+        status.id    = name;
+        status.row   = row;
+        status.size  = end - row;
+        status.total = total;
+        status.scale = scale;
+        kcc::StringStream buf;
+        if (request.parameters[kcc::TextQueryRest::queryFormat()] == kcc::TextQueryRest::queryFormatBinary())
+        {
+            kcc::String bin;
+            kcc::TextQueryBinary::Writer w(bin);
+            for (long i = row; i < end; i++) w.document(i, document(i));
+            w.status(status);
+            buf.write(bin.data(), bin.size());
+            kcc::Dictionary headers;
+            kcc::HTTP::setHeaders(headers, kcc::TextQueryBinary::contentType(), true);
+            out->response(buf, headers);
+            return;
+        }
+        kcc::DOMWriter w(buf);
+        w.start(kcc::TextQueryXml::root());
+        for (long i = row; i < end; i++) kcc::TextQueryXmlCodec::document(w, i, document(i));
+        w.start(kcc::TextQueryXml::status());
+        w.attr(kcc::TextQueryXml::statusId(),    status.id);
+        w.attr(kcc::TextQueryXml::statusRow(),   kcc::Strings::printf("%d", status.row));
+        w.attr(kcc::TextQueryXml::statusSize(),  kcc::Strings::printf("%d", status.size));
+        w.attr(kcc::TextQueryXml::statusTotal(), kcc::Strings::printf("%d", status.total));
+        w.attr(kcc::TextQueryXml::statusScale(), kcc::Strings::printf("%.9g", status.scale));
+        w.end(kcc::TextQueryXml::status());
+        w.end(kcc::TextQueryXml::root());
+        out->xml(buf);
+    }
+    kcc::TextDocument document(long i)
+    {
+        kcc::TextDocument doc;
+        doc.metadata["id"] = kcc::Strings::printf("%s%d", name.c_str(), i);
+        doc.score          = raw[i] / scale;
+        return doc;
+    }
+};
+
+// merge: query two shards of different score scales, checking documents arrive in raw score order
+bool merge(const kcc::String& host, int port, bool binary) throw (kcc::Exception)
+{
+    kcc::Log::Scope scope(KCC_FILE, "merge");
+    static const double      k_a[]      = { 4.0, 2.0, 1.0, 0.5 }; // scale 4: normalized 1.0, 0.5, 0.25, 0.125
+    static const double      k_b[]      = { 0.9, 0.8, 0.3 };      // scale 1: normalized as is
+    static const kcc::Char*  k_merged[] = { "a0", "a1", "a2", "b0", "b1", "a3", "b2" };
+    static const double      k_raw[]    = { 4.0,  2.0,  1.0,  0.9,  0.8,  0.5,  0.3 };
+
+    // shard services
+    kcc::IHTTPServerFactory* httpFactory = KCC_FACTORY(kcc::IHTTPServerFactory, "k_httpserver");
+    QueryShard a("a", k_a, 4L), b("b", k_b, 3L);
+    QueryShard* shards[] = { &a, &b };
+    kcc::AutoPtr<kcc::IHTTPResponseDispatcher> dispatchers[2];
+    kcc::AutoPtr<kcc::IHTTPServer>             servers[2];
+    kcc::String                                connections;
+    for (int i = 0; i < 2; i++)
+    {
+        dispatchers[i] = httpFactory->constructDispatcher();
+        dispatchers[i]->handlers()[kcc::TextQueryRest::query()] = shards[i];
+        servers[i] = httpFactory->constructServer();
+        servers[i]->init(host, port + i, dispatchers[i]);
+        servers[i]->start();
+        if (i > 0) connections += ",";
+        connections += kcc::Strings::printf("%s:%d", host.c_str(), port + i);
+    }
+
+    // merged query (pages smaller than shards so merge crosses shard windows)
+    bool ordered = true;
+    {
+        kcc::Properties queryConfig;
+        queryConfig.set("TextQueryClient.connections", connections);
+        queryConfig.set("TextQueryClient.maxDocs",     2L);
+        queryConfig.set("TextQueryClient.format",      binary ? kcc::TextQueryRest::queryFormatBinary() : kcc::String("xml"));
+        kcc::AutoPtr<kcc::ITextQuery> query(KCC_COMPONENT(kcc::ITextQuery, "k_textqueryclient"));
+        query->init(queryConfig);
+        kcc::AutoPtr<kcc::ITextResults> tr(query->query("merge"));
+        long rows = 0L;
+        kcc::TextDocument txtdoc;
+        ordered = tr->total() == 7L && tr->scale() == 4.0;
+        while (tr->next())
+        {
+            tr->results(txtdoc);
+            double raw = txtdoc.score * tr->scale();
+            std::cout << "merge: row=[" << rows << "] id=[" << txtdoc.metadata["id"] << "] raw=[" << raw << "]\n";
+            ordered = ordered && rows < 7L && txtdoc.metadata["id"] == k_merged[rows] && std::fabs(raw - k_raw[rows]) < 1e-5;
+            rows++;
+        }
+        ordered = ordered && rows == 7L;
+    }
+    for (int i = 0; i < 2; i++) servers[i]->stop();
+    std::cout << "merge: format=[" << (binary ? "binary" : "xml") << "] raw score order=[" << (ordered ? "yes" : "no") << "]\n";
+    return ordered;
+}
+
 int main(int argc, const char* argv[])
 {
     kcc::Properties props;
     props.set("kcc.logVerbosity", (long) kcc::Log::V_INFO_3);
     props.set("kcc.logMax",       1L);
     props.set("kcc.logName",      KCC_FILE);
+    props.set("HTTPServer.keepAliveMax", 1L); // merge shards: no handler outlives its server
     if (argc > 1) props.load(argc, argv, false);
     kcc::Core::init(props, KCC_VERSION);
 
     kcc::String host(props.get("host", "localhost:8080"));
     kcc::String expr(props.get("expr", "travelocity AND (orbitz OR expedia)"));
+    kcc::String action(props.get("action", "query"));
 
     kcc::Log::Scope scope(KCC_FILE, "main");
     try
     {
-        kcc::Properties queryConfig;
-        queryConfig.set("TextQueryClient.connections", host);
-        kcc::AutoPtr<kcc::ITextQuery> query(KCC_COMPONENT(kcc::ITextQuery, "k_textqueryclient"));
-        query->init(queryConfig);
-        results(query, expr);
+        if (action == "merge")
+        {
+            // shards served locally from port (xml on port, port+1; binary on port+2, port+3)
+            int port = kcc::Strings::parseInteger(props.get("port", "5970"));
+            if (!merge("127.0.0.1", port, false) || !merge("127.0.0.1", port + 2, true)) 
+                throw kcc::Exception("shard results not merged in raw score order");
+        }
+        else
+        {
+            kcc::Properties queryConfig;
+            queryConfig.set("TextQueryClient.connections", host);
+            kcc::AutoPtr<kcc::ITextQuery> query(KCC_COMPONENT(kcc::ITextQuery, "k_textqueryclient"));
+            query->init(queryConfig);
+            results(query, expr);
+        }
     }
     catch (std::exception& e)
     {
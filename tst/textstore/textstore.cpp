@@ -1,10 +1,26 @@
 #include <inc/core/Core.h>
 #include <inc/store/ITextStore.h>
+#include <inc/store/TextQueryXml.h>
+#include <inc/store/TextQueryBinary.h>
+#include <inc/store/TextQueryXmlCodec.h>
 
 #define KCC_FILE    "textstore"
 #define KCC_VERSION "$Id: textstore.cpp 23042 2008-04-07 20:10:40Z tvk $"
 
-bool indexDocument(kcc::ITextStore* store, const kcc::String& line) throw (kcc::TextException)
+const kcc::TextDocument::MetadataFields& csvFields()
+{
+    static kcc::TextDocument::MetadataFields fields;
+    if (fields.empty())
+    {
+        fields["id"]        = kcc::TextDocument::MD_ENUM;
+        fields["md5"]       = kcc::TextDocument::MD_ENUM;
+        fields["date_enum"] = kcc::TextDocument::MD_ENUM;
+        fields["date_text"] = kcc::TextDocument::MD_TEXT;
+    }
+    return fields;
+}
+
+bool csvDocument(const kcc::String& line, long pass, kcc::TextDocument& txtdoc)
 {
     int yr = 0, mo = 0, dy = 0;
     kcc::StringVector csv;
@@ -12,44 +28,82 @@ bool indexDocument(kcc::ITextStore* store, const kcc::String& line) throw (kcc::
     if (csv.size() != 3) return false;
     std::sscanf(csv[2].c_str(), "%d/%d/%d", &mo, &dy, &yr);
     kcc::ISODate date(yr, mo, dy);
-    kcc::TextDocument txtdoc;
+    txtdoc.clear();
     txtdoc.text                  = csv[1];
-    txtdoc.metadata["id"]        = csv[0];
+    txtdoc.metadata["id"]        = pass == 0L ? csv[0] : csv[0] + "." + kcc::Strings::printf("%ld", pass);
     txtdoc.metadata["md5"]       = kcc::MD5::hash(txtdoc.text);
     txtdoc.metadata["date_enum"] = date.isodate();
     txtdoc.metadata["date_text"] = date.isodate();
-    static kcc::TextDocument::MetadataFields fields;
-    if (fields.empty())
-    {
-        fields["id"]        = kcc::TextDocument::MD_ENUM;
-        fields["md5"]       = kcc::TextDocument::MD_ENUM;
-        fields["date_enum"] = kcc::TextDocument::MD_ENUM;
-        fields["date_text"] = kcc::TextDocument::MD_TEXT;
-    }
-    store->indexText(
-        txtdoc, fields, 
-        kcc::TextDocument::C_TEXT|kcc::TextDocument::C_METADATA|kcc::TextDocument::C_TERMS);
     return true;
 }
 
-void index(kcc::ITextStore* store, const kcc::String& input, long maxDocs) throw (kcc::TextException)
+kcc::TextDocument::Contents k_csvContents = 
+    kcc::TextDocument::C_TEXT|kcc::TextDocument::C_METADATA|kcc::TextDocument::C_TERMS;
+
+void index(kcc::ITextStore* store, const kcc::String& input, long maxDocs, long scale) throw (kcc::TextException)
 {
     kcc::Log::Scope scope(KCC_FILE, "index");
     long total = 0L;
     kcc::String line;
+    kcc::TextDocument txtdoc;
+    kcc::Timer t;
+    t.start();
     store->indexOpen();
-    std::ifstream in(input.c_str());
-    while (!in.eof() && in.good())
+    for (long pass = 0L; pass < scale && (maxDocs <= 0L || total < maxDocs); pass++)
     {
-        std::getline(in, line);
-        if (indexDocument(store, line))
+        std::ifstream in(input.c_str());
+        while (!in.eof() && in.good())
         {
-            total++;
-            if (maxDocs > 0L && total >= maxDocs) break;
+            std::getline(in, line);
+            if (csvDocument(line, pass, txtdoc))
+            {
+                store->indexText(txtdoc, csvFields(), k_csvContents);
+                total++;
+                if (maxDocs > 0L && total >= maxDocs) break;
+            }
         }
+        in.close();
     }
-    in.close();
     store->indexClose();
+    t.stop();
+    std::cout << "insert: docs=[" << total << "] secs=[" << t.secs() << "] docs/sec=[" << (long)(total / std::max(t.secs(), 0.001)) << "]\n";
+}
+
+void bulk(kcc::ITextStore* store, const kcc::String& input, long maxDocs, long scale, long batch) throw (kcc::TextException)
+{
+    kcc::Log::Scope scope(KCC_FILE, "bulk");
+    long total = 0L;
+    kcc::String line;
+    kcc::TextDocuments txtdocs;
+    txtdocs.reserve(batch);
+    kcc::TextDocument txtdoc;
+    kcc::Timer t;
+    t.start();
+    store->indexOpen();
+    for (long pass = 0L; pass < scale && (maxDocs <= 0L || total < maxDocs); pass++)
+    {
+        std::ifstream in(input.c_str());
+        while (!in.eof() && in.good())
+        {
+            std::getline(in, line);
+            if (csvDocument(line, pass, txtdoc))
+            {
+                txtdocs.push_back(txtdoc);
+                total++;
+                if ((long)txtdocs.size() >= batch)
+                {
+                    store->indexBulk(txtdocs, csvFields(), k_csvContents);
+                    txtdocs.clear();
+                }
+                if (maxDocs > 0L && total >= maxDocs) break;
+            }
+        }
+        in.close();
+    }
+    if (!txtdocs.empty()) store->indexBulk(txtdocs, csvFields(), k_csvContents);
+    store->indexClose();
+    t.stop();
+    std::cout << "bulk: docs=[" << total << "] secs=[" << t.secs() << "] docs/sec=[" << (long)(total / std::max(t.secs(), 0.001)) << "]\n";
 }
 
 void query(kcc::ITextStore* store, const kcc::String& expression) throw (kcc::TextException)
@@ -99,9 +153,128 @@ void query(kcc::ITextStore* store, const kcc::String& expression) throw (kcc::Te
     std::cout << "rows: received=[" << rows << "] actual=[" << tr->total() << "]\n";
 }
 
+void encodeXml(const kcc::TextDocuments& page, kcc::String& out)
+{
+    kcc::StringStream buf;
+    kcc::DOMWriter w(buf);
+    w.start(kcc::TextQueryXml::root());
+    long row = 0L;
+    for (kcc::TextDocuments::const_iterator d = page.begin(); d != page.end(); d++, row++) kcc::TextQueryXmlCodec::document(w, row, *d);
+    w.end(kcc::TextQueryXml::root());
+    out = buf.str();
+}
+
+void decodeXml(const kcc::String& in, kcc::TextDocuments& page)
+{
+    page.clear();
+    kcc::AutoPtr<kcc::IDOMNode> root(kcc::Core::rodom()->parseXML(in));
+    kcc::DOMReader r(root);
+    kcc::AutoPtr<kcc::IDOMNodeList> docs(r.nodes(r.doc(kcc::TextQueryXml::root()), kcc::TextQueryXml::document()));
+    for (long i = 0L; i < docs->getLength(); i++)
+    {
+        page.push_back(kcc::TextDocument());
+        kcc::TextQueryXmlCodec::document(r, docs->getItem(i), page.back());
+    }
+}
+
+void encodeBinary(const kcc::TextDocuments& page, kcc::String& out)
+{
+    out.clear();
+    kcc::TextQueryBinary::Writer w(out);
+    long row = 0L;
+    for (kcc::TextDocuments::const_iterator d = page.begin(); d != page.end(); d++, row++) w.document(row, *d);
+    w.status(kcc::TextQueryBinary::Status());
+}
+
+void decodeBinary(const kcc::String& in, kcc::TextDocuments& page) throw (kcc::TextException)
+{
+    page.clear();
+    kcc::TextQueryBinary::Reader r(in);
+    kcc::TextQueryBinary::Status status;
+    kcc::TextQueryBinary::Tag tag;
+    long row = 0L;
+    while ((tag = r.next()) != kcc::TextQueryBinary::T_END)
+    {
+        if (tag == kcc::TextQueryBinary::T_STATUS) r.status(status);
+        else
+        {
+            page.push_back(kcc::TextDocument());
+            r.document(row, page.back());
+        }
+    }
+}
+
+bool same(const kcc::TextDocument& decoded, const kcc::TextDocument& doc, double tolerance)
+{
+    if (decoded.text != doc.text || decoded.metadata != doc.metadata || decoded.terms != doc.terms) return false;
+    if (decoded.matches.size() != doc.matches.size()) return false;
+    for (kcc::TextDocument::Matches::size_type i = 0; i < doc.matches.size(); i++)
+    {
+        if (decoded.matches[i].startOffset != doc.matches[i].startOffset || 
+            decoded.matches[i].endOffset   != doc.matches[i].endOffset) return false;
+    }
+    return std::fabs(decoded.score - doc.score) <= tolerance * std::max(1.0, std::fabs(doc.score));
+}
+
+void codec(kcc::ITextStore* store, const kcc::String& expression, long max, long iterations) throw (kcc::TextException)
+{
+    kcc::Log::Scope scope(KCC_FILE, "codec");
+
+    // result pages of all contents
+    std::vector<kcc::TextDocuments> pages;
+    kcc::TextDocument txtdoc;
+    kcc::AutoPtr<kcc::ITextResults> tr(store->query(
+        expression, 
+        kcc::TextDocument::C_TEXT|kcc::TextDocument::C_METADATA|
+        kcc::TextDocument::C_TERMS|kcc::TextDocument::C_QUERY_MATCHES));
+    while (tr->next())
+    {
+        if (pages.empty() || (long)pages.back().size() >= max) pages.push_back(kcc::TextDocuments());
+        tr->results(txtdoc);
+        pages.back().push_back(txtdoc);
+    }
+    std::cout << "codec: expr=[" << expression << "] docs=[" << tr->total() << "] pages=[" << pages.size() << "]\n";
+
+    // encode/decode each page per iteration
+    kcc::String buf;
+    kcc::TextDocuments decoded;
+    const kcc::Char* names[]     = { "xml", "binary" };
+    const double     tolerance[] = { 1e-5, 0.0 }; // xml scores are written to 6 significant digits
+    long             failed      = 0L;
+    for (int c = 0; c < 2; c++)
+    {
+        long bytes = 0L, docs = 0L, mismatched = 0L;
+        kcc::Timer te, td;
+        for (long i = 0L; i < iterations; i++)
+        {
+            for (std::vector<kcc::TextDocuments>::iterator p = pages.begin(); p != pages.end(); p++)
+            {
+                te.start();
+                if (c == 0) encodeXml   (*p, buf);
+                else        encodeBinary(*p, buf);
+                te.stop();
+                td.start();
+                if (c == 0) decodeXml   (buf, decoded);
+                else        decodeBinary(buf, decoded);
+                td.stop();
+                bytes += (long)buf.size();
+                docs  += (long)decoded.size();
+                if (decoded.size() != p->size()) mismatched += std::labs((long)decoded.size() - (long)p->size());
+                for (kcc::TextDocuments::size_type d = 0; d < decoded.size() && d < p->size(); d++)
+                    if (!same(decoded[d], (*p)[d], tolerance[c])) mismatched++;
+            }
+        }
+        failed += mismatched;
+        std::cout << names[c] << ": bytes/page=[" << (pages.empty() ? 0L : bytes / (long)(pages.size() * iterations)) 
+                  << "] encode=[" << te.secs() << "s] decode=[" << td.secs() << "s] docs=[" << docs 
+                  << "] mismatched=[" << mismatched << "]\n";
+    }
+    if (failed != 0L) throw kcc::TextException(kcc::Strings::printf("codec round trip mismatched: docs=[%d]", failed));
+}
+
 const kcc::Char* k_usage =
     "Usage:\n"
-    "    textstore path={path} action=(create|insert|optimize|query) {params...}\n";
+    "    textstore path={path} action=(create|insert|bulk|optimize|query|codec) {params...}\n";
 int main(int argc, const char* argv[])
 {
     kcc::Properties props;
@@ -116,7 +289,7 @@ int main(int argc, const char* argv[])
     {
         // action param
         const kcc::String& action = props.get("action", kcc::Strings::empty());
-        if (!kcc::Strings::match(action, "create|insert|optimize|query"))
+        if (!kcc::Strings::match(action, "create|insert|bulk|optimize|query|codec"))
         {
             std::cerr << "Missing or invalid 'action' parameter.\n" << k_usage;
             return 1;
@@ -148,8 +321,9 @@ int main(int argc, const char* argv[])
             store->indexOpen();
             store->indexClose();
         }
-        else if (action == "insert")
+        else if (action == "insert" || action == "bulk")
         {
+            // index csv input (maxDocs=n scale=passes over input offsets=1 to store term offsets; bulk: batch=docs per indexBulk)
             const kcc::String& input = props.get("input", kcc::Strings::empty());
             if (input.empty() || !kcc::Platform::fsExists(input))
             {
@@ -157,7 +331,11 @@ int main(int argc, const char* argv[])
                 return 1;
             }
             if (!store->init(props)) throw kcc::Exception("store init failed");
-            index(store, input, props.get("maxDocs", -1L));
+            long maxDocs = props.get("maxDocs", -1L);
+            long scale   = std::max(props.get("scale", 1L), 1L);
+            if (props.get("offsets", 0L) != 0L) k_csvContents |= kcc::TextDocument::C_TERM_OFFSETS;
+            if (action == "insert") index(store, input, maxDocs, scale);
+            else                    bulk (store, input, maxDocs, scale, std::max(props.get("batch", 5000L), 1L));
         }
         else if (action == "optimize")
         {
@@ -191,6 +369,12 @@ int main(int argc, const char* argv[])
                 query(store, expr);
             }
         }
+        else if (action == "codec")
+        {
+            // compare xml and binary result encodings (expr=... max=docs/page iterations=n)
+            if (!store->init(props)) throw kcc::Exception("store init failed");
+            codec(store, props.get("expr", "travelocity"), props.get("max", 25L), props.get("iterations", 10L));
+        }
     }
     catch (std::exception& e)
     {
@@ -65,6 +65,91 @@ struct Joiner : kcc::IThread
     }
 };
 
+// Refcount benchmark: copy & release alternating references into a ring of copies
+template<class _P> double refcount(const _P& a, const _P& b, long n)
+{
+    std::vector<_P> ring(64, a);
+    kcc::Timer t;
+    t.start();
+    for (long i = 0; i < n; i++) ring[i & 63] = (i & 1) ? a : b;
+    return t.now();
+}
+
+// Refcount sharer: copy & release MT-safe references from many threads
+typedef kcc::SharedPtr<kcc::String, kcc::AtomicCount> SharedString;
+struct Sharer : kcc::IThread
+{
+    const SharedString& shared;
+    long                n;
+    kcc::Monitor&       done;
+    Sharer(const SharedString& s, long sz, kcc::Monitor& d) : shared(s), n(sz), done(d) { done.init(); }
+    void invoke()
+    {
+        {
+            std::vector<SharedString> ring(16, shared);
+            for (long i = 0; i < n; i++) ring[i & 15] = shared;
+        }
+        done.notify();
+    }
+};
+
+// Executor sum: divide & conquer sum submitting (and waiting on) nested halves
+struct Sum : kcc::Executor::Future
+{
+    kcc::Executor& executor;
+    long           begin, end, sum;
+    Sum(kcc::Executor& e, long b, long en) : executor(e), begin(b), end(en), sum(0L) {}
+    void invoke()
+    {
+        if (end - begin <= 1000L)
+        {
+            for (long i = begin; i < end; i++) sum += i;
+            return;
+        }
+        long mid = begin + (end - begin) / 2L;
+        Sum lo(executor, begin, mid), hi(executor, mid, end);
+        executor.submit(&lo);
+        executor.submit(&hi);
+        hi.wait();
+        lo.wait();
+        sum = lo.sum + hi.sum;
+    }
+};
+
+// Executor task counter (and failure when asked)
+struct Counter : kcc::Executor::Future
+{
+    kcc::AtomicCount& count;
+    bool              fail;
+    Counter(kcc::AtomicCount& c, bool f = false) : count(c), fail(f) {}
+    void invoke()
+    {
+        if (fail) throw kcc::Exception("counter failed");
+        count.increment();
+    }
+};
+
+// Executor task recording the thread it ran on
+struct Runner : kcc::Executor::Future
+{
+    unsigned long thread;
+    Runner() : thread(0UL) {}
+    void invoke() { thread = kcc::Thread::current(); }
+};
+
+// Thread per task counter (executor benchmark baseline)
+struct CounterThread : kcc::Thread
+{
+    kcc::AtomicCount& count;
+    kcc::Monitor&     done;
+    CounterThread(kcc::AtomicCount& c, kcc::Monitor& d) : kcc::Thread("counter"), count(c), done(d) { done.init(); }
+    void invoke()
+    {
+        count.increment();
+        done.notify();
+    }
+};
+
 int main(int argc, const char* argv[])
 {
     kcc::Properties props;
@@ -100,6 +185,107 @@ int main(int argc, const char* argv[])
         run->go(true);
         j.start.notify(); // don't let finish prior to join
         kcc::Thread::join(run);
+
+        long n = props.get("refcount", 5000000L);
+        kcc::Log::out("refcount benchmark: copies=[%d]", n);
+        kcc::SharedPtr<int>                   spa(new int(1)),   spb(new int(2));
+        kcc::SharedPtr<int, kcc::AtomicCount> aspa(new int(1)),  aspb(new int(2));
+        kcc::StringRC                         rca("a"),          rcb("b");
+        kcc::StringRCAtomic                   arca("a"),         arcb("b");
+        kcc::Log::out("SharedPtr              %.3fs", refcount(spa,  spb,  n));
+        kcc::Log::out("SharedPtr<AtomicCount> %.3fs", refcount(aspa, aspb, n));
+        kcc::Log::out("StringRC               %.3fs", refcount(rca,  rcb,  n));
+        kcc::Log::out("StringRCAtomic         %.3fs", refcount(arca, arcb, n));
+
+        SharedString shared(new kcc::String("shared"));
+        kcc::Monitor done;
+        std::vector<Sharer*> sharers;
+        for (int i = 0; i < 8; i++)
+        {
+            sharers.push_back(new Sharer(shared, n / 8L, done));
+            (new kcc::Thread(sharers.back(), "sharer"))->go();
+        }
+        done.wait();
+        for (int i = 0; i < 8; i++) delete sharers[i];
+        if (shared.rc() != 1) throw kcc::Exception(kcc::Strings::printf("atomic refcount mismatch: rc=[%d]", shared.rc()));
+        kcc::Log::out("atomic refcount shared by 8 threads: rc=[%d]", shared.rc());
+
+        // executor: nested tasks & stealing
+        kcc::Executor& executor = kcc::Core::executor();
+        long range = props.get("sum", 1000000L);
+        Sum sum(executor, 0L, range);
+        executor.submit(&sum);
+        sum.wait();
+        if (sum.sum != range * (range - 1L) / 2L) throw kcc::Exception(kcc::Strings::printf("executor sum mismatch: sum=[%ld]", sum.sum));
+        kcc::Log::out("executor sum: threads=[%d] executed=[%ld] stolen=[%ld]", executor.threads(), executor.executed(), executor.stolen());
+
+        // executor: task failure
+        kcc::AtomicCount count(0L);
+        Counter failer(count, true);
+        executor.submit(&failer);
+        if (failer.wait() || failer.error().empty()) throw kcc::Exception("executor task failure not reported");
+        kcc::Log::out("executor task failure: [%s]", failer.error().c_str());
+
+        // executor: blocking wait leaves queued tasks to the workers
+        {
+            kcc::Executor local(1, "blocking");
+            Runner runners[64];
+            for (int i = 0; i < 64; i++) local.submit(&runners[i]);
+            long helped = 0L;
+            for (int i = 0; i < 64; i++)
+            {
+                runners[i].wait(false);
+                if (runners[i].thread == kcc::Thread::current()) helped++;
+            }
+            if (helped != 0L) throw kcc::Exception(kcc::Strings::printf("executor blocking wait ran tasks: helped=[%ld]", helped));
+            kcc::Log::out("executor blocking wait: [%d] tasks run by workers", 64);
+        }
+
+        // executor: tasks vs thread per task
+        long tasks = props.get("tasks", 2000L);
+        {
+            kcc::Timer t;
+            t.start();
+            kcc::Monitor done;
+            for (long i = 0; i < tasks; i++) (new CounterThread(count, done))->go();
+            done.wait();
+            kcc::Log::out("thread per task: %.3fs (%ld tasks)", t.now(), tasks);
+        }
+        {
+            kcc::Timer t;
+            t.start();
+            std::vector<Counter*> counters;
+            for (long i = 0; i < tasks; i++)
+            {
+                counters.push_back(new Counter(count));
+                executor.submit(counters.back());
+            }
+            for (long i = 0; i < tasks; i++)
+            {
+                counters[i]->wait();
+                delete counters[i];
+            }
+            kcc::Log::out("executor:        %.3fs (%ld tasks)", t.now(), tasks);
+        }
+        if (count.get() != 2L * tasks) throw kcc::Exception(kcc::Strings::printf("executor count mismatch: count=[%ld]", count.get()));
+
+        // executor: graceful shutdown runs queued tasks, later tasks run on caller
+        {
+            kcc::AtomicCount drained(0L);
+            std::vector<Counter*> counters;
+            kcc::Executor local(2, "local");
+            for (long i = 0; i < 100L; i++)
+            {
+                counters.push_back(new Counter(drained));
+                local.submit(counters.back());
+            }
+            local.shutdown();
+            Counter after(drained);
+            local.submit(&after);
+            for (long i = 0; i < 100L; i++) delete counters[i];
+            if (drained.get() != 101L || !after.completed()) throw kcc::Exception(kcc::Strings::printf("executor shutdown mismatch: drained=[%ld]", drained.get()));
+            kcc::Log::out("executor shutdown drained: [%ld]", drained.get());
+        }
  
         kcc::Log::out("completed thread testing");
     }
@@ -9,6 +9,79 @@
 #define KCC_FILE    "xform"
 #define KCC_VERSION "$Id: xform.cpp 20740 2007-09-17 14:56:30Z tvk $"
 
+// Helper thread to run transforms concurrently
+struct StressThread : kcc::Thread
+{
+    kcc::IXMLTransform*   xform;
+    const kcc::String&    xml;
+    const kcc::String&    xslt;
+    const kcc::StringMap& params;
+    const kcc::String&    expected;
+    long                  iterations;
+    long&                 failures;
+    kcc::Monitor&         done;
+    StressThread(
+        kcc::IXMLTransform* x, const kcc::String& in, const kcc::String& ss, const kcc::StringMap& p, 
+        const kcc::String& e, long i, long& f, kcc::Monitor& d)
+        : kcc::Thread("StressThread"), 
+          xform(x), xml(in), xslt(ss), params(p), expected(e), iterations(i), failures(f), done(d)
+    {
+        done.init();
+    }
+    void failed()
+    {
+        static kcc::Mutex k_sentinel;
+        kcc::Mutex::Lock lock(k_sentinel);
+        failures++;
+    }
+    virtual void invoke()
+    {
+        for (long i = 0L; i < iterations; i++)
+        {
+            try
+            {
+                kcc::StringStream in(xml), out;
+                xform->apply(in, xslt, params, out);
+                if (out.str() != expected) failed();
+            }
+            catch (std::exception& e)
+            {
+                kcc::Log::exception(e);
+                failed();
+            }
+        }
+        done.notify();
+    }
+};
+
+// stress: transform with same stylesheet from 1, 2, 4, ... workers
+void stress(
+    kcc::IXMLTransform* xform, const kcc::String& xmlPath, const kcc::String& xslt, const kcc::StringMap& params, 
+    long workers, long iterations)
+{
+    kcc::String xml;
+    kcc::Strings::loadText(xmlPath, xml);
+    kcc::StringStream in(xml), out;
+    xform->apply(in, xslt, params, out);
+    kcc::String expected(out.str());
+    double base = 0.0;
+    for (long w = 1L; w <= workers; w *= 2L)
+    {
+        long failures = 0L;
+        kcc::Monitor done;
+        kcc::Timer t;
+        t.start();
+        for (long i = 0L; i < w; i++) (new StressThread(xform, xml, xslt, params, expected, iterations, failures, done))->go();
+        done.wait();
+        double secs = t.now();
+        double rate = (w * iterations) / secs;
+        if (w == 1L) base = rate;
+        kcc::Log::out(
+            "xform stress: workers=[%d] transforms=[%d] secs=[%.3f] rate=[%.1f/s] scale=[%.2f] failures=[%d]",
+            w, w * iterations, secs, rate, rate / base, failures);
+    }
+}
+
 // main: entry point into xslt transformation console application
 int main(int argc, const char* argv[])
 {
@@ -32,9 +105,11 @@ int main(int argc, const char* argv[])
         kcc::String xslt  (props.get("xslt",   kcc::Strings::empty()));
         kcc::String output(props.get("output", kcc::Strings::empty()));
         kcc::String params(props.get("params", kcc::Strings::empty()));
+        long        workers   = props.get("workers", 0L);
+        long        iterations= props.get("iterations", 200L);
         if (xml.empty() || xslt.empty())
         {
-            std::cout << "Usage: xform xml=full-path xslt=full-path output=(full-path) params=key:value,..." << std::endl;
+            std::cout << "Usage: xform xml=full-path xslt=full-path output=(full-path) params=key:value,... (workers=n iterations=n)" << std::endl;
             return 1;
         }
 
@@ -51,9 +126,14 @@ int main(int argc, const char* argv[])
 
         // transform
         kcc::AutoPtr<kcc::IXMLTransform> xform(KCC_COMPONENT(kcc::IXMLTransform, props.get("transform", "k_transform")));
+        xform->init(props);
         
         // transform
-        if (output.empty())
+        if (workers > 0L)
+        {
+            stress(xform, xml, xslt, xparams, workers, iterations);
+        }
+        else if (output.empty())
         {
             xform->apply(xml, xslt, xparams, std::cout);
         }
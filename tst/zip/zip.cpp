@@ -22,9 +22,10 @@ int main(int argc, const char* argv[])
     kcc::String inf (props.get("in",   kcc::Strings::empty()));
     kcc::String outf(props.get("out",  kcc::Strings::empty()));
     kcc::String type(props.get("type", "bzip2"));
+    bool memory = props.get("memory", KCC_PROPERTY_FALSE) == KCC_PROPERTY_TRUE;
     if ((!c && !d) || (c && d) || inf.empty() || outf.empty() || type.empty())
     {
-        std::cerr << "Usage: zip c|d in=input out=output (type=gzip|bzip2)\n";
+        std::cerr << "Usage: zip c|d in=input out=output (type=gzip|bzip2) (memory=1 to compress in memory)\n";
         return 1;
     }
 
@@ -34,7 +35,22 @@ int main(int argc, const char* argv[])
         // zip provider
         kcc::IZipFactory* zip = KCC_FACTORY(kcc::IZipFactory, (type == "bzip2" ? "k_bzip2" : "k_zlib"));
         
-        if (c)
+        if (c && memory)
+        {
+            // compress in memory (output must decompress with stream reader)
+            kcc::String data, zipped;
+            char buf[SZ];
+            FILE* in = std::fopen(inf.c_str(), "rb");
+            if (in == NULL) throw kcc::Exception("unable to open in file");
+            while (!feof(in)) data.append(buf, std::fread(buf, sizeof(char), SZ, in));
+            std::fclose(in);
+            if (!zip->compress(data.data(), (int)data.size(), zipped)) throw kcc::Exception("unable to compress in memory");
+            FILE* out = std::fopen(outf.c_str(), "wb");
+            if (out == NULL) throw kcc::Exception("unable to open out file");
+            std::fwrite(zipped.data(), sizeof(char), zipped.size(), out);
+            std::fclose(out);
+        }
+        else if (c)
         {
             // compress
             char buf[SZ];